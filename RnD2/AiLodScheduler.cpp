@@ -0,0 +1,97 @@
+#include "AiLodScheduler.h"
+#include "JobSystem.h"
+
+struct MoveJob
+{
+	ObjectPool<Enemy>* enemies;
+	float dt;
+};
+
+static void moveRange(void* data, int begin, int end)
+{
+	MoveJob* job = (MoveJob*)data;
+	for(int k=begin; k<end; k++)
+	{
+		Enemy& e = job->enemies->getActive(k);
+		if(e.getActiveState()) e.update(job->dt);
+	}
+}
+
+AiLodScheduler::AiLodScheduler()
+{
+	enabled = true;
+	frame = 0;
+	for(int b=0; b<aiLodNS::NUM_BUCKETS; b++)
+		setBucket(b, aiLodNS::BUCKET_RADIUS[b], aiLodNS::BUCKET_INTERVAL[b]);
+	thinkCount = 0;
+	coastCount = 0;
+}
+
+void AiLodScheduler::setBucket(int bucket, float radius, int inter)
+{
+	if(bucket < 0 || bucket >= aiLodNS::NUM_BUCKETS) return;
+	//FLT_MAX squared overflows, so leave the outermost bucket unbounded
+	radiusSq[bucket] = (radius >= FLT_MAX) ? FLT_MAX : radius*radius;
+	interval[bucket] = Max(1, inter);
+	bucketCount[bucket] = 0;
+}
+
+void AiLodScheduler::reset()
+{
+	frame = 0;
+	pendingDt.clear();
+}
+
+void AiLodScheduler::restart(int slot)
+{
+	if(slot < (int)pendingDt.size()) pendingDt[slot] = 0.0f;
+}
+
+int AiLodScheduler::bucketFor(float distSq)
+{
+	for(int b=0; b<aiLodNS::NUM_BUCKETS-1; b++)
+		if(distSq <= radiusSq[b]) return b;
+	return aiLodNS::NUM_BUCKETS-1;
+}
+
+void AiLodScheduler::update(ObjectPool<Enemy>& enemies, Player* player, float dt, EnemyStateMachine* brain)
+{
+	frame++;
+	coastCount = 0;
+	thinkers.clear();
+	for(int b=0; b<aiLodNS::NUM_BUCKETS; b++) bucketCount[b] = 0;
+	if((int)pendingDt.size() < enemies.getCapacity()) pendingDt.resize(enemies.getCapacity(), 0.0f);
+
+	int count = enemies.getActiveCount();
+	for(int k=0; k<count; k++)
+	{
+		int i = enemies.getActiveSlot(k);
+		Enemy& e = enemies[i];
+		if(!e.getActiveState()) continue;
+		pendingDt[i] += dt;
+
+		D3DXVECTOR3 toPlayer = e.getPosition() - player->getPosition();
+		int b = enabled ? bucketFor(D3DXVec3LengthSq(&toPlayer)) : 0;
+		bucketCount[b]++;
+
+		//Offset by index so a bucket's enemies are spread across frames instead of all thinking together.
+		//Dead enemies think straight away so they are removed and scored on the frame they die.
+		bool due = interval[b] == 1 || (frame + i) % interval[b] == 0 ||
+			pendingDt[i] >= aiLodNS::MAX_THINK_GAP || e.getHealth() <= 0;
+		if(due)
+		{
+			e.setThinkDt(pendingDt[i]);
+			pendingDt[i] = 0.0f;
+			thinkers.push_back(&e);
+		}
+		else coastCount++;
+	}
+	thinkCount = thinkers.size();
+
+	brain->think(thinkers, player);
+
+	//Between thinks this just carries on along the last velocity. Each enemy
+	//only moves itself, so this part can be spread over the job system.
+	MoveJob move = {&enemies, dt};
+	JobSystem::parallelFor(count, aiLodNS::MOVE_GRAIN, moveRange, &move);
+}
@@ -0,0 +1,62 @@
+#ifndef AI_LOD_SCHEDULER_H
+#define AI_LOD_SCHEDULER_H
+
+#include "Enemy.h"
+#include "Player.h"
+#include "EnemyStateMachine.h"
+#include "ObjectPool.h"
+#include <vector>
+using std::vector;
+
+//Distance buckets for enemy AI level-of-detail. Enemies inside the first
+//radius think every frame; further buckets think every Nth frame with the
+//dt accumulated since their last think and coast on their last velocity in between.
+namespace aiLodNS {
+	const int NUM_BUCKETS = 4;
+	//Enemies start chasing at 55 units, so keep some slack before dropping fidelity
+	const float BUCKET_RADIUS[NUM_BUCKETS] = {70.0f, 150.0f, 400.0f, FLT_MAX};
+	const int BUCKET_INTERVAL[NUM_BUCKETS] = {1, 2, 4, 8};
+	//Never let an enemy go longer than this without thinking, even on slow frames
+	const float MAX_THINK_GAP = 0.25f;
+	//Enemies per job when moving them
+	const int MOVE_GRAIN = 32;
+}
+
+class AiLodScheduler
+{
+public:
+	AiLodScheduler();
+
+	void setBucket(int bucket, float radius, int interval);
+	void setEnabled(bool e) {enabled = e;}
+	bool isEnabled() {return enabled;}
+
+	//Picks which enemies think this frame, hands them to brain as one batch,
+	//then moves every active enemy
+	void update(ObjectPool<Enemy>& enemies, Player* player, float dt, EnemyStateMachine* brain);
+	void reset();
+	//Call when an enemy spawns into a slot, so it doesn't carry over time from the last one
+	void restart(int slot);
+
+	//Per-frame stats
+	int getThinkCount() {return thinkCount;}
+	int getCoastCount() {return coastCount;}
+	int getBucketCount(int bucket) {return bucketCount[bucket];}
+
+private:
+	int bucketFor(float distSq);
+
+	bool enabled;
+	unsigned int frame;
+	float radiusSq[aiLodNS::NUM_BUCKETS];
+	int interval[aiLodNS::NUM_BUCKETS];
+	//Time since each enemy last thought, indexed by pool slot
+	vector<float> pendingDt;
+	vector<Enemy*> thinkers;
+
+	int thinkCount;
+	int coastCount;
+	int bucketCount[aiLodNS::NUM_BUCKETS];
+};
+
+#endif
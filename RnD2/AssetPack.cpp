@@ -0,0 +1,240 @@
+#include "AssetPack.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace assetPackNS;
+
+void packName(const char* path, char out[NAME_LENGTH])
+{
+	const char* name = path;
+	for(const char* p = path; *p; p++)
+		if(*p == '/' || *p == '\\') name = p + 1;
+	int i = 0;
+	for(; name[i] && i < NAME_LENGTH - 1; i++)
+		out[i] = (char)(name[i] >= 'A' && name[i] <= 'Z' ? name[i] - 'A' + 'a' : name[i]);
+	for(; i < NAME_LENGTH; i++)
+		out[i] = 0;
+}
+
+unsigned long long hashPackName(const char* path)
+{
+	char name[NAME_LENGTH];
+	packName(path, name);
+	unsigned long long hash = 14695981039346656037ull;
+	for(int i=0; name[i]; i++)
+		hash = (hash ^ (unsigned char)name[i]) * 1099511628211ull;
+	return hash;
+}
+
+static void layoutOf(const PackEntry* e, TextureData* layout)
+{
+	layout->width = e->width;
+	layout->height = e->height;
+	layout->mipLevels = e->mipLevels;
+	layout->format = (textureDataNS::Format)e->format;
+	layout->texels.clear();
+}
+
+AssetPack::AssetPack()
+{
+	base = 0;
+	size = 0;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = 0;
+#endif
+}
+
+AssetPack::~AssetPack()
+{
+	close();
+}
+
+bool AssetPack::open(const char* path)
+{
+	close();
+#ifdef _WIN32
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if(file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if(GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+		if(mapping) base = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		size = (size_t)fileSize.QuadPart;
+	}
+#else
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0) return false;
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if(p != MAP_FAILED)
+		{
+			base = (const unsigned char*)p;
+			size = st.st_size;
+		}
+	}
+	//The mapping keeps the file
+	::close(fd);
+#endif
+	if(base && validate()) return true;
+	close();
+	return false;
+}
+
+void AssetPack::close()
+{
+#ifdef _WIN32
+	if(base) UnmapViewOfFile(base);
+	if(mapping) CloseHandle(mapping);
+	if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	file = INVALID_HANDLE_VALUE;
+	mapping = 0;
+#else
+	if(base) munmap((void*)base, size);
+#endif
+	base = 0;
+	size = 0;
+}
+
+bool AssetPack::validate() const
+{
+	if(size < sizeof(PackHeader)) return false;
+	const PackHeader* h = (const PackHeader*)base;
+	if(memcmp(h->magic, MAGIC, sizeof(MAGIC)) || h->version != (unsigned int)VERSION || h->fileSize != size) return false;
+	if(h->entryCount > (size - sizeof(PackHeader)) / sizeof(PackEntry)) return false;
+	TextureData layout;
+	for(int i=0; i<getEntryCount(); i++)
+	{
+		const PackEntry* e = getEntry(i);
+		if(e->format >= textureDataNS::NUM_FORMATS || e->width == 0 || e->height == 0 ||
+			e->width > 65536 || e->height > 65536) return false;
+		if(e->mipLevels == 0 || e->mipLevels > (unsigned int)TextureData::fullMipCount(e->width, e->height)) return false;
+		if(e->name[NAME_LENGTH - 1] || e->nameHash != hashPackName(e->name)) return false;
+		if(i > 0 && getEntry(i - 1)->nameHash >= e->nameHash) return false;
+		layoutOf(e, &layout);
+		if(e->size != (unsigned long long)layout.getMipOffset(e->mipLevels)) return false;
+		if(e->offset > size || e->size > size - e->offset) return false;
+	}
+	return true;
+}
+
+int AssetPack::getEntryCount() const
+{
+	return base ? (int)((const PackHeader*)base)->entryCount : 0;
+}
+
+const PackEntry* AssetPack::getEntry(int i) const
+{
+	return (const PackEntry*)(base + sizeof(PackHeader)) + i;
+}
+
+const PackEntry* AssetPack::find(const char* path) const
+{
+	if(!base) return 0;
+	unsigned long long hash = hashPackName(path);
+	//The entries are sorted by hash
+	int lo = 0, hi = getEntryCount();
+	while(lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if(getEntry(mid)->nameHash < hash) lo = mid + 1;
+		else hi = mid;
+	}
+	if(lo == getEntryCount() || getEntry(lo)->nameHash != hash) return 0;
+	char name[NAME_LENGTH];
+	packName(path, name);
+	return strcmp(getEntry(lo)->name, name) ? 0 : getEntry(lo);
+}
+
+const unsigned char* AssetPack::getTexels(const PackEntry* e, TextureData* layout) const
+{
+	layoutOf(e, layout);
+	return base + e->offset;
+}
+
+void AssetPack::release(const PackEntry* e) const
+{
+#ifdef _WIN32
+	//Unlocking pages that aren't locked takes them out of the working set
+	VirtualUnlock((void*)(base + e->offset), (SIZE_T)e->size);
+#else
+	//madvise wants whole pages; the ones at the ends may be shared with the
+	//next texture, which would only read them back in
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t begin = ((size_t)e->offset + page - 1) / page * page;
+	size_t end = ((size_t)(e->offset + e->size)) / page * page;
+	if(end > begin) madvise((void*)(base + begin), end - begin, MADV_DONTNEED);
+#endif
+}
+
+static bool byHash(const PackEntry& a, const PackEntry& b)
+{
+	return a.nameHash < b.nameHash;
+}
+
+bool AssetPack::write(const char* path, const vector<const char*>& paths, const vector<const TextureData*>& textures)
+{
+	vector<PackEntry> entries(paths.size());
+	for(size_t i=0; i<paths.size(); i++)
+	{
+		PackEntry& e = entries[i];
+		packName(paths[i], e.name);
+		e.nameHash = hashPackName(paths[i]);
+		e.width = textures[i]->width;
+		e.height = textures[i]->height;
+		e.mipLevels = textures[i]->mipLevels;
+		e.format = textures[i]->format;
+		e.size = textures[i]->texels.size();
+		//Which texture it is, until the offsets go in
+		e.offset = i;
+	}
+	std::sort(entries.begin(), entries.end(), byHash);
+	for(size_t i=1; i<entries.size(); i++)
+		if(entries[i].nameHash == entries[i - 1].nameHash) return false;
+
+	unsigned long long offset = sizeof(PackHeader) + entries.size()*sizeof(PackEntry);
+	vector<const TextureData*> order(entries.size());
+	for(size_t i=0; i<entries.size(); i++)
+	{
+		order[i] = textures[(size_t)entries[i].offset];
+		offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		entries[i].offset = offset;
+		offset += entries[i].size;
+	}
+
+	PackHeader header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.entryCount = (unsigned int)entries.size();
+	header.reserved = 0;
+	header.fileSize = offset;
+
+	FILE* f = fopen(path, "wb");
+	if(!f) return false;
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	if(ok && !entries.empty()) ok = fwrite(&entries[0], sizeof(PackEntry), entries.size(), f) == entries.size();
+	static const char PADDING[ALIGNMENT] = {0};
+	unsigned long long at = sizeof(PackHeader) + entries.size()*sizeof(PackEntry);
+	for(size_t i=0; ok && i<entries.size(); i++)
+	{
+		size_t pad = (size_t)(entries[i].offset - at);
+		if(pad) ok = fwrite(PADDING, 1, pad, f) == pad;
+		if(ok && entries[i].size) ok = fwrite(&order[i]->texels[0], 1, (size_t)entries[i].size, f) == entries[i].size;
+		at = entries[i].offset + entries[i].size;
+	}
+	ok = fclose(f) == 0 && ok;
+	return ok;
+}
@@ -0,0 +1,99 @@
+//=======================================================================================
+// AssetPack.h
+//
+// The game's textures decoded ahead of time into one file, so startup maps it
+// and hands the texels straight to the GPU instead of decoding PNGs and JPEGs
+// and making their mips. rugger_pack writes it (see PackMain.cpp).
+//
+// The file is a PackHeader, a PackEntry per texture sorted by name hash, then
+// each texture's texels laid out as TextureData keeps them, every mip level,
+// each texture starting on an ALIGNMENT boundary. Everything is little-endian.
+//=======================================================================================
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "TextureData.h"
+#include <stddef.h>
+
+namespace assetPackNS {
+	const char MAGIC[4] = {'R', 'P', 'A', 'K'};
+	const int VERSION = 1;
+	const char DEFAULT_FILE[] = "assets.pak";
+	const int NAME_LENGTH = 48;
+	const int ALIGNMENT = 64;
+}
+
+//24 bytes on disk
+struct PackHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int entryCount;
+	unsigned int reserved;
+	unsigned long long fileSize;
+};
+
+//88 bytes on disk
+struct PackEntry
+{
+	unsigned long long nameHash;	//hashPackName of the name
+	char name[assetPackNS::NAME_LENGTH];	//lower case, no directory
+	unsigned int width;
+	unsigned int height;
+	unsigned int mipLevels;
+	unsigned int format;			//a textureDataNS::Format
+	unsigned long long offset;		//of the texels, from the start of the file
+	unsigned long long size;
+};
+
+//What a file is called in a pack: its name without the directory, in lower
+//case, as Windows doesn't care and the game isn't consistent
+void packName(const char* path, char out[assetPackNS::NAME_LENGTH]);
+//64-bit FNV-1a of packName(path)
+unsigned long long hashPackName(const char* path);
+
+//A pack mapped read-only into memory. The texels are used where they are in
+//the mapping, so nothing is copied on the way to the GPU.
+class AssetPack
+{
+public:
+	AssetPack();
+	~AssetPack();
+
+	//Fails, leaving nothing open, if the file is missing or isn't a whole,
+	//consistent pack of this version
+	bool open(const char* path);
+	void close();
+	bool isOpen() const {return base != 0;}
+
+	int getEntryCount() const;
+	const PackEntry* getEntry(int i) const;
+	//By file name, with or without a directory; NULL if it isn't in the pack
+	const PackEntry* find(const char* path) const;
+	//The entry's sizes in layout (its texels left empty), and where its
+	//texels start in the mapping. Good until close().
+	const unsigned char* getTexels(const PackEntry* e, TextureData* layout) const;
+	//Tells the OS the entry's pages can go once they've been uploaded; they
+	//come back from the file if they're touched again
+	void release(const PackEntry* e) const;
+
+	//Writes the textures as a pack under the packName of each of paths.
+	//Fails if two of them have the same name.
+	static bool write(const char* path, const vector<const char*>& paths, const vector<const TextureData*>& textures);
+
+private:
+	AssetPack(const AssetPack&);
+	AssetPack& operator=(const AssetPack&);
+
+	bool validate() const;
+
+	const unsigned char* base;
+	size_t size;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+};
+
+#endif
@@ -9,9 +9,10 @@
 
 #include <xact3.h>
 #include "constants.h"
+#include "SimAudio.h"
 
 
-class Audio
+class Audio : public SimAudio
 {
     // properties
   private:
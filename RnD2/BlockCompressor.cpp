@@ -0,0 +1,668 @@
+#include "BlockCompressor.h"
+#include "JobSystem.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef BLOCK_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace textureDataNS;
+using namespace blockCompressNS;
+
+//A block's colours split into channels, as the SIMD fit wants them
+struct BlockPixels
+{
+	short channel[3][16];
+	unsigned int transparent;	//bit i set if texel i has alpha under 128
+};
+
+//Where the best pair of endpoints so far has got to
+struct ColorFit
+{
+	int c0, c1;
+	unsigned int indices;
+	int error;
+};
+
+static int to565(int r, int g, int b)
+{
+	return (((r*31 + 127)/255) << 11) | (((g*63 + 127)/255) << 5) | ((b*31 + 127)/255);
+}
+
+static void from565(int c, int rgb[3])
+{
+	int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+//The four colours two endpoints give. Four-colour mode is BC3's always, and
+//BC1's when c0 > c1; otherwise the third is halfway and the fourth black.
+static void colorPalette(int c0, int c1, bool fourColor, int pal[4][3])
+{
+	from565(c0, pal[0]);
+	from565(c1, pal[1]);
+	for(int k=0; k<3; k++)
+	{
+		if(fourColor)
+		{
+			pal[2][k] = (2*pal[0][k] + pal[1][k] + 1) / 3;
+			pal[3][k] = (pal[0][k] + 2*pal[1][k] + 1) / 3;
+		}
+		else
+		{
+			pal[2][k] = (pal[0][k] + pal[1][k] + 1) / 2;
+			pal[3][k] = 0;
+		}
+	}
+}
+
+//Each texel's nearest palette colour, two bits a texel, and the summed
+//squared error. Ties go to the lower index.
+static int fitIndices(const BlockPixels& px, const int pal[4][3], int numColors, unsigned int* indices)
+{
+	//A colour that can't be used is put where nothing is nearest to it
+	int p[4][3];
+	for(int j=0; j<4; j++)
+		for(int k=0; k<3; k++)
+			p[j][k] = j < numColors ? pal[j][k] : 1000;
+
+	int best[16];
+	int index[16];
+#ifdef BLOCK_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	__m128i bestV[4], indexV[4];
+	for(int j=0; j<4; j++)
+	{
+		__m128i pr = _mm_set1_epi16((short)p[j][0]);
+		__m128i pg = _mm_set1_epi16((short)p[j][1]);
+		__m128i pb = _mm_set1_epi16((short)p[j][2]);
+		__m128i jV = _mm_set1_epi32(j);
+		for(int h=0; h<2; h++)
+		{
+			__m128i dr = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)&px.channel[0][h*8]), pr);
+			__m128i dg = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)&px.channel[1][h*8]), pg);
+			__m128i db = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)&px.channel[2][h*8]), pb);
+			//r and g side by side, then b beside zero, so each madd sums a texel's squares
+			__m128i rgLo = _mm_unpacklo_epi16(dr, dg), rgHi = _mm_unpackhi_epi16(dr, dg);
+			__m128i bLo = _mm_unpacklo_epi16(db, zero), bHi = _mm_unpackhi_epi16(db, zero);
+			__m128i d[2];
+			d[0] = _mm_add_epi32(_mm_madd_epi16(rgLo, rgLo), _mm_madd_epi16(bLo, bLo));
+			d[1] = _mm_add_epi32(_mm_madd_epi16(rgHi, rgHi), _mm_madd_epi16(bHi, bHi));
+			for(int q=0; q<2; q++)
+			{
+				int n = h*2 + q;
+				if(j == 0)
+				{
+					bestV[n] = d[q];
+					indexV[n] = zero;
+					continue;
+				}
+				__m128i closer = _mm_cmplt_epi32(d[q], bestV[n]);
+				bestV[n] = _mm_or_si128(_mm_and_si128(closer, d[q]), _mm_andnot_si128(closer, bestV[n]));
+				indexV[n] = _mm_or_si128(_mm_and_si128(closer, jV), _mm_andnot_si128(closer, indexV[n]));
+			}
+		}
+	}
+	for(int n=0; n<4; n++)
+	{
+		_mm_storeu_si128((__m128i*)&best[n*4], bestV[n]);
+		_mm_storeu_si128((__m128i*)&index[n*4], indexV[n]);
+	}
+#else
+	for(int i=0; i<16; i++)
+	{
+		for(int j=0; j<4; j++)
+		{
+			int dr = px.channel[0][i] - p[j][0], dg = px.channel[1][i] - p[j][1], db = px.channel[2][i] - p[j][2];
+			int d = dr*dr + dg*dg + db*db;
+			if(j == 0 || d < best[i])
+			{
+				best[i] = d;
+				index[i] = j;
+			}
+		}
+	}
+#endif
+	int error = 0;
+	unsigned int bits = 0;
+	for(int i=0; i<16; i++)
+	{
+		//Transparent texels are the fourth colour, whatever it looks like
+		if(px.transparent & (1u << i))
+		{
+			bits |= 3u << (i*2);
+			continue;
+		}
+		bits |= (unsigned int)index[i] << (i*2);
+		error += best[i];
+	}
+	*indices = bits;
+	return error;
+}
+
+//Puts the endpoints in the order their mode needs, fits the texels to them,
+//and keeps them if they beat best
+static void tryEndpoints(const BlockPixels& px, int c0, int c1, bool threeColor, bool bc3, ColorFit* best)
+{
+	if(threeColor ? c0 > c1 : c0 < c1)
+	{
+		int t = c0;
+		c0 = c1;
+		c1 = t;
+	}
+	int pal[4][3];
+	bool fourColor = bc3 || c0 > c1;
+	colorPalette(c0, c1, fourColor, pal);
+	//In BC1 equal endpoints mean three-colour mode, where the fourth is black
+	int numColors = threeColor || (!bc3 && c0 == c1) ? 3 : 4;
+	unsigned int indices;
+	int error = fitIndices(px, pal, numColors, &indices);
+	if(error < best->error)
+	{
+		best->c0 = c0;
+		best->c1 = c1;
+		best->indices = indices;
+		best->error = error;
+	}
+}
+
+//The corners of the opaque texels' bounding box, on the diagonal the colours
+//run along, pulled in a little as the palette's ends are rarely all used
+static void boxEndpoints(const BlockPixels& px, int e0[3], int e1[3])
+{
+	int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+	int mean[3] = {0, 0, 0}, count = 0;
+	for(int i=0; i<16; i++)
+	{
+		if(px.transparent & (1u << i)) continue;
+		for(int k=0; k<3; k++)
+		{
+			int v = px.channel[k][i];
+			if(v < lo[k]) lo[k] = v;
+			if(v > hi[k]) hi[k] = v;
+			mean[k] += v;
+		}
+		count++;
+	}
+	for(int k=0; k<3; k++)
+	{
+		mean[k] /= count;
+		int inset = (hi[k] - lo[k]) >> 4;
+		lo[k] += inset;
+		hi[k] -= inset;
+	}
+	//Green and blue go against red if they fall as it rises
+	int covRG = 0, covRB = 0;
+	for(int i=0; i<16; i++)
+	{
+		if(px.transparent & (1u << i)) continue;
+		int dr = px.channel[0][i] - mean[0];
+		covRG += dr*(px.channel[1][i] - mean[1]);
+		covRB += dr*(px.channel[2][i] - mean[2]);
+	}
+	e0[0] = hi[0];
+	e1[0] = lo[0];
+	e0[1] = covRG < 0 ? lo[1] : hi[1];
+	e1[1] = covRG < 0 ? hi[1] : lo[1];
+	e0[2] = covRB < 0 ? lo[2] : hi[2];
+	e1[2] = covRB < 0 ? hi[2] : lo[2];
+}
+
+//The opaque texels furthest apart along the line that best fits them
+static void lineEndpoints(const BlockPixels& px, int e0[3], int e1[3])
+{
+	float mean[3] = {0, 0, 0};
+	int count = 0;
+	for(int i=0; i<16; i++)
+	{
+		if(px.transparent & (1u << i)) continue;
+		for(int k=0; k<3; k++)
+			mean[k] += px.channel[k][i];
+		count++;
+	}
+	for(int k=0; k<3; k++)
+		mean[k] /= count;
+	float cov[6] = {0, 0, 0, 0, 0, 0};
+	for(int i=0; i<16; i++)
+	{
+		if(px.transparent & (1u << i)) continue;
+		float r = px.channel[0][i] - mean[0], g = px.channel[1][i] - mean[1], b = px.channel[2][i] - mean[2];
+		cov[0] += r*r;
+		cov[1] += r*g;
+		cov[2] += r*b;
+		cov[3] += g*g;
+		cov[4] += g*b;
+		cov[5] += b*b;
+	}
+	//Power iteration towards the principal axis
+	float axis[3] = {1, 1, 1};
+	for(int iter=0; iter<4; iter++)
+	{
+		float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+		float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+		float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+		float m = fabs(x) > fabs(y) ? fabs(x) : fabs(y);
+		if(fabs(z) > m) m = fabs(z);
+		//All one colour, or near enough
+		if(m < 1e-3f) break;
+		axis[0] = x / m;
+		axis[1] = y / m;
+		axis[2] = z / m;
+	}
+	float lo = 1e30f, hi = -1e30f;
+	int loTexel = 0, hiTexel = 0;
+	for(int i=0; i<16; i++)
+	{
+		if(px.transparent & (1u << i)) continue;
+		float d = px.channel[0][i]*axis[0] + px.channel[1][i]*axis[1] + px.channel[2][i]*axis[2];
+		if(d < lo) {lo = d; loTexel = i;}
+		if(d > hi) {hi = d; hiTexel = i;}
+	}
+	for(int k=0; k<3; k++)
+	{
+		e0[k] = px.channel[k][hiTexel];
+		e1[k] = px.channel[k][loTexel];
+	}
+}
+
+static int clampByte(float f)
+{
+	int i = (int)floor(f + 0.5f);
+	return i < 0 ? 0 : i > 255 ? 255 : i;
+}
+
+//The endpoints that, with these indices, leave the least squared error.
+//False if the indices don't pin them down.
+static bool refineEndpoints(const BlockPixels& px, const ColorFit& fit, bool fourColor, int* c0, int* c1)
+{
+	//How much of c0 each index is
+	static const float FOUR[4] = {1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f};
+	static const float THREE[4] = {1.0f, 0.0f, 0.5f, 0.0f};
+	const float* weight = fourColor ? FOUR : THREE;
+	float aa = 0, bb = 0, ab = 0;
+	float ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+	for(int i=0; i<16; i++)
+	{
+		int index = (fit.indices >> (i*2)) & 3;
+		if(!fourColor && index == 3) continue;
+		float a = weight[index], b = 1.0f - a;
+		aa += a*a;
+		bb += b*b;
+		ab += a*b;
+		for(int k=0; k<3; k++)
+		{
+			ax[k] += a*px.channel[k][i];
+			bx[k] += b*px.channel[k][i];
+		}
+	}
+	float det = aa*bb - ab*ab;
+	if(fabs(det) < 1e-6f) return false;
+	int e0[3], e1[3];
+	for(int k=0; k<3; k++)
+	{
+		e0[k] = clampByte((ax[k]*bb - bx[k]*ab) / det);
+		e1[k] = clampByte((bx[k]*aa - ax[k]*ab) / det);
+	}
+	*c0 = to565(e0[0], e0[1], e0[2]);
+	*c1 = to565(e1[0], e1[1], e1[2]);
+	return true;
+}
+
+static void encodeColor(const unsigned char rgba[64], Quality q, bool bc3, unsigned char out[8])
+{
+	BlockPixels px;
+	px.transparent = 0;
+	for(int i=0; i<16; i++)
+	{
+		for(int k=0; k<3; k++)
+			px.channel[k][i] = rgba[i*4 + k];
+		if(!bc3 && rgba[i*4 + 3] < 128) px.transparent |= 1u << i;
+	}
+
+	ColorFit best;
+	best.error = 0x7fffffff;
+	bool threeColor = px.transparent != 0;
+	if(px.transparent == 0xffff)
+	{
+		best.c0 = best.c1 = 0;
+		best.indices = 0xffffffff;
+	}
+	else
+	{
+		int e0[3], e1[3];
+		if(q == FAST) boxEndpoints(px, e0, e1);
+		else lineEndpoints(px, e0, e1);
+		int c0 = to565(e0[0], e0[1], e0[2]), c1 = to565(e1[0], e1[1], e1[2]);
+		tryEndpoints(px, c0, c1, threeColor, bc3, &best);
+		//With nothing transparent, three-colour mode is one more thing to try
+		if(q == HIGH && !bc3 && !threeColor) tryEndpoints(px, c0, c1, true, bc3, &best);
+
+		int refines = q == FAST ? 0 : q == NORMAL ? 1 : HIGH_REFINES;
+		for(int r=0; r<refines && best.error > 0; r++)
+		{
+			int error = best.error;
+			bool fourColor = bc3 || best.c0 > best.c1;
+			if(!refineEndpoints(px, best, fourColor, &c0, &c1)) break;
+			tryEndpoints(px, c0, c1, !fourColor, bc3, &best);
+			if(best.error >= error) break;
+		}
+	}
+	out[0] = (unsigned char)best.c0;
+	out[1] = (unsigned char)(best.c0 >> 8);
+	out[2] = (unsigned char)best.c1;
+	out[3] = (unsigned char)(best.c1 >> 8);
+	for(int i=0; i<4; i++)
+		out[4 + i] = (unsigned char)(best.indices >> (i*8));
+}
+
+void encodeBC1Block(const unsigned char rgba[64], Quality q, unsigned char out[8])
+{
+	encodeColor(rgba, q, false, out);
+}
+
+void encodeBC3Block(const unsigned char rgba[64], Quality q, unsigned char out[16])
+{
+	unsigned char alpha[16];
+	for(int i=0; i<16; i++)
+		alpha[i] = rgba[i*4 + 3];
+	encodeBC4Block(alpha, q, out);
+	encodeColor(rgba, q, true, out + 8);
+}
+
+//Eight values between a0 and a1 if a0 > a1; otherwise six, then 0 and 255
+static void valuePalette(int a0, int a1, int pal[8])
+{
+	pal[0] = a0;
+	pal[1] = a1;
+	if(a0 > a1)
+	{
+		for(int i=2; i<8; i++)
+			pal[i] = ((8 - i)*a0 + (i - 1)*a1 + 3) / 7;
+	}
+	else
+	{
+		for(int i=2; i<6; i++)
+			pal[i] = ((6 - i)*a0 + (i - 1)*a1 + 2) / 5;
+		pal[6] = 0;
+		pal[7] = 255;
+	}
+}
+
+//Nearest palette entry for each value, three bits each, and the summed
+//squared error
+static int fitValues(const unsigned char values[16], int a0, int a1, unsigned long long* indices)
+{
+	int pal[8];
+	valuePalette(a0, a1, pal);
+	int error = 0;
+	unsigned long long bits = 0;
+	for(int i=0; i<16; i++)
+	{
+		int best = 0x7fffffff, index = 0;
+		for(int j=0; j<8; j++)
+		{
+			int d = values[i] - pal[j];
+			if(d*d < best)
+			{
+				best = d*d;
+				index = j;
+			}
+		}
+		error += best;
+		bits |= (unsigned long long)index << (i*3);
+	}
+	*indices = bits;
+	return error;
+}
+
+void encodeBC4Block(const unsigned char values[16], Quality q, unsigned char out[8])
+{
+	int lo = 255, hi = 0;
+	//The same without the 0s and 255s six-value mode has for free
+	int innerLo = 255, innerHi = 0;
+	for(int i=0; i<16; i++)
+	{
+		int v = values[i];
+		if(v < lo) lo = v;
+		if(v > hi) hi = v;
+		if(v != 0 && v != 255)
+		{
+			if(v < innerLo) innerLo = v;
+			if(v > innerHi) innerHi = v;
+		}
+	}
+
+	int a0 = hi, a1 = lo;
+	unsigned long long indices = 0;
+	if(hi == lo)
+	{
+		//Six-value mode, everything the first
+	}
+	else if(q == FAST)
+	{
+		//Straight to the nearest of eight evenly spaced steps
+		int range = hi - lo;
+		for(int i=0; i<16; i++)
+		{
+			int t = ((values[i] - lo)*14 + range) / (2*range);
+			int index = t == 7 ? 0 : t == 0 ? 1 : 8 - t;
+			indices |= (unsigned long long)index << (i*3);
+		}
+	}
+	else
+	{
+		int error = fitValues(values, a0, a1, &indices);
+		if(innerLo <= innerHi && (innerLo != lo || innerHi != hi))
+		{
+			unsigned long long six;
+			int sixError = fitValues(values, innerLo, innerHi, &six);
+			if(sixError < error)
+			{
+				error = sixError;
+				a0 = innerLo;
+				a1 = innerHi;
+				indices = six;
+			}
+		}
+		//Ends a little inside the range often fit the rest better
+		if(q == HIGH && error > 0)
+		{
+			for(int d0=0; d0<4; d0++)
+				for(int d1=0; d1<4; d1++)
+				{
+					int t0 = hi - d0, t1 = lo + d1;
+					if(t0 <= t1 || (d0 == 0 && d1 == 0)) continue;
+					unsigned long long bits;
+					int e = fitValues(values, t0, t1, &bits);
+					if(e < error)
+					{
+						error = e;
+						a0 = t0;
+						a1 = t1;
+						indices = bits;
+					}
+				}
+		}
+	}
+	out[0] = (unsigned char)a0;
+	out[1] = (unsigned char)a1;
+	for(int i=0; i<6; i++)
+		out[2 + i] = (unsigned char)(indices >> (i*8));
+}
+
+static void decodeColor(const unsigned char in[8], bool bc3, unsigned char rgba[64])
+{
+	int c0 = in[0] | (in[1] << 8), c1 = in[2] | (in[3] << 8);
+	int pal[4][3];
+	bool fourColor = bc3 || c0 > c1;
+	colorPalette(c0, c1, fourColor, pal);
+	unsigned int indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((unsigned int)in[7] << 24);
+	for(int i=0; i<16; i++)
+	{
+		int index = (indices >> (i*2)) & 3;
+		for(int k=0; k<3; k++)
+			rgba[i*4 + k] = (unsigned char)pal[index][k];
+		rgba[i*4 + 3] = !fourColor && index == 3 ? 0 : 255;
+	}
+}
+
+void decodeBC1Block(const unsigned char in[8], unsigned char rgba[64])
+{
+	decodeColor(in, false, rgba);
+}
+
+void decodeBC2Block(const unsigned char in[16], unsigned char rgba[64])
+{
+	decodeColor(in + 8, true, rgba);
+	for(int i=0; i<16; i++)
+		rgba[i*4 + 3] = (unsigned char)(((in[i/2] >> ((i & 1)*4)) & 15) * 17);
+}
+
+void decodeBC3Block(const unsigned char in[16], unsigned char rgba[64])
+{
+	decodeColor(in + 8, true, rgba);
+	unsigned char alpha[16];
+	decodeBC4Block(in, alpha);
+	for(int i=0; i<16; i++)
+		rgba[i*4 + 3] = alpha[i];
+}
+
+void decodeBC4Block(const unsigned char in[8], unsigned char values[16])
+{
+	int pal[8];
+	valuePalette(in[0], in[1], pal);
+	unsigned long long indices = 0;
+	for(int i=0; i<6; i++)
+		indices |= (unsigned long long)in[2 + i] << (i*8);
+	for(int i=0; i<16; i++)
+		values[i] = (unsigned char)pal[(indices >> (i*3)) & 7];
+}
+
+//One level's worth of work for the job system
+struct CompressJob
+{
+	const unsigned char* src;
+	int width, height;
+	unsigned char* dst;
+	int blocksW;
+	Format format;
+	Quality quality;
+};
+
+static void compressRows(void* data, int begin, int end)
+{
+	const CompressJob& job = *(const CompressJob*)data;
+	int blockBytes = TextureData::unitSize(job.format);
+	for(int by=begin; by<end; by++)
+	{
+		for(int bx=0; bx<job.blocksW; bx++)
+		{
+			//Past the edge of a small level the last row and column repeat
+			unsigned char rgba[64];
+			for(int y=0; y<4; y++)
+			{
+				int sy = by*4 + y < job.height ? by*4 + y : job.height - 1;
+				for(int x=0; x<4; x++)
+				{
+					int sx = bx*4 + x < job.width ? bx*4 + x : job.width - 1;
+					memcpy(&rgba[(y*4 + x)*4], job.src + ((size_t)sy*job.width + sx)*4, 4);
+				}
+			}
+			unsigned char* out = job.dst + ((size_t)by*job.blocksW + bx)*blockBytes;
+			if(job.format == BC1) encodeBC1Block(rgba, job.quality, out);
+			else if(job.format == BC3) encodeBC3Block(rgba, job.quality, out);
+			else
+			{
+				unsigned char red[16];
+				for(int i=0; i<16; i++)
+					red[i] = rgba[i*4];
+				encodeBC4Block(red, job.quality, out);
+			}
+		}
+	}
+}
+
+bool compressTexture(const TextureData& rgba, Format format, Quality q, TextureData* out)
+{
+	if(rgba.isCompressed() || (format != BC1 && format != BC3 && format != BC4)) return false;
+	if(rgba.width % BLOCK_SIZE || rgba.height % BLOCK_SIZE) return false;
+	out->allocate(rgba.width, rgba.height, rgba.mipLevels, format);
+	for(int level=0; level<rgba.mipLevels; level++)
+	{
+		CompressJob job;
+		job.src = rgba.getMip(level);
+		job.width = rgba.getMipWidth(level);
+		job.height = rgba.getMipHeight(level);
+		job.dst = out->getMip(level);
+		job.blocksW = (job.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		job.format = format;
+		job.quality = q;
+		int blocksH = (job.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		JobSystem::parallelFor(blocksH, ROW_GRAIN, compressRows, &job);
+	}
+	return true;
+}
+
+void decompressTexture(const TextureData& in, TextureData* rgba)
+{
+	rgba->allocate(in.width, in.height, in.mipLevels, RGBA8);
+	for(int level=0; level<in.mipLevels; level++)
+	{
+		int w = in.getMipWidth(level), h = in.getMipHeight(level);
+		const unsigned char* src = in.getMip(level);
+		unsigned char* dst = rgba->getMip(level);
+		if(!in.isCompressed())
+		{
+			memcpy(dst, src, in.getMipSize(level));
+			continue;
+		}
+		int blocksW = (w + BLOCK_SIZE - 1) / BLOCK_SIZE, blocksH = (h + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		int blockBytes = TextureData::unitSize(in.format);
+		for(int by=0; by<blocksH; by++)
+			for(int bx=0; bx<blocksW; bx++)
+			{
+				const unsigned char* block = src + (by*blocksW + bx)*blockBytes;
+				unsigned char texels[64];
+				switch(in.format)
+				{
+				case BC1: decodeBC1Block(block, texels); break;
+				case BC2: decodeBC2Block(block, texels); break;
+				case BC3: decodeBC3Block(block, texels); break;
+				default:
+					{
+						unsigned char red[16];
+						decodeBC4Block(block, red);
+						for(int i=0; i<16; i++)
+						{
+							texels[i*4] = red[i];
+							texels[i*4 + 1] = texels[i*4 + 2] = 0;
+							texels[i*4 + 3] = 255;
+						}
+					}
+				}
+				for(int y=0; y<4 && by*4 + y < h; y++)
+					for(int x=0; x<4 && bx*4 + x < w; x++)
+						memcpy(dst + ((size_t)(by*4 + y)*w + bx*4 + x)*4, &texels[(y*4 + x)*4], 4);
+			}
+	}
+}
+
+double computePsnr(const TextureData& a, const TextureData& b, int level, int first, int numChannels)
+{
+	const unsigned char* pa = a.getMip(level);
+	const unsigned char* pb = b.getMip(level);
+	int texels = a.getMipWidth(level)*a.getMipHeight(level);
+	double sum = 0;
+	for(int i=0; i<texels; i++)
+		for(int k=first; k<first + numChannels; k++)
+		{
+			int d = pa[i*4 + k] - pb[i*4 + k];
+			sum += d*d;
+		}
+	if(sum == 0) return 99.0;
+	double mse = sum / ((double)texels*numChannels);
+	return 10.0*log10(255.0*255.0 / mse);
+}
@@ -0,0 +1,47 @@
+#ifndef BLOCK_COMPRESSOR_H
+#define BLOCK_COMPRESSOR_H
+
+#include "TextureData.h"
+
+//SSE2 is always there on x64 and MSVC has the intrinsics on x86 too; anything
+//else gets the plain loop, which gives the same answers
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define BLOCK_SSE2
+#endif
+
+namespace blockCompressNS {
+	//FAST takes the corners of the colours' bounding box. NORMAL fits a line
+	//through them and refines its ends once; HIGH refines until it stops
+	//helping and tries more endpoints for BC4.
+	enum Quality {FAST, NORMAL, HIGH, NUM_QUALITIES};
+	//Least-squares passes HIGH makes at most
+	const int HIGH_REFINES = 8;
+	//Block rows a job compresses
+	const int ROW_GRAIN = 4;
+}
+
+//A 4x4 block is 64 bytes of RGBA, row by row. For BC1, texels with alpha
+//under 128 come out transparent; BC3's colour ignores alpha.
+void encodeBC1Block(const unsigned char rgba[64], blockCompressNS::Quality q, unsigned char out[8]);
+void encodeBC3Block(const unsigned char rgba[64], blockCompressNS::Quality q, unsigned char out[16]);
+//16 values of one channel
+void encodeBC4Block(const unsigned char values[16], blockCompressNS::Quality q, unsigned char out[8]);
+
+void decodeBC1Block(const unsigned char in[8], unsigned char rgba[64]);
+void decodeBC2Block(const unsigned char in[16], unsigned char rgba[64]);
+void decodeBC3Block(const unsigned char in[16], unsigned char rgba[64]);
+void decodeBC4Block(const unsigned char in[8], unsigned char values[16]);
+
+//Every mip level of an RGBA8 texture into format, whose top level has to be
+//a multiple of 4 across and down. BC4 keeps the red channel. Block rows are
+//shared out over the job system.
+bool compressTexture(const TextureData& rgba, textureDataNS::Format format, blockCompressNS::Quality q, TextureData* out);
+//Any texture back to RGBA8, every level; BC4 comes back as red with opaque alpha
+void decompressTexture(const TextureData& in, TextureData* rgba);
+
+//Peak signal-to-noise ratio in dB of b against a, over numChannels channels
+//from first on, at one level of two RGBA8 textures the same size. 99 when
+//they're the same.
+double computePsnr(const TextureData& a, const TextureData& b, int level, int first, int numChannels);
+
+#endif
@@ -4,22 +4,24 @@
 
 #include "Box.h"
 #include "Vertex.h"
+#include "PerfStats.h"
 
 Box::Box()
-: md3dDevice(0), mVB(0), mIB(0)
+: md3dDevice(0), mCube(0), mfxBoxColorVar(0), mfxBoxScaleVar(0)
 {
 	diffuse = D3DXCOLOR(1,1,1,1);
 	spec = D3DXCOLOR(1,1,1,1);
+	mScale = 1.0f;
 	mNumVertices = 24;
 	mNumFaces    = 12; // 2 per quad
 }
  
 Box::~Box()
 {
-	ReleaseCOM(mVB);
-	ReleaseCOM(mIB);
 }
 
+//The cube's buffers are the cache's; all a Box has of its own is its colour,
+//which every vertex is drawn in, and its size
 void Box::init(ID3D10Device* device, float scale, D3DXCOLOR c, ID3D10Effect* mFX)
 {
 	Box::mFX = mFX;
@@ -27,111 +29,12 @@ void Box::init(ID3D10Device* device, float scale, D3DXCOLOR c, ID3D10Effect* mFX
 	boxColor = Vector3(c.r,c.g,c.b);
 	md3dDevice = device;
 
-
-	mNumVertices = 24;
-	mNumFaces    = 12; // 2 per quad
-	D3DXCOLOR diffuse = c;
-	D3DXCOLOR spec = c;
-	//D3DXCOLOR diffuse(0.5,0.5,1,1);
-
-	// Create vertex buffer
-    Vertex vertices[] =
-    {
-		//front - 0 1 2 3
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-
-		//left - 7 6 1 0
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-
-		//back - 4 5 6 7
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-
-		//right - 3 2 5 4 
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-
-		//top - 1 6 5 2
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-
-		//bottom - 7 0 3 4
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-    };
-
-	// Scale the box.
-	for(DWORD i = 0; i < mNumVertices; ++i)
-		vertices[i].pos *= scale;
-
-
-    D3D10_BUFFER_DESC vbd;
-    vbd.Usage = D3D10_USAGE_IMMUTABLE;
-    vbd.ByteWidth = sizeof(Vertex) * mNumVertices;
-    vbd.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-    vbd.CPUAccessFlags = 0;
-    vbd.MiscFlags = 0;
-    D3D10_SUBRESOURCE_DATA vinitData;
-    vinitData.pSysMem = vertices;
-    HR(md3dDevice->CreateBuffer(&vbd, &vinitData, &mVB));
-
-	DWORD indices[] = {
-		//front
-		//0, 1, 2,
-		//0, 2, 3,
-		0, 1, 2,
-		3, 2, 0,
-		//left
-		//4, 5, 6,
-		//4, 6, 7,
-		4, 5, 6,
-		7, 6, 4,
-		//back
-		//8, 9, 10,
-		//8, 10, 11,
-		8, 9, 10,
-		11, 10, 8,
-		//right
-		//12, 13, 14,
-		//12, 14, 15,
-		12, 13, 14,
-		15, 14, 12,
-		//top
-		//16, 17, 18,
-		//16, 18, 19,
-		16, 17, 18,
-		19, 18, 16,
-		//bottom
-		//20, 21, 22,
-		//20, 22, 23
-		20, 21, 22,
-		23, 22, 20
-	};
-
-	D3D10_BUFFER_DESC ibd;
-    ibd.Usage = D3D10_USAGE_IMMUTABLE;
-    ibd.ByteWidth = sizeof(DWORD) * mNumFaces*3;
-    ibd.BindFlags = D3D10_BIND_INDEX_BUFFER;
-    ibd.CPUAccessFlags = 0;
-    ibd.MiscFlags = 0;
-    D3D10_SUBRESOURCE_DATA iinitData;
-    iinitData.pSysMem = indices;
-    HR(md3dDevice->CreateBuffer(&ibd, &iinitData, &mIB));
+	diffuse = c;
+	spec = c;
+	mScale = scale;
+	mCube = GetMeshCache().getCube(meshCacheNS::COLORED_CUBE);
 }
+
 void Box::init(ID3D10Device* device, float scale, ID3D10Effect* mFX)
 {
 	Box::mFX = mFX;
@@ -139,102 +42,63 @@ void Box::init(ID3D10Device* device, float scale, ID3D10Effect* mFX)
 	boxColor = Vector3(1,1,1);
 	md3dDevice = device;
 
-    Vertex vertices[] =
-    {
-		//front - 0 1 2 3
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-
-		//left - 7 6 1 0
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-
-		//back - 4 5 6 7
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-
-		//right - 3 2 5 4 
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), D3DXVECTOR3(1.0f, 0.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-
-		//top - 1 6 5 2
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-
-		//bottom - 7 0 3 4
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 0.0)),
-		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 0.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(0.0, 1.0)),
-		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f), diffuse, spec, D3DXVECTOR2(1.0, 1.0)),
-    };
-
-
-	// Scale the box.
-	for(DWORD i = 0; i < mNumVertices; ++i)
-		vertices[i].pos *= scale;
-
+	mScale = scale;
+	mCube = GetMeshCache().getCube(meshCacheNS::PLAIN_CUBE);
+}
 
-    D3D10_BUFFER_DESC vbd;
-    vbd.Usage = D3D10_USAGE_IMMUTABLE;
-    vbd.ByteWidth = sizeof(Vertex) * mNumVertices;
-    vbd.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-    vbd.CPUAccessFlags = 0;
-    vbd.MiscFlags = 0;
-    D3D10_SUBRESOURCE_DATA vinitData;
-    vinitData.pSysMem = vertices;
-    HR(md3dDevice->CreateBuffer(&vbd, &vinitData, &mVB));
+void Box::setDrawVars()
+{
+	mfxBoxColorVar->SetRawValue(&diffuse, 0, sizeof(D3DXCOLOR));
+	mfxBoxScaleVar->SetFloat(mScale);
+}
 
+void Box::clearDrawVars()
+{
+	D3DXCOLOR white(1.0f, 1.0f, 1.0f, 1.0f);
+	mfxBoxColorVar->SetRawValue(&white, 0, sizeof(D3DXCOLOR));
+	mfxBoxScaleVar->SetFloat(1.0f);
+}
 
-	// Create the index buffer
+static bool sameColor(const D3DXCOLOR& a, const D3DXCOLOR& b)
+{
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
 
-	DWORD indices[] = {
-		//front
-		0, 1, 2, 
-		0, 2, 3,
-		//left
-		4, 5, 6,
-		4, 6, 7,
-		//back
-		8, 9, 10,
-		8, 10, 11,
-		//right
-		12, 13, 14,
-		13, 14, 15,
-		//top
-		16, 17, 18,
-		16, 18, 19,
-		//bottom
-		20, 21, 22,
-		20, 22, 23
-	};
+bool Box::colorsLike(const Box& other) const
+{
+	return sameColor(diffuse, other.diffuse) && sameColor(spec, other.spec);
+}
 
-	D3D10_BUFFER_DESC ibd;
-    ibd.Usage = D3D10_USAGE_IMMUTABLE;
-    ibd.ByteWidth = sizeof(DWORD) * mNumFaces*3;
-    ibd.BindFlags = D3D10_BIND_INDEX_BUFFER;
-    ibd.CPUAccessFlags = 0;
-    ibd.MiscFlags = 0;
-    D3D10_SUBRESOURCE_DATA iinitData;
-    iinitData.pSysMem = indices;
-    HR(md3dDevice->CreateBuffer(&ibd, &iinitData, &mIB));
+bool Box::drawsLike(const Box& other) const
+{
+	return mScale == other.mScale && colorsLike(other);
 }
 
 void Box::draw()
 {
-	UINT stride = sizeof(Vertex);
+	UINT stride = sizeof(PackedVertex);
     UINT offset = 0;
 	md3dDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-    md3dDevice->IASetVertexBuffers(0, 1, &mVB, &stride, &offset);
-	md3dDevice->IASetIndexBuffer(mIB, DXGI_FORMAT_R32_UINT, 0);
+    md3dDevice->IASetVertexBuffers(0, 1, &mCube->vb, &stride, &offset);
+	md3dDevice->IASetIndexBuffer(mCube->ib, DXGI_FORMAT_R16_UINT, 0);
 	md3dDevice->DrawIndexed(mNumFaces*3, 0, 0);
-}
\ No newline at end of file
+	PERF_COUNT(PERF_BUFFER_BINDS);
+	PERF_COUNT(PERF_DRAW_CALLS);
+}
+
+void Box::bindInstanced(ID3D10Buffer* instances, UINT stride)
+{
+	ID3D10Buffer* buffers[2] = {mCube->vb, instances};
+	UINT strides[2] = {sizeof(PackedVertex), stride};
+	UINT offsets[2] = {0, 0};
+	md3dDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	md3dDevice->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+	md3dDevice->IASetIndexBuffer(mCube->ib, DXGI_FORMAT_R16_UINT, 0);
+	PERF_COUNT(PERF_BUFFER_BINDS);
+}
+
+void Box::drawInstanced(UINT count, UINT start)
+{
+	md3dDevice->DrawIndexedInstanced(mNumFaces*3, count, 0, 0, start);
+	PERF_COUNT(PERF_DRAW_CALLS);
+}
@@ -7,6 +7,7 @@
 
 #include "d3dUtil.h"
 #include "constants.h"
+#include "MeshCache.h"
 
 class Box
 {
@@ -17,18 +18,36 @@ public:
 
 	void init(ID3D10Device* device, float scale, ID3D10Effect* mFX);
 	void init(ID3D10Device* device, float scale, D3DXCOLOR c, ID3D10Effect* mFX);
+	//Puts the colour and size in the effect; call before the pass is applied
+	void setDrawVars();
+	//Back to white and 1, for whatever draws next with colours of its own
+	void clearDrawVars();
+	//Same colour and size, so the effect needn't be set again between them
+	bool drawsLike(const Box& other) const;
+	bool colorsLike(const Box& other) const;
 	void draw();
+	//Binds the cube with the instance buffer in slot 1, for drawInstanced
+	void bindInstanced(ID3D10Buffer* instances, UINT stride);
+	//count instances from the bound buffer, starting at instance start
+	void drawInstanced(UINT count, UINT start);
 
 	void pullInVariables() {
 		mfxCubeColorVar	= mFX->GetVariableByName("gCubeColor");
 		mfxGlow			= mFX->GetVariableByName("gGlow")->AsScalar();
+		mfxBoxColorVar	= mFX->GetVariableByName("gBoxColor");
+		mfxBoxScaleVar	= mFX->GetVariableByName("gBoxScale")->AsScalar();
 	}
 
 	Vector3  getColor() {return boxColor;}
+	float getScale() {return mScale;}
+	//The colour it draws in, which multiplies the cube's white vertices
+	D3DXCOLOR getDiffuse() {return diffuse;}
+	D3DXCOLOR getSpec() {return spec;}
 	ID3D10EffectScalarVariable* getGlowVar() {return mfxGlow;}
 	ID3D10EffectVariable* getCubeColorVar() {return mfxCubeColorVar;}
 	ID3D10Effect* getMFX() {return mFX;}
 	ID3D10Device* getDevice() {return md3dDevice;}
+	const CubeMesh* getCube() {return mCube;}
 
 private:
 	DWORD mNumVertices;
@@ -38,11 +57,13 @@ private:
 
 	D3DXCOLOR diffuse;
 	D3DXCOLOR spec;
+	float mScale;
 	ID3D10Device* md3dDevice;
-	ID3D10Buffer* mVB;
-	ID3D10Buffer* mIB;
+	const CubeMesh* mCube;
 	ID3D10EffectScalarVariable* mfxGlow;
 	ID3D10EffectVariable* mfxCubeColorVar;
+	ID3D10EffectVariable* mfxBoxColorVar;
+	ID3D10EffectScalarVariable* mfxBoxScaleVar;
 	ID3D10Effect* mFX;
 };
 
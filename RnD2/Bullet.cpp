@@ -26,19 +26,11 @@ void Bullet::init(Box* b, float r, Vector3 pos, Vector3 vel, float sp, float s)
 	active = false;
 }
 
-void Bullet::draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectTechnique* mTech, Matrix* mVP)
+void Bullet::draw(SimRenderer* renderer)
 {
 	if (!active)
 		return;
-	Matrix mWVP = world* (*mVP);
-	mfxWVPVar->SetMatrix((float*)&mWVP);
-    D3D10_TECHNIQUE_DESC techDesc;
-    mTech->GetDesc( &techDesc );
-    for(UINT p = 0; p < techDesc.Passes; ++p)
-    {
-        mTech->GetPassByIndex( p )->Apply(0);
-        box->draw();
-    }
+	renderer->drawMesh(box, getInterpolatedWorld(renderer->getInterpolation()), false);
 }
 
 void Bullet::update(float dt)
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "gameobject.h"
+#include "GameObject.h"
 
 namespace bulletNS {
 	const int SPEED = 300;
@@ -14,7 +14,7 @@ public:
 	~Bullet(void);
 
 	void init(Box* b, float r, Vector3 pos, Vector3 vel, float sp, float s);
-	void draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectTechnique* mTech, Matrix* mVP);
+	void draw(SimRenderer* renderer);
 	void update(float dt);
 	float getMass(){return mass;}
 	void setActive() {
@@ -22,13 +22,29 @@ Camera::~Camera()
 	//nothing to deallocate
 }
 
-void Camera::init(Input* input, Vector3 position, Vector3 direction, Vector3 _lookAt)
+void Camera::init(SimInput* input, Vector3 position, Vector3 direction, Vector3 _lookAt)
 {
 	Camera::position = position;
 	Camera::input = input;
 	setPerspective();
 	//Generate an initial view matrix
 	D3DXMatrixLookAtLH(&mView, &position, &lookAt, &up);
+	savePrevious();
+}
+
+void Camera::savePrevious()
+{
+	prevPosition = position;
+	prevLookAt = lookAt;
+}
+
+Matrix Camera::getInterpolatedViewMatrix(float alpha)
+{
+	Vector3 eye = prevPosition + (position - prevPosition) * alpha;
+	Vector3 at = prevLookAt + (lookAt - prevLookAt) * alpha;
+	Matrix view;
+	D3DXMatrixLookAtLH(&view, &eye, &at, &up);
+	return view;
 }
 
 void Camera::setPerspective()
@@ -52,11 +68,14 @@ void Camera::transformToWorld(Vector3 position, Vector3 axis) {
 	D3DXMatrixRotationY(&yawR, yaw);
 	D3DXMatrixRotationZ(&pitchR, pitch);
 
-	Transform(&transformedReference, &transformedReference, &(pitchR * yawR));
+	Matrix pitchYaw = pitchR * yawR;
+	Transform(&transformedReference, &transformedReference, &pitchYaw);
 	D3DXVec3Normalize(&transformedReference, &transformedReference);
 	lookAt = transformedReference * 40;
 	lookAt += position;
 	D3DXMatrixLookAtLH(&mView, &position, &lookAt, &up);
+	//A jump, not movement, so don't draw anything in between
+	savePrevious();
 }
 
 void Camera::transformToMenu() {
@@ -73,11 +92,14 @@ void Camera::transformToMenu() {
 	D3DXMatrixRotationY(&yawR, yaw);
 	D3DXMatrixRotationZ(&pitchR, pitch);
 
-	Transform(&transformedReference, &transformedReference, &(pitchR * yawR));
+	Matrix pitchYaw = pitchR * yawR;
+	Transform(&transformedReference, &transformedReference, &pitchYaw);
 	D3DXVec3Normalize(&transformedReference, &transformedReference);
 	lookAt = transformedReference * 40;
 	lookAt += position;
 	D3DXMatrixLookAtLH(&mView, &position, &lookAt, &up);
+	//A jump, not movement, so don't draw anything in between
+	savePrevious();
 }
 
 void Camera::update(float dt, float playerSpeeed, bool* walking)
@@ -176,7 +198,8 @@ void Camera::update(float dt, float playerSpeeed, bool* walking)
 	//Update LookAt
 	if (rotated)
 	{
-		Transform(&transformedReference, &transformedReference, &(pitchR * yawR));
+		Matrix pitchYaw = pitchR * yawR;
+		Transform(&transformedReference, &transformedReference, &pitchYaw);
 		D3DXVec3Normalize(&transformedReference, &transformedReference);
 		lookAt = transformedReference * playerSpeed;
 		lookAt += position;
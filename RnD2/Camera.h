@@ -2,20 +2,20 @@
 #define _CAMERA_H 
 
 #include "constants.h"
-#include "d3dUtil.h"
-#include "d3dApp.h"
-#include <d3dx9math.h>
-#include "input.h"
+#include "SimInput.h"
 
 class Camera
 {
 public:
 	Camera();
 	~Camera();
-	void init(Input* input, Vector3 position, Vector3 direction, Vector3 _lookAt);
+	void init(SimInput* input, Vector3 position, Vector3 direction, Vector3 _lookAt);
 	void update(float dt, float playerSpeeed, bool* walking);
 
 	Matrix getViewMatrix() {return mView;}
+	//For drawing between fixed simulation steps: call savePrevious before each step
+	void savePrevious();
+	Matrix getInterpolatedViewMatrix(float alpha);
 	Matrix getProjectionMatrix() {return mProj;}
 	
 	void setPosition(Vector3 pos) {position = pos;}
@@ -57,7 +57,9 @@ private:
 	bool fly;
 	bool fall;
 	Vector3 oldLook;
+	Vector3 prevPosition;
+	Vector3 prevLookAt;
 
-	Input* input;
+	SimInput* input;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,386 @@
+#include "D3DRenderer.h"
+#include "PerfStats.h"
+#include <cstring>
+#include <sstream>
+
+D3DRenderer::D3DRenderer()
+: mTech(0), mfxWVPVar(0), mfxWorldVar(0), mfxGlow(0), mfxCubeColorVar(0),
+  mfxDiffuseMapVar(0), mfxSpecMapVar(0), mfxMaterialMapsVar(0), mfxMaterialSliceVar(0),
+  mfxBoxColorVar(0), mfxBoxScaleVar(0), materialSlice(materialNS::NO_SLICE),
+  instancing(false), md3dDevice(0), mInstancedTech(0), mfxViewProjVar(0),
+  mInstancedLayout(0), mLayout(0), mInstanceVB(0), instanceCapacity(0),
+  staticReused(0), staticCreated(0)
+{
+	Identity(&mVP);
+	for(int i=0; i<NUM_MATERIALS; i++)
+	{
+		diffuseMaps[i] = textureMgrNS::NO_TEXTURE;
+		specMaps[i] = textureMgrNS::NO_TEXTURE;
+	}
+	batcher.setMaterialTable(&materials);
+}
+
+D3DRenderer::~D3DRenderer()
+{
+	ReleaseCOM(mInstancedLayout);
+	ReleaseCOM(mInstanceVB);
+	for(unsigned int i=0; i<staticBuffers.size(); i++)
+		releaseStatic(staticBuffers[i]);
+}
+
+void D3DRenderer::init(ID3D10Effect* fx, ID3D10EffectTechnique* tech)
+{
+	mTech = tech;
+	mfxWVPVar			= fx->GetVariableByName("gWVP")->AsMatrix();
+	mfxWorldVar			= fx->GetVariableByName("gWorld")->AsMatrix();
+	mfxGlow				= fx->GetVariableByName("gGlow")->AsScalar();
+	mfxCubeColorVar		= fx->GetVariableByName("gCubeColor");
+	mfxDiffuseMapVar	= fx->GetVariableByName("gDiffuseMap")->AsShaderResource();
+	mfxSpecMapVar		= fx->GetVariableByName("gSpecMap")->AsShaderResource();
+	mfxMaterialMapsVar	= fx->GetVariableByName("gMaterialMaps")->AsShaderResource();
+	mfxMaterialSliceVar	= fx->GetVariableByName("gMaterialSlice")->AsScalar();
+	mfxBoxColorVar		= fx->GetVariableByName("gBoxColor");
+	mfxBoxScaleVar		= fx->GetVariableByName("gBoxScale")->AsScalar();
+}
+
+void D3DRenderer::initInstancing(ID3D10Device* device, ID3D10Effect* fx, ID3D10InputLayout* layout)
+{
+	md3dDevice = device;
+	mLayout = layout;
+	mInstancedTech = fx->GetTechniqueByName("InstancedTech");
+	mfxViewProjVar = fx->GetVariableByName("gViewProj")->AsMatrix();
+
+	//The PackedVertex from slot 0, then an InstanceData from slot 1 per instance
+	D3D10_INPUT_ELEMENT_DESC vertexDesc[] =
+	{
+		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"NORMAL",   0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"DIFFUSE",  0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 20, D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"WORLD",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0,  D3D10_INPUT_PER_INSTANCE_DATA, 1},
+		{"WORLD",    1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D10_INPUT_PER_INSTANCE_DATA, 1},
+		{"WORLD",    2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D10_INPUT_PER_INSTANCE_DATA, 1},
+		{"WORLD",    3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D10_INPUT_PER_INSTANCE_DATA, 1},
+		{"GLOW",     0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 64, D3D10_INPUT_PER_INSTANCE_DATA, 1},
+		{"SLICE",    0, DXGI_FORMAT_R32_FLOAT, 1, 80, D3D10_INPUT_PER_INSTANCE_DATA, 1},
+	};
+	D3D10_PASS_DESC PassDesc;
+	mInstancedTech->GetPassByIndex(0)->GetDesc(&PassDesc);
+	HR(md3dDevice->CreateInputLayout(vertexDesc, 10, PassDesc.pIAInputSignature,
+		PassDesc.IAInputSignatureSize, &mInstancedLayout));
+}
+
+void D3DRenderer::setMaterialTextures(int material, TextureId diffuse, TextureId spec)
+{
+	diffuseMaps[material] = diffuse;
+	specMaps[material] = spec;
+}
+
+//Materials group by their diffuse map's layout in the pack and their spec map
+void D3DRenderer::buildMaterialArrays()
+{
+	TextureMgr& tm = GetTextureMgr();
+	materials.clear();
+	for(int i=0; i<NUM_MATERIALS; i++)
+	{
+		TextureData layout;
+		if (tm.getPackedLayout(diffuseMaps[i], &layout))
+			materials.setLayout(i, layout, specMaps[i]);
+	}
+	materials.build();
+
+	materialArrays.clear();
+	for(int a=0; a<materials.getArrayCount(); a++)
+	{
+		const vector<int>& slices = materials.getArrayMaterials(a);
+		TextureMgr::StringVector names;
+		for(unsigned int k=0; k<slices.size(); k++)
+			names.push_back(tm.getName(diffuseMaps[slices[k]]));
+		std::wostringstream name;
+		name << L"materials" << a;
+		materialArrays.push_back(tm.createTexArray(name.str(), names));
+	}
+	for(int i=0; i<NUM_MATERIALS; i++)
+	{
+		if (materials.getSlice(i) == materialNS::NO_SLICE && diffuseMaps[i] != textureMgrNS::NO_TEXTURE)
+			tm.loadTex(tm.getName(diffuseMaps[i]));
+	}
+}
+
+void D3DRenderer::bindTextures(TextureId diffuse, TextureId spec)
+{
+	mfxDiffuseMapVar->SetResource(GetTextureMgr().getTex(diffuse));
+	mfxSpecMapVar->SetResource(GetTextureMgr().getTex(spec));
+	materialSlice = materialNS::NO_SLICE;
+	PERF_COUNT_N(PERF_STATE_CHANGES, 2);
+}
+
+void D3DRenderer::setMaterial(int material)
+{
+	if (instancing) batcher.setMaterial(material);
+	else applyMaterial(material);
+}
+
+//A slice binds its whole array, so it holds for the rest of the group too
+void D3DRenderer::applyMaterial(int material)
+{
+	materialSlice = materials.getSlice(material);
+	if (materialSlice == materialNS::NO_SLICE)
+		mfxDiffuseMapVar->SetResource(GetTextureMgr().getTex(diffuseMaps[material]));
+	else mfxMaterialMapsVar->SetResource(materialArrays[materials.getGroup(material)]);
+	mfxSpecMapVar->SetResource(GetTextureMgr().getTex(specMaps[material]));
+	PERF_COUNT_N(PERF_STATE_CHANGES, 2);
+}
+
+void D3DRenderer::drawMesh(Box* mesh, const Matrix& world, bool glow)
+{
+	if (instancing) {
+		batcher.drawMesh(mesh, world, glow);
+		return;
+	}
+
+	if (glow) {
+		Vector3 color = mesh->getColor();
+		mfxGlow->SetInt(2);
+		mfxCubeColorVar->SetRawValue(&color, 0, sizeof(D3DXVECTOR3));
+	}
+	else mfxGlow->SetInt(0);
+
+	Matrix mWVP = world * mVP;
+	mfxWVPVar->SetMatrix((float*)&mWVP);
+	mfxWorldVar->SetMatrix((float*)&world);
+	mfxMaterialSliceVar->SetFloat((float)materialSlice);
+	mesh->setDrawVars();
+	D3D10_TECHNIQUE_DESC techDesc;
+	mTech->GetDesc( &techDesc );
+	for(UINT p = 0; p < techDesc.Passes; ++p)
+	{
+		mTech->GetPassByIndex( p )->Apply(0);
+		PERF_COUNT(PERF_STATE_CHANGES);
+		mesh->draw();
+	}
+	mesh->clearDrawVars();
+
+	//Anything drawn with the effect outside the renderer uses gDiffuseMap
+	mfxMaterialSliceVar->SetFloat((float)materialNS::NO_SLICE);
+	if (glow) mfxGlow->SetInt(0);
+}
+
+void D3DRenderer::beginInstancing()
+{
+	batcher.clear();
+	instancing = true;
+}
+
+//Copies every batch's instances into the one buffer, growing it first if need be
+void D3DRenderer::uploadInstances()
+{
+	const vector<InstanceData>& instances = batcher.getInstances();
+	if ((int)instances.size() > instanceCapacity || mInstanceVB == 0)
+	{
+		ReleaseCOM(mInstanceVB);
+		if (instanceCapacity == 0) instanceCapacity = rendererNS::START_INSTANCES;
+		while (instanceCapacity < (int)instances.size()) instanceCapacity *= 2;
+
+		D3D10_BUFFER_DESC vbd;
+		vbd.Usage = D3D10_USAGE_DYNAMIC;
+		vbd.ByteWidth = sizeof(InstanceData) * instanceCapacity;
+		vbd.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+		vbd.CPUAccessFlags = D3D10_CPU_ACCESS_WRITE;
+		vbd.MiscFlags = 0;
+		HR(md3dDevice->CreateBuffer(&vbd, 0, &mInstanceVB));
+		PERF_COUNT(PERF_ALLOCATIONS);
+	}
+
+	void* data = 0;
+	HR(mInstanceVB->Map(D3D10_MAP_WRITE_DISCARD, 0, &data));
+	memcpy(data, &instances[0], sizeof(InstanceData) * instances.size());
+	mInstanceVB->Unmap();
+}
+
+void D3DRenderer::flushInstances()
+{
+	PROFILE_ZONE("flushInstances");
+	instancing = false;
+	batcher.build();
+	if (batcher.getDrawCount() == 0) return;
+	uploadInstances();
+
+	md3dDevice->IASetInputLayout(mInstancedLayout);
+	mfxViewProjVar->SetMatrix((float*)&mVP);
+	mfxGlow->SetInt(0);
+	D3D10_TECHNIQUE_DESC techDesc;
+	mInstancedTech->GetDesc( &techDesc );
+	//Batches come sorted by bind group, so most of them can draw with what the
+	//last one left bound. A single pass stays applied until a texture, or the
+	//colour or size of the box, changes. Every Box shares the cache's cube, so
+	//it's bound once.
+	int bound = -1;
+	Box* look = 0;
+	const CubeMesh* cube = 0;
+	for(int b = 0; b < batcher.getBatchCount(); ++b)
+	{
+		const InstanceBatch& batch = batcher.getBatch(b);
+		bool changed = b == 0;
+		int group = materials.getGroup(batch.material);
+		if (batch.material >= 0 && group != bound) {
+			applyMaterial(batch.material);
+			bound = group;
+			changed = true;
+		}
+		if (look == 0 || !batch.mesh->drawsLike(*look)) {
+			batch.mesh->setDrawVars();
+			look = batch.mesh;
+			changed = true;
+		}
+		if (batch.mesh->getCube() != cube) {
+			batch.mesh->bindInstanced(mInstanceVB, sizeof(InstanceData));
+			cube = batch.mesh->getCube();
+		}
+		for(UINT p = 0; p < techDesc.Passes; ++p)
+		{
+			if (changed || techDesc.Passes > 1) {
+				mInstancedTech->GetPassByIndex( p )->Apply(0);
+				PERF_COUNT(PERF_STATE_CHANGES);
+			}
+			batch.mesh->drawInstanced(batch.count, batch.first);
+		}
+	}
+	look->clearDrawVars();
+	md3dDevice->IASetInputLayout(mLayout);
+}
+
+void D3DRenderer::releaseStatic(StaticBuffers& b)
+{
+	ReleaseCOM(b.vb);
+	ReleaseCOM(b.ib);
+}
+
+void D3DRenderer::buildStatic(StaticBatcher& statics)
+{
+	PROFILE_ZONE("buildStatic");
+	using namespace staticBatchNS;
+	vector<StaticBuffers> old;
+	old.swap(staticBuffers);
+	staticReused = staticCreated = 0;
+	unsigned int next = 0;
+
+	for(int i=0; i<statics.getPieceCount(); i++)
+	{
+		const StaticPiece& piece = statics.getPiece(i);
+		//Pieces keep their order from one build to the next, so a match is
+		//looked for from where the last one was found
+		StaticBuffers b;
+		b.vb = 0;
+		for(unsigned int n=0; n<old.size(); n++)
+		{
+			unsigned int k = (next + n) % old.size();
+			if(old[k].vb && old[k].hash == piece.hash)
+			{
+				b = old[k];
+				old[k].vb = old[k].ib = 0;
+				next = k + 1;
+				break;
+			}
+		}
+		if(b.vb) {
+			staticReused++;
+			staticBuffers.push_back(b);
+			continue;
+		}
+
+		b.hash = piece.hash;
+		b.material = piece.material;
+		b.mesh = piece.mesh;
+		b.indices = piece.count*BOX_INDICES;
+		staticVertices.resize(piece.count*BOX_VERTICES);
+		staticIndices.resize(b.indices);
+		statics.fillVertices(i, &staticVertices[0]);
+		StaticBatcher::fillIndices(piece.count, &staticIndices[0]);
+
+		D3D10_BUFFER_DESC desc;
+		desc.Usage = D3D10_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = 0;
+		D3D10_SUBRESOURCE_DATA init;
+		desc.ByteWidth = sizeof(PackedVertex) * staticVertices.size();
+		init.pSysMem = &staticVertices[0];
+		HR(md3dDevice->CreateBuffer(&desc, &init, &b.vb));
+
+		desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
+		desc.ByteWidth = sizeof(unsigned short) * staticIndices.size();
+		init.pSysMem = &staticIndices[0];
+		HR(md3dDevice->CreateBuffer(&desc, &init, &b.ib));
+		PERF_COUNT_N(PERF_ALLOCATIONS, 2);
+
+		staticCreated++;
+		staticBuffers.push_back(b);
+	}
+
+	for(unsigned int k=0; k<old.size(); k++)
+		releaseStatic(old[k]);
+}
+
+//Already in world space, so world is the identity and WVP the view-projection
+void D3DRenderer::drawStatic(const vector<int>& pieces)
+{
+	PROFILE_ZONE("drawStatic");
+	if (pieces.empty()) return;
+	Matrix world;
+	Identity(&world);
+	mfxWVPVar->SetMatrix((float*)&mVP);
+	mfxWorldVar->SetMatrix((float*)&world);
+	mfxGlow->SetInt(0);
+	md3dDevice->IASetInputLayout(mLayout);
+	md3dDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	//Sized already; only the colour comes from the Box
+	mfxBoxScaleVar->SetFloat(1.0f);
+
+	D3D10_TECHNIQUE_DESC techDesc;
+	mTech->GetDesc( &techDesc );
+	//Pieces of materials in one array only change the slice
+	int bound = -1;
+	int slice = materialNS::NO_SLICE;
+	mfxMaterialSliceVar->SetFloat((float)slice);
+	Box* look = 0;
+	for(unsigned int i = 0; i < pieces.size(); ++i)
+	{
+		const StaticBuffers& b = staticBuffers[pieces[i]];
+		bool changed = i == 0;
+		int group = materials.getGroup(b.material);
+		if (b.material >= 0 && group != bound) {
+			applyMaterial(b.material);
+			bound = group;
+			changed = true;
+		}
+		if (b.material >= 0 && materials.getSlice(b.material) != slice) {
+			slice = materials.getSlice(b.material);
+			mfxMaterialSliceVar->SetFloat((float)slice);
+			changed = true;
+		}
+		if (look == 0 || !b.mesh->colorsLike(*look)) {
+			D3DXCOLOR color = b.mesh->getDiffuse();
+			mfxBoxColorVar->SetRawValue(&color, 0, sizeof(D3DXCOLOR));
+			look = b.mesh;
+			changed = true;
+		}
+		UINT stride = sizeof(PackedVertex);
+		UINT offset = 0;
+		md3dDevice->IASetVertexBuffers(0, 1, &b.vb, &stride, &offset);
+		md3dDevice->IASetIndexBuffer(b.ib, DXGI_FORMAT_R16_UINT, 0);
+		for(UINT p = 0; p < techDesc.Passes; ++p)
+		{
+			if (changed || techDesc.Passes > 1) {
+				mTech->GetPassByIndex( p )->Apply(0);
+				PERF_COUNT(PERF_STATE_CHANGES);
+			}
+			md3dDevice->DrawIndexed(b.indices, 0, 0);
+			PERF_COUNT(PERF_DRAW_CALLS);
+		}
+		PERF_COUNT(PERF_BUFFER_BINDS);
+	}
+	look->clearDrawVars();
+	mfxMaterialSliceVar->SetFloat((float)materialNS::NO_SLICE);
+}
@@ -0,0 +1,132 @@
+#ifndef D3DRENDERER_H
+#define D3DRENDERER_H
+
+#include "d3dUtil.h"
+#include "Box.h"
+#include "SimRenderer.h"
+#include "InstanceBatcher.h"
+#include "StaticBatcher.h"
+#include "TextureMgr.h"
+#include "MaterialTable.h"
+
+namespace rendererNS {
+	//Instances the buffer starts with room for; it doubles when a frame needs more
+	const int START_INSTANCES = 1024;
+}
+
+//Batches glow in their mesh's colour
+class D3DInstanceBatcher : public InstanceBatcher
+{
+protected:
+	virtual Vector3 meshColor(Box* mesh) {return mesh ? mesh->getColor() : Vector3(1, 1, 1);}
+};
+
+//Draws the world's meshes with lighting.fx. Each SimMaterial maps to a
+//diffuse/spec texture pair from TextureMgr, looked up as it's bound so a
+//texture still loading shows as soon as it's in.
+//
+//buildMaterialArrays puts the diffuse maps that are in the asset pack into
+//Texture2DArrays, one per size and format, so those materials are slices of
+//gMaterialMaps and switching between them binds nothing. The pack fits the
+//pickups' and bullets' colour swatches to one size, so those share an array;
+//the bigger maps keep their own sizes and are arrays of one.
+//
+//Between beginInstancing and flushInstances draws are only collected; the
+//flush draws each mesh and bind group (see MaterialTable) with one
+//DrawIndexedInstanced, each instance carrying its slice, and only binds when
+//the group differs from the last batch's.
+//
+//The scenery is drawn apart from that, from buffers made by buildStatic with
+//every box already moved into place, one DrawIndexed per piece.
+class D3DRenderer : public SimRenderer, public MeshSizes
+{
+public:
+	D3DRenderer();
+	~D3DRenderer();
+
+	void init(ID3D10Effect* fx, ID3D10EffectTechnique* tech);
+	//layout is the one the rest of the game draws with, put back after each flush
+	void initInstancing(ID3D10Device* device, ID3D10Effect* fx, ID3D10InputLayout* layout);
+	void setViewProj(const Matrix& vp) {mVP = vp;}
+	//For sorting instances nearest first
+	void setView(const Matrix& view) {batcher.setView(view);}
+	void setMaterialTextures(int material, TextureId diffuse, TextureId spec);
+	//After the materials' textures are set and the pack is open. Maps that
+	//aren't slices are loaded on their own, so the textures set can be ids
+	//from TextureMgr::getId.
+	void buildMaterialArrays();
+	int getMaterialArrayCount() {return materials.getArrayCount();}
+	//Binds textures that aren't a material's, for draws of material -1
+	void bindTextures(TextureId diffuse, TextureId spec);
+
+	void setMaterial(int material);
+	void drawMesh(Box* mesh, const Matrix& world, bool glow);
+	float getScale(Box* mesh) const {return mesh ? mesh->getScale() : 1.0f;}
+
+	void beginInstancing();
+	void flushInstances();
+
+	//Makes a buffer pair for each piece, keeping those of the last build that
+	//hold the same boxes
+	void buildStatic(StaticBatcher& statics);
+	//pieces are indexes into the last build's, in order
+	void drawStatic(const vector<int>& pieces);
+	int getStaticReused() {return staticReused;}
+	int getStaticCreated() {return staticCreated;}
+
+private:
+	//One StaticBatcher piece on the GPU. Its vertices are white in the usual
+	//layout and gBoxColor tints them, as for any Box.
+	struct StaticBuffers
+	{
+		unsigned long long hash;
+		int material;
+		Box* mesh;
+		int indices;
+		ID3D10Buffer* vb;
+		ID3D10Buffer* ib;
+	};
+	void releaseStatic(StaticBuffers& b);
+
+	void applyMaterial(int material);
+	void uploadInstances();
+
+	ID3D10EffectTechnique* mTech;
+	ID3D10EffectMatrixVariable* mfxWVPVar;
+	ID3D10EffectMatrixVariable* mfxWorldVar;
+	ID3D10EffectScalarVariable* mfxGlow;
+	ID3D10EffectVariable* mfxCubeColorVar;
+	ID3D10EffectShaderResourceVariable* mfxDiffuseMapVar;
+	ID3D10EffectShaderResourceVariable* mfxSpecMapVar;
+	ID3D10EffectShaderResourceVariable* mfxMaterialMapsVar;
+	ID3D10EffectScalarVariable* mfxMaterialSliceVar;
+	ID3D10EffectVariable* mfxBoxColorVar;
+	ID3D10EffectScalarVariable* mfxBoxScaleVar;
+	Matrix mVP;
+
+	TextureId diffuseMaps[NUM_MATERIALS];
+	TextureId specMaps[NUM_MATERIALS];
+	MaterialTable materials;
+	//One per array in materials; TextureMgr owns them
+	vector<ID3D10ShaderResourceView*> materialArrays;
+	//The bound material's slice, for draws that aren't instanced
+	int materialSlice;
+
+	bool instancing;
+	D3DInstanceBatcher batcher;
+	ID3D10Device* md3dDevice;
+	ID3D10EffectTechnique* mInstancedTech;
+	ID3D10EffectMatrixVariable* mfxViewProjVar;
+	ID3D10InputLayout* mInstancedLayout;
+	ID3D10InputLayout* mLayout;
+	ID3D10Buffer* mInstanceVB;
+	int instanceCapacity;
+
+	vector<StaticBuffers> staticBuffers;
+	vector<PackedVertex> staticVertices;
+	vector<unsigned short> staticIndices;
+	int staticReused;
+	int staticCreated;
+};
+
+#endif
@@ -1,9 +1,5 @@
 #include "Enemy.h"
-#include <queue>
-using std::priority_queue;
-
-void queue_remove(priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare>& pq, Waypoint* w);
-float heuristic(Waypoint* x, Waypoint* y);
+#include "SimRandom.h"
 
 Enemy::Enemy()
 {
@@ -25,13 +21,11 @@ Enemy::Enemy()
 	lastAttacked = 0.5f;
 	health = 100;
 	attacking = false;
-	for(int i=0; i<WAYPOINT_SIZE; i++)
-	{
-		for(int j=0; j<WAYPOINT_SIZE; j++)
-		{
-			waypoints[i][j] = 0;
-		}
-	}
+	state = 0;
+	speedScale = 1.0f;
+	thinkDt = 0.0f;
+	patrolGoal = 0;
+	navGrid = 0;
 }
 
 Enemy::~Enemy()
@@ -49,14 +43,14 @@ void Enemy::init(Box *b, float r, Vector3 pos, Vector3 vel, float sp, float s, i
 	//Translate(&world, position.x, position.y, position.z);
 
 	destination = D3DXVECTOR3(0, 0, 0);
-	initWaypoints();
 }
 
 //Call this after calculating collisions
 void Enemy::update(float dt)
 {
+	oldPos = position;
 	D3DXVec3Normalize(&velocity, &velocity);
-	velocity *= speed;
+	velocity *= speed*speedScale;
 	position = position + velocity * dt;
 	Identity(&world);
 	D3DXMatrixScaling(&mScale, width, height, depth);
@@ -64,360 +58,154 @@ void Enemy::update(float dt)
 	D3DXMatrixMultiply(&world, &mScale, &mTranslate);
 }
 
-//Call this to set appropriate velocity
-void Enemy::update(float dt, Player* p)
+//Called by EnemyStateMachine before any behaviour step. thinkDt may span
+//several frames for enemies the AI LOD scheduler updates less often.
+void Enemy::beginThink()
 {
 	attacking = false;
-	if(!active) return;
-
-	if(health <= 0)
-	{
-		active = false;
-		p->addScore(10);
-		return;
-	}
-	oldPos = position;
-
-	Identity(&world);
-	lastAttacked += dt;
-	float dist = D3DXVec3Length(&(position - p->getPosition()));
-	
-	if(dist <= 15)
-	{
-		nav.clear();
-		velocity = D3DXVECTOR3(0,0,0);
-		attack(p);
-		facing = true;
-		attacking = true;
-	}
-	else if (dist <= 55)
-	{
-		facing = true;
-		nav.clear();
-		D3DXVECTOR3 tar;
-		D3DXVec3Normalize(&tar, &(p->getPosition() - position));
-		tar.y = 0;
-		velocity = tar;
-	}
-	else
-	{
-		//calculate the path from the nearest waypoint to the nearest waypoint to the player
-		facing = false;
-		if(nav.empty()) {
-			calculatePath(p);
-		}
-		else
-		{
-			if(target == 0)
-			{
-				target = nav.front();
-				nav.pop_front();
-			}
-			if(D3DXVec3Length(&(position - target->getPosition())) > 2)
-			{
-				D3DXVECTOR3 tar;
-				D3DXVec3Normalize(&tar, &(target->getPosition() - position));
-				velocity = tar * speed;
-			}
-			//we are AT the destination (of this leg of the journey)
-			else
-			{
-				calculatePath(p);
-				nav.pop_front();
-				if(!nav.empty()) target = nav.front();
-			}
-		}
-	}
-	update(dt);
+	lastAttacked += thinkDt;
 }
 
-void Enemy::attack(Player* p)
+void Enemy::die(Player* p)
 {
-	if(lastAttacked >= 0.5f){
-		lastAttacked = 0;
-		p->damage(5);
-		p->grunt();
-	}
+	attacking = false;
+	if(!active) return;
+	active = false;
+	p->addScore(10);
 }
 
-list<Waypoint*> Enemy::pathfindAStar(Waypoint* src, Waypoint* dest)
+void Enemy::attackStep(Player* p)
 {
-	priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare> openWay;
-	vector<Waypoint*> closedWay;
-	list<Waypoint*> path;
-	if(src == dest)
-	{
-		path.push_front(src);
-		return path;
-	}
-
-	for(int i=0; i<WAYPOINT_SIZE; i++)
-	{
-		for(int j=0; j<WAYPOINT_SIZE; j++)
-		{
-			waypoints[i][j]->setContainer(NONE);
-			waypoints[i][j]->setFCost(0);
-			waypoints[i][j]->setGCost(0);
-			waypoints[i][j]->setParent(0);
-			//wayLine[i][j].setBox(&inactiveLine);
-		}
-	}
-
-	//find path
-	//src = waypoints[0][0];
-	src->setFCost(heuristic(src, dest));
-	
-	int nodesConsidered = 0;
-	src->setContainer(OPEN);
-	openWay.push(src);
-
-	//OPEN = priority queue containing START
-	//CLOSED = empty set
-	//while lowest rank in OPEN is not the GOAL:
-	while(!openWay.empty())
-	{
-		nodesConsidered++;
-		//current = remove lowest rank item from OPEN
-		Waypoint* current = openWay.top();
-		openWay.pop();
-		current->setContainer(NONE);
-
-		if(current == dest) 
-			break;
-		//for neighbors of current
-		for(int i=0; i<current->getNeighbors().size(); i++)
-		{
-			Waypoint* n = current->getNeighbors()[i];
-			if(n->isActive())
-			{
-				//cost to get to n from current
-				float gCost = current->getGCost() + 1;
-
-				//Cost to get from n to target
-				float hCost = heuristic(dest, n);
-
-				//total cost through waypoint n
-				float cost = gCost + hCost;
-
-				//if neighbor in OPEN and cost less than g(neighbor):
-				//and this solution is better than what we've seen
-				if(n->getContainer() == OPEN && gCost < n->getGCost())
-				{
-					//remove neighbor from OPEN, because new path is better
-					queue_remove(openWay, n);
-					//n->setParent(0);
-					n->setContainer(NONE);
-				}
-				//if neighbor in CLOSED and cost less than g(neighbor):
-				//and this solution is better than what we've seen
-				if(n->getContainer() == CLOSED && gCost < n->getGCost())
-				{
-					//remove neighbor from CLOSED
-					for(int i=0; i<closedWay.size(); i++)
-					{
-						if(closedWay[i] == n)
-						{
-							closedWay[i] = closedWay[closedWay.size()-1];
-							closedWay.pop_back();
-						}
-					}
-					//n->setParent(0);
-					n->setContainer(NONE);
-				}
-				//if neighbor not in OPEN and neighbor not in CLOSED:
-				if(n->getContainer() == NONE && n->getFCost() <= current->getFCost())
-				{
-					//set g(neighbor) to cost
-					n->setFCost(cost);
-					n->setGCost(gCost);
-					//set neighbor's parent to current
-					n->setParent(current);
-					//add neighbor to OPEN
-					n->setContainer(OPEN);
-					openWay.push(n);
-					//set priority queue rank to g(neighbor) + h(neighbor)
-				}
-			}
-		}
-		//add current to CLOSED
-		current->setContainer(CLOSED);
-		closedWay.push_back(current);
-	}
-
-	Waypoint* c = dest;
-	while(c->getParent() != 0)
-	{
-		path.push_front(c);
-		c = c->getParent();
-	}
-	path.push_front(c);
-	return path;
+	nav.clear();
+	velocity = D3DXVECTOR3(0,0,0);
+	attack(p);
+	facing = true;
+	attacking = true;
 }
 
-Waypoint* Enemy::findNearestWaypoint(D3DXVECTOR3& p)
+void Enemy::chaseStep(Player* p)
 {
-	//Short-circuit the search by automatically targeting the center if they are in the square
-	if(D3DXVec3LengthSq(&(p - D3DXVECTOR3(0,0,0))) < 55*55)
-	{
-		return waypoints[2][2];
-	}
+	facing = true;
+	nav.clear();
+	D3DXVECTOR3 tar;
+	D3DXVECTOR3 toPlayer = p->getPosition() - position;
+	D3DXVec3Normalize(&tar, &toPlayer);
+	tar.y = 0;
+	velocity = tar;
+}
 
-	//Otherwise, make the nearest waypoint anything but the center of the square
-	Waypoint* nearest = waypoints[0][0];
-	for(int i=0; i<WAYPOINT_SIZE; i++)
-	{
-		for(int j=0; j<WAYPOINT_SIZE; j++)
-		{
-			if(i ==2 && j == 2){}
-			else{
-				if(D3DXVec3LengthSq(&(nearest->getPosition() - p)) > D3DXVec3LengthSq(&(waypoints[i][j]->getPosition() - p))) 
-				{
-					nearest = waypoints[i][j];
-				}
-			}
-		}
-	}
-	return nearest;
+void Enemy::fleeStep(Player* p)
+{
+	facing = false;
+	nav.clear();
+	D3DXVECTOR3 tar;
+	D3DXVECTOR3 fromPlayer = position - p->getPosition();
+	D3DXVec3Normalize(&tar, &fromPlayer);
+	tar.y = 0;
+	velocity = tar;
 }
 
-void Enemy::initWaypoints()
+void Enemy::idleStep()
 {
-	for(int i=0; i<WAYPOINT_SIZE; i++){
-		for(int j=0; j<WAYPOINT_SIZE; j++)
-		{
-			if(waypoints[i][j] == 0) waypoints[i][j] = new Waypoint(D3DXVECTOR3(i*100 - 200, 0, j*100 - 200));
-			else waypoints[i][j]->setPosition(D3DXVECTOR3(i*100 - 200, 0, j*100 - 200));
-			waypoints[i][j]->setContainer(NONE);
-			//wayLine[i][j].init(&inactiveLine, 1.0f, D3DXVECTOR3(waypoints[i][j]->getPosition().x, 2, waypoints[i][j]->getPosition().z), D3DXVECTOR3(0,0,0), 0.0f, 0.125f);
-		}
-	}
+	facing = false;
+	nav.clear();
+	velocity = D3DXVECTOR3(0,0,0);
+}
 
-	for(int i=0; i<WAYPOINT_SIZE; i++)
+void Enemy::patrolStep()
+{
+	//Wander between random waypoints, picking a new one once the last is reached
+	if(patrolGoal == 0 || nav.empty())
 	{
-		for(int j=0; j<WAYPOINT_SIZE; j++)
-		{
-			//Currently just waypoints in the cardinal directions
-			if(i-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i-1][j]);
-			if(i+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i+1][j]);
-			if(j-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i][j-1]);
-			if(j+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i][j+1]);
-		}
+		int i = SimRandom::next()%navGrid->getSize();
+		patrolGoal = navGrid->at(i, SimRandom::next()%navGrid->getSize());
+		nav.clear();
 	}
+	followPathStep(patrolGoal->getPosition());
 }
 
-void Enemy::initWaypoints2()
+//calculate the path from the nearest waypoint to the nearest waypoint to the goal
+void Enemy::followPathStep(const D3DXVECTOR3& goal)
 {
-	for(int i=0; i<WAYPOINT_SIZE; i++){
-		for(int j=0; j<WAYPOINT_SIZE; j++)
-		{
-			if(waypoints[i][j] == 0) waypoints[i][j] = new Waypoint(D3DXVECTOR3(i*450 - 900, 0, j*800 - 1600));
-			else waypoints[i][j]->setPosition(D3DXVECTOR3(i*450 - 900, 0, j*800 - 1600));
-			waypoints[i][j]->setContainer(NONE);
-			//wayLine[i][j].init(&inactiveLine, 1.0f, D3DXVECTOR3(waypoints[i][j]->getPosition().x, 2, waypoints[i][j]->getPosition().z), D3DXVECTOR3(0,0,0), 0.0f, 0.125f);
-		}
+	facing = false;
+	if(nav.empty()) {
+		calculatePath(goal);
 	}
-
-	for(int i=0; i<WAYPOINT_SIZE; i++)
+	else
 	{
-		for(int j=0; j<WAYPOINT_SIZE; j++)
+		if(target == 0)
 		{
-			//Currently just waypoints in the cardinal directions
-			if (i == 0 && j == 2)
-			{
-				if(i-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i-1][j]);
-				//if(i+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i+1][j]);
-				if(j-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i][j-1]);
-				if(j+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i][j+1]);
-			}
-			else if (i == 1 && j == 2)
-			{
-				//if(i-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i-1][j]);
-				if(i+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i+1][j]);
-				//if(j-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i][j-1]);
-				//if(j+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i][j+1]);
-			}
-			else if (i == 1 && j == 1)
-			{
-				//if(i-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i-1][j]);
-				if(i+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i+1][j]);
-				if(j-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i][j-1]);
-				//if(j+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i][j+1]);
-			}
-			else if (i==0 && j==1)
-			{
-				if(i-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i-1][j]);
-				//if(i+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i+1][j]);
-				if(j-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i][j-1]);
-				if(j+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i][j+1]);
-			}
-			else if (i == 1 && j == 3)
-			{
-				if(i-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i-1][j]);
-				if(i+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i+1][j]);
-				//if(j-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i][j-1]);
-				if(j+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i][j+1]);
-			}
-			else
-			{
-				if(i-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i-1][j]);
-				if(i+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i+1][j]);
-				if(j-1 >= 0) waypoints[i][j]->addNeighbor(waypoints[i][j-1]);
-				if(j+1 < WAYPOINT_SIZE) waypoints[i][j]->addNeighbor(waypoints[i][j+1]);
-			}
+			target = nav.front();
+			nav.pop_front();
 		}
-	}
-}
-
-void queue_remove(priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare>& pq, Waypoint* w)
-{
-	priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare> hold;
-	int limit = pq.size();
-	for(int i=0; i<limit; i++)
-	{
-		if(pq.top() == w) pq.pop();//don't copy it over
+		//Widen the arrival radius by the distance covered between thinks so
+		//infrequently updated enemies don't overshoot their waypoint
+		D3DXVECTOR3 toTarget = target->getPosition() - position;
+		if(D3DXVec3Length(&toTarget) > Max(2.0f, speed*thinkDt))
+		{
+			D3DXVECTOR3 tar;
+			D3DXVec3Normalize(&tar, &toTarget);
+			velocity = tar * speed;
+		}
+		//we are AT the destination (of this leg of the journey)
 		else
 		{
-			hold.push(pq.top());
-			pq.pop();
+			calculatePath(goal);
+			nav.pop_front();
+			if(!nav.empty()) target = nav.front();
 		}
 	}
-	pq = hold;
 }
 
-float heuristic(Waypoint* x, Waypoint* y)
+void Enemy::attack(Player* p)
 {
-	return abs(x->getPosition().x - y->getPosition().x) + abs(x->getPosition().z - y->getPosition().z);
+	if(lastAttacked >= 0.5f){
+		lastAttacked = 0;
+		p->damage(5);
+		p->grunt();
+	}
 }
 
-vector<D3DXVECTOR3> Enemy::waypointPositions()
+Waypoint* Enemy::findNearestWaypoint(const D3DXVECTOR3& p)
 {
-	vector<D3DXVECTOR3> wp;
-	for(int i=0; i<WAYPOINT_SIZE; i++)
+	//Short-circuit the search by automatically targeting the center if they are in the square
+	Waypoint* centre = navGrid->getCentre();
+	if(D3DXVec3LengthSq(&p) < 55*55)
 	{
-		for(int j=0; j<WAYPOINT_SIZE; j++)
+		return centre;
+	}
+
+	//Otherwise, make the nearest waypoint anything but the center of the square
+	Waypoint* nearest = navGrid->get(0);
+	for(int i=0; i<navGrid->getCount(); i++)
+	{
+		Waypoint* w = navGrid->get(i);
+		if(w == centre) continue;
+		Vector3 toNearest = nearest->getPosition() - p;
+		Vector3 toCandidate = w->getPosition() - p;
+		if(D3DXVec3LengthSq(&toNearest) > D3DXVec3LengthSq(&toCandidate)) 
 		{
-			wp.push_back(waypoints[i][j]->getPosition());
+			nearest = w;
 		}
 	}
-	return wp;
+	return nearest;
 }
 
-void Enemy::calculatePath(Player* p)
+void Enemy::calculatePath(const D3DXVECTOR3& goal)
 {
 	target = 0;
 	nav.clear();
 
 	//find nearest waypoint to the enemy
 	src = findNearestWaypoint(position);
-	//find waypoint nearest to player
-	dest = findNearestWaypoint(p->getPosition());
-	//Waypoint* dest = waypoints[rand()%WAYPOINT_SIZE][rand()%WAYPOINT_SIZE];
+	//find waypoint nearest to the goal
+	dest = findNearestWaypoint(goal);
 
 	//calculate path from nearest waypoint to the player's nearest waypoint
 	//If the source is not the destination, calculate normally
 	if(src != dest)
 	{
-		nav = pathfindAStar(src, dest);
+		nav = navGrid->findPath(src, dest);
 	}
 	//however if the source and destination are the same, only use that waypoint and stay there
 	else 
@@ -425,5 +213,4 @@ void Enemy::calculatePath(Player* p)
 		nav.clear();
 		nav.push_front(src);
 	}
-	//nav = pathfindAStar(src, dest);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #ifndef ENEMY_H
 #define ENEMY_H
 #include "GameObject.h"
-#include "Waypoint.h"
+#include "NavGrid.h"
 #include <vector>
 using std::vector;
 #include <list>
@@ -25,9 +25,25 @@ public:
 	virtual void init(Box *b, float r, Vector3 pos, Vector3 velocity = Vector3(0,0,0), float sp = 1.0f, float s = 1, int width = 1, int height = 1, int depth = 1, float rx = 0.0f, float ry = 0.0f, float rz = 0.0f);
 	virtual void update(float dt);
 
-	void update(float dt, Player* p);
 	void ai();
 	void attack(Player* p);
+
+	//Behaviour steps. These only choose a velocity; EnemyStateMachine runs them
+	//in per-behaviour batches and update(dt) does the moving.
+	void beginThink();
+	void die(Player* p);
+	void attackStep(Player* p);
+	void chaseStep(Player* p);
+	void followPathStep(const D3DXVECTOR3& goal);
+	void fleeStep(Player* p);
+	void patrolStep();
+	void idleStep();
+
+	int getState(){return state;}
+	void setState(int s, float scale){state = s; speedScale = scale;}
+	//Time since this enemy last thought, set by the AI LOD scheduler
+	void setThinkDt(float t){thinkDt = t;}
+	float getThinkDt(){return thinkDt;}
 	void damage(int d) {health -= d;}
 
 	void setDestination(D3DXVECTOR3& d) {destination = d;}
@@ -43,13 +59,11 @@ public:
 	//float getDepth(){return depth;}
 
 
-	list<Waypoint*> pathfindAStar(Waypoint* source, Waypoint* target);
-	Waypoint* findNearestWaypoint(D3DXVECTOR3&);
-	//For positioning waypoint indicators
-	vector<D3DXVECTOR3> waypointPositions();
-	void calculatePath(Player*);
-	void initWaypoints();
-	void initWaypoints2();
+	Waypoint* findNearestWaypoint(const D3DXVECTOR3&);
+	void calculatePath(const D3DXVECTOR3& goal);
+	//The grid this enemy paths over, shared with the rest
+	void setNavGrid(NavGrid* g) {navGrid = g; nav.clear(); target = 0; patrolGoal = 0;}
+	NavGrid* getNavGrid() {return navGrid;}
 
 private:
 	float radius;
@@ -62,8 +76,7 @@ private:
 
 	float speed;
 
-	Waypoint* waypoints[WAYPOINT_SIZE][WAYPOINT_SIZE];
-	
+	NavGrid* navGrid;
 
 	Waypoint* target;
 
@@ -71,6 +84,12 @@ private:
 	int health;
 	D3DXVECTOR3 oldPos;
 	bool attacking;
+
+	//Index into the EnemyStateMachine's state table
+	int state;
+	float speedScale;
+	float thinkDt;
+	Waypoint* patrolGoal;
 };
 
 
@@ -0,0 +1,215 @@
+#include "EnemyStateMachine.h"
+#include <fstream>
+#include <sstream>
+
+//Names used in the state file, in enum order
+static const char* BEHAVIOUR_NAMES[NUM_BEHAVIOURS] = {"die", "attack", "chase", "follow_path", "flee", "patrol", "idle"};
+static const char* CONDITION_NAMES[] = {"always", "dead", "player_within", "player_beyond", "health_below", "health_above", "day", "night"};
+static const int NUM_CONDITIONS = sizeof(CONDITION_NAMES)/sizeof(CONDITION_NAMES[0]);
+
+EnemyStateMachine::EnemyStateMachine()
+{
+	night = false;
+	lookupDirty = true;
+	initDefault();
+}
+
+void EnemyStateMachine::clear()
+{
+	states.clear();
+	transitions.clear();
+	lookupDirty = true;
+}
+
+void EnemyStateMachine::initDefault()
+{
+	clear();
+	int follow = addState("follow_path", BEHAVIOUR_FOLLOW_PATH);
+	int chase = addState("chase", BEHAVIOUR_CHASE);
+	int attack = addState("attack", BEHAVIOUR_ATTACK);
+	int dead = addState("dead", BEHAVIOUR_DIE);
+
+	addTransition(enemyStateNS::ANY_STATE, CONDITION_DEAD, 0, dead);
+	addTransition(enemyStateNS::ANY_STATE, CONDITION_PLAYER_WITHIN, 15, attack);
+	addTransition(enemyStateNS::ANY_STATE, CONDITION_PLAYER_WITHIN, 55, chase);
+	addTransition(enemyStateNS::ANY_STATE, CONDITION_ALWAYS, 0, follow);
+}
+
+int EnemyStateMachine::addState(const string& name, EnemyBehaviour behaviour, float speedScale)
+{
+	EnemyStateDesc d;
+	d.name = name;
+	d.behaviour = behaviour;
+	d.speedScale = speedScale;
+	states.push_back(d);
+	lookupDirty = true;
+	return states.size()-1;
+}
+
+void EnemyStateMachine::addTransition(int from, EnemyCondition condition, float value, int to)
+{
+	EnemyTransition t;
+	t.from = from;
+	t.condition = condition;
+	t.value = value;
+	t.to = to;
+	transitions.push_back(t);
+	lookupDirty = true;
+}
+
+int EnemyStateMachine::findState(const string& name)
+{
+	for(unsigned int i=0; i<states.size(); i++)
+		if(states[i].name == name) return i;
+	return -1;
+}
+
+//Format, one entry per line, # starts a comment:
+//	state <name> <behaviour> [speed scale]
+//	transition <from state|any> <condition> <value> <to state>
+bool EnemyStateMachine::loadFromFile(const char* filename)
+{
+	std::ifstream in(filename);
+	if(!in) return false;
+
+	vector<EnemyStateDesc> oldStates = states;
+	vector<EnemyTransition> oldTransitions = transitions;
+	clear();
+
+	bool ok = true;
+	string line;
+	while(ok && std::getline(in, line))
+	{
+		line = line.substr(0, line.find('#'));
+		std::istringstream ss(line);
+		string kind;
+		if(!(ss >> kind)) continue;
+
+		if(kind == "state")
+		{
+			string name, behaviour;
+			float scale = 1.0f;
+			ss >> name >> behaviour;
+			if(!(ss >> scale)) scale = 1.0f;
+			int b = 0;
+			while(b < NUM_BEHAVIOURS && behaviour != BEHAVIOUR_NAMES[b]) b++;
+			if(name.empty() || b == NUM_BEHAVIOURS) ok = false;
+			else addState(name, (EnemyBehaviour)b, scale);
+		}
+		else if(kind == "transition")
+		{
+			string from, condition, to;
+			float value = 0;
+			ss >> from >> condition >> value >> to;
+			int c = 0;
+			while(c < NUM_CONDITIONS && condition != CONDITION_NAMES[c]) c++;
+			int f = (from == "any") ? enemyStateNS::ANY_STATE : findState(from);
+			int t = findState(to);
+			if(c == NUM_CONDITIONS || t < 0 || (f < 0 && from != "any")) ok = false;
+			else addTransition(f, (EnemyCondition)c, value, t);
+		}
+		else ok = false;
+	}
+
+	//Keep whatever table we had rather than run with half of a broken one
+	if(!ok || states.empty())
+	{
+		states = oldStates;
+		transitions = oldTransitions;
+		lookupDirty = true;
+		return false;
+	}
+	return true;
+}
+
+void EnemyStateMachine::rebuildLookup()
+{
+	lookup.assign(states.size(), vector<int>());
+	for(unsigned int t=0; t<transitions.size(); t++)
+	{
+		for(unsigned int s=0; s<states.size(); s++)
+		{
+			if(transitions[t].from == enemyStateNS::ANY_STATE || transitions[t].from == (int)s)
+				lookup[s].push_back(t);
+		}
+	}
+	lookupDirty = false;
+}
+
+void EnemyStateMachine::resetEnemy(Enemy* e)
+{
+	if(states.empty()) return;
+	e->setState(0, states[0].speedScale);
+}
+
+bool EnemyStateMachine::test(const EnemyTransition& t, Enemy* e, float distSq)
+{
+	switch(t.condition)
+	{
+	case CONDITION_ALWAYS:			return true;
+	case CONDITION_DEAD:			return e->getHealth() <= 0;
+	case CONDITION_PLAYER_WITHIN:	return distSq <= t.value*t.value;
+	case CONDITION_PLAYER_BEYOND:	return distSq > t.value*t.value;
+	case CONDITION_HEALTH_BELOW:	return e->getHealth() < t.value;
+	case CONDITION_HEALTH_ABOVE:	return e->getHealth() > t.value;
+	case CONDITION_DAY:				return !night;
+	case CONDITION_NIGHT:			return night;
+	}
+	return false;
+}
+
+int EnemyStateMachine::nextState(Enemy* e, float distSq)
+{
+	int current = e->getState();
+	if(current < 0 || current >= (int)states.size()) current = 0;
+	const vector<int>& candidates = lookup[current];
+	for(unsigned int i=0; i<candidates.size(); i++)
+	{
+		const EnemyTransition& t = transitions[candidates[i]];
+		if(test(t, e, distSq)) return t.to;
+	}
+	return current;
+}
+
+void EnemyStateMachine::think(vector<Enemy*>& thinkers, Player* p)
+{
+	if(states.empty()) return;
+	if(lookupDirty) rebuildLookup();
+
+	for(int b=0; b<NUM_BEHAVIOURS; b++) batches[b].clear();
+
+	//Pick everyone's state first...
+	for(unsigned int i=0; i<thinkers.size(); i++)
+	{
+		Enemy* e = thinkers[i];
+		if(!e->getActiveState()) continue;
+		D3DXVECTOR3 toPlayer = e->getPosition() - p->getPosition();
+		int s = nextState(e, D3DXVec3LengthSq(&toPlayer));
+		e->setState(s, states[s].speedScale);
+		e->beginThink();
+		batches[states[s].behaviour].push_back(e);
+	}
+
+	//...then run each behaviour over its whole batch
+	vector<Enemy*>& dying = batches[BEHAVIOUR_DIE];
+	for(unsigned int i=0; i<dying.size(); i++) dying[i]->die(p);
+
+	vector<Enemy*>& attackers = batches[BEHAVIOUR_ATTACK];
+	for(unsigned int i=0; i<attackers.size(); i++) attackers[i]->attackStep(p);
+
+	vector<Enemy*>& chasers = batches[BEHAVIOUR_CHASE];
+	for(unsigned int i=0; i<chasers.size(); i++) chasers[i]->chaseStep(p);
+
+	vector<Enemy*>& followers = batches[BEHAVIOUR_FOLLOW_PATH];
+	D3DXVECTOR3 playerPos = p->getPosition();
+	for(unsigned int i=0; i<followers.size(); i++) followers[i]->followPathStep(playerPos);
+
+	vector<Enemy*>& fleeing = batches[BEHAVIOUR_FLEE];
+	for(unsigned int i=0; i<fleeing.size(); i++) fleeing[i]->fleeStep(p);
+
+	vector<Enemy*>& patrolling = batches[BEHAVIOUR_PATROL];
+	for(unsigned int i=0; i<patrolling.size(); i++) patrolling[i]->patrolStep();
+
+	vector<Enemy*>& idle = batches[BEHAVIOUR_IDLE];
+	for(unsigned int i=0; i<idle.size(); i++) idle[i]->idleStep();
+}
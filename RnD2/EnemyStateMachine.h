@@ -0,0 +1,82 @@
+#ifndef ENEMY_STATE_MACHINE_H
+#define ENEMY_STATE_MACHINE_H
+
+#include "Enemy.h"
+#include "Player.h"
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+//What an enemy does while in a state. States are rows in a table that pick
+//one of these plus tuning, so new states don't need new code.
+enum EnemyBehaviour {BEHAVIOUR_DIE, BEHAVIOUR_ATTACK, BEHAVIOUR_CHASE, BEHAVIOUR_FOLLOW_PATH, BEHAVIOUR_FLEE, BEHAVIOUR_PATROL, BEHAVIOUR_IDLE, NUM_BEHAVIOURS};
+
+//Tests a transition can make. Distances are to the player.
+enum EnemyCondition {CONDITION_ALWAYS, CONDITION_DEAD, CONDITION_PLAYER_WITHIN, CONDITION_PLAYER_BEYOND, CONDITION_HEALTH_BELOW, CONDITION_HEALTH_ABOVE, CONDITION_DAY, CONDITION_NIGHT};
+
+namespace enemyStateNS {
+	//Use as the from state of a transition that applies in every state
+	const int ANY_STATE = -1;
+	const char DEFAULT_FILE[] = "enemyStates.txt";
+}
+
+struct EnemyStateDesc
+{
+	string name;
+	EnemyBehaviour behaviour;
+	float speedScale;
+};
+
+struct EnemyTransition
+{
+	int from;
+	EnemyCondition condition;
+	float value;
+	int to;
+};
+
+class EnemyStateMachine
+{
+public:
+	EnemyStateMachine();
+
+	//dead -> attack within 15 -> chase within 55 -> follow waypoints
+	void initDefault();
+	//Replaces the table with one read from a text file, see enemyStates.txt
+	bool loadFromFile(const char* filename);
+	void clear();
+
+	int addState(const string& name, EnemyBehaviour behaviour, float speedScale = 1.0f);
+	//Transitions are tried in the order they were added and the first match wins
+	void addTransition(int from, EnemyCondition condition, float value, int to);
+	int findState(const string& name);
+	int getStateCount() {return states.size();}
+	const EnemyStateDesc& getState(int s) {return states[s];}
+
+	void setNight(bool n) {night = n;}
+	//Puts a freshly spawned enemy in the first state of the table
+	void resetEnemy(Enemy* e);
+
+	//Moves every thinker to its next state, then runs each behaviour over
+	//all of its enemies in one batch
+	void think(vector<Enemy*>& thinkers, Player* p);
+
+	int getBatchSize(EnemyBehaviour b) {return batches[b].size();}
+
+private:
+	void rebuildLookup();
+	int nextState(Enemy* e, float distSq);
+	bool test(const EnemyTransition& t, Enemy* e, float distSq);
+
+	vector<EnemyStateDesc> states;
+	vector<EnemyTransition> transitions;
+	//Per state, the transitions that can fire from it in table order
+	vector< vector<int> > lookup;
+	bool lookupDirty;
+
+	vector<Enemy*> batches[NUM_BEHAVIOURS];
+	bool night;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+#include <cmath>
+
+//The simulation always steps by STEP, however long the frame took. Frames
+//bank their time and run as many whole steps as fit; what is left over is how
+//far drawing should interpolate between the last two steps.
+namespace timestepNS {
+	const float STEP = 1.0f/120.0f;
+	//A frame slower than this many steps drops the rest of its time instead of
+	//running ever more steps to catch up
+	const int MAX_STEPS = 8;
+}
+
+class FixedTimestep
+{
+public:
+	FixedTimestep(float step = timestepNS::STEP, int maxSteps = timestepNS::MAX_STEPS)
+		: step(step), maxSteps(maxSteps), accumulator(0.0f) {}
+
+	//Banks a frame's time and returns how many steps to run for it
+	int advance(float frameDt)
+	{
+		accumulator += frameDt;
+		int steps = 0;
+		while(accumulator >= step && steps < maxSteps)
+		{
+			accumulator -= step;
+			steps++;
+		}
+		if(accumulator >= step) accumulator = fmodf(accumulator, step);
+		return steps;
+	}
+
+	float getStep() {return step;}
+	//0 draws the previous step, 1 the latest
+	float getAlpha() {return accumulator / step;}
+	void reset() {accumulator = 0.0f;}
+
+private:
+	float step;
+	int maxSteps;
+	float accumulator;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "FrameSnapshot.h"
+#include "PerfStats.h"
+
+FrameSnapshot::FrameSnapshot()
+{
+	gameState = INTROSCREEN;
+	level = 1;
+	debugMode = false;
+	daylight = 1.0f;
+	Identity(&view);
+	Identity(&proj);
+	eyePos = Vector3(0, 0, 0);
+	score = health = ammo = 0;
+	dayCount = 0;
+	playerPos = Vector3(0, 0, 0);
+	attacked = false;
+	activeEnemies = liveBullets = 0;
+	material = -1;
+	staticVersion = -1;
+	capturingStatic = false;
+}
+
+void FrameSnapshot::capture(World* world, float alpha)
+{
+	PROFILE_ZONE("FrameSnapshot::capture");
+	gameState = world->getGameState();
+	level = world->getLevel();
+	debugMode = world->getDebugMode();
+	daylight = world->getDaylight();
+
+	Camera& camera = world->getCamera();
+	view = camera.getInterpolatedViewMatrix(alpha);
+	proj = camera.getProjectionMatrix();
+	eyePos = camera.getPosition();
+
+	Player& player = world->getPlayer();
+	score = player.getScore();
+	health = player.getHealth();
+	ammo = player.getAmmo();
+	gunName = player.getGunName();
+	timeOfDay = world->getTimeOfDay();
+	dayCount = world->getDayCount();
+	playerPos = player.getPosition();
+	attacked = world->getAttacked() || world->getSinceLastAttacked() < 0.25f;
+	activeEnemies = world->getActiveEnemyCount();
+	liveBullets = world->getLiveBulletCount();
+
+	waypoints.clear();
+	if(debugMode) waypoints = world->getNavGrid().getPositions();
+
+	//clear keeps the capacity, so after the first few frames this doesn't allocate
+	draws.clear();
+	material = -1;
+	if(gameState == PLAYING)
+	{
+		setInterpolation(alpha);
+		if(world->getStaticVersion() != staticVersion)
+		{
+			staticDraws.clear();
+			capturingStatic = true;
+			world->drawStatic(this);
+			capturingStatic = false;
+			staticVersion = world->getStaticVersion();
+			material = -1;
+		}
+		world->drawDynamic(this);
+	}
+}
+
+void FrameSnapshot::drawMesh(Box* mesh, const Matrix& world, bool glow)
+{
+	SnapshotDraw d;
+	d.mesh = mesh;
+	d.world = world;
+	d.material = material;
+	d.glow = glow;
+	if(capturingStatic) staticDraws.push_back(d);
+	else draws.push_back(d);
+}
+
+static void replayDraws(SimRenderer* renderer, const vector<SnapshotDraw>& draws)
+{
+	int current = -1;
+	for(unsigned int i=0; i<draws.size(); i++)
+	{
+		const SnapshotDraw& d = draws[i];
+		if(d.material != current && d.material >= 0)
+		{
+			renderer->setMaterial(d.material);
+			current = d.material;
+		}
+		renderer->drawMesh(d.mesh, d.world, d.glow);
+	}
+}
+
+void FrameSnapshot::replay(SimRenderer* renderer) const
+{
+	replayDraws(renderer, draws);
+}
+
+void FrameSnapshot::replayStatic(SimRenderer* renderer) const
+{
+	replayDraws(renderer, staticDraws);
+}
+
+//Draws come in long runs of one mesh, so its scale is only asked for once a run
+static float meshScale(const MeshSizes* sizes, Box* mesh, Box** lastMesh, float* lastScale)
+{
+	if(!sizes) return 1.0f;
+	if(mesh != *lastMesh)
+	{
+		*lastMesh = mesh;
+		*lastScale = sizes->getScale(mesh);
+	}
+	return *lastScale;
+}
+
+void FrameSnapshot::cull(FrustumCuller* culler, const MeshSizes* sizes) const
+{
+	culler->setViewProj(view*proj);
+	culler->clear();
+	Box* lastMesh = 0;
+	float lastScale = 1.0f;
+	for(unsigned int i=0; i<draws.size(); i++)
+		culler->addMesh(draws[i].world, meshScale(sizes, draws[i].mesh, &lastMesh, &lastScale));
+	culler->cull();
+}
+
+//Boxes are numbered in the culler as added: the pieces' bounds, then the draws
+void FrameSnapshot::occlude(OcclusionCuller* occlusion, const MeshSizes* sizes, vector<int>* visible, StaticBatcher* statics,
+	vector<int>* pieces) const
+{
+	PROFILE_ZONE("FrameSnapshot::occlude");
+	occlusion->setViewProj(view*proj);
+	occlusion->clear();
+	int first = 0;
+	if(statics && pieces)
+	{
+		statics->addOccluders(occlusion, *pieces);
+		for(unsigned int i=0; i<pieces->size(); i++)
+		{
+			const StaticPiece& p = statics->getPiece((*pieces)[i]);
+			occlusion->addBounds(p.centre, p.halfExtents);
+		}
+		first = pieces->size();
+	}
+	Box* lastMesh = 0;
+	float lastScale = 1.0f;
+	for(unsigned int i=0; i<visible->size(); i++)
+	{
+		const SnapshotDraw& d = draws[(*visible)[i]];
+		occlusion->addMesh(d.world, meshScale(sizes, d.mesh, &lastMesh, &lastScale));
+	}
+	occlusion->rasterize();
+
+	unsigned int kept = 0;
+	if(statics && pieces)
+	{
+		for(unsigned int i=0; i<pieces->size(); i++)
+			if(occlusion->isVisible(i)) (*pieces)[kept++] = (*pieces)[i];
+		pieces->resize(kept);
+	}
+	kept = 0;
+	for(unsigned int i=0; i<visible->size(); i++)
+		if(occlusion->isVisible(first + i)) (*visible)[kept++] = (*visible)[i];
+	visible->resize(kept);
+	PERF_COUNT_N(PERF_OCCLUDED, occlusion->getOccludedCount());
+}
+
+//Skipped draws can still set the material, so it's followed through them
+void FrameSnapshot::replay(SimRenderer* renderer, const vector<int>& visible) const
+{
+	int current = -1;
+	int bound = -1;
+	unsigned int next = 0;
+	for(unsigned int v=0; v<visible.size(); v++)
+	{
+		unsigned int k = visible[v];
+		for(; next <= k; next++)
+			if(draws[next].material >= 0) current = draws[next].material;
+		const SnapshotDraw& d = draws[k];
+		if(current != bound)
+		{
+			renderer->setMaterial(current);
+			bound = current;
+		}
+		renderer->drawMesh(d.mesh, d.world, d.glow);
+	}
+}
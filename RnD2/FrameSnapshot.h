@@ -0,0 +1,94 @@
+//=======================================================================================
+// FrameSnapshot.h
+//
+// Everything the game draws from the World, copied out at the end of a
+// simulation frame: the draw list (mesh, world matrix, material), the view and
+// the HUD values. The render thread draws a snapshot while the simulation thread
+// moves the world on and fills the next one, so nothing drawn reads the World.
+// The scenery is only copied again when the world says it has changed.
+//=======================================================================================
+
+#ifndef FRAME_SNAPSHOT_H
+#define FRAME_SNAPSHOT_H
+
+#include "World.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "StaticBatcher.h"
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+struct SnapshotDraw
+{
+	Box* mesh;
+	Matrix world;
+	int material;
+	bool glow;
+};
+
+//Records the world's draw calls by standing in as its renderer
+class FrameSnapshot : public SimRenderer
+{
+public:
+	FrameSnapshot();
+
+	//Copies out the world, with movement interpolated alpha of the way from the
+	//last step to this one. Only the thread updating the world may call it.
+	void capture(World* world, float alpha);
+	//Draws what was captured, in the same order and materials
+	void replay(SimRenderer* renderer) const;
+	//The scenery, the same way
+	void replayStatic(SimRenderer* renderer) const;
+	//Culls the draws against this snapshot's view, leaving the culler's visible
+	//list ready for the replay below. Meshes are as big as sizes says, or
+	//unscaled without it.
+	void cull(FrustumCuller* culler, const MeshSizes* sizes) const;
+	//Takes the draws in visible hidden behind the nearest big ones out of it,
+	//with meshes sized as for cull(). Given the scenery's pieces, the big boxes
+	//in them hide things too, and hidden pieces are taken out of their list the
+	//same way.
+	void occlude(OcclusionCuller* occlusion, const MeshSizes* sizes, vector<int>* visible, StaticBatcher* statics = 0,
+		vector<int>* pieces = 0) const;
+	//Only the draws in visible, which must be in order, each with the material
+	//it had in the full list
+	void replay(SimRenderer* renderer, const vector<int>& visible) const;
+
+	virtual void setMaterial(int m) {material = m;}
+	virtual void drawMesh(Box* mesh, const Matrix& world, bool glow);
+
+	GameState gameState;
+	int level;
+	bool debugMode;
+	float daylight;
+	Matrix view;
+	Matrix proj;
+	Vector3 eyePos;
+
+	//HUD
+	int score;
+	int health;
+	int ammo;
+	string gunName;
+	string timeOfDay;
+	int dayCount;
+	Vector3 playerPos;
+	bool attacked;
+	int activeEnemies;
+	int liveBullets;
+	//Debug mode only
+	vector<Vector3> waypoints;
+
+	//Everything that may move
+	vector<SnapshotDraw> draws;
+	//The scenery as of staticVersion
+	vector<SnapshotDraw> staticDraws;
+	int staticVersion;
+
+private:
+	int material;
+	bool capturingStatic;
+};
+
+#endif
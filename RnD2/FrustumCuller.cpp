@@ -0,0 +1,145 @@
+#include "FrustumCuller.h"
+#include "PerfStats.h"
+#include <math.h>
+#ifdef FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+FrustumCuller::FrustumCuller()
+{
+	count = 0;
+	for(int p=0; p<frustumNS::NUM_PLANES; p++)
+	{
+		planes[p][0] = planes[p][1] = planes[p][2] = 0;
+		planes[p][3] = 1;
+	}
+}
+
+//Gribb and Hartmann: with row vectors clip = v*M, so each plane is a sum or
+//difference of M's columns. D3D's clip z runs 0 to w, so near is column 3 alone.
+void FrustumCuller::setViewProj(const Matrix& m)
+{
+	using namespace frustumNS;
+	float col[4][4];
+	for(int j=0; j<4; j++)
+	{
+		col[j][0] = m(0, j);
+		col[j][1] = m(1, j);
+		col[j][2] = m(2, j);
+		col[j][3] = m(3, j);
+	}
+	for(int k=0; k<4; k++)
+	{
+		planes[LEFT_PLANE][k] = col[3][k] + col[0][k];
+		planes[RIGHT_PLANE][k] = col[3][k] - col[0][k];
+		planes[BOTTOM_PLANE][k] = col[3][k] + col[1][k];
+		planes[TOP_PLANE][k] = col[3][k] - col[1][k];
+		planes[NEAR_PLANE][k] = col[2][k];
+		planes[FAR_PLANE][k] = col[3][k] - col[2][k];
+	}
+	for(int p=0; p<NUM_PLANES; p++)
+	{
+		float len = sqrt(planes[p][0]*planes[p][0] + planes[p][1]*planes[p][1] + planes[p][2]*planes[p][2]);
+		if(len > 0)
+			for(int k=0; k<4; k++) planes[p][k] /= len;
+	}
+}
+
+void FrustumCuller::clear()
+{
+	count = 0;
+	cx.clear(); cy.clear(); cz.clear();
+	ex.clear(); ey.clear(); ez.clear();
+	visible.clear();
+}
+
+void FrustumCuller::add(const Vector3& centre, const Vector3& halfExtents)
+{
+	cx.push_back(centre.x); cy.push_back(centre.y); cz.push_back(centre.z);
+	ex.push_back(halfExtents.x); ey.push_back(halfExtents.y); ez.push_back(halfExtents.z);
+	count++;
+}
+
+//The model box's centre is (0, s, 0) with half-extents of s, so the world box
+//is that centre moved, and each half-extent s times the sum of the matrix's
+//column magnitudes
+void FrustumCuller::addMesh(const Matrix& w, float s)
+{
+	Vector3 centre(s*w._21 + w._41, s*w._22 + w._42, s*w._23 + w._43);
+	Vector3 half(fabs(w._11) + fabs(w._21) + fabs(w._31),
+		fabs(w._12) + fabs(w._22) + fabs(w._32),
+		fabs(w._13) + fabs(w._23) + fabs(w._33));
+	add(centre, half*s);
+}
+
+//Zero-sized boxes at the origin fill out the last group; cull() never reports them
+void FrustumCuller::pad()
+{
+	while(cx.size() % frustumNS::LANES)
+	{
+		cx.push_back(0); cy.push_back(0); cz.push_back(0);
+		ex.push_back(0); ey.push_back(0); ez.push_back(0);
+	}
+}
+
+//Outside when even the corner furthest along the plane's normal is behind it
+bool FrustumCuller::outside(int i)
+{
+	for(int p=0; p<frustumNS::NUM_PLANES; p++)
+	{
+		const float* n = planes[p];
+		float d = n[0]*cx[i] + n[1]*cy[i] + n[2]*cz[i] + n[3];
+		float r = fabs(n[0])*ex[i] + fabs(n[1])*ey[i] + fabs(n[2])*ez[i];
+		if(d + r < 0) return true;
+	}
+	return false;
+}
+
+void FrustumCuller::cullScalar()
+{
+	visible.clear();
+	for(int i=0; i<count; i++)
+		if(!outside(i)) visible.push_back(i);
+}
+
+void FrustumCuller::cull()
+{
+	PROFILE_ZONE("FrustumCuller::cull");
+	visible.clear();
+#ifdef FRUSTUM_SSE
+	pad();
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 n[frustumNS::NUM_PLANES][4];
+	__m128 absN[frustumNS::NUM_PLANES][3];
+	for(int p=0; p<frustumNS::NUM_PLANES; p++)
+		for(int k=0; k<4; k++)
+		{
+			n[p][k] = _mm_set1_ps(planes[p][k]);
+			if(k < 3) absN[p][k] = _mm_andnot_ps(signMask, n[p][k]);
+		}
+
+	const __m128 zero = _mm_setzero_ps();
+	for(int i=0; i<count; i+=frustumNS::LANES)
+	{
+		__m128 x = _mm_loadu_ps(&cx[i]), y = _mm_loadu_ps(&cy[i]), z = _mm_loadu_ps(&cz[i]);
+		__m128 hx = _mm_loadu_ps(&ex[i]), hy = _mm_loadu_ps(&ey[i]), hz = _mm_loadu_ps(&ez[i]);
+		__m128 out = zero;
+		for(int p=0; p<frustumNS::NUM_PLANES; p++)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[p][0], x), _mm_mul_ps(n[p][1], y)),
+				_mm_add_ps(_mm_mul_ps(n[p][2], z), n[p][3]));
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absN[p][0], hx), _mm_mul_ps(absN[p][1], hy)),
+				_mm_mul_ps(absN[p][2], hz));
+			out = _mm_or_ps(out, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+		}
+		int mask = _mm_movemask_ps(out);
+		for(int lane=0; lane<frustumNS::LANES && i+lane<count; lane++)
+			if(!(mask & (1 << lane))) visible.push_back(i + lane);
+	}
+#else
+	for(int i=0; i<count; i++)
+		if(!outside(i)) visible.push_back(i);
+#endif
+	PERF_COUNT_N(PERF_VISIBLE, getVisibleCount());
+	PERF_COUNT_N(PERF_CULLED, getCulledCount());
+}
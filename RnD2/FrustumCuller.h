@@ -0,0 +1,62 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include "constants.h"
+#include <vector>
+using std::vector;
+
+//SSE is always there on x64 and MSVC has the intrinsics on x86 too; anything
+//else gets the plain loop, which gives the same answers
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define FRUSTUM_SSE
+#endif
+
+namespace frustumNS {
+	//Boxes tested at once; the arrays are padded to a multiple of this
+	const int LANES = 4;
+	enum {LEFT_PLANE, RIGHT_PLANE, BOTTOM_PLANE, TOP_PLANE, NEAR_PLANE, FAR_PLANE, NUM_PLANES};
+}
+
+//Throws out boxes that are wholly outside the view. Boxes are kept as
+//structure-of-arrays, centres and half-extents, so four go through each plane
+//at once. A box is only culled when it is entirely behind one plane, so some
+//off-screen boxes near the corners survive; nothing on screen is lost.
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	//The planes, from the row-vector view*projection the game draws with
+	void setViewProj(const Matrix& vp);
+	//a*x + b*y + c*z + d, positive inside
+	const float* getPlane(int i) {return planes[i];}
+
+	void clear();
+	void add(const Vector3& centre, const Vector3& halfExtents);
+	//The box a Box mesh of the given scale covers once moved by world. Box's
+	//model space is -1 to 1 across and 0 to 2 up, times its scale.
+	void addMesh(const Matrix& world, float scale);
+
+	//Fills the visible list with the indices, in the order added, of the boxes
+	//that may be on screen
+	void cull();
+	//The same one box at a time, to check cull() against
+	void cullScalar();
+
+	const vector<int>& getVisible() {return visible;}
+	int getCount() {return count;}
+	int getVisibleCount() {return visible.size();}
+	int getCulledCount() {return count - visible.size();}
+
+private:
+	void pad();
+	bool outside(int i);
+
+	float planes[frustumNS::NUM_PLANES][4];
+	int count;
+	vector<float> cx, cy, cz;
+	vector<float> ex, ey, ez;
+	vector<int> visible;
+};
+
+#endif
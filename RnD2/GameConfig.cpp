@@ -0,0 +1,63 @@
+#include "GameConfig.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+using std::string;
+
+GameConfig::GameConfig()
+{
+	maxEnemies = configNS::DEFAULT_MAX_ENEMIES;
+	waypointGrid = WAYPOINT_SIZE;
+	lights = configNS::DEFAULT_LIGHTS;
+	fires = configNS::DEFAULT_FIRES;
+}
+
+static bool readCount(std::istringstream& ss, int& value, int low, int high)
+{
+	int v;
+	if(!(ss >> v)) return false;
+	value = v < low ? low : (v > high ? high : v);
+	return true;
+}
+
+static bool readSeed(std::istringstream& ss, unsigned int& value)
+{
+	unsigned int v;
+	if(!(ss >> v)) return false;
+	value = v;
+	return true;
+}
+
+bool GameConfig::loadFromFile(const char* filename)
+{
+	std::ifstream in(filename);
+	if(!in) return false;
+
+	GameConfig read = *this;
+	bool ok = true;
+	string line;
+	while(ok && std::getline(in, line))
+	{
+		line = line.substr(0, line.find('#'));
+		std::istringstream ss(line);
+		string key;
+		if(!(ss >> key)) continue;
+
+		if(key == "max_enemies") ok = readCount(ss, read.maxEnemies, 0, configNS::MAX_ENEMIES);
+		else if(key == "waypoint_grid") ok = readCount(ss, read.waypointGrid, configNS::MIN_WAYPOINT_GRID, configNS::MAX_WAYPOINT_GRID);
+		else if(key == "lights") ok = readCount(ss, read.lights, configNS::MIN_LIGHTS, configNS::MAX_LIGHTS);
+		else if(key == "fires") ok = readCount(ss, read.fires, 0, configNS::MAX_LIGHTS);
+		else if(key == "scenario_seed") ok = readSeed(ss, read.scenario.seed);
+		else if(key == "scenario_buildings") ok = readCount(ss, read.scenario.buildings, 0, scenarioNS::MAX_STATIC);
+		else if(key == "scenario_walls") ok = readCount(ss, read.scenario.walls, 0, scenarioNS::MAX_STATIC);
+		else if(key == "scenario_barrels") ok = readCount(ss, read.scenario.barrels, 0, scenarioNS::MAX_STATIC);
+		else if(key == "scenario_lamps") ok = readCount(ss, read.scenario.lamps, 0, scenarioNS::MAX_STATIC);
+		else if(key == "scenario_pickups") ok = readCount(ss, read.scenario.pickups, 0, scenarioNS::MAX_DYNAMIC);
+		else if(key == "scenario_enemies") ok = readCount(ss, read.scenario.enemies, 0, scenarioNS::MAX_DYNAMIC);
+		else ok = false;
+	}
+
+	if(!ok) return false;
+	*this = read;
+	return true;
+}
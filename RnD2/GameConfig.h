@@ -0,0 +1,42 @@
+#ifndef GAME_CONFIG_H
+#define GAME_CONFIG_H
+
+#include "constants.h"
+#include "Scenario.h"
+
+namespace configNS {
+	const char DEFAULT_FILE[] = "game.txt";
+
+	const int DEFAULT_MAX_ENEMIES = 20;
+	const int DEFAULT_LIGHTS = 15;
+	const int DEFAULT_FIRES = 12;
+	//The lighting shader's gLight array; the first three are the sun, a spare
+	//and the flashlight
+	const int MAX_LIGHTS = 30;
+	const int MIN_LIGHTS = 3;
+	//Enemies find the centre of the grid, so it needs one
+	const int MIN_WAYPOINT_GRID = 3;
+	const int MAX_WAYPOINT_GRID = 64;
+	const int MAX_ENEMIES = 65536;
+}
+
+//How many of everything to make room for, read at startup. The pools are
+//allocated once at these sizes, so raising them is an edit to game.txt rather
+//than a recompile.
+struct GameConfig
+{
+	int maxEnemies;
+	//Waypoints along each side of the enemies' nav grid
+	int waypointGrid;
+	//Lights the shader adds up, and fires drawn on the level 2 barrels
+	int lights;
+	int fires;
+	//A generated city to play instead of the levels, if it has anything in it
+	ScenarioDesc scenario;
+
+	GameConfig();
+	//Keeps the values it had if the file is missing or has a bad line
+	bool loadFromFile(const char* filename);
+};
+
+#endif
@@ -15,6 +15,9 @@ GameObject::GameObject()
 	facedObject = NULL;
 	facedCoordinate = Vector3(0,0,0);
 	glow = false;
+	material = -1;
+	box = NULL;
+	interpolated = false;
 }
 
 GameObject::~GameObject()
@@ -32,7 +35,7 @@ void GameObject::faceObject(Vector3 coordinate) {
 	facedCoordinate = coordinate;
 }
 
-void GameObject::draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP)
+void GameObject::draw(SimRenderer* renderer)
 {
 
 	if (!active) return;	
@@ -47,29 +50,14 @@ void GameObject::draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixV
 	}
 
 	transformation = transform(Vector3(1,1,1), Vector3(0,rotY,0), Vector3(0,0,0));
-	drawWithWorld(mfxWVPVar, mfxWorldVar, mTech, mVP, transformation);
+	drawWithWorld(renderer, transformation);
 }
 
-void GameObject::drawWithWorld(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP, Matrix transformation) {
-	if (glow) {
-		mfxGlow->SetInt(2);
-	}
-	else mfxGlow->SetInt(0);
-	Matrix worldMatrix = GameObject::world;
+void GameObject::drawWithWorld(SimRenderer* renderer, Matrix transformation) {
+	Matrix worldMatrix = getInterpolatedWorld(renderer->getInterpolation());
 	worldMatrix=transformation*worldMatrix;
-	Matrix mWVP = worldMatrix* (*mVP);
-	mfxWVPVar->SetMatrix((float*)&mWVP);
-	mfxWorldVar->SetMatrix((float*)&worldMatrix);
-	D3D10_TECHNIQUE_DESC techDesc;
-	mTech->GetDesc( &techDesc );
-	for(UINT p = 0; p < techDesc.Passes; ++p)
-	{
-		mTech->GetPassByIndex( p )->Apply(0);
-		box->draw();
-	}
-
-	if (glow)
-		mfxGlow->SetInt(0);
+	if(material >= 0) renderer->setMaterial(material);
+	renderer->drawMesh(box, worldMatrix, glow);
 }
 
 
@@ -117,10 +105,6 @@ void GameObject::init(Box *b, float r, Vector3 pos, Vector3 vel, float sp, float
 	width = w*s;
 	depth = d*s;
 	height = h*s;
-	D3DXVECTOR3 temp = box->getColor();
-	mfxCubeColorVar	= box->getMFX()->GetVariableByName("gCubeColor");
-	mfxGlow			= box->getMFX()->GetVariableByName("gGlow")->AsScalar();
-	mfxCubeColorVar->SetRawValue(&box->getColor(), 0, sizeof(D3DXVECTOR3));
 }
 
 void GameObject::update(float dt)
@@ -133,6 +117,25 @@ void GameObject::update(float dt)
 
 }
 
+void GameObject::savePrevious()
+{
+	prevPosition = position;
+	interpolated = true;
+}
+
+//The world matrix slid back from position toward prevPosition. Only the
+//translation moves; objects that never save a previous position draw as they are.
+Matrix GameObject::getInterpolatedWorld(float alpha)
+{
+	Matrix m = world;
+	if(!interpolated) return m;
+	Vector3 back = (position - prevPosition) * (1.0f - alpha);
+	m._41 -= back.x;
+	m._42 -= back.y;
+	m._43 -= back.z;
+	return m;
+}
+
 //Note that this collision only works for axis-aligned cubes
 bool GameObject::collided(GameObject *gameObject)
 {
@@ -2,22 +2,20 @@
 #ifndef GameObject_H
 #define GameObject_H
 
-//#include "d3dUtil.h"
-#include "d3dUtil.h"
-#include "Box.h"
 #include "constants.h"
+#include "SimRenderer.h"
 
 class GameObject
 {
 public:
 
 	GameObject();
-	~GameObject();
+	virtual ~GameObject();
 	//				   geom,  rad,  position,				sc,	w,		h,	d
 	//walls[0].init(&brick, 2.0f, Vector3(155, 0, 250), 	1,	115,	10, 10);//	Left/Front wall 
 	void init(Box *b, float r, Vector3 pos, Vector3 vel, float sp, float s = 1.0f, float w = 1.0f, float h = 1.0f, float d = 1.0f);
-	virtual void draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP);
-	virtual void drawWithWorld(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP, Matrix transformation);
+	virtual void draw(SimRenderer* renderer);
+	virtual void drawWithWorld(SimRenderer* renderer, Matrix transformation);
 	virtual void update(float dt);
 
 	void setPosition (Vector3 pos) {position = pos;}
@@ -30,6 +28,9 @@ public:
 	float getRadiusSquare() {return radiusSquared;}
 	float getRadius() {return radius;}
 	Matrix getWorldMatrix() {return world;}
+	//For drawing between fixed simulation steps: call savePrevious before each step
+	void savePrevious();
+	Matrix getInterpolatedWorld(float alpha);
 	void setScale(float s) {scale = s; radiusSquared = (s*radius)*(s*radius);}
 	float getScale() {return scale;}
 	void setActive() {active = true;}
@@ -53,6 +54,10 @@ public:
 	virtual float getDepth(){return depth;}
 
 	void setBox(Box* b){box = b;}
+	Box* getBox(){return box;}
+	//SimMaterial to draw with, or -1 to use whatever is already set
+	void setMaterial(int m){material = m;}
+	int getMaterial(){return material;}
 
 private:
 	float speed;
@@ -60,6 +65,8 @@ private:
 protected:
 	Box *box;
 	Vector3 position;
+	Vector3 prevPosition;
+	bool interpolated;
 	Matrix world;
 	float scale;
 	float rotX, rotY, rotZ;
@@ -73,9 +80,8 @@ protected:
 	bool facing;
 	GameObject* facedObject;
 	Vector3 facedCoordinate;
-	ID3D10EffectScalarVariable* mfxGlow;
-	ID3D10EffectVariable* mfxCubeColorVar;
 	bool glow;
+	int material;
 };
 
 
@@ -3,15 +3,37 @@
 //=======================================================================================
 
 #include "GameTimer.h"
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// The performance counter on Windows, a monotonic nanosecond clock elsewhere.
+static long long readCounter()
+{
+#ifdef _WIN32
+	__int64 count;
+	QueryPerformanceCounter((LARGE_INTEGER*)&count);
+	return count;
+#else
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec*1000000000LL + ts.tv_nsec;
+#endif
+}
 
 GameTimer::GameTimer()
 : mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0), 
   mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
 {
+#ifdef _WIN32
 	__int64 countsPerSec;
 	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
 	mSecondsPerCount = 1.0 / (double)countsPerSec;
+#else
+	mSecondsPerCount = 1.0e-9;
+#endif
 }
 
 // Returns the total time elapsed since reset() was called, NOT counting any
@@ -49,10 +71,16 @@ float GameTimer::getDeltaTime()const
 	return (float)mDeltaTime;
 }
 
+// Reads the performance counter now, regardless of tick() or pausing.
+double GameTimer::getRealTime()const
+{
+	long long currTime = readCounter();
+	return currTime*mSecondsPerCount;
+}
+
 void GameTimer::reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	long long currTime = readCounter();
 
 	mBaseTime = currTime;
 	mPrevTime = currTime;
@@ -62,8 +90,7 @@ void GameTimer::reset()
 
 void GameTimer::start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	long long startTime = readCounter();
 
 
 	// Accumulate the time elapsed between stop and start pairs.
@@ -86,8 +113,7 @@ void GameTimer::stop()
 {
 	if( !mStopped )
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		long long currTime = readCounter();
 
 		mStopTime = currTime;
 		mStopped  = true;
@@ -102,8 +128,7 @@ void GameTimer::tick()
 		return;
 	}
 
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	long long currTime = readCounter();
 	mCurrTime = currTime;
 
 	// Time difference between this frame and the previous.
@@ -13,6 +13,7 @@ public:
 
 	float getGameTime()const;  // in seconds
 	float getDeltaTime()const; // in seconds
+	double getRealTime()const; // in seconds, straight off the counter, for timing code
 
 	void reset(); // Call before message loop.
 	void start(); // Call when unpaused.
@@ -23,11 +24,11 @@ private:
 	double mSecondsPerCount;
 	double mDeltaTime;
 
-	__int64 mBaseTime;
-	__int64 mPausedTime;
-	__int64 mStopTime;
-	__int64 mPrevTime;
-	__int64 mCurrTime;
+	long long mBaseTime;
+	long long mPausedTime;
+	long long mStopTime;
+	long long mPrevTime;
+	long long mCurrTime;
 
 	bool mStopped;
 };
@@ -4,33 +4,35 @@
 #include<iostream>
 #include "constants.h"
 #include "Bullet.h"
-#include "Box.h"
 #include <ctime>
-#include "Audio.h"
 #include <string>
+#include "SimRandom.h"
 
 using namespace std;
 
 
 class Gun {
 public:
+	virtual ~Gun() {}
 	virtual void shoot(Vector3 startingPosition, Vector3 axis, double timeSinceLastShot){} //Need to override in children
 	void update(float dt) {
 		for (int i = 0; i < bullets->size(); i++) {
 			//a bullet will be set to inactive after it has been in the air for three seconds.
 			//if it's inactive, it will be removed from the vector of bullets.
 			if (!bullets->at(i)->getActiveState()) { 
-				bullets->erase(bullets->begin()+i); //is this causing a mem leak?
+				delete bullets->at(i);
+				bullets->erase(bullets->begin()+i);
+				i--;
 			}
 		}
 		for (int i = 0; i < bullets->size(); i++) {
 			bullets->at(i)->update(dt);
 		}
 	}
-	void draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectTechnique* mTech, Matrix* mVP) {
+	void draw(SimRenderer* renderer) {
 		for (int i = 0; i < bullets->size(); i++) 
 			if(bullets->at(i)->getActiveState())
-				bullets->at(i)->draw(mfxWVPVar, mTech, mVP);
+				bullets->at(i)->draw(renderer);
 	}
 	float getShotDelay() {return shotDelay;}
 	string getName() {return name;}
@@ -68,7 +70,6 @@ public:
 class Shotgun : public Gun {
 public:
 	Shotgun(Box* b, vector<Bullet*>* theBullets) {
-		srand(time(0));
 		bulletBox = b;
 		bullets = theBullets;
 		damage = 4;
@@ -78,8 +79,8 @@ public:
 
 	float randOffset(float shotGunSprayConstant = 0.2) {
 		float constant = shotGunSprayConstant; //increase for wider bullet spread
-		float negate = (rand()%2 == 1)? -1.0f : 1.0f;
-		return ((rand()%600)/100.0f+0.8f)*constant*negate;
+		float negate = (SimRandom::next()%2 == 1)? -1.0f : 1.0f;
+		return ((SimRandom::next()%600)/100.0f+0.8f)*constant*negate;
 	}
 
 	void shoot(Vector3 startingPosition, Vector3 axis, double timeSinceLastShot) {		
@@ -0,0 +1,471 @@
+//=======================================================================================
+// HeadlessMain.cpp
+//
+// rugger_headless [options] <ticks> [input script] [dt]
+// rugger_headless [options] --replay <log.rpl>
+//
+//	--record <log.rpl>	record the run for replaying later
+//	--repeat <n>		play the replay n times, for timing
+//	--trace <file.json>	write the profiler zones from the end of the run
+//	--threads <n>		job system worker threads besides the main one (default 0)
+//	--batches			check the renderer's culling and batching on the fixed
+//						scenes in RenderChecks, then stop
+//	--config <file>		capacities and scenario to use instead of game.txt (see
+//						stress.txt). A replay needs the config it was recorded with.
+//	--packing			check PackedVertex round trips, then stop
+//	--decode <image>	decode a PNG, JPEG or DDS file on the texture loader's
+//						--threads threads and print what came out, then stop;
+//						may be given more than once
+//	--pack <file.pak>	map an asset pack made by rugger_pack and go through its
+//						textures as the game uploads them, printing the same as
+//						--decode, then stop
+//
+// Steps the simulation with no window, renderer or sound and prints how fast it
+// went. Input comes from a ScriptedInput script (see headless.txt); without one
+// the player just stands there while the night comes. A replay feeds back a log
+// recorded here or by the game and checks the state hash after every frame.
+//=======================================================================================
+
+#include "World.h"
+#include "ScriptedInput.h"
+#include "Replay.h"
+#include "SimRandom.h"
+#include "GameTimer.h"
+#include "Profiler.h"
+#include "FixedTimestep.h"
+#include "JobSystem.h"
+#include "StaticBatcher.h"
+#include "PackedVertex.h"
+#include "TextureLoader.h"
+#include "RenderChecks.h"
+#include "AssetPack.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace headlessNS {
+	const int DEFAULT_TICKS = 10000;
+	//The step the game runs at
+	const float DEFAULT_DT = timestepNS::STEP;
+	//Same seed every run so runs are comparable
+	const unsigned int SEED = 1234;
+	const char* STATE_NAMES[] = {"INTROSCREEN", "INSTRUCTIONS", "BEATLV1", "WIN", "LOSE", "PLAYING"};
+	//Normals spread over the sphere for the packing check
+	const int PACKING_NORMALS = 100000;
+	//Furthest an octahedron-packed normal may come back from where it was
+	const float PACKED_NORMAL_MAX_DEGREES = 0.01f;
+	const int MAX_DECODES = 64;
+	const char* FORMAT_NAMES[] = {"RGBA8", "BC1", "BC2", "BC3", "BC4"};
+}
+
+//What a PackedVertex must give back: every half exactly as it went in and any
+//float to within half a step, every UNORM8 colour exactly, any unit normal to
+//within PACKED_NORMAL_MAX_DEGREES, and a static box's vertices with no error
+//at all, since its corners, axis normals and 0/1 coordinates are all exact.
+static bool checkPacking()
+{
+	int failures = 0;
+
+	int halves = 0;
+	for(int h=0; h<65536; h++)
+	{
+		unsigned short bits = (unsigned short)h;
+		//NaNs only have to stay NaNs
+		if((bits & 0x7c00) == 0x7c00 && (bits & 0x3ff)) halves += (floatToHalf(halfToFloat(bits)) & 0x3ff) != 0;
+		else halves += floatToHalf(halfToFloat(bits)) == bits;
+	}
+	if(halves != 65536) failures++;
+	//2^-11 relative is half a step for a normal half
+	float worstHalf = 0;
+	for(int i=0; i<100000; i++)
+	{
+		float f = (i - 50000) * 0.0123457f;
+		if(f == 0.0f) continue;
+		float err = fabs(halfToFloat(floatToHalf(f)) - f) / fabs(f);
+		if(err > worstHalf) worstHalf = err;
+	}
+	if(worstHalf > 1.0f/2048) failures++;
+
+	int colors = 0;
+	for(int c=0; c<256; c++)
+		colors += floatToUnorm8(c / packedVertexNS::UNORM8_SCALE) == c;
+	if(colors != 256) failures++;
+
+	//A Fibonacci spiral, which covers the sphere evenly, then the axes and the
+	//octahedron's folds
+	float worstDegrees = 0;
+	for(int i=0; i<headlessNS::PACKING_NORMALS + 10; i++)
+	{
+		Vector3 n;
+		if(i < headlessNS::PACKING_NORMALS) {
+			float y = 1.0f - 2.0f*(i + 0.5f)/headlessNS::PACKING_NORMALS;
+			float r = sqrt(1.0f - y*y);
+			float a = i*2.39996323f;
+			n = Vector3(r*cos(a), y, r*sin(a));
+		} else {
+			static const float EXTRA[10][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+				{1, 1, -1}, {-1, 1, -1}, {1, -1, -1}, {-1, -1, -1}};
+			const float* e = EXTRA[i - headlessNS::PACKING_NORMALS];
+			n = Vector3(e[0], e[1], e[2]);
+		}
+		D3DXVec3Normalize(&n, &n);
+		short packed[2];
+		packNormal(n, packed);
+		Vector3 back = unpackNormal(packed);
+		//From the cross product, since a dot this close to 1 is all rounding
+		Vector3 cross;
+		D3DXVec3Cross(&cross, &n, &back);
+		float degrees = atan2(D3DXVec3Length(&cross), D3DXVec3Dot(&n, &back)) * 180.0f / 3.14159265f;
+		if(degrees > worstDegrees) worstDegrees = degrees;
+	}
+	if(worstDegrees > headlessNS::PACKED_NORMAL_MAX_DEGREES) failures++;
+
+	StaticBatcher statics;
+	Matrix world;
+	Identity(&world);
+	statics.drawMesh(NULL, world, false);
+	statics.build();
+	PackedVertex box[staticBatchNS::BOX_VERTICES];
+	statics.fillVertices(0, box);
+	int exact = 0;
+	for(int i=0; i<staticBatchNS::BOX_VERTICES; i++)
+	{
+		Vector3 pos, normal;
+		float color[4], u, v;
+		unpackVertex(box[i], &pos, &normal, color, &u, &v);
+		//On the face its normal says, which is one of the axes
+		float along = pos.x*normal.x + pos.y*normal.y + pos.z*normal.z;
+		bool ok = fabs(normal.x) + fabs(normal.y) + fabs(normal.z) == 1.0f;
+		ok = ok && along == (normal.y < 0 ? 0.0f : normal.y > 0 ? 2.0f : 1.0f);
+		ok = ok && (u == 0.0f || u == 1.0f) && (v == 0.0f || v == 1.0f);
+		ok = ok && color[0] == 1.0f && color[1] == 1.0f && color[2] == 1.0f && color[3] == 1.0f;
+		exact += ok;
+	}
+	if(exact != staticBatchNS::BOX_VERTICES) failures++;
+
+	printf("packing:        %d-byte vertices\n", (int)sizeof(PackedVertex));
+	printf("halves:         %d of 65536 round-trip, worst %.2g relative\n", halves, worstHalf);
+	printf("colours:        %d of 256 round-trip\n", colors);
+	printf("normals:        worst %.4f degrees of %d\n", worstDegrees, headlessNS::PACKING_NORMALS + 10);
+	printf("box vertices:   %d of %d exact\n", exact, staticBatchNS::BOX_VERTICES);
+	if(failures == 0) printf("packing checks: all match\n");
+	else printf("packing checks: %d differ\n", failures);
+	return failures == 0;
+}
+
+//Most memory the process has held at once, in MB, or -1 where that isn't known
+static double peakMemoryMb()
+{
+#ifdef _WIN32
+	return -1;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+//One texture as --decode and --pack print it, with a checksum of its top
+//level to compare between runs and between the two
+static void printTexture(const char* name, const TextureData& layout, const unsigned char* texels)
+{
+	unsigned int hash = 2166136261u;
+	int top = layout.getMipSize(0);
+	for(int k=0; k<top; k++)
+		hash = (hash ^ texels[k]) * 16777619u;
+	printf("%-24s %dx%d %s, %d mips, %d bytes, top level %08x\n", name, layout.width, layout.height,
+		headlessNS::FORMAT_NAMES[layout.format], layout.mipLevels, layout.getMipOffset(layout.mipLevels), hash);
+}
+
+static void printLoad(const char* what, int loaded, int count, long long bytes, double elapsed, int threads)
+{
+	printf("%-16s%d of %d textures, %.1f MB in %.1f ms on %d threads\n", what, loaded, count,
+		bytes / (1024.0*1024.0), elapsed*1000.0, threads);
+	double peak = peakMemoryMb();
+	if(peak >= 0) printf("peak memory:    %.1f MB\n", peak);
+}
+
+//Decodes the files the way the game loads textures that aren't in its pack
+static bool decodeImages(const char** files, int count, int threads)
+{
+	TextureLoader loader;
+	loader.start(threads);
+	GameTimer timer;
+	timer.reset();
+	double start = timer.getRealTime();
+	for(int i=0; i<count; i++)
+		loader.request(i, files[i]);
+	int failures = 0;
+	long long bytes = 0;
+	while(loader.getPending() > 0)
+	{
+		int id;
+		bool ok;
+		TextureData data;
+		if(!loader.takeDone(&id, &data, &ok))
+		{
+			Thread::yield();
+			continue;
+		}
+		if(!ok)
+		{
+			printf("%-24s could not decode\n", files[id]);
+			failures++;
+			continue;
+		}
+		printTexture(files[id], data, &data.texels[0]);
+		bytes += data.texels.size();
+	}
+	double elapsed = timer.getRealTime() - start;
+	loader.stop();
+	printLoad("decoded:", count - failures, count, bytes, elapsed, threads);
+	return failures == 0;
+}
+
+//Maps the pack and reads every texture from it once, letting its pages go
+//after, the way TextureMgr uploads them
+static bool loadPack(const char* file)
+{
+	GameTimer timer;
+	timer.reset();
+	double start = timer.getRealTime();
+	AssetPack pack;
+	if(!pack.open(file))
+	{
+		fprintf(stderr, "could not open asset pack %s\n", file);
+		return false;
+	}
+	long long bytes = 0;
+	for(int i=0; i<pack.getEntryCount(); i++)
+	{
+		const PackEntry* e = pack.getEntry(i);
+		TextureData layout;
+		const unsigned char* texels = pack.getTexels(e, &layout);
+		printTexture(e->name, layout, texels);
+		pack.release(e);
+		bytes += e->size;
+	}
+	double elapsed = timer.getRealTime() - start;
+	printLoad("mapped:", pack.getEntryCount(), pack.getEntryCount(), bytes, elapsed, 0);
+	return true;
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: rugger_headless [--record log.rpl] [--trace file.json] [--threads n] [--config file] <ticks> [input script] [dt]\n");
+	fprintf(stderr, "       rugger_headless [--repeat n] [--trace file.json] [--threads n] [--config file] --replay log.rpl\n");
+	fprintf(stderr, "       rugger_headless --packing\n");
+	fprintf(stderr, "       rugger_headless --batches\n");
+	fprintf(stderr, "       rugger_headless [--threads n] --decode image [--decode image ...]\n");
+	fprintf(stderr, "       rugger_headless --pack file.pak\n");
+}
+
+static World* newWorld(ReplayInput* input, SimAudio* audio, unsigned int flags, const char* config)
+{
+	World* world = new World;
+	world->init(input, audio, WorldMeshes(), config);
+	if(flags & replayNS::START_PLAYING) world->startPlaying();
+	return world;
+}
+
+static bool gameOver(World* world)
+{
+	return world->getGameState() == LOSE || world->getGameState() == WIN;
+}
+
+static void printRun(const char* what, int ticks, float simTime, double elapsed)
+{
+	printf("%-16s%d\n", what, ticks);
+	printf("sim time:       %.1f s\n", simTime);
+	printf("wall time:      %.3f s\n", elapsed);
+	printf("ticks/sec:      %.0f\n", elapsed > 0 ? ticks/elapsed : 0.0);
+}
+
+static void printState(World* world)
+{
+	printf("final state:    %s (level %d, day %d, night %d, %d enemies)\n",
+		headlessNS::STATE_NAMES[world->getGameState()], world->getLevel(),
+		world->getDayCount(), world->getNightCount(), world->getActiveEnemyCount());
+}
+
+static void printScenario(World* world)
+{
+	if(!world->isScenario()) return;
+	printf("scenario:       %d buildings, %d walls, %d barrels, %d pickups, %d enemies, %d waypoints\n",
+		world->getBuildingCount(), world->getWallCount(), world->getBarrelCount(),
+		world->getPickupCount(), world->getActiveEnemyCount(), world->getNavGrid().getCount());
+}
+
+//Runs the log and checks every frame's hash. Returns the number of frames that differ.
+static int replay(ReplayLog& log, int repeats, const char* config)
+{
+	ReplayInput input;
+	SimAudio audio;
+	GameTimer timer;
+	timer.reset();
+	int mismatches = 0;
+	int firstMismatch = -1;
+	World* world = 0;
+	double start = timer.getRealTime();
+	for(int r=0; r<repeats; r++)
+	{
+		delete world;
+		SimRandom::seed(log.getSeed());
+		world = newWorld(&input, &audio, log.getFlags(), config);
+		if(r == 0) printScenario(world);
+		for(int i=0; i<log.getFrameCount(); i++)
+		{
+			const ReplayFrame& f = log.getFrame(i);
+			input.setFrame(f);
+			world->setEnemyCostOverride(f.enemyCostMs);
+			world->update(f.dt);
+			if(world->computeStateHash() != f.stateHash)
+			{
+				if(firstMismatch < 0) firstMismatch = i;
+				mismatches++;
+			}
+			if((log.getFlags() & replayNS::RESTART_ON_GAME_OVER) && gameOver(world))
+			{
+				delete world;
+				world = newWorld(&input, &audio, log.getFlags(), config);
+			}
+		}
+	}
+	double elapsed = timer.getRealTime() - start;
+
+	printRun("frames:", log.getFrameCount()*repeats, log.getDuration()*repeats, elapsed);
+	printState(world);
+	if(mismatches == 0) printf("hashes:         all match\n");
+	else printf("hashes:         %d frames differ, first at frame %d\n", mismatches, firstMismatch);
+	delete world;
+	return mismatches;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* recordFile = 0;
+	const char* replayFile = 0;
+	const char* traceFile = 0;
+	int repeats = 1;
+	int threads = 0;
+	const char* config = configNS::DEFAULT_FILE;
+	bool checkBatches = false;
+	bool packing = false;
+	const char* decodes[headlessNS::MAX_DECODES];
+	int numDecodes = 0;
+	const char* packFile = 0;
+	const char* positional[3] = {0, 0, 0};
+	int numPositional = 0;
+	for(int i=1; i<argc; i++)
+	{
+		bool hasValue = i+1 < argc;
+		if(!strcmp(argv[i], "--record") && hasValue) recordFile = argv[++i];
+		else if(!strcmp(argv[i], "--replay") && hasValue) replayFile = argv[++i];
+		else if(!strcmp(argv[i], "--trace") && hasValue) traceFile = argv[++i];
+		else if(!strcmp(argv[i], "--repeat") && hasValue) repeats = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--threads") && hasValue) threads = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--config") && hasValue) config = argv[++i];
+		else if(!strcmp(argv[i], "--batches")) checkBatches = true;
+		else if(!strcmp(argv[i], "--packing")) packing = true;
+		else if(!strcmp(argv[i], "--pack") && hasValue) packFile = argv[++i];
+		else if(!strcmp(argv[i], "--decode") && hasValue && numDecodes < headlessNS::MAX_DECODES) decodes[numDecodes++] = argv[++i];
+		else if(argv[i][0] != '-' && numPositional < 3) positional[numPositional++] = argv[i];
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	if(packing) return checkPacking() ? 0 : 3;
+	if(checkBatches) return checkRendering() ? 0 : 3;
+	if(numDecodes) return decodeImages(decodes, numDecodes, threads) ? 0 : 3;
+	if(packFile) return loadPack(packFile) ? 0 : 3;
+
+	int result = 0;
+	if(replayFile)
+	{
+		ReplayLog log;
+		if(!log.load(replayFile) || log.getFrameCount() == 0 || repeats <= 0)
+		{
+			fprintf(stderr, "could not read replay %s\n", replayFile);
+			return 1;
+		}
+		JobSystem::init(threads);
+		result = replay(log, repeats, config) ? 2 : 0;
+	}
+	else
+	{
+		int ticks = positional[0] ? atoi(positional[0]) : headlessNS::DEFAULT_TICKS;
+		float dt = positional[2] ? (float)atof(positional[2]) : headlessNS::DEFAULT_DT;
+		if(ticks <= 0 || dt <= 0.0f)
+		{
+			usage();
+			return 1;
+		}
+
+		ScriptedInput script;
+		if(positional[1] && !script.loadFromFile(positional[1]))
+		{
+			fprintf(stderr, "could not read input script %s\n", positional[1]);
+			return 1;
+		}
+
+		//A finished game starts over so every tick is a playing tick
+		unsigned int flags = replayNS::START_PLAYING | replayNS::RESTART_ON_GAME_OVER;
+		ReplayRecorder recorder;
+		if(recordFile && !recorder.start(recordFile, headlessNS::SEED, flags))
+		{
+			fprintf(stderr, "could not write replay %s\n", recordFile);
+			return 1;
+		}
+
+		JobSystem::init(threads);
+		SimRandom::seed(headlessNS::SEED);
+		ReplayInput input;
+		SimAudio audio;
+		World* world = newWorld(&input, &audio, flags, config);
+		printScenario(world);
+
+		int games = 1;
+		GameTimer timer;
+		timer.reset();
+		double start = timer.getRealTime();
+		for(int i=0; i<ticks; i++)
+		{
+			script.advance();
+			input.capture(&script);
+			world->update(dt);
+			if(recorder.isRecording())
+			{
+				ReplayFrame f = input.getFrame();
+				f.dt = dt;
+				f.enemyCostMs = world->getEnemyCostMs();
+				f.stateHash = world->computeStateHash();
+				recorder.record(f);
+			}
+			if(gameOver(world))
+			{
+				delete world;
+				world = newWorld(&input, &audio, flags, config);
+				games++;
+			}
+		}
+		double elapsed = timer.getRealTime() - start;
+
+		printRun("ticks:", ticks, ticks*dt, elapsed);
+		printf("games:          %d\n", games);
+		printState(world);
+		if(recorder.isRecording()) printf("recorded:       %d frames to %s\n", recorder.getFrameCount(), recordFile);
+		delete world;
+	}
+
+	JobSystem::shutdown();
+	if(traceFile && !Profiler::writeChromeTrace(traceFile))
+		fprintf(stderr, "could not write trace %s\n", traceFile);
+	return result;
+}
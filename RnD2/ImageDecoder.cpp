@@ -0,0 +1,1316 @@
+#include "ImageDecoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+using namespace textureDataNS;
+
+namespace imageDecoderNS {
+	//Huffman codes this long or shorter are looked up in one step
+	const int FAST_BITS = 9;
+	//Past the end of a deflate or JPEG stream the readers feed zeros; this
+	//many bytes of them and the stream is broken
+	const int MAX_OVERRUN = 8;
+	const int MAX_DIMENSION = 1 << 16;
+}
+
+using namespace imageDecoderNS;
+
+static unsigned int readBE32(const unsigned char* p)
+{
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+static unsigned int readLE32(const unsigned char* p)
+{
+	return p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//=======================================================================================
+// Inflate
+//=======================================================================================
+
+//Reads deflate's bits from the bottom of each byte up
+struct InflateBits
+{
+	const unsigned char* p;
+	const unsigned char* end;
+	unsigned long long bits;
+	int count;
+	int overrun;
+
+	void fill()
+	{
+		while(count <= 56)
+		{
+			unsigned long long b = 0;
+			if(p < end) b = *p++;
+			else overrun++;
+			bits |= b << count;
+			count += 8;
+		}
+	}
+	unsigned int get(int n)
+	{
+		if(count < n) fill();
+		unsigned int v = (unsigned int)(bits & ((1ull << n) - 1));
+		bits >>= n;
+		count -= n;
+		return v;
+	}
+};
+
+static int reverseBits(int v, int n)
+{
+	int r = 0;
+	for(int i=0; i<n; i++)
+	{
+		r = (r << 1) | (v & 1);
+		v >>= 1;
+	}
+	return r;
+}
+
+//Deflate's canonical codes. A code of FAST_BITS or fewer is found straight
+//from the next bits; a longer one by comparing against each length's last.
+struct InflateHuffman
+{
+	//length << 9 | symbol, or 0 for a longer code
+	unsigned short fast[1 << FAST_BITS];
+	unsigned short firstCode[16];
+	unsigned short firstSymbol[16];
+	int maxCode[17];
+	unsigned char size[288];
+	unsigned short value[288];
+
+	bool build(const unsigned char* lengths, int n)
+	{
+		int counts[16] = {0};
+		int nextCode[16];
+		memset(fast, 0, sizeof(fast));
+		memset(size, 0, sizeof(size));
+		for(int i=0; i<n; i++)
+			counts[lengths[i]]++;
+		counts[0] = 0;
+		int code = 0, k = 0;
+		for(int i=1; i<16; i++)
+		{
+			nextCode[i] = code;
+			firstCode[i] = (unsigned short)code;
+			firstSymbol[i] = (unsigned short)k;
+			code += counts[i];
+			if(counts[i] && code - 1 >= (1 << i)) return false;
+			maxCode[i] = code << (16 - i);
+			code <<= 1;
+			k += counts[i];
+		}
+		maxCode[16] = 0x10000;
+		for(int i=0; i<n; i++)
+		{
+			int s = lengths[i];
+			if(!s) continue;
+			int c = nextCode[s] - firstCode[s] + firstSymbol[s];
+			size[c] = (unsigned char)s;
+			value[c] = (unsigned short)i;
+			if(s <= FAST_BITS)
+			{
+				for(int j = reverseBits(nextCode[s], s); j < (1 << FAST_BITS); j += 1 << s)
+					fast[j] = (unsigned short)((s << 9) | i);
+			}
+			nextCode[s]++;
+		}
+		return true;
+	}
+
+	int decode(InflateBits& in) const
+	{
+		if(in.count < 16) in.fill();
+		int f = fast[in.bits & ((1 << FAST_BITS) - 1)];
+		if(f)
+		{
+			int s = f >> 9;
+			in.bits >>= s;
+			in.count -= s;
+			return f & 511;
+		}
+		int k = reverseBits((int)(in.bits & 0xffff), 16);
+		int s;
+		for(s = FAST_BITS + 1; s < 16; s++)
+			if(k < maxCode[s]) break;
+		if(s >= 16) return -1;
+		int b = (k >> (16 - s)) - firstCode[s] + firstSymbol[s];
+		if(b >= 288 || size[b] != s) return -1;
+		in.bits >>= s;
+		in.count -= s;
+		return value[b];
+	}
+};
+
+static const unsigned short LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const unsigned char LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const unsigned short DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const unsigned char DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static bool inflateBlock(InflateBits& in, const InflateHuffman& lit, const InflateHuffman& dist, vector<unsigned char>& out)
+{
+	size_t n = out.size();
+	out.resize(n + 65536);
+	for(;;)
+	{
+		int sym = lit.decode(in);
+		if(sym < 0 || in.overrun > MAX_OVERRUN) return false;
+		if(n + 258 > out.size()) out.resize(out.size()*2);
+		if(sym < 256)
+		{
+			out[n++] = (unsigned char)sym;
+			continue;
+		}
+		if(sym == 256) break;
+		sym -= 257;
+		if(sym >= 29) return false;
+		int length = LENGTH_BASE[sym] + in.get(LENGTH_EXTRA[sym]);
+		int d = dist.decode(in);
+		if(d < 0 || d >= 30) return false;
+		size_t distance = DIST_BASE[d] + in.get(DIST_EXTRA[d]);
+		if(distance > n) return false;
+		unsigned char* dst = &out[n];
+		const unsigned char* src = dst - distance;
+		for(int i=0; i<length; i++)
+			dst[i] = src[i];
+		n += length;
+	}
+	out.resize(n);
+	return true;
+}
+
+bool inflateZlib(const unsigned char* data, size_t size, vector<unsigned char>& out)
+{
+	if(size < 2) return false;
+	int cmf = data[0], flg = data[1];
+	if((cmf*256 + flg) % 31 || (cmf & 15) != 8 || (flg & 32)) return false;
+
+	InflateBits in;
+	in.p = data + 2;
+	in.end = data + size;
+	in.bits = 0;
+	in.count = 0;
+	in.overrun = 0;
+
+	InflateHuffman lit, dist;
+	int final;
+	do
+	{
+		final = in.get(1);
+		int type = in.get(2);
+		if(type == 0)
+		{
+			in.get(in.count & 7);
+			int len = in.get(16);
+			int nlen = in.get(16);
+			if((len ^ 0xffff) != nlen) return false;
+			for(int i=0; i<len; i++)
+				out.push_back((unsigned char)in.get(8));
+			if(in.overrun > MAX_OVERRUN) return false;
+		}
+		else if(type == 1)
+		{
+			unsigned char lengths[288];
+			for(int i=0; i<288; i++)
+				lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+			lit.build(lengths, 288);
+			memset(lengths, 5, 30);
+			dist.build(lengths, 30);
+			if(!inflateBlock(in, lit, dist, out)) return false;
+		}
+		else if(type == 2)
+		{
+			static const unsigned char ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+			int hlit = in.get(5) + 257;
+			int hdist = in.get(5) + 1;
+			int hclen = in.get(4) + 4;
+			unsigned char codeLengths[19] = {0};
+			for(int i=0; i<hclen; i++)
+				codeLengths[ORDER[i]] = (unsigned char)in.get(3);
+			InflateHuffman lengthCodes;
+			if(!lengthCodes.build(codeLengths, 19)) return false;
+
+			unsigned char lengths[288 + 32];
+			int n = 0;
+			while(n < hlit + hdist)
+			{
+				int c = lengthCodes.decode(in);
+				if(c < 0 || in.overrun > MAX_OVERRUN) return false;
+				if(c < 16)
+				{
+					lengths[n++] = (unsigned char)c;
+					continue;
+				}
+				int repeat;
+				unsigned char fill = 0;
+				if(c == 16)
+				{
+					if(n == 0) return false;
+					repeat = 3 + in.get(2);
+					fill = lengths[n - 1];
+				}
+				else if(c == 17) repeat = 3 + in.get(3);
+				else repeat = 11 + in.get(7);
+				if(n + repeat > hlit + hdist) return false;
+				while(repeat--)
+					lengths[n++] = fill;
+			}
+			if(!lit.build(lengths, hlit) || !dist.build(lengths + hlit, hdist)) return false;
+			if(!inflateBlock(in, lit, dist, out)) return false;
+		}
+		else return false;
+	} while(!final);
+	return true;
+}
+
+//=======================================================================================
+// PNG
+//=======================================================================================
+
+static int paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if(pa <= pb && pa <= pc) return a;
+	return pb <= pc ? b : c;
+}
+
+//Undoes each row's filter in place. Rows are a filter byte and rowBytes more.
+static bool unfilter(unsigned char* rows, int rowBytes, int height, int pixelBytes)
+{
+	const unsigned char* prior = 0;
+	for(int y=0; y<height; y++)
+	{
+		unsigned char* row = rows + y*(rowBytes + 1);
+		int filter = row[0];
+		unsigned char* cur = row + 1;
+		switch(filter)
+		{
+		case 0:
+			break;
+		case 1:
+			for(int i=pixelBytes; i<rowBytes; i++)
+				cur[i] = (unsigned char)(cur[i] + cur[i - pixelBytes]);
+			break;
+		case 2:
+			if(prior)
+				for(int i=0; i<rowBytes; i++)
+					cur[i] = (unsigned char)(cur[i] + prior[i]);
+			break;
+		case 3:
+			for(int i=0; i<rowBytes; i++)
+			{
+				int left = i >= pixelBytes ? cur[i - pixelBytes] : 0;
+				int up = prior ? prior[i] : 0;
+				cur[i] = (unsigned char)(cur[i] + ((left + up) >> 1));
+			}
+			break;
+		case 4:
+			for(int i=0; i<rowBytes; i++)
+			{
+				int left = i >= pixelBytes ? cur[i - pixelBytes] : 0;
+				int up = prior ? prior[i] : 0;
+				int upLeft = prior && i >= pixelBytes ? prior[i - pixelBytes] : 0;
+				cur[i] = (unsigned char)(cur[i] + paeth(left, up, upLeft));
+			}
+			break;
+		default:
+			return false;
+		}
+		prior = cur;
+	}
+	return true;
+}
+
+struct PngInfo
+{
+	int width, height;
+	int depth;
+	int colorType;
+	int channels;
+	unsigned char palette[256][4];
+	bool hasKey;
+	int key[3];
+};
+
+//One sample of an unfiltered row: 1, 2, 4 or 8 bits, or the whole 16
+static int pngSample(const unsigned char* row, int index, int depth)
+{
+	switch(depth)
+	{
+	case 16: return (row[index*2] << 8) | row[index*2 + 1];
+	case 8: return row[index];
+	default:
+		{
+			int bit = index*depth;
+			return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+		}
+	}
+}
+
+//An unfiltered image of w x h pixels into RGBA8 at dst, every stride pixels
+//across and rowStride down, so an interlace pass can go straight into place
+static void pngToRgba(const PngInfo& info, const unsigned char* rows, int w, int h, unsigned char* dst, int stride, int rowStride)
+{
+	int rowBytes = (w*info.channels*info.depth + 7) / 8;
+	int maxValue = (1 << info.depth) - 1;
+	for(int y=0; y<h; y++)
+	{
+		const unsigned char* row = rows + y*(rowBytes + 1) + 1;
+		unsigned char* out = dst + y*rowStride*4;
+		//Nearly every file is 8-bit RGB or RGBA with no key
+		if(info.depth == 8 && (info.colorType == 6 || (info.colorType == 2 && !info.hasKey)))
+		{
+			if(info.colorType == 6 && stride == 1)
+			{
+				memcpy(out, row, w*4);
+				continue;
+			}
+			for(int x=0; x<w; x++, out += stride*4, row += info.channels)
+			{
+				out[0] = row[0];
+				out[1] = row[1];
+				out[2] = row[2];
+				out[3] = info.colorType == 6 ? row[3] : 255;
+			}
+			continue;
+		}
+		for(int x=0; x<w; x++, out += stride*4)
+		{
+			int s[4];
+			for(int c=0; c<info.channels; c++)
+				s[c] = pngSample(row, x*info.channels + c, info.depth);
+			if(info.colorType == 3)
+			{
+				int i = s[0];
+				out[0] = info.palette[i][0];
+				out[1] = info.palette[i][1];
+				out[2] = info.palette[i][2];
+				out[3] = info.palette[i][3];
+				continue;
+			}
+			bool keyed = false;
+			if(info.hasKey)
+			{
+				if(info.colorType == 0) keyed = s[0] == info.key[0];
+				if(info.colorType == 2) keyed = s[0] == info.key[0] && s[1] == info.key[1] && s[2] == info.key[2];
+			}
+			for(int c=0; c<info.channels; c++)
+				s[c] = info.depth == 16 ? s[c] >> 8 : s[c]*255 / maxValue;
+			switch(info.colorType)
+			{
+			case 0: out[0] = out[1] = out[2] = (unsigned char)s[0]; out[3] = keyed ? 0 : 255; break;
+			case 2: out[0] = (unsigned char)s[0]; out[1] = (unsigned char)s[1]; out[2] = (unsigned char)s[2]; out[3] = keyed ? 0 : 255; break;
+			case 4: out[0] = out[1] = out[2] = (unsigned char)s[0]; out[3] = (unsigned char)s[1]; break;
+			case 6: out[0] = (unsigned char)s[0]; out[1] = (unsigned char)s[1]; out[2] = (unsigned char)s[2]; out[3] = (unsigned char)s[3]; break;
+			}
+		}
+	}
+}
+
+bool decodePng(const unsigned char* data, size_t size, TextureData* out)
+{
+	static const unsigned char SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+	if(size < 8 || memcmp(data, SIGNATURE, 8)) return false;
+
+	PngInfo info;
+	memset(&info, 0, sizeof(info));
+	for(int i=0; i<256; i++)
+		info.palette[i][3] = 255;
+	int interlace = 0;
+	bool haveHeader = false;
+	vector<unsigned char> compressed;
+	size_t pos = 8;
+	for(;;)
+	{
+		if(pos + 8 > size) return false;
+		unsigned int length = readBE32(data + pos);
+		const unsigned char* type = data + pos + 4;
+		const unsigned char* chunk = data + pos + 8;
+		if(length > size - pos - 8) return false;
+		pos += 12 + (size_t)length;
+
+		if(!memcmp(type, "IHDR", 4))
+		{
+			if(length != 13) return false;
+			info.width = (int)readBE32(chunk);
+			info.height = (int)readBE32(chunk + 4);
+			info.depth = chunk[8];
+			info.colorType = chunk[9];
+			interlace = chunk[12];
+			static const int CHANNELS[7] = {1, 0, 3, 1, 2, 0, 4};
+			if(info.colorType > 6 || CHANNELS[info.colorType] == 0) return false;
+			info.channels = CHANNELS[info.colorType];
+			bool depthOk = info.depth == 8 || (info.depth == 16 && info.colorType != 3) ||
+				((info.depth == 1 || info.depth == 2 || info.depth == 4) && (info.colorType == 0 || info.colorType == 3));
+			if(!depthOk || chunk[10] || chunk[11] || interlace > 1) return false;
+			if(info.width <= 0 || info.height <= 0 || info.width > MAX_DIMENSION || info.height > MAX_DIMENSION) return false;
+			haveHeader = true;
+		}
+		else if(!memcmp(type, "PLTE", 4))
+		{
+			if(length % 3 || length > 768) return false;
+			for(unsigned int i=0; i<length/3; i++)
+			{
+				info.palette[i][0] = chunk[i*3];
+				info.palette[i][1] = chunk[i*3 + 1];
+				info.palette[i][2] = chunk[i*3 + 2];
+			}
+		}
+		else if(!memcmp(type, "tRNS", 4))
+		{
+			if(info.colorType == 3)
+			{
+				for(unsigned int i=0; i<length && i<256; i++)
+					info.palette[i][3] = chunk[i];
+			}
+			else if(info.colorType == 0 && length >= 2)
+			{
+				info.hasKey = true;
+				info.key[0] = (chunk[0] << 8) | chunk[1];
+			}
+			else if(info.colorType == 2 && length >= 6)
+			{
+				info.hasKey = true;
+				for(int c=0; c<3; c++)
+					info.key[c] = (chunk[c*2] << 8) | chunk[c*2 + 1];
+			}
+		}
+		else if(!memcmp(type, "IDAT", 4))
+			compressed.insert(compressed.end(), chunk, chunk + length);
+		else if(!memcmp(type, "IEND", 4))
+			break;
+		//An unknown chunk that matters to the image has an upper-case first letter
+		else if(!(type[0] & 32))
+			return false;
+	}
+	if(!haveHeader || compressed.empty()) return false;
+
+	int bitsPerPixel = info.channels*info.depth;
+	int pixelBytes = bitsPerPixel >= 8 ? bitsPerPixel/8 : 1;
+	vector<unsigned char> raw;
+	raw.reserve((size_t)info.height*((info.width*bitsPerPixel + 7)/8 + 1));
+	if(!inflateZlib(&compressed[0], compressed.size(), raw)) return false;
+
+	out->allocate(info.width, info.height, 1, RGBA8);
+	if(!interlace)
+	{
+		int rowBytes = (info.width*bitsPerPixel + 7) / 8;
+		if(raw.size() < (size_t)info.height*(rowBytes + 1)) return false;
+		if(!unfilter(&raw[0], rowBytes, info.height, pixelBytes)) return false;
+		pngToRgba(info, &raw[0], info.width, info.height, out->getMip(0), 1, info.width);
+		return true;
+	}
+
+	//Adam7: seven passes, each a small image of every so many pixels
+	static const int START_X[7] = {0, 4, 0, 2, 0, 1, 0};
+	static const int START_Y[7] = {0, 0, 4, 0, 2, 0, 1};
+	static const int STEP_X[7] = {8, 8, 4, 4, 2, 2, 1};
+	static const int STEP_Y[7] = {8, 8, 8, 4, 4, 2, 2};
+	size_t offset = 0;
+	for(int p=0; p<7; p++)
+	{
+		int w = (info.width - START_X[p] + STEP_X[p] - 1) / STEP_X[p];
+		int h = (info.height - START_Y[p] + STEP_Y[p] - 1) / STEP_Y[p];
+		if(w <= 0 || h <= 0) continue;
+		int rowBytes = (w*bitsPerPixel + 7) / 8;
+		size_t passSize = (size_t)h*(rowBytes + 1);
+		if(raw.size() < offset + passSize) return false;
+		if(!unfilter(&raw[offset], rowBytes, h, pixelBytes)) return false;
+		unsigned char* dst = out->getMip(0) + (START_Y[p]*info.width + START_X[p])*4;
+		pngToRgba(info, &raw[offset], w, h, dst, STEP_X[p], STEP_Y[p]*info.width);
+		offset += passSize;
+	}
+	return true;
+}
+
+//=======================================================================================
+// JPEG
+//=======================================================================================
+
+//Where each of a block's coefficients goes, in the order they're stored
+static const unsigned char ZIGZAG[64 + 16] = {
+	0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+	//Somewhere harmless for a broken run that overshoots
+	63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63};
+
+//A JPEG Huffman table; codes are read from the top bit down
+struct JpegHuffman
+{
+	//Index into code and size, 255 for a longer code
+	unsigned char fast[1 << FAST_BITS];
+	unsigned short code[256];
+	unsigned char values[256];
+	unsigned char size[257];
+	unsigned int maxCode[18];
+	int delta[17];
+
+	bool build(const unsigned char counts[16])
+	{
+		int k = 0;
+		for(int i=0; i<16; i++)
+			for(int j=0; j<counts[i]; j++)
+			{
+				if(k >= 256) return false;
+				size[k++] = (unsigned char)(i + 1);
+			}
+		size[k] = 0;
+		unsigned int c = 0;
+		k = 0;
+		int j;
+		for(j=1; j<=16; j++)
+		{
+			delta[j] = k - c;
+			if(size[k] == j)
+			{
+				while(size[k] == j)
+					code[k++] = (unsigned short)c++;
+				if(c - 1 >= (1u << j)) return false;
+			}
+			maxCode[j] = c << (16 - j);
+			c <<= 1;
+		}
+		maxCode[j] = 0xffffffff;
+		memset(fast, 255, sizeof(fast));
+		for(int i=0; i<k; i++)
+		{
+			int s = size[i];
+			if(s > FAST_BITS) continue;
+			int first = code[i] << (FAST_BITS - s);
+			for(int m=0; m < (1 << (FAST_BITS - s)); m++)
+				fast[first + m] = (unsigned char)i;
+		}
+		return true;
+	}
+};
+
+struct JpegComponent
+{
+	int id;
+	int h, v;
+	int quant;
+	int dcTable, acTable;
+	//Blocks across and down as stored: whole MCUs of them
+	int blocksW, blocksH;
+	//Blocks across and down that hold the image, which a scan of this
+	//component alone covers
+	int usedW, usedH;
+	int dcPred;
+	vector<short> coefs;
+	vector<unsigned char> pixels;
+};
+
+struct JpegDecoder
+{
+	const unsigned char* data;
+	size_t size;
+	size_t pos;
+	int overrun;
+
+	unsigned int bits;
+	int count;
+	//Set when the bit reader runs into a marker, after which it feeds zeros
+	int marker;
+
+	int width, height;
+	bool progressive;
+	int hMax, vMax;
+	int mcusX, mcusY;
+	int restartInterval;
+	int eobRun;
+	unsigned short quant[4][64];
+	JpegHuffman dc[4], ac[4];
+	JpegComponent comps[3];
+	int numComps;
+
+	//This scan's components, and the spectral selection and approximation
+	int scanComps[3];
+	int numScanComps;
+	int spectralStart, spectralEnd;
+	int approxHigh, approxLow;
+
+	int byte()
+	{
+		if(pos < size) return data[pos++];
+		overrun++;
+		return 0;
+	}
+	int word()
+	{
+		int hi = byte();
+		return (hi << 8) | byte();
+	}
+
+	void fill()
+	{
+		do
+		{
+			int b = 0;
+			if(marker < 0)
+			{
+				b = byte();
+				if(b == 0xff)
+				{
+					int c = byte();
+					while(c == 0xff)
+						c = byte();
+					if(c != 0)
+					{
+						marker = c;
+						b = 0;
+					}
+				}
+			}
+			bits |= (unsigned int)b << (24 - count);
+			count += 8;
+		} while(count <= 24);
+	}
+
+	int getBits(int n)
+	{
+		if(n == 0) return 0;
+		if(count < n) fill();
+		int v = (int)(bits >> (32 - n));
+		bits <<= n;
+		count -= n;
+		return v;
+	}
+
+	int getBit()
+	{
+		return getBits(1);
+	}
+
+	//n bits as a signed difference: the lower half of the range is negative
+	int receiveExtend(int n)
+	{
+		if(n == 0) return 0;
+		int v = getBits(n);
+		return v < (1 << (n - 1)) ? v - (1 << n) + 1 : v;
+	}
+
+	int decode(const JpegHuffman& t)
+	{
+		if(count < 16) fill();
+		int k = t.fast[bits >> (32 - FAST_BITS)];
+		if(k < 255)
+		{
+			int s = t.size[k];
+			bits <<= s;
+			count -= s;
+			return t.values[k];
+		}
+		unsigned int top = bits >> 16;
+		for(k = FAST_BITS + 1; k < 17; k++)
+			if(top < t.maxCode[k]) break;
+		if(k == 17) return -1;
+		int c = (int)(bits >> (32 - k)) + t.delta[k];
+		if(c < 0 || c > 255) return -1;
+		bits <<= k;
+		count -= k;
+		return t.values[c];
+	}
+
+	void resetEntropy()
+	{
+		bits = 0;
+		count = 0;
+		marker = -1;
+		eobRun = 0;
+		for(int i=0; i<numComps; i++)
+			comps[i].dcPred = 0;
+	}
+
+	bool readFrame(int type);
+	bool readScanHeader();
+	bool decodeScan();
+	bool decodeBlock(JpegComponent& c, short* coefs);
+	void finish(TextureData* out);
+};
+
+bool JpegDecoder::readFrame(int type)
+{
+	int length = word();
+	if(byte() != 8) return false;
+	height = word();
+	width = word();
+	numComps = byte();
+	if(width <= 0 || height <= 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) return false;
+	if((numComps != 1 && numComps != 3) || length != 8 + 3*numComps) return false;
+	progressive = type == 0xc2;
+	hMax = vMax = 1;
+	for(int i=0; i<numComps; i++)
+	{
+		JpegComponent& c = comps[i];
+		c.id = byte();
+		int hv = byte();
+		c.h = hv >> 4;
+		c.v = hv & 15;
+		c.quant = byte();
+		if(c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4 || c.quant > 3) return false;
+		if(c.h > hMax) hMax = c.h;
+		if(c.v > vMax) vMax = c.v;
+	}
+	mcusX = (width + 8*hMax - 1) / (8*hMax);
+	mcusY = (height + 8*vMax - 1) / (8*vMax);
+	for(int i=0; i<numComps; i++)
+	{
+		JpegComponent& c = comps[i];
+		c.blocksW = mcusX*c.h;
+		c.blocksH = mcusY*c.v;
+		c.usedW = ((width*c.h + hMax - 1) / hMax + 7) / 8;
+		c.usedH = ((height*c.v + vMax - 1) / vMax + 7) / 8;
+		c.coefs.assign((size_t)c.blocksW*c.blocksH*64, 0);
+	}
+	return overrun == 0;
+}
+
+bool JpegDecoder::readScanHeader()
+{
+	int length = word();
+	numScanComps = byte();
+	if(numScanComps < 1 || numScanComps > numComps || length != 6 + 2*numScanComps) return false;
+	for(int i=0; i<numScanComps; i++)
+	{
+		int id = byte();
+		int tables = byte();
+		int which = -1;
+		for(int k=0; k<numComps; k++)
+			if(comps[k].id == id) which = k;
+		if(which < 0) return false;
+		scanComps[i] = which;
+		comps[which].dcTable = tables >> 4;
+		comps[which].acTable = tables & 15;
+		if(comps[which].dcTable > 3 || comps[which].acTable > 3) return false;
+	}
+	spectralStart = byte();
+	spectralEnd = byte();
+	int approx = byte();
+	approxHigh = approx >> 4;
+	approxLow = approx & 15;
+	if(progressive)
+	{
+		if(spectralStart > 63 || spectralEnd > 63 || spectralStart > spectralEnd || approxHigh > 13 || approxLow > 13) return false;
+		//DC and AC never share a scan, and AC scans are of one component
+		if(spectralStart == 0 && spectralEnd != 0) return false;
+		if(spectralStart != 0 && numScanComps != 1) return false;
+	}
+	else
+	{
+		spectralStart = 0;
+		spectralEnd = 63;
+		approxHigh = approxLow = 0;
+	}
+	return overrun == 0;
+}
+
+//One block's worth of this scan into coefs, which stay quantized
+bool JpegDecoder::decodeBlock(JpegComponent& c, short* coefs)
+{
+	if(!progressive)
+	{
+		int t = decode(dc[c.dcTable]);
+		if(t < 0 || t > 16) return false;
+		c.dcPred += receiveExtend(t);
+		coefs[0] = (short)c.dcPred;
+		for(int k=1; k<64;)
+		{
+			int rs = decode(ac[c.acTable]);
+			if(rs < 0) return false;
+			int s = rs & 15, r = rs >> 4;
+			if(s == 0)
+			{
+				if(rs != 0xf0) break;
+				k += 16;
+				continue;
+			}
+			k += r;
+			if(k > 63) return false;
+			coefs[ZIGZAG[k++]] = (short)receiveExtend(s);
+		}
+		return true;
+	}
+
+	if(spectralStart == 0)
+	{
+		if(approxHigh == 0)
+		{
+			int t = decode(dc[c.dcTable]);
+			if(t < 0 || t > 16) return false;
+			c.dcPred += receiveExtend(t);
+			coefs[0] = (short)(c.dcPred * (1 << approxLow));
+		}
+		else if(getBit())
+			coefs[0] = (short)(coefs[0] | (1 << approxLow));
+		return true;
+	}
+
+	if(approxHigh == 0)
+	{
+		if(eobRun)
+		{
+			eobRun--;
+			return true;
+		}
+		for(int k=spectralStart; k<=spectralEnd;)
+		{
+			int rs = decode(ac[c.acTable]);
+			if(rs < 0) return false;
+			int s = rs & 15, r = rs >> 4;
+			if(s == 0)
+			{
+				if(r < 15)
+				{
+					eobRun = (1 << r) - 1;
+					if(r) eobRun += getBits(r);
+					break;
+				}
+				k += 16;
+				continue;
+			}
+			k += r;
+			if(k > 63) return false;
+			coefs[ZIGZAG[k++]] = (short)(receiveExtend(s) * (1 << approxLow));
+		}
+		return true;
+	}
+
+	//Refining: a correction bit for every coefficient already set, and new
+	//ones of plus or minus this bit placed among the zeros
+	int bit = 1 << approxLow;
+	if(eobRun)
+	{
+		eobRun--;
+		for(int k=spectralStart; k<=spectralEnd; k++)
+		{
+			short& p = coefs[ZIGZAG[k]];
+			if(p != 0 && getBit() && (p & bit) == 0)
+				p = (short)(p > 0 ? p + bit : p - bit);
+		}
+		return true;
+	}
+	int k = spectralStart;
+	do
+	{
+		int rs = decode(ac[c.acTable]);
+		if(rs < 0) return false;
+		int s = rs & 15, r = rs >> 4;
+		if(s == 0)
+		{
+			if(r < 15)
+			{
+				eobRun = (1 << r) - 1;
+				if(r) eobRun += getBits(r);
+				r = 64;
+			}
+		}
+		else
+		{
+			if(s != 1) return false;
+			s = getBit() ? bit : -bit;
+		}
+		while(k <= spectralEnd)
+		{
+			short& p = coefs[ZIGZAG[k++]];
+			if(p != 0)
+			{
+				if(getBit() && (p & bit) == 0)
+					p = (short)(p > 0 ? p + bit : p - bit);
+			}
+			else
+			{
+				if(r == 0)
+				{
+					p = (short)s;
+					break;
+				}
+				r--;
+			}
+		}
+	} while(k <= spectralEnd);
+	return true;
+}
+
+bool JpegDecoder::decodeScan()
+{
+	resetEntropy();
+	int todo = restartInterval ? restartInterval : 0x7fffffff;
+	//One component alone goes block by block over the part that holds the
+	//image; more go MCU by MCU, each with all its components' blocks
+	bool single = numScanComps == 1;
+	JpegComponent& first = comps[scanComps[0]];
+	int unitsX = single ? first.usedW : mcusX;
+	int unitsY = single ? first.usedH : mcusY;
+	for(int y=0; y<unitsY; y++)
+	{
+		for(int x=0; x<unitsX; x++)
+		{
+			if(single)
+			{
+				if(!decodeBlock(first, &first.coefs[((size_t)y*first.blocksW + x)*64])) return false;
+			}
+			else
+			{
+				for(int i=0; i<numScanComps; i++)
+				{
+					JpegComponent& c = comps[scanComps[i]];
+					for(int by=0; by<c.v; by++)
+						for(int bx=0; bx<c.h; bx++)
+						{
+							size_t block = (size_t)(y*c.v + by)*c.blocksW + x*c.h + bx;
+							if(!decodeBlock(c, &c.coefs[block*64])) return false;
+						}
+				}
+			}
+			if(overrun > MAX_OVERRUN) return false;
+			if(--todo <= 0)
+			{
+				if(count < 24) fill();
+				//A restart marker starts the next interval afresh
+				if(marker < 0xd0 || marker > 0xd7) return true;
+				resetEntropy();
+				todo = restartInterval;
+			}
+		}
+	}
+	return true;
+}
+
+//basis[x][u] is the inverse DCT's C(u)/2 cos((2x+1)u pi/16)
+static void idctBlock(const float basis[8][8], const short* coefs, const unsigned short* q, unsigned char* out, int stride)
+{
+	float f[64];
+	bool acZero = true;
+	for(int i=0; i<64; i++)
+	{
+		f[i] = (float)(coefs[i]*q[i]);
+		if(i && coefs[i]) acZero = false;
+	}
+	if(acZero)
+	{
+		int v = (int)floorf(f[0]*0.125f + 128.5f);
+		unsigned char c = (unsigned char)(v < 0 ? 0 : v > 255 ? 255 : v);
+		for(int y=0; y<8; y++)
+			memset(out + y*stride, c, 8);
+		return;
+	}
+	//Rows, then columns
+	float t[64];
+	for(int v=0; v<8; v++)
+		for(int x=0; x<8; x++)
+		{
+			float s = 0;
+			for(int u=0; u<8; u++)
+				s += basis[x][u]*f[v*8 + u];
+			t[v*8 + x] = s;
+		}
+	for(int y=0; y<8; y++)
+		for(int x=0; x<8; x++)
+		{
+			float s = 0;
+			for(int v=0; v<8; v++)
+				s += basis[y][v]*t[v*8 + x];
+			int p = (int)floorf(s + 128.5f);
+			out[y*stride + x] = (unsigned char)(p < 0 ? 0 : p > 255 ? 255 : p);
+		}
+}
+
+void JpegDecoder::finish(TextureData* out)
+{
+	float basis[8][8];
+	for(int x=0; x<8; x++)
+		for(int u=0; u<8; u++)
+			basis[x][u] = (u == 0 ? sqrtf(0.5f) : 1.0f) * 0.5f * cosf((2*x + 1)*u*3.14159265f/16);
+	for(int i=0; i<numComps; i++)
+	{
+		JpegComponent& c = comps[i];
+		int stride = c.blocksW*8;
+		c.pixels.resize((size_t)stride*c.blocksH*8);
+		for(int by=0; by<c.blocksH; by++)
+			for(int bx=0; bx<c.blocksW; bx++)
+				idctBlock(basis, &c.coefs[((size_t)by*c.blocksW + bx)*64], quant[c.quant],
+					&c.pixels[(size_t)by*8*stride + bx*8], stride);
+		vector<short>().swap(c.coefs);
+	}
+
+	//Chroma is spread over the pixels it covers, then YCbCr goes to RGB
+	out->allocate(width, height, 1, RGBA8);
+	unsigned char* dst = out->getMip(0);
+	for(int y=0; y<height; y++)
+	{
+		for(int x=0; x<width; x++, dst += 4)
+		{
+			int s[3];
+			for(int i=0; i<numComps; i++)
+			{
+				const JpegComponent& c = comps[i];
+				s[i] = c.pixels[(size_t)(y*c.v/vMax)*c.blocksW*8 + x*c.h/hMax];
+			}
+			if(numComps == 1)
+			{
+				dst[0] = dst[1] = dst[2] = (unsigned char)s[0];
+			}
+			else
+			{
+				float luma = (float)s[0], cb = s[1] - 128.0f, cr = s[2] - 128.0f;
+				float rgb[3] = {luma + 1.402f*cr, luma - 0.344136f*cb - 0.714136f*cr, luma + 1.772f*cb};
+				for(int k=0; k<3; k++)
+				{
+					int v = (int)floorf(rgb[k] + 0.5f);
+					dst[k] = (unsigned char)(v < 0 ? 0 : v > 255 ? 255 : v);
+				}
+			}
+			dst[3] = 255;
+		}
+	}
+}
+
+bool decodeJpeg(const unsigned char* data, size_t size, TextureData* out)
+{
+	if(size < 4 || data[0] != 0xff || data[1] != 0xd8) return false;
+
+	JpegDecoder* d = new JpegDecoder;
+	d->data = data;
+	d->size = size;
+	d->pos = 2;
+	d->overrun = 0;
+	d->marker = -1;
+	d->restartInterval = 0;
+	d->numComps = 0;
+	d->width = d->height = 0;
+	//A scan may name a table that never came; it decodes nothing
+	unsigned char noCodes[16] = {0};
+	for(int i=0; i<4; i++)
+	{
+		d->dc[i].build(noCodes);
+		d->ac[i].build(noCodes);
+	}
+	bool ok = false;
+	bool frame = false;
+	int marker = -1;
+	for(;;)
+	{
+		//The next marker: whatever the last scan ran into, or the next 0xff
+		if(marker < 0)
+		{
+			int b = d->byte();
+			while(b != 0xff && d->overrun == 0)
+				b = d->byte();
+			while(b == 0xff)
+				b = d->byte();
+			marker = b;
+		}
+		if(d->overrun) break;
+		int m = marker;
+		marker = -1;
+		//Stuffing left over after a scan
+		if(m == 0) continue;
+
+		if(m == 0xd9)
+		{
+			ok = frame;
+			break;
+		}
+		else if(m == 0xc0 || m == 0xc1 || m == 0xc2)
+		{
+			if(frame || !d->readFrame(m)) break;
+			frame = true;
+		}
+		else if(m == 0xc4)
+		{
+			int length = d->word() - 2;
+			bool good = true;
+			while(length > 0 && good)
+			{
+				int tc = d->byte();
+				unsigned char counts[16];
+				int total = 0;
+				for(int i=0; i<16; i++)
+				{
+					counts[i] = (unsigned char)d->byte();
+					total += counts[i];
+				}
+				if((tc >> 4) > 1 || (tc & 15) > 3 || total > 256) {good = false; break;}
+				JpegHuffman& t = (tc >> 4) ? d->ac[tc & 15] : d->dc[tc & 15];
+				for(int i=0; i<total; i++)
+					t.values[i] = (unsigned char)d->byte();
+				good = t.build(counts);
+				length -= 17 + total;
+			}
+			if(!good || length != 0 || d->overrun) break;
+		}
+		else if(m == 0xdb)
+		{
+			int length = d->word() - 2;
+			while(length > 0)
+			{
+				int pq = d->byte();
+				int table = pq & 15;
+				bool wide = (pq >> 4) != 0;
+				if(table > 3) {length = -1; break;}
+				for(int i=0; i<64; i++)
+					d->quant[table][ZIGZAG[i]] = (unsigned short)(wide ? d->word() : d->byte());
+				length -= 65 + (wide ? 64 : 0);
+			}
+			if(length != 0 || d->overrun) break;
+		}
+		else if(m == 0xdd)
+		{
+			if(d->word() != 4) break;
+			d->restartInterval = d->word();
+		}
+		else if(m == 0xda)
+		{
+			if(!frame || !d->readScanHeader() || !d->decodeScan()) break;
+			marker = d->marker;
+		}
+		else if((m >= 0xe0 && m <= 0xef) || m == 0xfe || (m >= 0xd0 && m <= 0xd7))
+		{
+			if(m >= 0xd0 && m <= 0xd7) continue;
+			int length = d->word();
+			if(length < 2) break;
+			d->pos += length - 2;
+			if(d->pos > size) break;
+		}
+		//Arithmetic coding, lossless, 12-bit and the rest
+		else break;
+	}
+	if(ok) d->finish(out);
+	delete d;
+	return ok;
+}
+
+//=======================================================================================
+// DDS
+//=======================================================================================
+
+static unsigned int fourCC(const char* s)
+{
+	return (unsigned char)s[0] | ((unsigned char)s[1] << 8) | ((unsigned char)s[2] << 16) | ((unsigned int)(unsigned char)s[3] << 24);
+}
+
+//The DXGI_FORMAT values a DX10 header may name, UNORM or SRGB
+static bool dxgiToFormat(unsigned int dxgi, Format* f, bool* bgra)
+{
+	*bgra = false;
+	switch(dxgi)
+	{
+	case 28: case 29: *f = RGBA8; return true;
+	case 87: case 91: *f = RGBA8; *bgra = true; return true;
+	case 71: case 72: *f = BC1; return true;
+	case 74: case 75: *f = BC2; return true;
+	case 77: case 78: *f = BC3; return true;
+	case 80: *f = BC4; return true;
+	default: return false;
+	}
+}
+
+//Which byte of a little-endian 32-bit texel a one-byte mask picks
+static int maskByte(unsigned int mask)
+{
+	for(int i=0; i<4; i++)
+		if(mask == 0xffu << (i*8)) return i;
+	return -1;
+}
+
+bool decodeDds(const unsigned char* data, size_t size, TextureData* out)
+{
+	if(size < 128 || readLE32(data) != fourCC("DDS ") || readLE32(data + 4) != 124) return false;
+	int height = (int)readLE32(data + 12);
+	int width = (int)readLE32(data + 16);
+	int mips = (readLE32(data + 8) & 0x20000) ? (int)readLE32(data + 28) : 1;
+	unsigned int pfFlags = readLE32(data + 80);
+	unsigned int code = readLE32(data + 84);
+	unsigned int bitCount = readLE32(data + 88);
+	unsigned int caps2 = readLE32(data + 112);
+	if(width <= 0 || height <= 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) return false;
+	//Cube maps and volumes are for createCubeTex
+	if(caps2 & 0x200 || caps2 & 0x200000) return false;
+	if(mips < 1) mips = 1;
+	if(mips > TextureData::fullMipCount(width, height)) return false;
+
+	size_t offset = 128;
+	Format format = RGBA8;
+	bool bgra = false;
+	int channel[4] = {0, 1, 2, 3};
+	bool hasAlpha = true;
+	if(pfFlags & 0x4)
+	{
+		if(code == fourCC("DX10"))
+		{
+			if(size < 148 || readLE32(data + 132) != 3 || (readLE32(data + 136) & 0x4) || readLE32(data + 140) > 1) return false;
+			if(!dxgiToFormat(readLE32(data + 128), &format, &bgra)) return false;
+			offset = 148;
+		}
+		else if(code == fourCC("DXT1")) format = BC1;
+		else if(code == fourCC("DXT2") || code == fourCC("DXT3")) format = BC2;
+		else if(code == fourCC("DXT4") || code == fourCC("DXT5")) format = BC3;
+		else if(code == fourCC("ATI1") || code == fourCC("BC4U")) format = BC4;
+		else return false;
+		if(bgra) {channel[0] = 2; channel[2] = 0;}
+	}
+	else if((pfFlags & 0x40) && bitCount == 32)
+	{
+		for(int c=0; c<3; c++)
+			if((channel[c] = maskByte(readLE32(data + 92 + c*4))) < 0) return false;
+		hasAlpha = (pfFlags & 0x1) != 0;
+		if(hasAlpha && (channel[3] = maskByte(readLE32(data + 104))) < 0) return false;
+	}
+	else return false;
+
+	out->allocate(width, height, mips, format);
+	if(size - offset < out->texels.size()) return false;
+	const unsigned char* src = data + offset;
+	if(format != RGBA8)
+	{
+		memcpy(&out->texels[0], src, out->texels.size());
+		return true;
+	}
+	unsigned char* dst = &out->texels[0];
+	for(size_t i=0; i<out->texels.size(); i+=4)
+	{
+		dst[i] = src[i + channel[0]];
+		dst[i + 1] = src[i + channel[1]];
+		dst[i + 2] = src[i + channel[2]];
+		dst[i + 3] = hasAlpha ? src[i + channel[3]] : 255;
+	}
+	return true;
+}
+
+//=======================================================================================
+
+bool decodeImage(const unsigned char* data, size_t size, TextureData* out)
+{
+	if(size >= 8 && data[0] == 137 && data[1] == 'P') return decodePng(data, size, out);
+	if(size >= 2 && data[0] == 0xff && data[1] == 0xd8) return decodeJpeg(data, size, out);
+	if(size >= 4 && !memcmp(data, "DDS ", 4)) return decodeDds(data, size, out);
+	return false;
+}
+
+bool loadImage(const char* path, TextureData* out)
+{
+	FILE* f = fopen(path, "rb");
+	if(!f) return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	bool ok = false;
+	if(size > 0)
+	{
+		vector<unsigned char> bytes(size);
+		if(fread(&bytes[0], 1, size, f) == (size_t)size)
+			ok = decodeImage(&bytes[0], bytes.size(), out);
+	}
+	fclose(f);
+	return ok;
+}
@@ -0,0 +1,24 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include "TextureData.h"
+#include <stddef.h>
+
+//Reads the game's image files without D3DX, so they can be decoded on any
+//thread and on any platform:
+//  PNG   every colour type and bit depth, interlaced or not
+//  JPEG  baseline and progressive, greyscale or YCbCr, any subsampling
+//  DDS   BC1 to BC4 and 32-bit RGBA, mips and all; no cube maps or arrays
+//PNG and JPEG come out as one level of RGBA8; DDS keeps its format and mips.
+//Anything else, or a broken file, returns false.
+bool decodeImage(const unsigned char* data, size_t size, TextureData* out);
+bool loadImage(const char* path, TextureData* out);
+
+//The stages on their own, for when the format is already known
+bool decodePng(const unsigned char* data, size_t size, TextureData* out);
+bool decodeJpeg(const unsigned char* data, size_t size, TextureData* out);
+bool decodeDds(const unsigned char* data, size_t size, TextureData* out);
+//A zlib stream, as PNG keeps its pixels in. Appends to out.
+bool inflateZlib(const unsigned char* data, size_t size, vector<unsigned char>& out);
+
+#endif
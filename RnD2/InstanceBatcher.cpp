@@ -0,0 +1,81 @@
+#include "InstanceBatcher.h"
+#include "Profiler.h"
+
+InstanceBatcher::InstanceBatcher()
+{
+	material = -1;
+	lastMesh = -1;
+	table = 0;
+	Identity(&view);
+}
+
+void InstanceBatcher::clear()
+{
+	material = -1;
+	lastMesh = -1;
+	meshes.clear();
+	records.clear();
+	queue.clear();
+	batches.clear();
+	instances.clear();
+}
+
+//The view's z row, as D3DXVec3TransformCoord would give it without the divide
+float InstanceBatcher::viewDepth(const Matrix& world)
+{
+	return world._41*view._13 + world._42*view._23 + world._43*view._33 + view._43;
+}
+
+//Draws come in long runs of one mesh, so the last one is nearly always it.
+//There are only ever a handful of meshes to search.
+int InstanceBatcher::findMesh(Box* mesh)
+{
+	if(lastMesh >= 0 && meshes[lastMesh] == mesh)
+		return lastMesh;
+	for(unsigned int i=0; i<meshes.size(); i++)
+	{
+		if(meshes[i] == mesh)
+			return lastMesh = i;
+	}
+	meshes.push_back(mesh);
+	return lastMesh = meshes.size() - 1;
+}
+
+void InstanceBatcher::drawMesh(Box* mesh, const Matrix& world, bool glow)
+{
+	Record r;
+	r.mesh = mesh;
+	r.material = material;
+	r.data.world = world;
+	r.data.glowColor = glow ? meshColor(mesh) : Vector3(0, 0, 0);
+	r.data.glow = glow ? 1.0f : 0.0f;
+	r.data.slice = table ? (float)table->getSlice(material) : (float)materialNS::NO_SLICE;
+	records.push_back(r);
+	int group = table ? table->getGroup(material) : material;
+	queue.submit(RenderQueue::makeKey(RENDER_OPAQUE, TECH_INSTANCED, group, findMesh(mesh), viewDepth(world)));
+}
+
+//One sort, then a new batch wherever the key's mesh or anything above it changes
+void InstanceBatcher::build()
+{
+	PROFILE_ZONE("InstanceBatcher::build");
+	queue.sort();
+	batches.clear();
+	int n = records.size();
+	instances.resize(n);
+	for(int i=0; i<n; i++)
+	{
+		const Record& r = records[queue.getIndex(i)];
+		instances[i] = r.data;
+		if(i == 0 || (queue.getSortedKey(i) & renderQueueNS::BATCH_MASK) != (queue.getSortedKey(i-1) & renderQueueNS::BATCH_MASK))
+		{
+			InstanceBatch b;
+			b.mesh = r.mesh;
+			b.material = r.material;
+			b.first = i;
+			b.count = 0;
+			batches.push_back(b);
+		}
+		batches.back().count++;
+	}
+}
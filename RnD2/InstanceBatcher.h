@@ -0,0 +1,98 @@
+#ifndef INSTANCE_BATCHER_H
+#define INSTANCE_BATCHER_H
+
+#include "SimRenderer.h"
+#include "RenderQueue.h"
+#include "MaterialTable.h"
+#include <vector>
+using std::vector;
+
+//What lighting.fx's InstancedTech reads per instance: the world matrix as four
+//rows, the glow colour with 1 in w if the instance draws flat in it, then the
+//material's slice of the bound texture array, or -1 to use gDiffuseMap
+struct InstanceData
+{
+	Matrix world;
+	Vector3 glowColor;
+	float glow;
+	float slice;
+};
+
+//A run of instances that share a mesh and bind group, drawn with one call.
+//material is the first instance's; the rest may be others in its group.
+struct InstanceBatch
+{
+	Box* mesh;
+	int material;
+	int first;
+	int count;
+};
+
+//Stands in as the renderer and puts every draw through a RenderQueue, so
+//build() gets one batch per mesh and material pair, with the batches that
+//share a material next to each other and the instances in each nearest to the
+//eye first. Given a MaterialTable, it batches on the material's bind group
+//instead, so materials that are slices of one texture array share draws.
+//Every batch is laid out end to end in one array, ready to copy into a single
+//instance buffer.
+//
+//No D3D in here, so the batches can be checked without a GPU.
+class InstanceBatcher : public SimRenderer
+{
+public:
+	InstanceBatcher();
+	virtual ~InstanceBatcher() {}
+
+	//Forgets the last frame's draws but keeps the memory
+	void clear();
+	void build();
+	//Depths are measured along this view's z
+	void setView(const Matrix& v) {view = v;}
+	//Batch on these groups and give each instance its slice; NULL batches on
+	//the material alone
+	void setMaterialTable(const MaterialTable* t) {table = t;}
+	float viewDepth(const Matrix& world);
+
+	virtual void setMaterial(int m) {material = m;}
+	virtual void drawMesh(Box* mesh, const Matrix& world, bool glow);
+
+	int getDrawCount() {return records.size();}
+	int getBatchCount() {return batches.size();}
+	const InstanceBatch& getBatch(int i) {return batches[i];}
+	//Valid after build()
+	const vector<InstanceData>& getInstances() {return instances;}
+	//Bind group switches from one batch to the next, after build(), and how many
+	//there would be drawing in the order the world drew
+	int getStateChanges() {return queue.countSortedChanges(renderQueueNS::STATE_MASK);}
+	int getDrawnStateChanges() {return queue.countSubmittedChanges(renderQueueNS::STATE_MASK);}
+	int getRadixPasses() {return queue.getRadixPasses();}
+
+protected:
+	//The colour a glowing instance of mesh is drawn in. Meshes are opaque here,
+	//so the D3D renderer fills this in.
+	virtual Vector3 meshColor(Box*) {return Vector3(1, 1, 1);}
+
+private:
+	int findMesh(Box* mesh);
+
+	struct Record
+	{
+		Box* mesh;
+		int material;
+		InstanceData data;
+	};
+
+	int material;
+	int lastMesh;
+	Matrix view;
+	const MaterialTable* table;
+	//The key's mesh field is the index in here, so it's the same every frame the
+	//world draws in the same order
+	vector<Box*> meshes;
+	vector<Record> records;
+	RenderQueue queue;
+	vector<InstanceBatch> batches;
+	vector<InstanceData> instances;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+//Both ends sit behind one small lock. The owner and a thief only meet on a
+//nearly empty deque, and jobs are coarse enough that the lock doesn't show.
+class JobDeque
+{
+public:
+	JobDeque() : top(0), bottom(0) {}
+
+	bool push(const Job& job)
+	{
+		ScopedLock lock(mutex);
+		if(bottom - top >= jobNS::DEQUE_SIZE) return false;
+		jobs[bottom % jobNS::DEQUE_SIZE] = job;
+		bottom++;
+		return true;
+	}
+
+	//Newest first, for the owner
+	bool pop(Job& job)
+	{
+		ScopedLock lock(mutex);
+		if(bottom == top) return false;
+		bottom--;
+		job = jobs[bottom % jobNS::DEQUE_SIZE];
+		return true;
+	}
+
+	//Oldest first, for everyone else
+	bool steal(Job& job)
+	{
+		ScopedLock lock(mutex);
+		if(bottom == top) return false;
+		job = jobs[top % jobNS::DEQUE_SIZE];
+		top++;
+		return true;
+	}
+
+private:
+	Mutex mutex;
+	Job jobs[jobNS::DEQUE_SIZE];
+	int top;
+	int bottom;
+};
+
+int JobSystem::numWorkers = 0;
+volatile long JobSystem::quit = 0;
+volatile long JobSystem::queued = 0;
+volatile long JobSystem::sleeping = 0;
+
+//Deque 0 is shared by the threads that aren't workers; worker i has deque i+1
+static JobDeque deques[jobNS::MAX_WORKERS + 1];
+static Thread workers[jobNS::MAX_WORKERS];
+static int workerDeque[jobNS::MAX_WORKERS];
+static Semaphore wake;
+static THREAD_LOCAL int threadDeque = 0;
+
+void JobSystem::init(int n)
+{
+	shutdown();
+	if(n > jobNS::MAX_WORKERS) n = jobNS::MAX_WORKERS;
+	if(n <= 0) return;
+	atomicStore(&quit, 0);
+	//Workers steal using the count, so it's set before any of them start. One
+	//that fails to start just leaves an empty deque; the others still steal.
+	numWorkers = n;
+	for(int i=0; i<n; i++)
+	{
+		workerDeque[i] = i + 1;
+		workers[i].start(workerLoop, &workerDeque[i]);
+	}
+}
+
+void JobSystem::shutdown()
+{
+	if(numWorkers == 0) return;
+	atomicStore(&quit, 1);
+	wake.post(numWorkers);
+	for(int i=0; i<numWorkers; i++)
+		workers[i].join();
+	numWorkers = 0;
+}
+
+void JobSystem::run(JobFunction f, void* data, int begin, int end, JobCounter* counter, JobCounter* dependency)
+{
+	Job job;
+	job.function = f;
+	job.data = data;
+	job.begin = begin;
+	job.end = end;
+	job.counter = counter;
+	job.dependency = dependency;
+	if(counter) atomicIncrement(&counter->pending);
+
+	if(numWorkers > 0)
+	{
+		//Paired with the sleeping/queued check in workerLoop, so a worker either
+		//sees this job or is counted as sleeping here and gets woken
+		atomicIncrement(&queued);
+		if(deques[threadDeque].push(job))
+		{
+			if(atomicAdd(&sleeping, 0) > 0) wake.post();
+			return;
+		}
+		atomicDecrement(&queued);
+	}
+	execute(job);
+}
+
+void JobSystem::wait(JobCounter* counter)
+{
+	while(!counter->isDone())
+	{
+		if(!runOne(threadDeque)) Thread::yield();
+	}
+}
+
+void JobSystem::parallelFor(int count, int grain, JobFunction f, void* data)
+{
+	if(count <= 0) return;
+	if(grain < 1) grain = 1;
+	if(numWorkers == 0 || count <= grain)
+	{
+		f(data, 0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for(int begin=0; begin<count; begin+=grain)
+	{
+		int end = begin + grain < count ? begin + grain : count;
+		run(f, data, begin, end, &counter);
+	}
+	wait(&counter);
+}
+
+void JobSystem::execute(const Job& job)
+{
+	//The dependency's jobs may be queued under this one, so help run them
+	if(job.dependency) wait(job.dependency);
+	job.function(job.data, job.begin, job.end);
+	if(job.counter) atomicDecrement(&job.counter->pending);
+}
+
+bool JobSystem::runOne(int self)
+{
+	Job job;
+	bool found = deques[self].pop(job);
+	for(int i=1; !found && i<=numWorkers; i++)
+		found = deques[(self + i) % (numWorkers + 1)].steal(job);
+	if(!found) return false;
+
+	atomicDecrement(&queued);
+	execute(job);
+	return true;
+}
+
+void JobSystem::workerLoop(void* index)
+{
+	threadDeque = *(int*)index;
+	int spins = 0;
+	while(!atomicLoad(&quit))
+	{
+		if(runOne(threadDeque))
+		{
+			spins = 0;
+			continue;
+		}
+		if(++spins < jobNS::SPINS_BEFORE_SLEEP)
+		{
+			Thread::yield();
+			continue;
+		}
+
+		PROFILE_ZONE("JobSystem::sleep");
+		atomicIncrement(&sleeping);
+		if(atomicAdd(&queued, 0) == 0 && !atomicLoad(&quit)) wake.wait();
+		atomicDecrement(&sleeping);
+		spins = 0;
+	}
+}
@@ -0,0 +1,80 @@
+//=======================================================================================
+// JobSystem.h
+//
+// Work-stealing job scheduler. Every worker thread has its own deque of jobs:
+// it pushes and pops at the bottom, and when it runs dry it steals from the top
+// of someone else's. Threads that aren't workers (the main and simulation
+// threads) share one more deque, and help with the work while they wait.
+//
+//	JobSystem::parallelFor(walls.size(), gameNS::JOB_GRAIN, updateWallRange, this);
+//
+// Jobs run in any order on any thread, so a parallel pass may only write to its
+// own items. Anything order-sensitive (SimRandom, the player, running totals)
+// belongs in a serial pass afterwards that goes through the results in index
+// order; that keeps the simulation, and so replays, deterministic.
+//=======================================================================================
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "Threading.h"
+
+namespace jobNS {
+	const int MAX_WORKERS = 31;
+	//Jobs a deque holds. Queuing onto a full one just runs the job there and then.
+	const int DEQUE_SIZE = 512;
+	//Times an idle worker looks for work before it goes to sleep
+	const int SPINS_BEFORE_SLEEP = 64;
+}
+
+//Runs items [begin, end) of whatever data is
+typedef void (*JobFunction)(void* data, int begin, int end);
+
+//Jobs still to finish. Several jobs can share one; wait on it, or make it
+//another job's dependency.
+struct JobCounter
+{
+	volatile long pending;
+
+	JobCounter() : pending(0) {}
+	bool isDone() {return atomicLoad(&pending) == 0;}
+};
+
+struct Job
+{
+	JobFunction function;
+	void* data;
+	int begin;
+	int end;
+	JobCounter* counter;		//counts the job down when it finishes; may be NULL
+	JobCounter* dependency;		//the job waits for this before it starts; may be NULL
+};
+
+class JobSystem
+{
+public:
+	//Starts this many worker threads. With none, jobs run as they are queued.
+	//Workers are joined at exit, so shutdown has to come first.
+	static void init(int workers);
+	static void shutdown();
+	static int getWorkerCount() {return numWorkers;}
+
+	static void run(JobFunction f, void* data, int begin, int end, JobCounter* counter, JobCounter* dependency = 0);
+	//Runs queued jobs until counter is done
+	static void wait(JobCounter* counter);
+	//Splits [0, count) into jobs of grain items and waits for all of them.
+	//Small counts, or no workers, just run on the calling thread.
+	static void parallelFor(int count, int grain, JobFunction f, void* data);
+
+private:
+	static void workerLoop(void* index);
+	static bool runOne(int deque);
+	static void execute(const Job& job);
+
+	static int numWorkers;
+	static volatile long quit;
+	static volatile long queued;
+	static volatile long sleeping;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "LampPost.h"
+#include "PerfStats.h"
 
 LampPost::LampPost()
 {
@@ -76,10 +77,10 @@ Matrix LampPost::transform(Vector3 scale, Vector3 rotate, Vector3 translate) {
 
 void LampPost::drawWithWorld(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP, Matrix transformation, bool glow) {
 	if (glow) {
+		//The lamp itself glows white
+		Vector3 white(1, 1, 1);
 		mfxGlow->SetInt(2);
-		mfxCubeColorVar = lamp.getCubeColorVar();
-		mfxCubeColorVar->SetRawValue(&lamp.getColor(), 0, sizeof(D3DXVECTOR3));
-		//think I have to add a  mfxCubeColorVar->setRawValue call
+		mfxCubeColorVar->SetRawValue(&white, 0, sizeof(D3DXVECTOR3));
 	}
 	else mfxGlow->SetInt(0);
 
@@ -88,13 +89,16 @@ void LampPost::drawWithWorld(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10Effect
 	Matrix mWVP = worldMatrix* (*mVP);
 	mfxWVPVar->SetMatrix((float*)&mWVP);
 	mfxWorldVar->SetMatrix((float*)&worldMatrix);
+	box->setDrawVars();
 	D3D10_TECHNIQUE_DESC techDesc;
 	mTech->GetDesc( &techDesc );
 	for(UINT p = 0; p < techDesc.Passes; ++p)
 	{
 		mTech->GetPassByIndex( p )->Apply(0);
+		PERF_COUNT(PERF_STATE_CHANGES);
 		box->draw();
 	}
+	box->clearDrawVars();
 	if (glow) mfxGlow->SetInt(0);
 }
 
@@ -115,7 +119,6 @@ void LampPost::init(Box *b, Vector3 pos, float r, float s, int w, int h, int d,
 	mfxCubeColorVar = box->getCubeColorVar();
 	mfxGlow = box->getGlowVar();
 	//Translate(&world, position.x, position.y, position.z);
-	lamp.init(box->getDevice(), 1.0f, D3DXCOLOR(1,1,1,0), box->getMFX());
 }
 
 void LampPost::update(float dt)
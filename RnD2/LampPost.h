@@ -1,6 +1,8 @@
 #ifndef LAMPPOST_H
 #define LAMPPOST_H
 #include "GameObject.h"
+#include "d3dUtil.h"
+#include "Box.h"
 
 class LampPost : public GameObject
 {
@@ -21,9 +23,9 @@ public:
 
 private:
 	ID3D10EffectScalarVariable* mfxGlow;
+	ID3D10EffectVariable* mfxCubeColorVar;
 	float radius;
 	float radiusSquared;
-	Box lamp;
 };
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Line.h"
 #include "Vertex.h"
 #include "constants.h"
+#include "PerfStats.h"
 
 Line::Line()
 : mNumVertices(0), md3dDevice(0), mVB(0), mIB(0)
@@ -29,25 +30,29 @@ void Line::init(ID3D10Device* device, float scale, D3DXCOLOR c)
 	// Scale the Line.
 	for(DWORD i = 0; i < mNumVertices; ++i)
 		vertices[i].pos *= scale;
+	PackedVertex packed[2];
+	for(DWORD i = 0; i < mNumVertices; ++i)
+		packed[i] = vertices[i].pack();
 
 
     D3D10_BUFFER_DESC vbd;
     vbd.Usage = D3D10_USAGE_IMMUTABLE;
-    vbd.ByteWidth = sizeof(Vertex) * mNumVertices;
+    vbd.ByteWidth = sizeof(PackedVertex) * mNumVertices;
     vbd.BindFlags = D3D10_BIND_VERTEX_BUFFER;
     vbd.CPUAccessFlags = 0;
     vbd.MiscFlags = 0;
     D3D10_SUBRESOURCE_DATA vinitData;
-    vinitData.pSysMem = vertices;
+    vinitData.pSysMem = packed;
     HR(md3dDevice->CreateBuffer(&vbd, &vinitData, &mVB));
 }
 
 
 void Line::draw()
 {
-	UINT stride = sizeof(Vertex);
+	UINT stride = sizeof(PackedVertex);
     UINT offset = 0;
     md3dDevice->IASetVertexBuffers(0, 1, &mVB, &stride, &offset);
 	md3dDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_LINELIST);
 	md3dDevice->Draw(2,0);
+	PERF_COUNT(PERF_DRAW_CALLS);
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "LineObject.h"
+#include "PerfStats.h"
 
 LineObject::LineObject()
 {
@@ -24,6 +25,7 @@ void LineObject::draw()
     for(UINT p = 0; p < techDesc.Passes; ++p)
     {
         mTech->GetPassByIndex( p )->Apply(0);
+        PERF_COUNT(PERF_STATE_CHANGES);
         line->draw();
     }
 
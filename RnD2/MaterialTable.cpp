@@ -0,0 +1,60 @@
+#include "MaterialTable.h"
+
+using namespace materialNS;
+
+MaterialTable::MaterialTable()
+{
+	clear();
+}
+
+void MaterialTable::clear()
+{
+	for(int i=0; i<NUM_MATERIALS; i++)
+	{
+		known[i] = false;
+		groups[i] = i;
+		slices[i] = NO_SLICE;
+	}
+	groupCount = NUM_MATERIALS;
+	arrays.clear();
+}
+
+void MaterialTable::setLayout(int material, const TextureData& layout, int other)
+{
+	known[material] = true;
+	others[material] = other;
+	layouts[material].width = layout.width;
+	layouts[material].height = layout.height;
+	layouts[material].mipLevels = layout.mipLevels;
+	layouts[material].format = layout.format;
+}
+
+bool MaterialTable::sameLayout(int a, int b) const
+{
+	return others[a] == others[b] && layouts[a].width == layouts[b].width && layouts[a].height == layouts[b].height &&
+		layouts[a].mipLevels == layouts[b].mipLevels && layouts[a].format == layouts[b].format;
+}
+
+//Materials go into the first array whose maps look like theirs, in material
+//order, so the same layouts always give the same slices
+void MaterialTable::build()
+{
+	arrays.clear();
+	for(int i=0; i<NUM_MATERIALS; i++)
+	{
+		if(!known[i]) continue;
+		unsigned int a = 0;
+		while(a < arrays.size() && !sameLayout(arrays[a][0], i)) a++;
+		if(a == arrays.size()) arrays.push_back(vector<int>());
+		groups[i] = a;
+		slices[i] = arrays[a].size();
+		arrays[a].push_back(i);
+	}
+	groupCount = arrays.size();
+	for(int i=0; i<NUM_MATERIALS; i++)
+	{
+		if(known[i]) continue;
+		groups[i] = groupCount++;
+		slices[i] = NO_SLICE;
+	}
+}
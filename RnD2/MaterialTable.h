@@ -0,0 +1,59 @@
+#ifndef MATERIAL_TABLE_H
+#define MATERIAL_TABLE_H
+
+#include "SimRenderer.h"
+#include "TextureData.h"
+#include <vector>
+using std::vector;
+
+namespace materialNS {
+	//A material drawn from a texture of its own rather than a slice of an array
+	const int NO_SLICE = -1;
+}
+
+//Which materials' diffuse maps are slices of a shared Texture2DArray. Maps
+//with the same size, mips and format go in one array, so every material in
+//it draws with one bind and its slice goes along with each instance. A
+//material whose map's layout isn't known (it isn't in the asset pack) keeps a
+//texture of its own.
+//
+//Every material has a bind group: the arrays are groups 0 up and the loners
+//come after. Draws in one group need nothing rebound between them, so
+//InstanceBatcher batches on the group rather than the material. Until build()
+//each material is its own group.
+//
+//No D3D in here, so the grouping can be checked without a GPU.
+class MaterialTable
+{
+public:
+	MaterialTable();
+
+	//Forgets every layout
+	void clear();
+	//other is whatever else the material binds, which has to match too for
+	//two materials to share an array; the game gives its specular map
+	void setLayout(int material, const TextureData& layout, int other);
+	//Shares out the arrays and slices
+	void build();
+
+	//-1 for material -1, which is "whatever is bound"
+	int getGroup(int material) const {return material < 0 ? -1 : groups[material];}
+	int getSlice(int material) const {return material < 0 ? materialNS::NO_SLICE : slices[material];}
+	int getGroupCount() const {return groupCount;}
+	int getArrayCount() const {return arrays.size();}
+	//An array's materials, slice by slice
+	const vector<int>& getArrayMaterials(int array) const {return arrays[array];}
+
+private:
+	bool sameLayout(int a, int b) const;
+
+	bool known[NUM_MATERIALS];
+	TextureData layouts[NUM_MATERIALS];
+	int others[NUM_MATERIALS];
+	int groups[NUM_MATERIALS];
+	int slices[NUM_MATERIALS];
+	int groupCount;
+	vector<vector<int> > arrays;
+};
+
+#endif
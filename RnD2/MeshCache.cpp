@@ -0,0 +1,139 @@
+#include "MeshCache.h"
+#include "Vertex.h"
+#include "PerfStats.h"
+
+using namespace meshCacheNS;
+
+MeshCache& GetMeshCache()
+{
+	static MeshCache mc;
+
+	return mc;
+}
+
+MeshCache::MeshCache()
+: md3dDevice(0), bufferCount(0)
+{
+	for(int i = 0; i < NUM_LAYOUTS; ++i)
+		cubes[i].vb = cubes[i].ib = 0;
+}
+
+MeshCache::~MeshCache()
+{
+	for(int i = 0; i < NUM_LAYOUTS; ++i)
+	{
+		ReleaseCOM(cubes[i].vb);
+		ReleaseCOM(cubes[i].ib);
+	}
+}
+
+void MeshCache::init(ID3D10Device* device)
+{
+	md3dDevice = device;
+}
+
+const CubeMesh* MeshCache::getCube(CubeLayout layout)
+{
+	if(cubes[layout].vb == 0) buildCube(layout);
+	return &cubes[layout];
+}
+
+//The faces' corners, normals and texture coordinates, as Box has always had them
+static D3DXVECTOR2 texCoord(CubeLayout layout, int corner)
+{
+	static const float COLORED[4][2] = {{1, 1}, {1, 0}, {0, 0}, {0, 1}};
+	static const float PLAIN[4][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+	const float* uv = layout == COLORED_CUBE ? COLORED[corner] : PLAIN[corner];
+	return D3DXVECTOR2(uv[0], uv[1]);
+}
+
+void MeshCache::buildCube(CubeLayout layout)
+{
+	D3DXCOLOR white(1.0f, 1.0f, 1.0f, 1.0f);
+	D3DXVECTOR3 front(0.0f, 0.0f, -1.0f), left(-1.0f, 0.0f, 0.0f), back(0.0f, 0.0f, 1.0f);
+	D3DXVECTOR3 right(1.0f, 0.0f, 0.0f), top(0.0f, 1.0f, 0.0f), bottom(0.0f, -1.0f, 0.0f);
+	Vertex vertices[] =
+	{
+		//front - 0 1 2 3
+		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), front, white, white, texCoord(layout, 0)),
+		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), front, white, white, texCoord(layout, 1)),
+		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), front, white, white, texCoord(layout, 2)),
+		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), front, white, white, texCoord(layout, 3)),
+
+		//left - 7 6 1 0
+		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), left, white, white, texCoord(layout, 0)),
+		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), left, white, white, texCoord(layout, 1)),
+		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), left, white, white, texCoord(layout, 2)),
+		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), left, white, white, texCoord(layout, 3)),
+
+		//back - 4 5 6 7
+		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), back, white, white, texCoord(layout, 0)),
+		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), back, white, white, texCoord(layout, 1)),
+		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), back, white, white, texCoord(layout, 2)),
+		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), back, white, white, texCoord(layout, 3)),
+
+		//right - 3 2 5 4
+		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), right, white, white, texCoord(layout, 0)),
+		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), right, white, white, texCoord(layout, 1)),
+		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), right, white, white, texCoord(layout, 2)),
+		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), right, white, white, texCoord(layout, 3)),
+
+		//top - 1 6 5 2
+		Vertex(D3DXVECTOR3(-1.0f, 2.0f, -1.0f), top, white, white, texCoord(layout, 0)),
+		Vertex(D3DXVECTOR3(-1.0f, 2.0f, +1.0f), top, white, white, texCoord(layout, 1)),
+		Vertex(D3DXVECTOR3(+1.0f, 2.0f, +1.0f), top, white, white, texCoord(layout, 2)),
+		Vertex(D3DXVECTOR3(+1.0f, 2.0f, -1.0f), top, white, white, texCoord(layout, 3)),
+
+		//bottom - 7 0 3 4
+		Vertex(D3DXVECTOR3(-1.0f, 0.0f, +1.0f), bottom, white, white, texCoord(layout, 0)),
+		Vertex(D3DXVECTOR3(-1.0f, 0.0f, -1.0f), bottom, white, white, texCoord(layout, 1)),
+		Vertex(D3DXVECTOR3(+1.0f, 0.0f, -1.0f), bottom, white, white, texCoord(layout, 2)),
+		Vertex(D3DXVECTOR3(+1.0f, 0.0f, +1.0f), bottom, white, white, texCoord(layout, 3)),
+	};
+
+	PackedVertex packed[CUBE_VERTICES];
+	for(int i = 0; i < CUBE_VERTICES; ++i)
+		packed[i] = vertices[i].pack();
+
+	unsigned short coloredIndices[CUBE_INDICES] = {
+		0, 1, 2,	3, 2, 0,		//front
+		4, 5, 6,	7, 6, 4,		//left
+		8, 9, 10,	11, 10, 8,		//back
+		12, 13, 14,	15, 14, 12,		//right
+		16, 17, 18,	19, 18, 16,		//top
+		20, 21, 22,	23, 22, 20		//bottom
+	};
+	unsigned short plainIndices[CUBE_INDICES] = {
+		0, 1, 2,	0, 2, 3,		//front
+		4, 5, 6,	4, 6, 7,		//left
+		8, 9, 10,	8, 10, 11,		//back
+		12, 13, 14,	13, 14, 15,		//right
+		16, 17, 18,	16, 18, 19,		//top
+		20, 21, 22,	20, 22, 23		//bottom
+	};
+
+	CubeMesh& cube = cubes[layout];
+
+	D3D10_BUFFER_DESC vbd;
+	vbd.Usage = D3D10_USAGE_IMMUTABLE;
+	vbd.ByteWidth = sizeof(PackedVertex) * CUBE_VERTICES;
+	vbd.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = 0;
+	vbd.MiscFlags = 0;
+	D3D10_SUBRESOURCE_DATA vinitData;
+	vinitData.pSysMem = packed;
+	HR(md3dDevice->CreateBuffer(&vbd, &vinitData, &cube.vb));
+
+	D3D10_BUFFER_DESC ibd;
+	ibd.Usage = D3D10_USAGE_IMMUTABLE;
+	ibd.ByteWidth = sizeof(unsigned short) * CUBE_INDICES;
+	ibd.BindFlags = D3D10_BIND_INDEX_BUFFER;
+	ibd.CPUAccessFlags = 0;
+	ibd.MiscFlags = 0;
+	D3D10_SUBRESOURCE_DATA iinitData;
+	iinitData.pSysMem = layout == COLORED_CUBE ? coloredIndices : plainIndices;
+	HR(md3dDevice->CreateBuffer(&ibd, &iinitData, &cube.ib));
+
+	bufferCount += 2;
+	PERF_COUNT_N(PERF_ALLOCATIONS, 2);
+}
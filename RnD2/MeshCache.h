@@ -0,0 +1,53 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include "d3dUtil.h"
+
+namespace meshCacheNS {
+	//Box has two ways of laying texture coordinates and triangles on its faces:
+	//the one the coloured init always used and the one the plain init did
+	enum CubeLayout {COLORED_CUBE, PLAIN_CUBE, NUM_LAYOUTS};
+	const int CUBE_VERTICES = 24;
+	const int CUBE_INDICES = 36;
+}
+
+//One cube's buffers, shared by every Box with its layout: PackedVertex
+//vertices and 16-bit indices
+struct CubeMesh
+{
+	ID3D10Buffer* vb;
+	ID3D10Buffer* ib;
+};
+
+//The unit cube every Box draws, made once per layout. Its vertices are white
+//and unscaled; each Box passes its own colour and size to lighting.fx when it
+//draws, so a new colour costs no buffers at all.
+class MeshCache
+{
+public:
+	friend MeshCache& GetMeshCache();
+
+	void init(ID3D10Device* device);
+
+	//Made the first time it's asked for
+	const CubeMesh* getCube(meshCacheNS::CubeLayout layout);
+	//Vertex and index buffers made so far
+	int getBufferCount() {return bufferCount;}
+
+private:
+	MeshCache();
+	MeshCache(const MeshCache& rhs);
+	MeshCache& operator=(const MeshCache& rhs);
+	~MeshCache();
+
+	void buildCube(meshCacheNS::CubeLayout layout);
+
+private:
+	ID3D10Device* md3dDevice;
+	CubeMesh cubes[meshCacheNS::NUM_LAYOUTS];
+	int bufferCount;
+};
+
+MeshCache& GetMeshCache();
+
+#endif // MESHCACHE_H
@@ -0,0 +1,389 @@
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef MIP_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace textureDataNS;
+using namespace mipNS;
+
+//Four floats a texel, RGBA, row after row
+struct FloatImage
+{
+	int width, height;
+	vector<float> texels;
+};
+
+//The source texels each new texel along one axis is made from
+struct Taps
+{
+	int count;				//the same for every new texel
+	vector<int> first;		//the first source texel of each new one's taps
+	vector<float> weights;	//count for each new texel, adding up to 1
+};
+
+//sRGB bytes to linear, and the linear value halfway between each byte and the
+//next, with where to start looking for it in 4096 even steps
+struct SrgbTables
+{
+	float linear[256];
+	float halfway[255];
+	unsigned char start[4096];
+};
+
+static float srgbToLinear(float s)
+{
+	return s <= 0.04045f ? s / 12.92f : powf((s + 0.055f) / 1.055f, 2.4f);
+}
+
+static void buildSrgbTables(SrgbTables* t)
+{
+	for(int i=0; i<256; i++)
+		t->linear[i] = srgbToLinear(i / 255.0f);
+	for(int i=0; i<255; i++)
+		t->halfway[i] = srgbToLinear((i + 0.5f) / 255.0f);
+	int byte = 0;
+	for(int i=0; i<4096; i++)
+	{
+		while(byte < 255 && t->halfway[byte] <= i / 4095.0f) byte++;
+		t->start[i] = (unsigned char)byte;
+	}
+}
+
+//The byte whose sRGB value is nearest
+static unsigned char linearToSrgb(const SrgbTables& t, float f)
+{
+	if(!(f > 0)) return 0;
+	if(f >= 1) return 255;
+	int byte = t.start[(int)(f*4095.0f)];
+	while(byte < 255 && f >= t.halfway[byte]) byte++;
+	return (unsigned char)byte;
+}
+
+static unsigned char toByte(float f)
+{
+	if(!(f > 0)) return 0;
+	if(f >= 1) return 255;
+	return (unsigned char)(f*255.0f + 0.5f);
+}
+
+//Modified Bessel function of the first kind, order 0, for the Kaiser window
+static double besselI0(double x)
+{
+	double sum = 1, term = 1, q = x*x/4;
+	for(int k=1; k<50 && term > sum*1e-12; k++)
+	{
+		term *= q / ((double)k*k);
+		sum += term;
+	}
+	return sum;
+}
+
+//How much of source texel j goes into a new texel centred on c, with the
+//filter stretched by scale
+static double filterWeight(Filter f, double j, double c, double scale)
+{
+	double t = (j - c) / scale;
+	if(f == BOX)
+	{
+		//The overlap of the source texel with the new one's footprint
+		double lo = t - 0.5/scale > -0.5 ? t - 0.5/scale : -0.5;
+		double hi = t + 0.5/scale < 0.5 ? t + 0.5/scale : 0.5;
+		return hi > lo ? (hi - lo)*scale : 0;
+	}
+	if(fabs(t) >= KAISER_WIDTH) return 0;
+	const double PI_D = 3.14159265358979323846;
+	double sinc = t == 0 ? 1 : sin(PI_D*t) / (PI_D*t);
+	double r = t / KAISER_WIDTH;
+	return sinc * besselI0(KAISER_ALPHA*sqrt(1 - r*r)) / besselI0(KAISER_ALPHA);
+}
+
+//Taps past either edge are folded onto it, as the game's clamp sampler does.
+//Only as many taps are kept as the widest new texel has weights that aren't 0.
+static void makeTaps(int src, int dst, Filter f, Taps* taps)
+{
+	double scale = (double)src / dst;
+	double stretch = scale > 1 ? scale : 1;
+	//Source texels further than this from a new one's centre add nothing
+	double radius = f == BOX ? (stretch + 1)*0.5 : KAISER_WIDTH*stretch;
+	int span = (int)ceil(radius*2) + 1;
+	vector<double> w((size_t)dst*span, 0.0);
+	vector<int> lowest(dst), highest(dst);
+	int count = 1;
+	for(int x=0; x<dst; x++)
+	{
+		double c = (x + 0.5)*scale - 0.5;
+		int lo = (int)floor(c - radius);
+		int base = lo > 0 ? lo : 0;
+		double sum = 0;
+		lowest[x] = src;
+		highest[x] = -1;
+		for(int j=lo; j<lo + span; j++)
+		{
+			double weight = filterWeight(f, j, c, stretch);
+			if(weight == 0) continue;
+			int clamped = j < 0 ? 0 : j >= src ? src - 1 : j;
+			w[(size_t)x*span + clamped - base] += weight;
+			sum += weight;
+			if(clamped < lowest[x]) lowest[x] = clamped;
+			if(clamped > highest[x]) highest[x] = clamped;
+		}
+		for(int k=0; k<span; k++)
+			w[(size_t)x*span + k] /= sum;
+		if(highest[x] - lowest[x] + 1 > count) count = highest[x] - lowest[x] + 1;
+	}
+
+	taps->count = count;
+	taps->first.resize(dst);
+	taps->weights.assign((size_t)dst*count, 0.0f);
+	for(int x=0; x<dst; x++)
+	{
+		int lo = (int)floor((x + 0.5)*scale - 0.5 - radius);
+		int base = lo > 0 ? lo : 0;
+		int first = lowest[x] < src - count ? lowest[x] : src - count;
+		taps->first[x] = first;
+		for(int j=lowest[x]; j<=highest[x]; j++)
+			taps->weights[(size_t)x*count + j - first] = (float)w[(size_t)x*span + j - base];
+	}
+}
+
+//One resampling pass's worth of work for the job system
+struct ResampleJob
+{
+	const FloatImage* src;
+	FloatImage* across;		//src resampled along x only
+	FloatImage* dst;
+	const Taps* tapsX;
+	const Taps* tapsY;
+};
+
+//Each source row to the new width
+static void resampleRows(void* data, int begin, int end)
+{
+	const ResampleJob& job = *(const ResampleJob*)data;
+	const Taps& taps = *job.tapsX;
+	int srcW = job.src->width, dstW = job.across->width;
+	for(int y=begin; y<end; y++)
+	{
+		const float* in = &job.src->texels[(size_t)y*srcW*4];
+		float* out = &job.across->texels[(size_t)y*dstW*4];
+		for(int x=0; x<dstW; x++)
+		{
+			const float* weights = &taps.weights[(size_t)x*taps.count];
+			const float* p = in + taps.first[x]*4;
+#ifdef MIP_SSE2
+			__m128 acc = _mm_setzero_ps();
+			for(int k=0; k<taps.count; k++)
+				acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(p + k*4), _mm_set1_ps(weights[k])));
+			_mm_storeu_ps(out + x*4, acc);
+#else
+			float acc[4] = {0, 0, 0, 0};
+			for(int k=0; k<taps.count; k++)
+				for(int c=0; c<4; c++)
+					acc[c] += p[k*4 + c]*weights[k];
+			memcpy(out + x*4, acc, sizeof(acc));
+#endif
+		}
+	}
+}
+
+//Each new row from the rows above and below it, a whole row at a time
+static void resampleColumns(void* data, int begin, int end)
+{
+	const ResampleJob& job = *(const ResampleJob*)data;
+	const Taps& taps = *job.tapsY;
+	int n = job.dst->width*4;
+	for(int y=begin; y<end; y++)
+	{
+		float* out = &job.dst->texels[(size_t)y*n];
+		memset(out, 0, n*sizeof(float));
+		for(int k=0; k<taps.count; k++)
+		{
+			const float* in = &job.across->texels[(size_t)(taps.first[y] + k)*n];
+			float weight = taps.weights[(size_t)y*taps.count + k];
+#ifdef MIP_SSE2
+			__m128 w = _mm_set1_ps(weight);
+			for(int i=0; i<n; i+=4)
+				_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), w)));
+#else
+			for(int i=0; i<n; i++)
+				out[i] += in[i]*weight;
+#endif
+		}
+	}
+}
+
+static void resample(const FloatImage& src, int w, int h, Filter f, FloatImage* dst)
+{
+	Taps tapsX, tapsY;
+	makeTaps(src.width, w, f, &tapsX);
+	makeTaps(src.height, h, f, &tapsY);
+	FloatImage across;
+	across.width = w;
+	across.height = src.height;
+	across.texels.resize((size_t)w*src.height*4);
+	dst->width = w;
+	dst->height = h;
+	dst->texels.resize((size_t)w*h*4);
+
+	ResampleJob job;
+	job.src = &src;
+	job.across = &across;
+	job.dst = dst;
+	job.tapsX = &tapsX;
+	job.tapsY = &tapsY;
+	JobSystem::parallelFor(src.height, ROW_GRAIN, resampleRows, &job);
+	JobSystem::parallelFor(h, ROW_GRAIN, resampleColumns, &job);
+}
+
+//Bytes to and from float, a row at a time
+struct ConvertJob
+{
+	const SrgbTables* tables;	//NULL if the colour is linear
+	unsigned char* bytes;
+	FloatImage* image;
+	float alphaScale;
+};
+
+static void rowsToFloat(void* data, int begin, int end)
+{
+	const ConvertJob& job = *(const ConvertJob*)data;
+	int w = job.image->width;
+	for(int y=begin; y<end; y++)
+	{
+		const unsigned char* in = job.bytes + (size_t)y*w*4;
+		float* out = &job.image->texels[(size_t)y*w*4];
+		if(!job.tables)
+			for(int i=0; i<w*4; i++)
+				out[i] = in[i] / 255.0f;
+		else
+			for(int i=0; i<w*4; i+=4)
+			{
+				for(int c=0; c<3; c++)
+					out[i + c] = job.tables->linear[in[i + c]];
+				out[i + 3] = in[i + 3] / 255.0f;
+			}
+	}
+}
+
+static void rowsToBytes(void* data, int begin, int end)
+{
+	const ConvertJob& job = *(const ConvertJob*)data;
+	int w = job.image->width;
+	for(int y=begin; y<end; y++)
+	{
+		const float* in = &job.image->texels[(size_t)y*w*4];
+		unsigned char* out = job.bytes + (size_t)y*w*4;
+		for(int i=0; i<w*4; i+=4)
+		{
+			for(int c=0; c<3; c++)
+				out[i + c] = job.tables ? linearToSrgb(*job.tables, in[i + c]) : toByte(in[i + c]);
+			out[i + 3] = toByte(in[i + 3]*job.alphaScale);
+		}
+	}
+}
+
+static void toFloat(const unsigned char* bytes, int w, int h, const SrgbTables* tables, FloatImage* image)
+{
+	image->width = w;
+	image->height = h;
+	image->texels.resize((size_t)w*h*4);
+	ConvertJob job;
+	job.tables = tables;
+	job.bytes = (unsigned char*)bytes;
+	job.image = image;
+	job.alphaScale = 1;
+	JobSystem::parallelFor(h, ROW_GRAIN, rowsToFloat, &job);
+}
+
+static void toBytes(FloatImage& image, const SrgbTables* tables, float alphaScale, unsigned char* bytes)
+{
+	ConvertJob job;
+	job.tables = tables;
+	job.bytes = bytes;
+	job.image = &image;
+	job.alphaScale = alphaScale;
+	JobSystem::parallelFor(image.height, ROW_GRAIN, rowsToBytes, &job);
+}
+
+//The share of texels whose alpha, scaled and stored as a byte, is over ref
+static float coverage(const FloatImage& image, float alphaScale, float ref)
+{
+	int n = image.width*image.height, over = 0;
+	for(int i=0; i<n; i++)
+		if(toByte(image.texels[i*4 + 3]*alphaScale) > ref*255.0f) over++;
+	return (float)over / n;
+}
+
+//The alpha scale that brings a level's coverage closest to the top level's.
+//Coverage only grows with the scale, so a bisection finds it.
+static float coverageScale(const FloatImage& image, float target, float ref)
+{
+	float lo = 0, hi = 4;
+	if(coverage(image, hi, ref) <= target) return hi;
+	for(int i=0; i<COVERAGE_STEPS; i++)
+	{
+		float mid = (lo + hi)*0.5f;
+		if(coverage(image, mid, ref) < target) lo = mid;
+		else hi = mid;
+	}
+	return hi;
+}
+
+bool generateMips(TextureData* image, const MipOptions& options)
+{
+	if(image->isCompressed()) return false;
+	int levels = TextureData::fullMipCount(image->width, image->height);
+	if(image->mipLevels >= levels) return true;
+
+	SrgbTables tables;
+	if(options.srgb) buildSrgbTables(&tables);
+	const SrgbTables* srgb = options.srgb ? &tables : 0;
+
+	//The top level stays where it is and the rest go after it
+	image->mipLevels = 1;
+	image->allocate(image->width, image->height, levels, RGBA8);
+	FloatImage level, next;
+	toFloat(image->getMip(0), image->width, image->height, srgb, &level);
+	float target = options.alphaRef > 0 ? coverage(level, 1, options.alphaRef) : 0;
+	//Each level comes from the last one as it was filtered, before its alpha
+	//was scaled, so the scaling doesn't build up down the chain
+	for(int i=1; i<levels; i++)
+	{
+		resample(level, image->getMipWidth(i), image->getMipHeight(i), options.filter, &next);
+		float alphaScale = options.alphaRef > 0 ? coverageScale(next, target, options.alphaRef) : 1;
+		toBytes(next, srgb, alphaScale, image->getMip(i));
+		level.texels.swap(next.texels);
+		level.width = next.width;
+		level.height = next.height;
+	}
+	return true;
+}
+
+bool resizeImage(TextureData* image, int w, int h, const MipOptions& options)
+{
+	if(image->isCompressed() || w < 1 || h < 1) return false;
+	if(image->width == w && image->height == h) return true;
+
+	SrgbTables tables;
+	if(options.srgb) buildSrgbTables(&tables);
+	const SrgbTables* srgb = options.srgb ? &tables : 0;
+
+	FloatImage src, dst;
+	toFloat(image->getMip(0), image->width, image->height, srgb, &src);
+	resample(src, w, h, options.filter, &dst);
+	image->allocate(w, h, 1, RGBA8);
+	toBytes(dst, srgb, 1, image->getMip(0));
+	return true;
+}
+
+int nearestPowerOfTwo(int n)
+{
+	int p = 1;
+	while(p*2 <= n && p < (1 << 30)) p *= 2;
+	//n sits between p and 2p; the nearer by ratio is the one n*n is closer to
+	return (double)n*n > 2.0*p*p ? p*2 : p;
+}
@@ -0,0 +1,51 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include "TextureData.h"
+
+//SSE2 is always there on x64 and MSVC has the intrinsics on x86 too; anything
+//else gets the plain loop, which gives the same answers
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define MIP_SSE2
+#endif
+
+namespace mipNS {
+	//BOX averages the texels each new one covers. KAISER is a Kaiser-windowed
+	//sinc, sharper with less aliasing, for a little ringing at hard edges.
+	enum Filter {BOX, KAISER, NUM_FILTERS};
+	//The Kaiser filter's half-width in new texels, and its window's alpha
+	const float KAISER_WIDTH = 3.0f;
+	const float KAISER_ALPHA = 4.0f;
+	//Rows a job filters
+	const int ROW_GRAIN = 16;
+	//Steps of the search for the alpha scale that keeps a level's coverage
+	const int COVERAGE_STEPS = 16;
+}
+
+struct MipOptions
+{
+	mipNS::Filter filter;
+	//Colour is sRGB-encoded, so it's filtered in linear light and encoded
+	//again after; alpha is always linear
+	bool srgb;
+	//If above 0, every level has as many texels with alpha over this as the
+	//top one, so alpha-tested or thin sprites don't fade away in the distance
+	float alphaRef;
+
+	MipOptions() : filter(mipNS::BOX), srgb(false), alphaRef(0) {}
+};
+
+//Gives a one-level RGBA8 image its full mip chain down to 1x1, each level
+//filtered from the one above in float. Rows are shared out over the job
+//system. Returns false for a compressed image, which has to come with its
+//mips.
+bool generateMips(TextureData* image, const MipOptions& options = MipOptions());
+
+//Resamples a one-level RGBA8 image to w by h with the same filters; growing,
+//BOX is bilinear. Returns false for a compressed image.
+bool resizeImage(TextureData* image, int w, int h, const MipOptions& options = MipOptions());
+
+//The power of two closest to n by ratio, so 640 gives 512 and 781 gives 1024
+int nearestPowerOfTwo(int n);
+
+#endif
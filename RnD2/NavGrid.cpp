@@ -0,0 +1,190 @@
+#include "NavGrid.h"
+#include <queue>
+using std::priority_queue;
+
+static void queue_remove(priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare>& pq, Waypoint* w);
+static float heuristic(Waypoint* x, Waypoint* y);
+
+NavGrid::NavGrid()
+{
+	size = 0;
+}
+
+void NavGrid::place(int n, float width, float depth)
+{
+	//Neighbours are pointers into the vector, so a new size starts unlinked
+	if(n != size)
+	{
+		waypoints.assign(n*n, Waypoint());
+		size = n;
+	}
+	for(int i=0; i<size; i++){
+		for(int j=0; j<size; j++)
+		{
+			D3DXVECTOR3 pos(i*width/(size-1) - width/2, 0, j*depth/(size-1) - depth/2);
+			at(i, j)->setPosition(pos);
+			at(i, j)->setContainer(NONE);
+		}
+	}
+}
+
+void NavGrid::link(int i, int j, bool west, bool east, bool south, bool north)
+{
+	if(west && i-1 >= 0) at(i, j)->addNeighbor(at(i-1, j));
+	if(east && i+1 < size) at(i, j)->addNeighbor(at(i+1, j));
+	if(south && j-1 >= 0) at(i, j)->addNeighbor(at(i, j-1));
+	if(north && j+1 < size) at(i, j)->addNeighbor(at(i, j+1));
+}
+
+void NavGrid::linkAll()
+{
+	//Currently just waypoints in the cardinal directions
+	for(int i=0; i<size; i++)
+		for(int j=0; j<size; j++)
+			link(i, j, true, true, true, true);
+}
+
+void NavGrid::clearLinks()
+{
+	for(unsigned int k=0; k<waypoints.size(); k++)
+	{
+		D3DXVECTOR3 pos = waypoints[k].getPosition();
+		waypoints[k] = Waypoint(pos);
+	}
+}
+
+vector<D3DXVECTOR3> NavGrid::getPositions()
+{
+	vector<D3DXVECTOR3> wp;
+	for(unsigned int i=0; i<waypoints.size(); i++)
+		wp.push_back(waypoints[i].getPosition());
+	return wp;
+}
+
+list<Waypoint*> NavGrid::findPath(Waypoint* src, Waypoint* dest)
+{
+	priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare> openWay;
+	vector<Waypoint*> closedWay;
+	list<Waypoint*> path;
+	if(src == dest)
+	{
+		path.push_front(src);
+		return path;
+	}
+
+	for(unsigned int i=0; i<waypoints.size(); i++)
+	{
+		waypoints[i].setContainer(NONE);
+		waypoints[i].setFCost(0);
+		waypoints[i].setGCost(0);
+		waypoints[i].setParent(0);
+	}
+
+	//find path
+	src->setFCost(heuristic(src, dest));
+
+	int nodesConsidered = 0;
+	src->setContainer(OPEN);
+	openWay.push(src);
+
+	//OPEN = priority queue containing START
+	//CLOSED = empty set
+	//while lowest rank in OPEN is not the GOAL:
+	while(!openWay.empty())
+	{
+		nodesConsidered++;
+		//current = remove lowest rank item from OPEN
+		Waypoint* current = openWay.top();
+		openWay.pop();
+		current->setContainer(NONE);
+
+		if(current == dest)
+			break;
+		//for neighbors of current
+		for(int i=0; i<current->getNeighbors().size(); i++)
+		{
+			Waypoint* n = current->getNeighbors()[i];
+			if(n->isActive())
+			{
+				//cost to get to n from current
+				float gCost = current->getGCost() + 1;
+
+				//Cost to get from n to target
+				float hCost = heuristic(dest, n);
+
+				//total cost through waypoint n
+				float cost = gCost + hCost;
+
+				//if neighbor in OPEN and cost less than g(neighbor):
+				//and this solution is better than what we've seen
+				if(n->getContainer() == OPEN && gCost < n->getGCost())
+				{
+					//remove neighbor from OPEN, because new path is better
+					queue_remove(openWay, n);
+					n->setContainer(NONE);
+				}
+				//if neighbor in CLOSED and cost less than g(neighbor):
+				//and this solution is better than what we've seen
+				if(n->getContainer() == CLOSED && gCost < n->getGCost())
+				{
+					//remove neighbor from CLOSED
+					for(int i=0; i<closedWay.size(); i++)
+					{
+						if(closedWay[i] == n)
+						{
+							closedWay[i] = closedWay[closedWay.size()-1];
+							closedWay.pop_back();
+						}
+					}
+					n->setContainer(NONE);
+				}
+				//if neighbor not in OPEN and neighbor not in CLOSED:
+				if(n->getContainer() == NONE && n->getFCost() <= current->getFCost())
+				{
+					//set g(neighbor) to cost
+					n->setFCost(cost);
+					n->setGCost(gCost);
+					//set neighbor's parent to current
+					n->setParent(current);
+					//add neighbor to OPEN
+					n->setContainer(OPEN);
+					openWay.push(n);
+					//set priority queue rank to g(neighbor) + h(neighbor)
+				}
+			}
+		}
+		//add current to CLOSED
+		current->setContainer(CLOSED);
+		closedWay.push_back(current);
+	}
+
+	Waypoint* c = dest;
+	while(c->getParent() != 0)
+	{
+		path.push_front(c);
+		c = c->getParent();
+	}
+	path.push_front(c);
+	return path;
+}
+
+static void queue_remove(priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare>& pq, Waypoint* w)
+{
+	priority_queue<Waypoint*, vector<Waypoint*>, WaypointCompare> hold;
+	int limit = pq.size();
+	for(int i=0; i<limit; i++)
+	{
+		if(pq.top() == w) pq.pop();//don't copy it over
+		else
+		{
+			hold.push(pq.top());
+			pq.pop();
+		}
+	}
+	pq = hold;
+}
+
+static float heuristic(Waypoint* x, Waypoint* y)
+{
+	return abs(x->getPosition().x - y->getPosition().x) + abs(x->getPosition().z - y->getPosition().z);
+}
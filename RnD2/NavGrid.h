@@ -0,0 +1,47 @@
+#ifndef NAV_GRID_H
+#define NAV_GRID_H
+
+#include "Waypoint.h"
+#include <list>
+using std::list;
+#include <vector>
+using std::vector;
+
+//The waypoints every enemy paths over: an n by n grid laid evenly over the
+//ground, row i at i*n. The world owns one and the enemies share it, so its
+//size costs memory once rather than once per enemy.
+//
+//findPath scribbles its working costs on the waypoints, so only one search
+//may run at a time. Enemies only path while thinking, which is serial.
+class NavGrid
+{
+public:
+	NavGrid();
+
+	//Lays out n*n waypoints evenly over width by depth, centred on the origin.
+	//Links are kept if n hasn't changed, so a level can add to the last one's.
+	void place(int n, float width, float depth);
+	//Links i,j to the neighbours in the directions asked for
+	void link(int i, int j, bool west, bool east, bool south, bool north);
+	//Links every waypoint to all four neighbours
+	void linkAll();
+	void clearLinks();
+
+	int getSize() {return size;}
+	int getCount() {return waypoints.size();}
+	Waypoint* at(int i, int j) {return &waypoints[i*size + j];}
+	Waypoint* get(int k) {return &waypoints[k];}
+	Waypoint* getCentre() {return at(size/2, size/2);}
+	//For positioning waypoint indicators
+	vector<D3DXVECTOR3> getPositions();
+
+	//A* from source to target over active waypoints. Returns the waypoints to
+	//visit, starting with source.
+	list<Waypoint*> findPath(Waypoint* source, Waypoint* target);
+
+private:
+	vector<Waypoint> waypoints;
+	int size;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+using std::vector;
+
+//A fixed number of objects made up front, plus the list of the ones in use.
+//Loops go over the active list, so they cost what is alive rather than what
+//there is room for. Both lists stay in slot order: acquire hands out the lowest
+//free slot and the active list runs low to high, so the order things are
+//visited in never depends on the order they spawned and died.
+//
+//T needs setActive, setInActive and getActiveState, as every GameObject has.
+template <class T>
+class ObjectPool
+{
+public:
+	//Drops everything and makes capacity objects, all free
+	void init(int capacity)
+	{
+		items.assign(capacity, T());
+		active.clear();
+		active.reserve(capacity);
+		freeSlots.clear();
+		freeSlots.reserve(capacity);
+		for(int i=capacity-1; i>=0; i--)
+			freeSlots.push_back(i);
+	}
+
+	//Activates the lowest free slot and returns it, or -1 if the pool is full
+	int acquire()
+	{
+		if(freeSlots.empty()) return -1;
+		int i = freeSlots.back();
+		freeSlots.pop_back();
+		active.insert(std::lower_bound(active.begin(), active.end(), i), i);
+		items[i].setActive();
+		return i;
+	}
+
+	void release(int i)
+	{
+		vector<int>::iterator it = std::lower_bound(active.begin(), active.end(), i);
+		if(it == active.end() || *it != i) return;
+		active.erase(it);
+		items[i].setInActive();
+		addFree(i);
+	}
+
+	//Takes back the slots of objects that went inactive by themselves
+	void sweep()
+	{
+		unsigned int kept = 0;
+		for(unsigned int k=0; k<active.size(); k++)
+		{
+			if(items[active[k]].getActiveState()) active[kept++] = active[k];
+			else addFree(active[k]);
+		}
+		active.resize(kept);
+	}
+
+	void releaseAll()
+	{
+		while(!active.empty())
+			release(active.back());
+	}
+
+	T& operator[](int i) {return items[i];}
+	int getCapacity() {return items.size();}
+	int getActiveCount() {return active.size();}
+	//The k'th object in use, and the slot it is in
+	T& getActive(int k) {return items[active[k]];}
+	int getActiveSlot(int k) {return active[k];}
+
+private:
+	//Free slots are kept high to low so the lowest is at the back
+	void addFree(int i)
+	{
+		freeSlots.insert(std::lower_bound(freeSlots.begin(), freeSlots.end(), i, std::greater<int>()), i);
+	}
+
+	vector<T> items;
+	vector<int> active;
+	vector<int> freeSlots;
+};
+
+#endif
@@ -0,0 +1,347 @@
+#include "OcclusionCuller.h"
+#include "PerfStats.h"
+#include <algorithm>
+#include <math.h>
+#ifdef FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+//Box's corners are -1 to 1 across and 0 to 2 up; corner c has x from bit 0,
+//y from bit 1 and z from bit 2. Each face is wound the same way seen from
+//outside, so a face's screen winding says whether it faces the eye.
+static const int FACES[6][4] = {
+	{0, 2, 6, 4}, {1, 5, 7, 3},
+	{0, 4, 5, 1}, {2, 3, 7, 6},
+	{0, 1, 3, 2}, {4, 6, 7, 5}
+};
+
+OcclusionCuller::OcclusionCuller()
+{
+	Identity(&viewProj);
+	simd = true;
+	depth.assign(occlusionNS::WIDTH*occlusionNS::HEIGHT, 1.0f);
+	tileDepth.assign(occlusionNS::TILES_X*occlusionNS::TILES_Y, 1.0f);
+	occluders = tested = occluded = 0;
+}
+
+void OcclusionCuller::clear()
+{
+	rects.clear();
+	candidates.clear();
+	nearest.clear();
+	occluders = tested = occluded = 0;
+}
+
+//Corner c's clip position is row 3 of world*viewProj plus rows 0-2 times its
+//model x, y and z, worked out for four corners at a time. The plain loop does
+//the same sums in the same order, so both round alike.
+bool OcclusionCuller::project(const Matrix& world, ScreenBox* box)
+{
+	using namespace occlusionNS;
+	float r[4][4];
+	float c[4][8];
+#ifdef FRUSTUM_SSE
+	if(simd)
+	{
+		__m128 v0 = _mm_loadu_ps(viewProj.m[0]), v1 = _mm_loadu_ps(viewProj.m[1]);
+		__m128 v2 = _mm_loadu_ps(viewProj.m[2]), v3 = _mm_loadu_ps(viewProj.m[3]);
+		for(int i=0; i<4; i++)
+		{
+			__m128 row = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(world.m[i][0]), v0),
+				_mm_mul_ps(_mm_set1_ps(world.m[i][1]), v1)), _mm_mul_ps(_mm_set1_ps(world.m[i][2]), v2)),
+				_mm_mul_ps(_mm_set1_ps(world.m[i][3]), v3));
+			_mm_storeu_ps(r[i], row);
+		}
+		//Corners 0-3 are at model z -1, 4-7 at +1
+		const __m128 lx = _mm_set_ps(1, -1, 1, -1), ly = _mm_set_ps(2, 2, 0, 0);
+		for(int j=0; j<4; j++)
+		{
+			__m128 base = _mm_add_ps(_mm_add_ps(_mm_set1_ps(r[3][j]), _mm_mul_ps(lx, _mm_set1_ps(r[0][j]))), _mm_mul_ps(ly, _mm_set1_ps(r[1][j])));
+			_mm_storeu_ps(&c[j][0], _mm_sub_ps(base, _mm_set1_ps(r[2][j])));
+			_mm_storeu_ps(&c[j][4], _mm_add_ps(base, _mm_set1_ps(r[2][j])));
+		}
+		const __m128 zero = _mm_setzero_ps();
+		__m128 behind = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(&c[2][0]), zero), _mm_cmple_ps(_mm_loadu_ps(&c[3][0]), zero)),
+			_mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(&c[2][4]), zero), _mm_cmple_ps(_mm_loadu_ps(&c[3][4]), zero)));
+		if(_mm_movemask_ps(behind)) return false;
+		const __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f);
+		const __m128 width = _mm_set1_ps((float)WIDTH), height = _mm_set1_ps((float)HEIGHT);
+		for(int g=0; g<8; g+=4)
+		{
+			__m128 inv = _mm_div_ps(one, _mm_loadu_ps(&c[3][g]));
+			_mm_storeu_ps(&box->x[g], _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&c[0][g]), inv), half), half), width));
+			_mm_storeu_ps(&box->y[g], _mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&c[1][g]), inv), half)), height));
+			_mm_storeu_ps(&box->z[g], _mm_mul_ps(_mm_loadu_ps(&c[2][g]), inv));
+		}
+	}
+	else
+#endif
+	{
+		for(int i=0; i<4; i++)
+			for(int j=0; j<4; j++)
+				r[i][j] = world.m[i][0]*viewProj.m[0][j] + world.m[i][1]*viewProj.m[1][j] + world.m[i][2]*viewProj.m[2][j] + world.m[i][3]*viewProj.m[3][j];
+		for(int k=0; k<8; k++)
+		{
+			float lx = (k & 1) ? 1.0f : -1.0f, ly = (k & 2) ? 2.0f : 0.0f;
+			for(int j=0; j<4; j++)
+			{
+				float base = r[3][j] + lx*r[0][j] + ly*r[1][j];
+				c[j][k] = (k & 4) ? base + r[2][j] : base - r[2][j];
+			}
+			if(c[2][k] < 0 || c[3][k] <= 0) return false;
+		}
+		for(int k=0; k<8; k++)
+		{
+			float inv = 1.0f/c[3][k];
+			box->x[k] = (c[0][k]*inv*0.5f + 0.5f)*WIDTH;
+			box->y[k] = (0.5f - c[1][k]*inv*0.5f)*HEIGHT;
+			box->z[k] = c[2][k]*inv;
+		}
+	}
+
+	box->minX = box->maxX = box->x[0];
+	box->minY = box->maxY = box->y[0];
+	box->minZ = box->z[0];
+	for(int k=1; k<8; k++)
+	{
+		box->minX = std::min(box->minX, box->x[k]); box->maxX = std::max(box->maxX, box->x[k]);
+		box->minY = std::min(box->minY, box->y[k]); box->maxY = std::max(box->maxY, box->y[k]);
+		box->minZ = std::min(box->minZ, box->z[k]);
+	}
+	return true;
+}
+
+//Scaling the model box is scaling the matrix's first three rows
+void OcclusionCuller::addMesh(const Matrix& world, float scale)
+{
+	if(scale == 1.0f)
+	{
+		addBox(world, true, true);
+		return;
+	}
+	Matrix scaled = world;
+	for(int i=0; i<3; i++)
+		for(int j=0; j<3; j++)
+			scaled.m[i][j] *= scale;
+	addBox(scaled, true, true);
+}
+
+void OcclusionCuller::addOccluder(const Matrix& world)
+{
+	addBox(world, true, false);
+}
+
+//The Box that fills those bounds, which sits on its base
+void OcclusionCuller::addBounds(const Vector3& centre, const Vector3& halfExtents)
+{
+	Matrix scale, move;
+	D3DXMatrixScaling(&scale, halfExtents.x, halfExtents.y, halfExtents.z);
+	D3DXMatrixTranslation(&move, centre.x, centre.y - halfExtents.y, centre.z);
+	addBox(scale*move, false, true);
+}
+
+void OcclusionCuller::addBox(const Matrix& world, bool occluder, bool tested)
+{
+	using namespace occlusionNS;
+	ScreenBox box;
+	ScreenRect rect;
+	rect.x0 = rect.y0 = 0;
+	rect.x1 = rect.y1 = -1;
+	rect.minZ = 0;
+	if(project(world, &box))
+	{
+		rect.x0 = std::max(0, (int)floor(box.minX));
+		rect.x1 = std::min(WIDTH - 1, (int)floor(box.maxX));
+		rect.y0 = std::max(0, (int)floor(box.minY));
+		rect.y1 = std::min(HEIGHT - 1, (int)floor(box.maxY));
+		rect.minZ = box.minZ;
+
+		float w = std::min(box.maxX, (float)WIDTH) - std::max(box.minX, 0.0f);
+		float h = std::min(box.maxY, (float)HEIGHT) - std::max(box.minY, 0.0f);
+		if(occluder && w > 0 && h > 0 && w*h >= MIN_OCCLUDER_AREA)
+		{
+			nearest.push_back(std::make_pair(box.minZ, (int)candidates.size()));
+			candidates.push_back(box);
+		}
+	}
+	if(tested) rects.push_back(rect);
+}
+
+void OcclusionCuller::rasterize()
+{
+	PROFILE_ZONE("OcclusionCuller::rasterize");
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	int n = std::min((int)nearest.size(), occlusionNS::MAX_OCCLUDERS);
+	std::partial_sort(nearest.begin(), nearest.begin() + n, nearest.end());
+	for(int i=0; i<n; i++)
+		drawBox(candidates[nearest[i].second]);
+	occluders = n;
+	buildTiles();
+}
+
+void OcclusionCuller::drawBox(const ScreenBox& box)
+{
+	for(int f=0; f<6; f++)
+	{
+		const int* q = FACES[f];
+		float area = (box.x[q[1]] - box.x[q[0]])*(box.y[q[2]] - box.y[q[0]]) - (box.x[q[2]] - box.x[q[0]])*(box.y[q[1]] - box.y[q[0]]);
+		//Faces wind clockwise on screen from outside; y runs down, so that's negative here
+		if(area >= 0) continue;
+		drawTriangle(box, q[0], q[2], q[1]);
+		drawTriangle(box, q[0], q[3], q[2]);
+	}
+}
+
+//Edge functions, all positive inside, sampled at pixel centres. Depth only
+//ever comes nearer, and only to the triangle's furthest point.
+void OcclusionCuller::drawTriangle(const ScreenBox& box, int i0, int i1, int i2)
+{
+	using namespace occlusionNS;
+	float vx[3] = {box.x[i0], box.x[i1], box.x[i2]};
+	float vy[3] = {box.y[i0], box.y[i1], box.y[i2]};
+	float z = std::max(box.z[i0], std::max(box.z[i1], box.z[i2]));
+
+	int x0 = std::max(0, (int)floor(std::min(vx[0], std::min(vx[1], vx[2]))));
+	int x1 = std::min(WIDTH - 1, (int)floor(std::max(vx[0], std::max(vx[1], vx[2]))));
+	int y0 = std::max(0, (int)floor(std::min(vy[0], std::min(vy[1], vy[2]))));
+	int y1 = std::min(HEIGHT - 1, (int)floor(std::max(vy[0], std::max(vy[1], vy[2]))));
+	if(x0 > x1 || y0 > y1) return;
+
+	float a[3], b[3], c[3];
+	for(int e=0; e<3; e++)
+	{
+		int next = (e + 1) % 3;
+		a[e] = vy[e] - vy[next];
+		b[e] = vx[next] - vx[e];
+		c[e] = -a[e]*vx[e] - b[e]*vy[e];
+	}
+
+#ifdef FRUSTUM_SSE
+	if(simd)
+	{
+		x0 &= ~3;
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 triZ = _mm_set1_ps(z);
+		const __m128 lanes = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 va0 = _mm_set1_ps(a[0]), va1 = _mm_set1_ps(a[1]), va2 = _mm_set1_ps(a[2]);
+		for(int y=y0; y<=y1; y++)
+		{
+			float py = y + 0.5f;
+			__m128 row0 = _mm_set1_ps(b[0]*py + c[0]);
+			__m128 row1 = _mm_set1_ps(b[1]*py + c[1]);
+			__m128 row2 = _mm_set1_ps(b[2]*py + c[2]);
+			float* row = &depth[y*WIDTH];
+			for(int x=x0; x<=x1; x+=4)
+			{
+				//Not stepped along the row, so it rounds as the plain loop does
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(va0, px), row0);
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(va1, px), row1);
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(va2, px), row2);
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if(_mm_movemask_ps(inside))
+				{
+					__m128 d = _mm_loadu_ps(row + x);
+					__m128 nearer = _mm_min_ps(d, triZ);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, d)));
+				}
+			}
+		}
+		return;
+	}
+#endif
+	for(int y=y0; y<=y1; y++)
+	{
+		float py = y + 0.5f;
+		float row0 = b[0]*py + c[0], row1 = b[1]*py + c[1], row2 = b[2]*py + c[2];
+		float* row = &depth[y*WIDTH];
+		for(int x=x0; x<=x1; x++)
+		{
+			float px = x + 0.5f;
+			if(a[0]*px + row0 >= 0 && a[1]*px + row1 >= 0 && a[2]*px + row2 >= 0)
+				row[x] = std::min(row[x], z);
+		}
+	}
+}
+
+void OcclusionCuller::buildTiles()
+{
+	using namespace occlusionNS;
+	for(int ty=0; ty<TILES_Y; ty++)
+		for(int tx=0; tx<TILES_X; tx++)
+		{
+			const float* row = &depth[ty*TILE*WIDTH + tx*TILE];
+#ifdef FRUSTUM_SSE
+			if(simd)
+			{
+				__m128 far4 = _mm_loadu_ps(row);
+				for(int y=0; y<TILE; y++, row += WIDTH)
+					for(int x=0; x<TILE; x+=4)
+						far4 = _mm_max_ps(far4, _mm_loadu_ps(row + x));
+				float lanes[4];
+				_mm_storeu_ps(lanes, far4);
+				tileDepth[ty*TILES_X + tx] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+				continue;
+			}
+#endif
+			float furthest = row[0];
+			for(int y=0; y<TILE; y++, row += WIDTH)
+				for(int x=0; x<TILE; x++)
+					furthest = std::max(furthest, row[x]);
+			tileDepth[ty*TILES_X + tx] = furthest;
+		}
+}
+
+//True if any pixel in the rectangle is at or behind its depth. A tile whose
+//furthest pixel is nearer hides its part of the rectangle without a look.
+bool OcclusionCuller::testRect(const ScreenRect& r)
+{
+	using namespace occlusionNS;
+	for(int ty=r.y0/TILE; ty<=r.y1/TILE; ty++)
+	{
+		int y0 = std::max(r.y0, ty*TILE), y1 = std::min(r.y1, ty*TILE + TILE - 1);
+		for(int tx=r.x0/TILE; tx<=r.x1/TILE; tx++)
+		{
+			if(tileDepth[ty*TILES_X + tx] < r.minZ) continue;
+			int x0 = std::max(r.x0, tx*TILE), x1 = std::min(r.x1, tx*TILE + TILE - 1);
+#ifdef FRUSTUM_SSE
+			if(simd)
+			{
+				const __m128 boxZ = _mm_set1_ps(r.minZ);
+				const __m128 lo = _mm_set1_ps((float)x0), hi = _mm_set1_ps((float)x1);
+				const __m128 lanes = _mm_set_ps(3, 2, 1, 0);
+				for(int y=y0; y<=y1; y++)
+				{
+					const float* row = &depth[y*WIDTH];
+					for(int x=x0 & ~3; x<=x1; x+=4)
+					{
+						__m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+						__m128 inRect = _mm_and_ps(_mm_cmpge_ps(px, lo), _mm_cmple_ps(px, hi));
+						__m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), boxZ);
+						if(_mm_movemask_ps(_mm_and_ps(inRect, behind))) return true;
+					}
+				}
+				continue;
+			}
+#endif
+			for(int y=y0; y<=y1; y++)
+			{
+				const float* row = &depth[y*WIDTH];
+				for(int x=x0; x<=x1; x++)
+					if(row[x] >= r.minZ) return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool OcclusionCuller::isVisible(int i)
+{
+	tested++;
+	const ScreenRect& r = rects[i];
+	//Off the buffer, or too near to say, so nothing here can call it hidden
+	if(r.x0 > r.x1 || r.y0 > r.y1) return true;
+	if(testRect(r)) return true;
+	occluded++;
+	return false;
+}
@@ -0,0 +1,101 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "constants.h"
+#include "FrustumCuller.h"
+#include <vector>
+using std::vector;
+
+namespace occlusionNS {
+	//The depth buffer occluders are drawn into, a 16:9 shrink of the screen.
+	//WIDTH has to be a multiple of 4 for the SSE loops.
+	const int WIDTH = 256;
+	const int HEIGHT = 144;
+	//Boxes are tested against the furthest depth in each tile of this many
+	//pixels square, not pixel by pixel
+	const int TILE = 8;
+	const int TILES_X = WIDTH/TILE;
+	const int TILES_Y = HEIGHT/TILE;
+	//Only boxes at least this many pixels on screen are worth drawing as
+	//occluders, and only this many of the nearest of those
+	const float MIN_OCCLUDER_AREA = 64.0f;
+	const int MAX_OCCLUDERS = 64;
+}
+
+//Hides boxes behind the big ones near the eye. Each frame the nearest large
+//boxes are drawn, front faces only, into a small depth buffer on the CPU, with
+//each triangle at its furthest vertex's depth so an occluder never claims
+//more than it covers. Then every box is tested by the nearest depth of its
+//screen rectangle: tiles with nothing behind that depth are passed over
+//whole, and the rest looked at pixel by pixel. If no pixel has something
+//behind it, it's hidden.
+//
+//Boxes are Box meshes at their drawn scale as moved by their world matrix, as
+//FrustumCuller takes them, and each is projected once for both jobs, so an
+//occluder is exactly the box that's drawn. Anything crossing the near plane
+//is never an occluder and never hidden.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller();
+
+	void setViewProj(const Matrix& vp) {viewProj = vp;}
+	//Off to check the SSE loops against plain ones
+	void setSimd(bool s) {simd = s;}
+
+	//Forgets the boxes and the last frame's counts
+	void clear();
+	//Every box that may be seen; the big ones are offered as occluders too
+	void addMesh(const Matrix& world, float scale);
+	//A box that only hides others and is never tested itself, with any scale
+	//already in world
+	void addOccluder(const Matrix& world);
+	//Bounds that are only tested, numbered along with addMesh's boxes
+	void addBounds(const Vector3& centre, const Vector3& halfExtents);
+	void rasterize();
+	//Valid after rasterize(); i is the order the box was added in
+	bool isVisible(int i);
+
+	//Row by row, 0 at the near plane to 1 at the far
+	const vector<float>& getDepth() {return depth;}
+	//The furthest depth in each tile, row by row
+	const vector<float>& getTileDepth() {return tileDepth;}
+	int getOccluderCount() {return occluders;}
+	int getTestedCount() {return tested;}
+	int getOccludedCount() {return occluded;}
+
+private:
+	//A box's corners in buffer pixels and depth, and the rectangle around them
+	struct ScreenBox
+	{
+		float x[8], y[8], z[8];
+		float minX, minY, maxX, maxY, minZ;
+	};
+	//What's kept of every box for testing: the pixels it may cover, inclusive.
+	//x0 > x1 for a box that's off the buffer or crosses the near plane.
+	struct ScreenRect
+	{
+		int x0, y0, x1, y1;
+		float minZ;
+	};
+	void addBox(const Matrix& world, bool occluder, bool tested);
+	bool project(const Matrix& world, ScreenBox* box);
+	void drawBox(const ScreenBox& box);
+	void drawTriangle(const ScreenBox& box, int i0, int i1, int i2);
+	void buildTiles();
+	bool testRect(const ScreenRect& r);
+
+	Matrix viewProj;
+	bool simd;
+	vector<float> depth;
+	vector<float> tileDepth;
+	vector<ScreenRect> rects;
+	vector<ScreenBox> candidates;
+	//Nearest depth, then the order offered, so ties sort the same every run
+	vector<std::pair<float, int> > nearest;
+	int occluders;
+	int tested;
+	int occluded;
+};
+
+#endif
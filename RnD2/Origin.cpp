@@ -1,4 +1,5 @@
 #include "Origin.h"
+#include "PerfStats.h"
 
 
 Origin::Origin()
@@ -27,18 +28,21 @@ void Origin::draw()
 	for(UINT p = 0; p < techDesc.Passes; ++p)
 	{
 		mTech->GetPassByIndex( p )->Apply(0);
+		PERF_COUNT(PERF_STATE_CHANGES);
 		baseLine->draw();
 	}
 
 	for(UINT p = 0; p < techDesc.Passes; ++p)
 	{
 		mTech->GetPassByIndex( p )->Apply(0);
+		PERF_COUNT(PERF_STATE_CHANGES);
 		baseLine->draw();
 	}
 
 	for(UINT p = 0; p < techDesc.Passes; ++p)
 	{
 		mTech->GetPassByIndex( p )->Apply(0);
+		PERF_COUNT(PERF_STATE_CHANGES);
 		baseLine->draw();
 	}
 
@@ -2,7 +2,8 @@
 #include "TextureMgr.h"
 #include "InputLayouts.h"
 #include "Effects.h"
-#include "Camera.h"
+#include "Profiler.h"
+#include "PerfStats.h"
 
 namespace
 {
@@ -27,6 +28,7 @@ PSystem::PSystem()
 	mEyePosW  = D3DXVECTOR4(0.0f, 0.0f, 0.0f, 1.0f);
 	mEmitPosW = D3DXVECTOR4(0.0f, 0.0f, 0.0f, 1.0f);
 	mEmitDirW = D3DXVECTOR4(0.0f, 1.0f, 0.0f, 0.0f);
+	D3DXMatrixIdentity(&mViewProj);
 }
 
 PSystem::~PSystem()
@@ -46,6 +48,11 @@ void PSystem::setEyePos(const D3DXVECTOR3& eyePosW)
 	mEyePosW = D3DXVECTOR4(eyePosW.x, eyePosW.y, eyePosW.z, 1.0f);
 }
 
+void PSystem::setViewProj(const D3DXMATRIX& VP)
+{
+	mViewProj = VP;
+}
+
 void PSystem::setEmitPos(const D3DXVECTOR3& emitPosW)
 {
 	mEmitPosW = D3DXVECTOR4(emitPosW.x, emitPosW.y, emitPosW.z, 1.0f);
@@ -57,12 +64,10 @@ void PSystem::setEmitDir(const D3DXVECTOR3& emitDirW)
 }
 
 void PSystem::init(ID3D10Device* device, ID3D10Effect* FX, ID3D10ShaderResourceView* texArrayRV,
-				   UINT maxParticles,  D3DXVECTOR3& pos, Camera* c)
+				   UINT maxParticles,  D3DXVECTOR3& pos)
 {
 	md3dDevice = device;
 
-	camera = c;
-
 	mEmitPosW = D3DXVECTOR4(pos, 1);
 
 	mMaxParticles = maxParticles;
@@ -101,13 +106,11 @@ void PSystem::update(float dt, float gameTime)
 
 void PSystem::draw()
 {
-	D3DXMATRIX V = camera->getViewMatrix();
-	D3DXMATRIX P = camera->getProjectionMatrix();
-
+	PROFILE_ZONE("PSystem::draw");
 	//
 	// Set constants.
 	//
-	mfxViewProjVar->SetMatrix((float*)&(V*P));
+	mfxViewProjVar->SetMatrix((float*)&mViewProj);
 	mfxGameTimeVar->SetFloat(mGameTime);
 	mfxTimeStepVar->SetFloat(mTimeStep);
 	mfxEyePosVar->SetFloatVector((float*)&mEyePosW);
@@ -115,6 +118,7 @@ void PSystem::draw()
 	mfxEmitDirVar->SetFloatVector((float*)&mEmitDirW);
 	mfxTexArrayVar->SetResource(mTexArrayRV);
 	mfxRandomTexVar->SetResource(mRandomTexRV);
+	PERF_COUNT_N(PERF_STATE_CHANGES, 2);
 	//
 	// Set IA stage.
 	//
@@ -142,15 +146,18 @@ void PSystem::draw()
     for(UINT p = 0; p < techDesc.Passes; ++p)
     {
         mStreamOutTech->GetPassByIndex( p )->Apply(0);
+        PERF_COUNT(PERF_STATE_CHANGES);
         
 		if( mFirstRun )
 		{
 			md3dDevice->Draw(1, 0);
+			PERF_COUNT(PERF_DRAW_CALLS);
 			mFirstRun = false;
 		}
 		else
 		{
 			md3dDevice->DrawAuto();
+			PERF_COUNT(PERF_DRAW_CALLS);
 		}
     }
 
@@ -170,8 +177,10 @@ void PSystem::draw()
     for(UINT p = 0; p < techDesc.Passes; ++p)
     {
         mDrawTech->GetPassByIndex( p )->Apply(0);
+        PERF_COUNT(PERF_STATE_CHANGES);
         
 		md3dDevice->DrawAuto();
+		PERF_COUNT(PERF_DRAW_CALLS);
     }
 }
 
@@ -4,7 +4,6 @@
 #include "d3dUtil.h"
 #include <string>
 #include <vector>
-#include "Camera.h"
 
 class PSystem
 {
@@ -17,11 +16,12 @@ public:
 	float getAge()const;
 
 	void setEyePos(const D3DXVECTOR3& eyePosW);
+	void setViewProj(const D3DXMATRIX& VP);
 	void setEmitPos(const D3DXVECTOR3& emitPosW);
 	void setEmitDir(const D3DXVECTOR3& emitDirW);
 
 	void init(ID3D10Device* device, ID3D10Effect* FX, 
-		ID3D10ShaderResourceView* texArrayRV, UINT maxParticles, D3DXVECTOR3& pos, Camera* c);
+		ID3D10ShaderResourceView* texArrayRV, UINT maxParticles, D3DXVECTOR3& pos);
 
 	void reset();
 	void update(float dt, float gameTime);
@@ -34,7 +34,7 @@ private:
 	PSystem& operator=(const PSystem& rhs);
  
 private:
-	Camera* camera;
+	D3DXMATRIX mViewProj;
  
 	UINT mMaxParticles;
 	bool mFirstRun;
@@ -0,0 +1,349 @@
+//=======================================================================================
+// PackMain.cpp
+//
+// rugger_pack [--threads n] [--quality fast|normal|high] [--filter box|kaiser] [--pow2] [--raw]
+//             <out.pak> <image> [image ...] [--fit n image ...]
+//
+// Decodes the game's PNG, JPEG and DDS textures, gives each one that came as a
+// single level its full mip chain, and writes them all into one AssetPack.
+//
+// Mips are filtered with a Kaiser-windowed sinc unless --filter box is given,
+// in linear light for colour maps; spec maps hold numbers, not colours, so
+// they're filtered as they are. Textures with "flare" in the name keep the
+// same share of texels over packNS::ALPHA_REF at every level, so the flares
+// don't fade out as they get smaller. --pow2 resamples images that aren't
+// being fitted to the nearest power of two each way first. The images are
+// shared out over the job system, and each one's rows are too.
+//
+// Unless --raw is given, textures are block-compressed on the way in: opaque
+// ones to BC1, ones with alpha to BC3, and specular maps (a name with "spec"
+// in it) to BC4, which keeps only red; lighting.fx reads the map as .rrra.
+// DDS files that are compressed already stay as they are. A top level that
+// isn't a multiple of 4 each way is first scaled up to one. Each texture's
+// PSNR against what it was compressed from is printed, along with the memory
+// the pack saves over RGBA8.
+//
+// Images after --fit n are scaled to n by n; the renderer makes the ones that
+// come out alike slices of one texture array. --fit 0 stops it again. Only
+// images within packNS::MAX_FIT_RATIO of n each way are fitted, so none is
+// squashed out of shape or loses most of its detail; the rest keep their size.
+//
+// The game maps assets.pak from its working directory at startup and uploads
+// from it; textures that aren't in it are decoded as before. The build makes
+// assets.pak from the textures in RnD2, and it can be copied next to the game.
+//
+// After writing, it maps the pack it wrote and checks every texture against
+// what it decoded, so a pack that comes out of here is known to load.
+//=======================================================================================
+
+#include "AssetPack.h"
+#include "TextureLoader.h"
+#include "MipGenerator.h"
+#include "BlockCompressor.h"
+#include "JobSystem.h"
+#include "GameTimer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <string>
+
+namespace packNS {
+	const char* FORMAT_NAMES[] = {"RGBA8", "BC1", "BC2", "BC3", "BC4"};
+	const char* QUALITY_NAMES[] = {"fast", "normal", "high"};
+	const char* FILTER_NAMES[] = {"box", "kaiser"};
+	//The alpha whose coverage flares keep down their mips
+	const float ALPHA_REF = 0.5f;
+	//Furthest either side of an image may be from --fit n for it to be fitted
+	const int MAX_FIT_RATIO = 2;
+}
+
+using namespace textureDataNS;
+
+static void usage()
+{
+	fprintf(stderr, "usage: rugger_pack [--threads n] [--quality fast|normal|high] [--filter box|kaiser] [--pow2] [--raw]\n"
+		"                   <out.pak> <image> [image ...] [--fit n image ...]\n");
+}
+
+//printf onto the end of a texture's report
+static void report(std::string* out, const char* format, ...)
+{
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	*out += line;
+}
+
+//An option's index in names, or -1
+static int findName(const char* name, const char** names, int count)
+{
+	for(int i=0; i<count; i++)
+		if(!strcmp(name, names[i])) return i;
+	return -1;
+}
+
+static bool isOpaque(const TextureData& t)
+{
+	const unsigned char* texels = t.getMip(0);
+	for(int i=0, n=t.width*t.height; i<n; i++)
+		if(texels[i*4 + 3] != 255) return false;
+	return true;
+}
+
+//Compresses data in place to whichever format suits it, and reports how close
+//it came out. RGBA8 comes in with its mips already made.
+static void compress(const char* file, TextureData* data, blockCompressNS::Quality q, std::string* out)
+{
+	bool spec = strstr(file, "spec") != 0;
+	if(data->isCompressed() && !spec) return;
+
+	TextureData source;
+	if(data->isCompressed()) decompressTexture(*data, &source);
+	else source.texels.swap(data->texels);
+	source.width = data->width;
+	source.height = data->height;
+	source.mipLevels = data->mipLevels;
+	source.format = RGBA8;
+
+	Format format = spec ? BC4 : isOpaque(source) ? BC1 : BC3;
+	TextureData blocks;
+	if(!compressTexture(source, format, q, &blocks))
+	{
+		//Not whole blocks, which only an odd --fit leaves
+		if(!data->isCompressed()) data->texels.swap(source.texels);
+		report(out, "    kept as %s, not a multiple of 4\n", packNS::FORMAT_NAMES[data->format]);
+		return;
+	}
+	TextureData check;
+	decompressTexture(blocks, &check);
+	if(format == BC4) report(out, "    %s, PSNR R %.1f dB\n", packNS::FORMAT_NAMES[format], computePsnr(source, check, 0, 0, 1));
+	else if(format == BC3)
+		report(out, "    %s, PSNR RGB %.1f dB, A %.1f dB\n", packNS::FORMAT_NAMES[format],
+			computePsnr(source, check, 0, 0, 3), computePsnr(source, check, 0, 3, 1));
+	else report(out, "    %s, PSNR RGB %.1f dB\n", packNS::FORMAT_NAMES[format], computePsnr(source, check, 0, 0, 3));
+	data->format = format;
+	data->texels.swap(blocks.texels);
+}
+
+//Everything the jobs need to make each texture ready for the pack
+struct PackJob
+{
+	const vector<const char*>* files;
+	const vector<int>* fits;
+	vector<TextureData>* textures;
+	//What each texture's job printed, printed in order after
+	vector<std::string>* reports;
+	blockCompressNS::Quality quality;
+	mipNS::Filter filter;
+	bool pow2;
+	bool raw;
+};
+
+static bool closeTo(int size, int fit)
+{
+	return size*packNS::MAX_FIT_RATIO >= fit && size <= fit*packNS::MAX_FIT_RATIO;
+}
+
+//Scales, mips and compresses the decoded textures from begin to end
+static void prepareTextures(void* data, int begin, int end)
+{
+	const PackJob& job = *(const PackJob*)data;
+	for(int id=begin; id<end; id++)
+	{
+		const char* file = (*job.files)[id];
+		TextureData& t = (*job.textures)[id];
+		std::string& out = (*job.reports)[id];
+		MipOptions options;
+		options.filter = job.filter;
+		options.srgb = strstr(file, "spec") == 0;
+		options.alphaRef = strstr(file, "flare") != 0 ? packNS::ALPHA_REF : 0;
+
+		int levels = t.mipLevels;
+		int w = t.width, h = t.height;
+		int fit = (*job.fits)[id];
+		if(fit > 0 && !(closeTo(w, fit) && closeTo(h, fit)))
+		{
+			report(&out, "%-24s %dx%d too far from --fit %d, kept\n", file, w, h, fit);
+			fit = 0;
+		}
+		if(fit > 0 && !t.isCompressed())
+			resizeImage(&t, fit, fit, options);
+		else if(job.pow2 && !t.isCompressed())
+			resizeImage(&t, nearestPowerOfTwo(w), nearestPowerOfTwo(h), options);
+		//Blocks need whole 4x4s at the top; the levels below may be smaller
+		if(!job.raw && !t.isCompressed() && (t.width % BLOCK_SIZE || t.height % BLOCK_SIZE))
+			resizeImage(&t, (t.width + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE,
+				(t.height + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE, options);
+		//The mips a flare came with fade it out, so it gets its own
+		if(options.alphaRef > 0 && !t.isCompressed() && t.mipLevels > 1)
+			t.allocate(t.width, t.height, 1, RGBA8);
+		generateMips(&t, options);
+		report(&out, "%-24s %dx%d%s %s, %d mips%s\n", file, t.width, t.height, t.width != w || t.height != h ? " (scaled)" : "",
+			packNS::FORMAT_NAMES[t.format], t.mipLevels, t.mipLevels > levels ? " made" : "");
+		if(!job.raw) compress(file, &t, job.quality, &out);
+	}
+}
+
+//The pack as written, read back through the mapping
+static int verify(const char* path, const vector<const char*>& files, const vector<const TextureData*>& textures)
+{
+	AssetPack pack;
+	if(!pack.open(path))
+	{
+		fprintf(stderr, "could not open %s after writing it\n", path);
+		return (int)files.size();
+	}
+	int failures = 0;
+	for(size_t i=0; i<files.size(); i++)
+	{
+		const PackEntry* e = pack.find(files[i]);
+		TextureData layout;
+		const unsigned char* texels = e ? pack.getTexels(e, &layout) : 0;
+		const TextureData& t = *textures[i];
+		if(!e || layout.width != t.width || layout.height != t.height || layout.mipLevels != t.mipLevels ||
+			layout.format != t.format || e->size != t.texels.size() || memcmp(texels, &t.texels[0], t.texels.size()))
+		{
+			fprintf(stderr, "%s differs in the pack\n", files[i]);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+int main(int argc, char* argv[])
+{
+	int threads = Thread::getCoreCount();
+	blockCompressNS::Quality quality = blockCompressNS::NORMAL;
+	mipNS::Filter filter = mipNS::KAISER;
+	bool pow2 = false;
+	bool raw = false;
+	const char* out = 0;
+	vector<const char*> files;
+	//What each file is scaled to, or 0 to keep its size
+	vector<int> fits;
+	int fit = 0;
+	for(int i=1; i<argc; i++)
+	{
+		if(!strcmp(argv[i], "--threads") && i+1 < argc) threads = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--raw")) raw = true;
+		else if(!strcmp(argv[i], "--pow2")) pow2 = true;
+		else if(!strcmp(argv[i], "--fit") && i+1 < argc) fit = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--quality") && i+1 < argc)
+		{
+			int q = findName(argv[++i], packNS::QUALITY_NAMES, blockCompressNS::NUM_QUALITIES);
+			if(q < 0)
+			{
+				usage();
+				return 1;
+			}
+			quality = (blockCompressNS::Quality)q;
+		}
+		else if(!strcmp(argv[i], "--filter") && i+1 < argc)
+		{
+			int f = findName(argv[++i], packNS::FILTER_NAMES, mipNS::NUM_FILTERS);
+			if(f < 0)
+			{
+				usage();
+				return 1;
+			}
+			filter = (mipNS::Filter)f;
+		}
+		else if(argv[i][0] == '-')
+		{
+			usage();
+			return 1;
+		}
+		else if(!out) out = argv[i];
+		else
+		{
+			files.push_back(argv[i]);
+			fits.push_back(fit);
+		}
+	}
+	if(!out || files.empty())
+	{
+		usage();
+		return 1;
+	}
+
+	GameTimer timer;
+	timer.reset();
+	double start = timer.getRealTime();
+
+	//Everything is decoded first, then the job system's threads take over
+	TextureLoader loader;
+	loader.start(threads);
+	for(size_t i=0; i<files.size(); i++)
+		loader.request((int)i, files[i]);
+	vector<TextureData> textures(files.size());
+	int failures = 0;
+	while(loader.getPending() > 0)
+	{
+		int id;
+		bool ok;
+		TextureData data;
+		if(!loader.takeDone(&id, &data, &ok))
+		{
+			Thread::yield();
+			continue;
+		}
+		if(!ok)
+		{
+			fprintf(stderr, "could not decode %s\n", files[id]);
+			failures++;
+			continue;
+		}
+		textures[id].width = data.width;
+		textures[id].height = data.height;
+		textures[id].mipLevels = data.mipLevels;
+		textures[id].format = data.format;
+		textures[id].texels.swap(data.texels);
+	}
+	loader.stop();
+	if(failures) return 2;
+
+	vector<std::string> reports(files.size());
+	PackJob job;
+	job.files = &files;
+	job.fits = &fits;
+	job.textures = &textures;
+	job.reports = &reports;
+	job.quality = quality;
+	job.filter = filter;
+	job.pow2 = pow2;
+	job.raw = raw;
+	JobSystem::init(threads - 1);
+	JobSystem::parallelFor((int)files.size(), 1, prepareTextures, &job);
+	JobSystem::shutdown();
+	//What the textures would take as RGBA8 with full mips, near enough
+	long long rawBytes = 0;
+	for(size_t i=0; i<files.size(); i++)
+	{
+		fputs(reports[i].c_str(), stdout);
+		rawBytes += (long long)textures[i].width*textures[i].height*4*4/3;
+	}
+
+	vector<const TextureData*> pointers(textures.size());
+	for(size_t i=0; i<textures.size(); i++)
+		pointers[i] = &textures[i];
+	if(!AssetPack::write(out, files, pointers))
+	{
+		fprintf(stderr, "could not write %s (or two images have the same name)\n", out);
+		return 2;
+	}
+	double elapsed = timer.getRealTime() - start;
+
+	failures = verify(out, files, pointers);
+	long long bytes = 0;
+	for(size_t i=0; i<textures.size(); i++)
+		bytes += textures[i].texels.size();
+	printf("packed:         %d textures, %.1f MB to %s in %.1f ms\n", (int)files.size(), bytes / (1024.0*1024.0), out, elapsed*1000.0);
+	printf("texture memory: %.1f MB against %.1f MB as RGBA8 (%.2fx smaller)\n", bytes / (1024.0*1024.0),
+		rawBytes / (1024.0*1024.0), (double)rawBytes / bytes);
+	if(failures == 0) printf("pack checks:    all match\n");
+	else printf("pack checks:    %d differ\n", failures);
+	return failures ? 3 : 0;
+}
@@ -0,0 +1,158 @@
+#include "PackedVertex.h"
+#include <math.h>
+#include <string.h>
+
+using namespace packedVertexNS;
+
+unsigned short floatToHalf(float f)
+{
+	unsigned int x;
+	memcpy(&x, &f, sizeof(x));
+	unsigned int sign = (x >> 16) & 0x8000;
+	unsigned int bits = x & 0x7fffffff;
+
+	//Infinity stays infinity and NaN stays a NaN
+	if(bits >= 0x7f800000) return (unsigned short)(sign | 0x7c00 | (bits > 0x7f800000 ? 0x200 : 0));
+	//65520 and up round past the largest half
+	if(bits >= 0x477ff000) return (unsigned short)(sign | 0x7c00);
+	//Under 2^-14 is a denormal half, or zero under half the smallest one
+	if(bits < 0x38800000)
+	{
+		if(bits <= 0x33000000) return (unsigned short)sign;
+		unsigned int exponent = bits >> 23;
+		unsigned int mantissa = (bits & 0x7fffff) | 0x800000;
+		unsigned int shift = 126 - exponent;
+		unsigned int h = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if(rest > halfway || (rest == halfway && (h & 1))) h++;
+		return (unsigned short)(sign | h);
+	}
+	//Rebias the exponent from 127 to 15 and drop 13 bits of mantissa; a carry
+	//out of the mantissa moves the exponent up, which is the right answer
+	unsigned int h = (bits - 0x38000000) >> 13;
+	unsigned int rest = bits & 0x1fff;
+	if(rest > 0x1000 || (rest == 0x1000 && (h & 1))) h++;
+	return (unsigned short)(sign | h);
+}
+
+float halfToFloat(unsigned short h)
+{
+	unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+	unsigned int exponent = (h >> 10) & 0x1f;
+	unsigned int mantissa = h & 0x3ff;
+	if(exponent == 0)
+	{
+		float f = (float)mantissa / 16777216.0f;
+		return sign ? -f : f;
+	}
+	unsigned int x;
+	if(exponent == 31) x = sign | 0x7f800000 | (mantissa << 13);
+	else x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	float f;
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+unsigned char floatToUnorm8(float f)
+{
+	if(!(f > 0.0f)) return 0;
+	if(f >= 1.0f) return 255;
+	return (unsigned char)(f*UNORM8_SCALE + 0.5f);
+}
+
+static float snorm16(short s)
+{
+	float f = s * (1.0f / SNORM16_SCALE);
+	return f < -1.0f ? -1.0f : f;
+}
+
+static short toSnorm16(int i)
+{
+	if(i > 32767) i = 32767;
+	if(i < -32767) i = -32767;
+	return (short)i;
+}
+
+static float signNotZero(float f)
+{
+	return f >= 0.0f ? 1.0f : -1.0f;
+}
+
+//Before normalizing
+static D3DXVECTOR3 unfoldNormal(const short in[2])
+{
+	D3DXVECTOR3 n(snorm16(in[0]), snorm16(in[1]), 0);
+	n.z = 1.0f - fabs(n.x) - fabs(n.y);
+	//The lower half was folded over the diagonals; unfold it
+	float t = n.z < 0 ? -n.z : 0.0f;
+	n.x += n.x >= 0 ? -t : t;
+	n.y += n.y >= 0 ? -t : t;
+	return n;
+}
+
+D3DXVECTOR3 unpackNormal(const short in[2])
+{
+	D3DXVECTOR3 n = unfoldNormal(in);
+	D3DXVec3Normalize(&n, &n);
+	return n;
+}
+
+void packNormal(const D3DXVECTOR3& n, short out[2])
+{
+	float l1 = fabs(n.x) + fabs(n.y) + fabs(n.z);
+	if(!(l1 > 0.0f))
+	{
+		out[0] = out[1] = 0;
+		return;
+	}
+	float x = n.x / l1;
+	float y = n.y / l1;
+	if(n.z < 0)
+	{
+		float fx = (1.0f - fabs(y)) * signNotZero(x);
+		float fy = (1.0f - fabs(x)) * signNotZero(y);
+		x = fx;
+		y = fy;
+	}
+
+	//Closest is the largest cosine; its square, signed, over the candidate's
+	//squared length orders them the same without a square root
+	int bx = (int)floor(x*SNORM16_SCALE), by = (int)floor(y*SNORM16_SCALE);
+	float best = -1e30f;
+	for(int i=0; i<4; i++)
+	{
+		short candidate[2] = {toSnorm16(bx + (i & 1)), toSnorm16(by + (i >> 1))};
+		D3DXVECTOR3 d = unfoldNormal(candidate);
+		float dot = d.x*n.x + d.y*n.y + d.z*n.z;
+		float score = dot*fabs(dot) / (d.x*d.x + d.y*d.y + d.z*d.z);
+		if(score > best)
+		{
+			best = score;
+			out[0] = candidate[0];
+			out[1] = candidate[1];
+		}
+	}
+}
+
+void packVertex(const D3DXVECTOR3& pos, const D3DXVECTOR3& normal, const float color[4], float u, float v, PackedVertex* out)
+{
+	out->pos[0] = pos.x;
+	out->pos[1] = pos.y;
+	out->pos[2] = pos.z;
+	packNormal(normal, out->normal);
+	for(int i=0; i<4; i++)
+		out->color[i] = floatToUnorm8(color[i]);
+	out->texc[0] = floatToHalf(u);
+	out->texc[1] = floatToHalf(v);
+}
+
+void unpackVertex(const PackedVertex& in, D3DXVECTOR3* pos, D3DXVECTOR3* normal, float color[4], float* u, float* v)
+{
+	*pos = D3DXVECTOR3(in.pos[0], in.pos[1], in.pos[2]);
+	*normal = unpackNormal(in.normal);
+	for(int i=0; i<4; i++)
+		color[i] = in.color[i] / UNORM8_SCALE;
+	*u = halfToFloat(in.texc[0]);
+	*v = halfToFloat(in.texc[1]);
+}
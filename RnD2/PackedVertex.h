@@ -0,0 +1,38 @@
+#ifndef PACKED_VERTEX_H
+#define PACKED_VERTEX_H
+
+#include "SimMath.h"
+
+namespace packedVertexNS {
+	//SNORM16 as D3D reads it: -32767 to 32767 over -1 to 1
+	const float SNORM16_SCALE = 32767.0f;
+	const float UNORM8_SCALE = 255.0f;
+}
+
+//What lighting.fx reads per vertex, 24 bytes where Vertex is 64:
+//  pos      R32G32B32_FLOAT
+//  normal   R16G16_SNORM, the unit normal folded onto an octahedron
+//  color    R8G8B8A8_UNORM, diffuse and specular alike, as every mesh has had them
+//  texc     R16G16_FLOAT
+struct PackedVertex
+{
+	float pos[3];
+	short normal[2];
+	unsigned char color[4];
+	unsigned short texc[2];
+};
+
+//Round to nearest even, as the GPU does; too big for a half goes to infinity
+unsigned short floatToHalf(float f);
+float halfToFloat(unsigned short h);
+unsigned char floatToUnorm8(float f);
+//Of the four nearest SNORM16 pairs, the one that decodes closest to n. A zero
+//normal comes back as +z.
+void packNormal(const D3DXVECTOR3& n, short out[2]);
+//As the shader's octDecode does it
+D3DXVECTOR3 unpackNormal(const short in[2]);
+
+void packVertex(const D3DXVECTOR3& pos, const D3DXVECTOR3& normal, const float color[4], float u, float v, PackedVertex* out);
+void unpackVertex(const PackedVertex& in, D3DXVECTOR3* pos, D3DXVECTOR3* normal, float color[4], float* u, float* v);
+
+#endif
@@ -0,0 +1,77 @@
+//=======================================================================================
+// PerfAllocations.cpp
+//
+// Counts the game's heap allocations for the performance overlay. This replaces
+// the global operator new, so it's only built into the game itself; the
+// simulation library, the headless runner and the benchmarks keep the
+// standard one.
+//=======================================================================================
+
+#include "PerfStats.h"
+#include <cstdlib>
+#include <new>
+
+#ifndef RUGGER_NO_PROFILE
+static void* countedAlloc(size_t size)
+{
+	PERF_COUNT(PERF_ALLOCATIONS);
+	return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+	void* p = countedAlloc(size);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	void* p = countedAlloc(size);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	return countedAlloc(size);
+}
+
+void operator delete(void* p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+	free(p);
+}
+
+//Compilers that have sized deallocation call these instead of the ones above
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, size_t) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) throw()
+{
+	free(p);
+}
+#endif
+#endif
@@ -0,0 +1,72 @@
+#include "PerfStats.h"
+
+static const char* TIMER_NAMES[NUM_PERF_TIMERS] = {"update", "collision", "AI", "pickups", "draw"};
+static const char* COUNTER_NAMES[NUM_PERF_COUNTERS] = {"draw calls", "state changes", "allocations", "visible", "culled", "occluded", "buffer binds"};
+
+volatile long PerfStats::enabled = 0;
+volatile long long PerfStats::frameCounts[NUM_PERF_TIMERS];
+float PerfStats::history[NUM_PERF_TIMERS][perfStatsNS::HISTORY];
+int PerfStats::historyFrames = 0;
+int PerfStats::historyNext = 0;
+volatile long PerfStats::frameTotals[NUM_PERF_COUNTERS];
+int PerfStats::lastTotals[NUM_PERF_COUNTERS];
+double PerfStats::msPerCount = 0.0;
+
+void PerfStats::setEnabled(bool e)
+{
+	if(e && !isEnabled())
+	{
+		//Pays for the profiler's clock calibration now rather than mid-frame
+		msPerCount = Profiler::getSecondsPerCount() * 1000.0;
+		historyFrames = 0;
+		historyNext = 0;
+		for(int i=0; i<NUM_PERF_TIMERS; i++) atomicExchange64(&frameCounts[i], 0);
+		for(int i=0; i<NUM_PERF_COUNTERS; i++)
+		{
+			atomicExchange(&frameTotals[i], 0);
+			lastTotals[i] = 0;
+		}
+	}
+	atomicStore(&enabled, e ? 1 : 0);
+}
+
+void PerfStats::endFrame()
+{
+	if(!isEnabled()) return;
+
+	//Taken and zeroed at once, so counts added meanwhile go to the next frame
+	for(int i=0; i<NUM_PERF_TIMERS; i++)
+		history[i][historyNext] = (float)(atomicExchange64(&frameCounts[i], 0) * msPerCount);
+	historyNext = (historyNext + 1) % perfStatsNS::HISTORY;
+	if(historyFrames < perfStatsNS::HISTORY) historyFrames++;
+
+	for(int i=0; i<NUM_PERF_COUNTERS; i++)
+		lastTotals[i] = atomicExchange(&frameTotals[i], 0);
+}
+
+float PerfStats::getAverageMs(PerfTimerId timer)
+{
+	if(historyFrames == 0) return 0.0f;
+	float total = 0.0f;
+	for(int i=0; i<historyFrames; i++)
+		total += history[timer][i];
+	return total / historyFrames;
+}
+
+float PerfStats::getMaxMs(PerfTimerId timer)
+{
+	float most = 0.0f;
+	for(int i=0; i<historyFrames; i++)
+		if(history[timer][i] > most) most = history[timer][i];
+	return most;
+}
+
+const char* PerfStats::getTimerName(PerfTimerId timer)
+{
+	return TIMER_NAMES[timer];
+}
+
+const char* PerfStats::getCounterName(PerfCounterId counter)
+{
+	return COUNTER_NAMES[counter];
+}
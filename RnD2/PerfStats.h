@@ -0,0 +1,84 @@
+//=======================================================================================
+// PerfStats.h
+//
+// Per-frame timings and counters for the in-game performance overlay. Everything
+// is skipped unless the overlay turned stats on, so hidden they cost a branch.
+//
+//	PERF_TIMER(PERF_AI);				//time this scope
+//	PERF_COUNT(PERF_DRAW_CALLS);		//one more this frame
+//
+// The game calls PerfStats::endFrame once a frame; timers report the average and
+// max over the last perfStatsNS::HISTORY frames, counters the last whole frame.
+// Timers and counters may be bumped from any thread, the simulation's and the
+// job system's included; they're atomic, and endFrame takes each one's total
+// and zeroes it in the same step, so nothing is lost between frames.
+// RUGGER_NO_PROFILE compiles all of it out, like the profiler zones.
+//=======================================================================================
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include "Profiler.h"
+#include "Threading.h"
+
+namespace perfStatsNS {
+	const int HISTORY = 120;
+}
+
+enum PerfTimerId {PERF_UPDATE, PERF_COLLISION, PERF_AI, PERF_PICKUPS, PERF_DRAW, NUM_PERF_TIMERS};
+enum PerfCounterId {PERF_DRAW_CALLS, PERF_STATE_CHANGES, PERF_ALLOCATIONS, PERF_VISIBLE, PERF_CULLED, PERF_OCCLUDED, PERF_BUFFER_BINDS, NUM_PERF_COUNTERS};
+
+class PerfStats
+{
+public:
+	static bool isEnabled() {return atomicLoad(&enabled) != 0;}
+	//Turning stats off also forgets the history
+	static void setEnabled(bool e);
+
+	static void addTime(PerfTimerId timer, long long counts) {atomicAdd64(&frameCounts[timer], counts);}
+	static void count(PerfCounterId counter, int n = 1) {if(isEnabled()) atomicAdd(&frameTotals[counter], n);}
+	static void endFrame();
+
+	static float getAverageMs(PerfTimerId timer);
+	static float getMaxMs(PerfTimerId timer);
+	static int getCount(PerfCounterId counter) {return lastTotals[counter];}
+
+	static const char* getTimerName(PerfTimerId timer);
+	static const char* getCounterName(PerfCounterId counter);
+
+private:
+	static volatile long enabled;
+	static volatile long long frameCounts[NUM_PERF_TIMERS];
+	static float history[NUM_PERF_TIMERS][perfStatsNS::HISTORY];
+	static int historyFrames;
+	static int historyNext;
+	static volatile long frameTotals[NUM_PERF_COUNTERS];
+	static int lastTotals[NUM_PERF_COUNTERS];
+	static double msPerCount;
+};
+
+class PerfTimer
+{
+public:
+	PerfTimer(PerfTimerId t) : timer(t), start(PerfStats::isEnabled() ? Profiler::now() : 0) {}
+	~PerfTimer()
+	{
+		if(start) PerfStats::addTime(timer, Profiler::now() - start);
+	}
+
+private:
+	PerfTimerId timer;
+	long long start;
+};
+
+#ifdef RUGGER_NO_PROFILE
+#define PERF_TIMER(timer)
+#define PERF_COUNT(counter)
+#define PERF_COUNT_N(counter, n)
+#else
+#define PERF_TIMER(timer) PerfTimer PROFILE_ZONE_JOIN(perfTimer, __LINE__)(timer)
+#define PERF_COUNT(counter) PerfStats::count(counter)
+#define PERF_COUNT_N(counter, n) PerfStats::count(counter, n)
+#endif
+
+#endif
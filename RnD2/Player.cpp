@@ -1,4 +1,5 @@
 #include "Player.h"
+#include "SimRandom.h"
 
 
 Player::Player(void) : GameObject()
@@ -6,16 +7,19 @@ Player::Player(void) : GameObject()
 	health = 1000;
 	ammo = 50;
 	speed = 20;
+	gun = 0;
 }
 
 
 Player::~Player(void)
 {
+	delete gun;
 	box = 0;
 }
 
-void Player::init(Box* bulletBox, vector<Bullet*>* bullets, Box* b, float r, Vector3 pos, Vector3 vel, float sp, Audio* a, float s, float w, float d, float h)
+void Player::init(Box* bulletBox, vector<Bullet*>* bullets, Box* b, float r, Vector3 pos, Vector3 vel, float sp, SimAudio* a, float s, float w, float d, float h)
 { 
+	delete gun;
 	gun = new Pistol(bulletBox, bullets);
 	audio = a;
 	box = b;
@@ -34,27 +38,18 @@ void Player::init(Box* bulletBox, vector<Bullet*>* bullets, Box* b, float r, Vec
 	fired = false;
 	health = 100;
 	currentGun = 1;
+	gunType = 1;
 }
 
-void Player::draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP)
+void Player::draw(SimRenderer* renderer)
 {
 	if (!active)
 		return;
-	Matrix mWVP = world* (*mVP);
-	mfxWVPVar->SetMatrix((float*)&mWVP);
-	mfxWorldVar->SetMatrix((float*)&world);
-    D3D10_TECHNIQUE_DESC techDesc;
-    mTech->GetDesc( &techDesc );
-	D3DXMatrixScaling(&mScale, width, height, depth);
-    for(UINT p = 0; p < techDesc.Passes; ++p)
-    {
-        mTech->GetPassByIndex( p )->Apply(0);
-		gun->draw(mfxWVPVar, mTech, mVP);
-    }
+	gun->draw(renderer);
 }
 
 void Player::grunt() {
-	int num = rand()%7;
+	int num = SimRandom::next()%7;
 
 	switch (num) {
 	case(0):
@@ -93,14 +88,17 @@ void Player::update(float dt, D3DXVECTOR3 axis, Box* bulletBox, vector<Bullet*>*
 	D3DXMatrixTranslation(&mTranslate, position.x, position.y, position.z);
 	D3DXMatrixMultiply(&world, &mScale, &mTranslate);
 
-	if(currentGun == 1){
-		setGun(new Pistol(bulletBox, bullets));
-	}else if(currentGun == 2){
-		setGun(new Shotgun(bulletBox, bullets));
-	}else if (currentGun == 3){
-		setGun(new MachineGun(bulletBox, bullets));
-	}else {
-		setGun(new MachineGun(bulletBox, bullets));
+	//Only build a new gun when the pickup changed it, not every frame
+	if(currentGun != gunType){
+		delete gun;
+		gunType = currentGun;
+		if(currentGun == 1){
+			setGun(new Pistol(bulletBox, bullets));
+		}else if(currentGun == 2){
+			setGun(new Shotgun(bulletBox, bullets));
+		}else {
+			setGun(new MachineGun(bulletBox, bullets));
+		}
 	}
 		
 	gun->update(dt);
@@ -1,8 +1,8 @@
 #pragma once
-#include "gameobject.h"
+#include "GameObject.h"
 #include "Bullet.h"
 #include<vector>
-#include "Audio.h"
+#include "SimAudio.h"
 #include "constants.h"
 #include "Gun.h"
 
@@ -14,8 +14,8 @@ public:
 	~Player(void);
 
 	//Player takes a pointer to a bullet which will be handled completely by the player class: update, drawing, and all
-	void init(Box* bulletBox, vector<Bullet*>* bullets, Box* b, float r, Vector3 pos, Vector3 vel, float sp, Audio* a, float s = 1, float w = 1, float d = 1, float h = 1);
-	void draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP);
+	void init(Box* bulletBox, vector<Bullet*>* bullets, Box* b, float r, Vector3 pos, Vector3 vel, float sp, SimAudio* a, float s = 1, float w = 1, float d = 1, float h = 1);
+	void draw(SimRenderer* renderer);
 	void update(float dt, D3DXVECTOR3 moveAxis, Box* bulletBox, vector<Bullet*>* bullets);
 
 	void shoot(D3DXVECTOR3 moveAxis);
@@ -47,7 +47,8 @@ public:
 private:
 	float radius;
 	double timeSinceLastShot;
+	int gunType; //what gun currently holds, so it's only rebuilt on a change
 	
-	Audio* audio;
+	SimAudio* audio;
 };
 
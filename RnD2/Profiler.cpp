@@ -0,0 +1,152 @@
+#include "Profiler.h"
+#include "GameTimer.h"
+#include "Threading.h"
+#include <cstdio>
+#include <vector>
+using std::vector;
+
+#ifdef _WIN32
+#define PROFILER_WRITE_BARRIER() _WriteBarrier()
+#else
+#define PROFILER_WRITE_BARRIER() __asm__ __volatile__("" ::: "memory")
+#endif
+
+//One thread's zones. Only the owning thread writes; head is bumped after the
+//event is complete so a reader never sees a half-written newest entry.
+struct ProfileRing
+{
+	ProfileEvent events[profilerNS::RING_SIZE];
+	volatile unsigned int head;
+	volatile unsigned int cleared;
+	int threadId;
+};
+
+bool Profiler::enabled = true;
+
+static THREAD_LOCAL ProfileRing* threadRing = 0;
+
+//Registry of every thread's ring, only touched when a thread records its first
+//zone and when exporting
+static Mutex ringMutex;
+static void lockRings() {ringMutex.lock();}
+static void unlockRings() {ringMutex.unlock();}
+
+static vector<ProfileRing*>& allRings()
+{
+	static vector<ProfileRing*> rings;
+	return rings;
+}
+
+static ProfileRing* registerThread()
+{
+	ProfileRing* ring = new ProfileRing;
+	ring->head = 0;
+	ring->cleared = 0;
+	lockRings();
+	ring->threadId = allRings().size() + 1;
+	allRings().push_back(ring);
+	unlockRings();
+	return ring;
+}
+
+#ifdef PROFILER_USE_TSC
+//Pairs a TSC reading with a GameTimer one, to work out the TSC rate from two of them
+struct ClockSample
+{
+	long long count;
+	double seconds;
+
+	ClockSample(const GameTimer& timer) : count(Profiler::now()), seconds(timer.getRealTime()) {}
+};
+
+static GameTimer calibrationTimer;
+static ClockSample calibrationStart(calibrationTimer);
+#endif
+
+double Profiler::getSecondsPerCount()
+{
+#if defined(PROFILER_USE_TSC)
+	//Wait out a short interval so the rate is good to a fraction of a percent
+	ClockSample end(calibrationTimer);
+	while(end.seconds - calibrationStart.seconds < profilerNS::MIN_CALIBRATION_TIME)
+		end = ClockSample(calibrationTimer);
+	return (end.seconds - calibrationStart.seconds) / (double)(end.count - calibrationStart.count);
+#elif defined(_WIN32)
+	LARGE_INTEGER countsPerSec;
+	QueryPerformanceFrequency(&countsPerSec);
+	return 1.0 / (double)countsPerSec.QuadPart;
+#else
+	return 1.0e-9;
+#endif
+}
+
+void Profiler::record(const char* name, long long start, long long end)
+{
+	ProfileRing* ring = threadRing;
+	if(!ring) ring = threadRing = registerThread();
+
+	unsigned int h = ring->head;
+	ProfileEvent& e = ring->events[h & (profilerNS::RING_SIZE-1)];
+	e.name = name;
+	e.start = start;
+	e.end = end;
+	PROFILER_WRITE_BARRIER();
+	ring->head = h + 1;
+}
+
+void Profiler::clear()
+{
+	lockRings();
+	for(unsigned int i=0; i<allRings().size(); i++)
+		allRings()[i]->cleared = allRings()[i]->head;
+	unlockRings();
+}
+
+//Writes a complete ("X") event per zone, timestamps in microseconds from the
+//earliest zone recorded
+bool Profiler::writeChromeTrace(const char* filename)
+{
+	FILE* f = fopen(filename, "w");
+	if(!f) return false;
+
+	lockRings();
+	vector<ProfileRing*> rings = allRings();
+	unlockRings();
+
+	//Oldest zone still held in each ring
+	vector<unsigned int> first(rings.size()), last(rings.size());
+	long long origin = 0;
+	bool haveOrigin = false;
+	for(unsigned int r=0; r<rings.size(); r++)
+	{
+		last[r] = rings[r]->head;
+		unsigned int held = last[r] - rings[r]->cleared;
+		if(held > profilerNS::RING_SIZE) held = profilerNS::RING_SIZE;
+		first[r] = last[r] - held;
+		if(held > 0)
+		{
+			long long t = rings[r]->events[first[r] & (profilerNS::RING_SIZE-1)].start;
+			if(!haveOrigin || t < origin) origin = t;
+			haveOrigin = true;
+		}
+	}
+
+	double usPerCount = getSecondsPerCount() * 1.0e6;
+	fprintf(f, "{\"traceEvents\":[\n");
+	bool firstEvent = true;
+	for(unsigned int r=0; r<rings.size(); r++)
+	{
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+			firstEvent ? "" : ",\n", rings[r]->threadId, rings[r]->threadId);
+		firstEvent = false;
+		for(unsigned int i=first[r]; i!=last[r]; i++)
+		{
+			const ProfileEvent& e = rings[r]->events[i & (profilerNS::RING_SIZE-1)];
+			fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				e.name, rings[r]->threadId, (e.start - origin)*usPerCount, (e.end - e.start)*usPerCount);
+		}
+	}
+	fprintf(f, "\n]}\n");
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,108 @@
+//=======================================================================================
+// Profiler.h
+//
+// Scoped CPU timing zones:
+//
+//	void World::updateEnemies(float dt)
+//	{
+//		PROFILE_ZONE("updateEnemies");
+//		...
+//
+// Each thread records into its own ring buffer with no locking; the newest
+// profilerNS::RING_SIZE zones per thread are kept. Profiler::writeChromeTrace
+// dumps them as Chrome about:tracing / Perfetto JSON. Zone names must be string
+// literals (or otherwise outlive the profiler).
+//
+// Define RUGGER_NO_PROFILE to compile every zone out.
+//=======================================================================================
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+//The CPU timestamp counter where there is one (a few ns to read, against tens
+//for QueryPerformanceCounter/clock_gettime), otherwise the OS clock
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#define PROFILER_USE_TSC
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define PROFILER_USE_TSC
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace profilerNS {
+	//Zones kept per thread. Must be a power of two.
+	const unsigned int RING_SIZE = 1 << 16;
+	const char DEFAULT_TRACE_FILE[] = "profile.json";
+	//Seconds of TSC ticks to measure against the OS clock before trusting the rate
+	const double MIN_CALIBRATION_TIME = 0.01;
+}
+
+struct ProfileEvent
+{
+	const char* name;
+	long long start;
+	long long end;
+};
+
+class Profiler
+{
+public:
+	//Raw counter ticks; see getSecondsPerCount
+	static long long now()
+	{
+#if defined(PROFILER_USE_TSC)
+		return (long long)__rdtsc();
+#elif defined(_WIN32)
+		LARGE_INTEGER count;
+		QueryPerformanceCounter(&count);
+		return count.QuadPart;
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (long long)ts.tv_sec*1000000000LL + ts.tv_nsec;
+#endif
+	}
+	//Measured against the OS clock when counting in TSC ticks
+	static double getSecondsPerCount();
+
+	static bool isEnabled() {return enabled;}
+	static void setEnabled(bool e) {enabled = e;}
+
+	static void record(const char* name, long long start, long long end);
+	//Forgets everything recorded so far on every thread
+	static void clear();
+	//Safe to call while other threads record; zones they overwrite
+	//mid-export may come out garbled
+	static bool writeChromeTrace(const char* filename = profilerNS::DEFAULT_TRACE_FILE);
+
+private:
+	static bool enabled;
+};
+
+class ProfileZone
+{
+public:
+	ProfileZone(const char* n) : name(n), start(Profiler::isEnabled() ? Profiler::now() : 0) {}
+	~ProfileZone()
+	{
+		if(start) Profiler::record(name, start, Profiler::now());
+	}
+
+private:
+	const char* name;
+	long long start;
+};
+
+#ifdef RUGGER_NO_PROFILE
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE_JOIN2(a, b) a##b
+#define PROFILE_ZONE_JOIN(a, b) PROFILE_ZONE_JOIN2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_JOIN(profileZone, __LINE__)(name)
+#endif
+
+#endif
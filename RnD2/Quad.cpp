@@ -2,6 +2,7 @@
 #include "Quad.h"
 #include "Vertex.h"
 #include "constants.h"
+#include "PerfStats.h"
 
 Quad::Quad()
 : mNumVertices(0), mNumFaces(0), md3dDevice(0), mVB(0), mIB(0)
@@ -37,18 +38,21 @@ void Quad::init(ID3D10Device* device, float scale, D3DXCOLOR c)
 	// Scale the Quad.
 	for(DWORD i = 0; i < mNumVertices; ++i)
 		vertices[i].pos *= scale;
+	PackedVertex packed[4];
+	for(DWORD i = 0; i < mNumVertices; ++i)
+		packed[i] = vertices[i].pack();
     D3D10_BUFFER_DESC vbd;
     vbd.Usage = D3D10_USAGE_IMMUTABLE;
-    vbd.ByteWidth = sizeof(Vertex) * mNumVertices;
+    vbd.ByteWidth = sizeof(PackedVertex) * mNumVertices;
     vbd.BindFlags = D3D10_BIND_VERTEX_BUFFER;
     vbd.CPUAccessFlags = 0;
     vbd.MiscFlags = 0;
     D3D10_SUBRESOURCE_DATA vinitData;
-    vinitData.pSysMem = vertices;
+    vinitData.pSysMem = packed;
     HR(md3dDevice->CreateBuffer(&vbd, &vinitData, &mVB));
 
 	//Index buffer
-	DWORD indices[] = {
+	unsigned short indices[] = {
 		// front face
 		0, 1, 3,
 		0, 2, 1
@@ -57,7 +61,7 @@ void Quad::init(ID3D10Device* device, float scale, D3DXCOLOR c)
 
 	D3D10_BUFFER_DESC ibd;
     ibd.Usage = D3D10_USAGE_IMMUTABLE;
-    ibd.ByteWidth = sizeof(DWORD) * mNumFaces*3;
+    ibd.ByteWidth = sizeof(unsigned short) * mNumFaces*3;
     ibd.BindFlags = D3D10_BIND_INDEX_BUFFER;
     ibd.CPUAccessFlags = 0;
     ibd.MiscFlags = 0;
@@ -78,10 +82,11 @@ void Quad::update(float dt)
 
 void Quad::draw()
 {
-UINT stride = sizeof(Vertex);
+UINT stride = sizeof(PackedVertex);
     UINT offset = 0;
 	md3dDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
     md3dDevice->IASetVertexBuffers(0, 1, &mVB, &stride, &offset);
-	md3dDevice->IASetIndexBuffer(mIB, DXGI_FORMAT_R32_UINT, 0);
+	md3dDevice->IASetIndexBuffer(mIB, DXGI_FORMAT_R16_UINT, 0);
 	md3dDevice->DrawIndexed(mNumFaces*3, 0, 0);
+	PERF_COUNT(PERF_DRAW_CALLS);
 }
\ No newline at end of file
@@ -0,0 +1,479 @@
+//=======================================================================================
+// RenderChecks.cpp
+//
+// The fixed scenes rugger_headless --batches checks the renderer's CPU-side parts
+// with. None of it needs a world, a GPU or a particular config.
+//=======================================================================================
+
+#include "RenderChecks.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "MaterialTable.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "StaticBatcher.h"
+#include "FrameSnapshot.h"
+#include <cstdio>
+#include <cmath>
+
+//How many cases a check has tried and how many came out wrong
+struct CheckTally
+{
+	int cases;
+	int failures;
+	CheckTally() : cases(0), failures(0) {}
+};
+
+static void expect(CheckTally* tally, bool ok, const char* what)
+{
+	tally->cases++;
+	if(ok) return;
+	tally->failures++;
+	printf("  differs:      %s\n", what);
+}
+
+//Stand-ins for meshes. Nothing here looks inside a Box, only at which one it is.
+static char meshTags[4];
+
+static Box* tagMesh(int i)
+{
+	return (Box*)&meshTags[i];
+}
+
+static Matrix placed(float x, float y, float z)
+{
+	Matrix m;
+	Translate(&m, x, y, z);
+	return m;
+}
+
+static Matrix sized(float x, float y, float z, const Matrix& at)
+{
+	Matrix scale;
+	Scale(&scale, x, y, z);
+	return scale*at;
+}
+
+static TextureData layoutOf(int size, int mipLevels, textureDataNS::Format format)
+{
+	TextureData layout;
+	layout.width = layout.height = size;
+	layout.mipLevels = mipLevels;
+	layout.format = format;
+	return layout;
+}
+
+//The third mesh is drawn twice the size, like the game's enemies and player
+class TaggedSizes : public MeshSizes
+{
+public:
+	virtual float getScale(Box* mesh) const {return mesh == tagMesh(2) ? 2.0f : 1.0f;}
+};
+
+//Looking down +z from the origin with a 90 degree view, so the side planes
+//are x = z, -x = z, y = z and -y = z, and the near and far ones z = 1 and 100
+static Matrix rightAngleView()
+{
+	Matrix proj;
+	D3DXMatrixPerspectiveFovLH(&proj, 3.14159265f/2, 1.0f, 1.0f, 100.0f);
+	return proj;
+}
+
+static bool report(const char* what, const CheckTally& tally)
+{
+	if(tally.failures == 0) printf("%-16sall %d match\n", what, tally.cases);
+	else printf("%-16s%d of %d differ\n", what, tally.failures, tally.cases);
+	return tally.failures == 0;
+}
+
+//Keys laid out field by field, and seven draws that sort opaque before
+//blended, by material, then mesh, then nearest first (furthest first once
+//blended), with the two identical ones left in the order they came
+bool checkRenderQueue()
+{
+	CheckTally tally;
+	//Pass 1 << 54, technique 1 << 52, material 3 + 1 << 44, mesh 5 << 32, and
+	//2.0f's bits 0x40000000 turned over for blending
+	expect(&tally, RenderQueue::makeKey(RENDER_BLENDED, TECH_INSTANCED, 3, 5, 2.0f) == 0x00504005bfffffffull, "key layout");
+	expect(&tally, RenderQueue::makeKey(RENDER_OPAQUE, TECH_LIT, -1, 0, -3.0f) == 0, "unbound material and depth behind the eye");
+	expect(&tally, RenderQueue::makeKey(RENDER_OPAQUE, TECH_LIT, 1000, renderQueueNS::MAX_MESHES + 7, 0.0f) == 0x000ff00700000000ull,
+		"material and mesh out of range");
+
+	static const struct {RenderPass pass; int material, mesh; float depth;} DRAWS[] = {
+		{RENDER_OPAQUE, 2, 0, 30}, {RENDER_BLENDED, 1, 0, 10}, {RENDER_OPAQUE, 1, 1, 20}, {RENDER_OPAQUE, 2, 0, 5},
+		{RENDER_BLENDED, 1, 0, 40}, {RENDER_OPAQUE, 1, 1, 20}, {RENDER_OPAQUE, -1, 0, 50}};
+	static const int SORTED[] = {6, 2, 5, 3, 0, 4, 1};
+	const int count = sizeof(SORTED)/sizeof(SORTED[0]);
+	RenderQueue queue;
+	for(int i=0; i<count; i++)
+		queue.submit(RenderQueue::makeKey(DRAWS[i].pass, TECH_LIT, DRAWS[i].material, DRAWS[i].mesh, DRAWS[i].depth));
+	queue.sort();
+	bool ordered = queue.getCount() == count;
+	for(int i=0; ordered && i<count; i++)
+		ordered = queue.getIndex(i) == SORTED[i];
+	expect(&tally, ordered, "sorted order");
+	expect(&tally, queue.countSortedChanges(renderQueueNS::STATE_MASK) == 3, "state changes sorted");
+	expect(&tally, queue.countSubmittedChanges(renderQueueNS::STATE_MASK) == 6, "state changes as submitted");
+	//Every byte but the top one differs somewhere
+	expect(&tally, queue.getRadixPasses() == 7, "radix passes");
+
+	//One key, or all the same, needs no passes
+	queue.clear();
+	for(int i=0; i<4; i++)
+		queue.submit(RenderQueue::makeKey(RENDER_OPAQUE, TECH_LIT, 1, 1, 20));
+	queue.sort();
+	expect(&tally, queue.getRadixPasses() == 0 && queue.getIndex(0) == 0 && queue.getIndex(3) == 3, "equal keys");
+	return report("render queue:", tally);
+}
+
+//Six draws of two meshes in four materials, with brick and barrel slices of
+//one array and the enemy's map an array of its own. Batches are one per mesh
+//in a bind group, nearest the eye first; without the table, one per mesh and
+//material.
+bool checkInstanceBatcher()
+{
+	CheckTally tally;
+	MaterialTable table;
+	table.setLayout(MATERIAL_BRICK, layoutOf(1024, 11, textureDataNS::BC1), 0);
+	table.setLayout(MATERIAL_BARREL, layoutOf(1024, 11, textureDataNS::BC1), 0);
+	table.setLayout(MATERIAL_ENEMY, layoutOf(32, 6, textureDataNS::BC1), 0);
+	table.build();
+
+	static const struct {int material, mesh; float depth; bool glow;} DRAWS[] = {
+		{MATERIAL_BRICK, 0, 30, false}, {MATERIAL_BRICK, 0, 10, true}, {MATERIAL_BARREL, 0, 20, false},
+		{MATERIAL_ENEMY, 1, 5, false}, {MATERIAL_BRICK, 1, 15, false}, {MATERIAL_STREET, 0, 1, false}};
+	const int count = sizeof(DRAWS)/sizeof(DRAWS[0]);
+	//Batch by batch: mesh, first instance's material, first, count
+	static const int GROUPED[][4] = {{0, MATERIAL_BRICK, 0, 3}, {1, MATERIAL_BRICK, 3, 1}, {1, MATERIAL_ENEMY, 4, 1}, {0, MATERIAL_STREET, 5, 1}};
+	//Instance by instance: draw, slice
+	static const int GROUPED_INSTANCES[][2] = {{1, 0}, {2, 1}, {0, 0}, {4, 0}, {3, 0}, {5, materialNS::NO_SLICE}};
+	static const int ALONE[][4] = {{0, MATERIAL_BRICK, 0, 2}, {1, MATERIAL_BRICK, 2, 1}, {1, MATERIAL_ENEMY, 3, 1},
+		{0, MATERIAL_STREET, 4, 1}, {0, MATERIAL_BARREL, 5, 1}};
+	static const int ALONE_INSTANCES[][2] = {{1, -1}, {0, -1}, {4, -1}, {3, -1}, {5, -1}, {2, -1}};
+
+	InstanceBatcher batcher;
+	for(int pass=0; pass<2; pass++)
+	{
+		bool grouped = pass == 0;
+		const int (*expected)[4] = grouped ? GROUPED : ALONE;
+		const int (*expectedInstances)[2] = grouped ? GROUPED_INSTANCES : ALONE_INSTANCES;
+		int batches = grouped ? 4 : 5;
+		batcher.setMaterialTable(grouped ? &table : 0);
+		batcher.clear();
+		for(int i=0; i<count; i++)
+		{
+			batcher.setMaterial(DRAWS[i].material);
+			batcher.drawMesh(tagMesh(DRAWS[i].mesh), placed((float)i, 0, DRAWS[i].depth), DRAWS[i].glow);
+		}
+		batcher.build();
+
+		bool ok = batcher.getDrawCount() == count && batcher.getBatchCount() == batches;
+		for(int b=0; ok && b<batches; b++)
+		{
+			const InstanceBatch& batch = batcher.getBatch(b);
+			ok = batch.mesh == tagMesh(expected[b][0]) && batch.material == expected[b][1] && batch.first == expected[b][2]
+				&& batch.count == expected[b][3];
+		}
+		expect(&tally, ok, grouped ? "batches by bind group" : "batches by material");
+
+		const vector<InstanceData>& instances = batcher.getInstances();
+		ok = (int)instances.size() == count;
+		for(int i=0; ok && i<count; i++)
+		{
+			//Each draw was placed at x = its number
+			int d = expectedInstances[i][0];
+			const InstanceData& instance = instances[i];
+			ok = instance.world._41 == (float)d && instance.world._43 == DRAWS[d].depth && instance.slice == (float)expectedInstances[i][1]
+				&& instance.glow == (DRAWS[d].glow ? 1.0f : 0.0f) && instance.glowColor.x == (DRAWS[d].glow ? 1.0f : 0.0f);
+		}
+		expect(&tally, ok, grouped ? "instances by bind group" : "instances by material");
+		expect(&tally, batcher.getStateChanges() == (grouped ? 2 : 3) && batcher.getDrawnStateChanges() == (grouped ? 3 : 4),
+			grouped ? "bind group changes" : "material changes");
+	}
+	return report("instances:", tally);
+}
+
+//Ten boxes in and around a right-angled view: in the middle, behind, past
+//the far plane, across the right side, just past it, above, across the far
+//plane, one scaled by its matrix across the right side, one below and a
+//mesh drawn twice the size across the right side. Only boxes wholly outside
+//a plane go, and the SSE loop gives what the plain one does. A snapshot's
+//draws are culled at the size their mesh is drawn.
+bool checkFrustumCuller()
+{
+	CheckTally tally;
+	FrustumCuller culler;
+	culler.setViewProj(rightAngleView());
+	const float* right = culler.getPlane(frustumNS::RIGHT_PLANE);
+	expect(&tally, fabs(right[0] + sqrt(0.5f)) < 1e-5f && fabs(right[1]) < 1e-5f && fabs(right[2] - sqrt(0.5f)) < 1e-5f
+		&& fabs(right[3]) < 1e-5f, "right plane");
+
+	culler.clear();
+	culler.addMesh(placed(0, 0, 10), 1);
+	culler.addMesh(placed(0, 0, -10), 1);
+	culler.addMesh(placed(0, 0, 200), 1);
+	//1 across either side of x = 11.5, where the side is at x = 11 at its far end
+	culler.addMesh(placed(11.5f, 0, 10), 1);
+	culler.addMesh(placed(13, 0, 10), 1);
+	culler.add(Vector3(0, 50, 20), Vector3(1, 1, 1));
+	culler.addMesh(placed(0, 0, 99.5f), 1);
+	//3 across either side of x = 13, where the side is at x = 13 at its far end
+	culler.addMesh(sized(3, 3, 3, placed(13, 0, 10)), 1);
+	culler.addMesh(placed(0, -50, 10), 1);
+	//2 either side of x = 13.5 and 8 to 12 away; unscaled it would be past the side
+	culler.addMesh(placed(13.5f, 0, 10), 2);
+	static const int VISIBLE[] = {0, 3, 6, 7, 9};
+	vector<int> expected(VISIBLE, VISIBLE + sizeof(VISIBLE)/sizeof(VISIBLE[0]));
+
+	culler.cull();
+	expect(&tally, culler.getVisible() == expected && culler.getCount() == 10 && culler.getCulledCount() == 5, "culled");
+	culler.cullScalar();
+	expect(&tally, culler.getVisible() == expected, "culled one at a time");
+
+	FrameSnapshot snapshot;
+	snapshot.proj = rightAngleView();
+	snapshot.drawMesh(tagMesh(2), placed(13.5f, 0, 10), false);
+	snapshot.drawMesh(tagMesh(0), placed(13.5f, 0, 10), false);
+	TaggedSizes sizes;
+	snapshot.cull(&culler, &sizes);
+	expect(&tally, culler.getVisibleCount() == 1 && culler.getVisible()[0] == 0, "snapshot culled at mesh size");
+	return report("frustum:", tally);
+}
+
+//Which of a scene's boxes come out visible, and from how many occluders, the
+//same from the SSE loops and the plain ones
+static void expectOcclusion(CheckTally* tally, OcclusionCuller* occlusion, const bool* visible, int count, int occluders,
+	const char* what)
+{
+	vector<float> depth;
+	for(int simd=0; simd<2; simd++)
+	{
+		occlusion->setSimd(simd != 0);
+		occlusion->rasterize();
+		bool ok = occlusion->getOccluderCount() == occluders;
+		for(int i=0; i<count; i++)
+			ok = ok && occlusion->isVisible(i) == visible[i];
+		if(simd) ok = ok && occlusion->getDepth() == depth;
+		depth = occlusion->getDepth();
+		expect(tally, ok, what);
+	}
+}
+
+//A wall across the middle of a right-angled view with a box behind it, one
+//in front, one to the side hidden by a wall that only occludes and bounds
+//behind the first wall. Then boxes that mustn't hide anything: one too small
+//to be an occluder and a wall through the near plane. Then meshes drawn
+//bigger and smaller than their matrices say, which have to be hidden and
+//hide things at the size they're drawn.
+bool checkOcclusionCuller()
+{
+	CheckTally tally;
+	OcclusionCuller occlusion;
+	occlusion.setViewProj(rightAngleView());
+
+	occlusion.clear();
+	//20 across and up, 19 to 21 away
+	occlusion.addMesh(sized(10, 10, 1, placed(0, -10, 20)), 1);
+	occlusion.addMesh(placed(0, 0, 40), 1);
+	occlusion.addOccluder(sized(5, 5, 1, placed(22.5f, -5, 30)));
+	occlusion.addMesh(placed(30, 0, 40), 1);
+	//Big enough on screen to be an occluder too
+	occlusion.addMesh(placed(0, 0, 10), 1);
+	occlusion.addBounds(Vector3(0, 1, 60), Vector3(1, 1, 1));
+	static const bool WALLED[] = {true, false, false, true, false};
+	expectOcclusion(&tally, &occlusion, WALLED, 5, 3, "behind walls");
+
+	occlusion.clear();
+	occlusion.addMesh(placed(0, 0, 40), 1);
+	occlusion.addMesh(placed(0, 0, 80), 1);
+	occlusion.addMesh(sized(10, 10, 2, placed(0, -10, 0)), 1);
+	occlusion.addMesh(placed(0, 0, 90), 1);
+	static const bool OPEN[] = {true, true, true, true};
+	expectOcclusion(&tally, &occlusion, OPEN, 4, 0, "nothing big in front");
+
+	//A far wall with a twice-size mesh whose top shows over it, and a
+	//quarter-size mesh that would hide the box behind it at full size
+	occlusion.clear();
+	occlusion.addMesh(sized(10, 10, 1, placed(0, -10, 40)), 1);
+	occlusion.addMesh(placed(0, 12.2f, 60), 2);
+	occlusion.addMesh(sized(8, 8, 1, placed(0, -8, 20)), 0.25f);
+	occlusion.addMesh(placed(0, 0, 30), 1);
+	static const bool SCALED[] = {true, true, true, true};
+	expectOcclusion(&tally, &occlusion, SCALED, 4, 2, "meshes at their drawn size");
+
+	//The same through a snapshot, with the twice-size mesh drawn as one
+	FrameSnapshot snapshot;
+	snapshot.proj = rightAngleView();
+	snapshot.drawMesh(tagMesh(0), sized(10, 10, 1, placed(0, -10, 40)), false);
+	snapshot.drawMesh(tagMesh(2), placed(0, 12.2f, 60), false);
+	vector<int> visible;
+	for(int i=0; i<2; i++)
+		visible.push_back(i);
+	TaggedSizes sizes;
+	snapshot.occlude(&occlusion, &sizes, &visible);
+	expect(&tally, visible.size() == 2, "snapshot occluded at mesh size");
+	return report("occlusion:", tally);
+}
+
+//Six boxes of two meshes in two materials, across three chunks, one big
+//enough to occlude. With moved, the one in chunk 1 is somewhere else.
+static void drawStatics(StaticBatcher* statics, bool moved)
+{
+	statics->clear();
+	statics->setMaterial(MATERIAL_BRICK);
+	statics->drawMesh(tagMesh(0), placed(0, 0, 0), false);
+	statics->setMaterial(MATERIAL_BARREL);
+	statics->drawMesh(tagMesh(0), placed(10, 0, 0), false);
+	statics->setMaterial(MATERIAL_BRICK);
+	statics->drawMesh(tagMesh(0), placed(moved ? 700.0f : 600.0f, 0, 0), false);
+	statics->drawMesh(tagMesh(1), placed(20, 0, 0), false);
+	statics->drawMesh(tagMesh(0), sized(10, 10, 1, placed(-30, 0, 5)), false);
+	statics->drawMesh(tagMesh(0), placed(0, 0, -600), false);
+	statics->build();
+}
+
+//The pieces cut by material, mesh and chunk, their bounds, vertices and
+//indices, which are culled from a view of the big box and which boxes
+//occlude, and that moving one box changes only its own piece's hash. Then a
+//mesh drawn at twice the size, which has to be built at that size.
+bool checkStaticBatcher()
+{
+	CheckTally tally;
+	StaticBatcher statics;
+	drawStatics(&statics, false);
+	//Piece by piece: chunk x and z, mesh, material, count
+	static const int PIECES[][5] = {{0, -1, 0, MATERIAL_BRICK, 1}, {0, 0, 0, MATERIAL_BRICK, 2}, {1, 0, 0, MATERIAL_BRICK, 1},
+		{0, 0, 1, MATERIAL_BRICK, 1}, {0, 0, 0, MATERIAL_BARREL, 1}};
+	const int count = sizeof(PIECES)/sizeof(PIECES[0]);
+	bool ok = statics.getPieceCount() == count && statics.getBoxCount() == 6;
+	for(int i=0, first=0; ok && i<count; first += PIECES[i][4], i++)
+	{
+		const StaticPiece& p = statics.getPiece(i);
+		ok = p.chunkX == PIECES[i][0] && p.chunkZ == PIECES[i][1] && p.mesh == tagMesh(PIECES[i][2]) && p.material == PIECES[i][3]
+			&& p.first == first && p.count == PIECES[i][4];
+	}
+	expect(&tally, ok, "pieces");
+	//The box at the origin and the big one, -40 to 1 across, 0 to 20 up and -1 to 6 deep
+	const StaticPiece& shared = statics.getPiece(1);
+	expect(&tally, ok && shared.centre == Vector3(-19.5f, 10, 2.5f) && shared.halfExtents == Vector3(20.5f, 10, 3.5f)
+		&& statics.getWorld(1, 1)._11 == 10 && statics.getWorld(1, 1)._41 == -30, "bounds");
+
+	PackedVertex vertices[2*staticBatchNS::BOX_VERTICES];
+	statics.fillVertices(1, vertices);
+	Vector3 pos, normal;
+	float color[4], u, v;
+	//Each box starts on its front face's lower left corner, facing -z
+	unpackVertex(vertices[0], &pos, &normal, color, &u, &v);
+	ok = pos == Vector3(-1, 0, -1) && normal == Vector3(0, 0, -1);
+	unpackVertex(vertices[staticBatchNS::BOX_VERTICES], &pos, &normal, color, &u, &v);
+	ok = ok && pos == Vector3(-40, 0, 4) && normal == Vector3(0, 0, -1);
+	//Up the big box's left edge: its top face's first corner
+	unpackVertex(vertices[staticBatchNS::BOX_VERTICES + 16], &pos, &normal, color, &u, &v);
+	ok = ok && pos == Vector3(-40, 20, 4) && normal == Vector3(0, 1, 0);
+	expect(&tally, ok, "vertices");
+	unsigned short indices[2*staticBatchNS::BOX_INDICES];
+	StaticBatcher::fillIndices(2, indices);
+	expect(&tally, indices[0] == 0 && indices[4] == 2 && indices[5] == 0 && indices[2*staticBatchNS::BOX_INDICES - 1] == 44,
+		"indices");
+
+	//From 20 in front of the big box, which fills the middle of the view
+	Matrix view;
+	Translate(&view, 30, -10, 20);
+	Matrix vp = view*rightAngleView();
+	FrustumCuller culler;
+	statics.cull(&culler, vp);
+	expect(&tally, culler.getVisibleCount() == 1 && culler.getVisible()[0] == 1, "culled pieces");
+	OcclusionCuller occlusion;
+	occlusion.setViewProj(vp);
+	occlusion.clear();
+	vector<int> all;
+	for(int i=0; i<count; i++)
+		all.push_back(i);
+	statics.addOccluders(&occlusion, all);
+	occlusion.rasterize();
+	expect(&tally, occlusion.getOccluderCount() == 1, "occluders");
+
+	unsigned long long hashes[count];
+	for(int i=0; i<count; i++)
+		hashes[i] = statics.getPiece(i).hash;
+	drawStatics(&statics, true);
+	ok = statics.getPieceCount() == count;
+	for(int i=0; ok && i<count; i++)
+		ok = (statics.getPiece(i).hash == hashes[i]) == (i != 2);
+	expect(&tally, ok, "hashes after a box moved");
+
+	//A twice-size mesh goes in at that size: 6 either side, 12 up, 2 deep,
+	//which makes it an occluder
+	TaggedSizes sizes;
+	statics.setMeshSizes(&sizes);
+	statics.clear();
+	statics.setMaterial(MATERIAL_BRICK);
+	statics.drawMesh(tagMesh(2), sized(3, 3, 1, placed(0, 0, 20)), false);
+	statics.build();
+	statics.fillVertices(0, vertices);
+	unpackVertex(vertices[0], &pos, &normal, color, &u, &v);
+	const StaticPiece& big = statics.getPiece(0);
+	expect(&tally, big.centre == Vector3(0, 6, 20) && big.halfExtents == Vector3(6, 6, 2) && pos == Vector3(-6, 0, 18),
+		"mesh scale in bounds and vertices");
+	occlusion.setViewProj(rightAngleView());
+	occlusion.clear();
+	statics.addOccluders(&occlusion, vector<int>(1, 0));
+	occlusion.rasterize();
+	expect(&tally, occlusion.getOccluderCount() == 1, "mesh scale in occluders");
+	return report("statics:", tally);
+}
+
+//Seven maps in five layouts, counting a different specular map, which share
+//out into arrays in material order; the four without a map come after as
+//groups of their own
+bool checkMaterialTable()
+{
+	using namespace textureDataNS;
+	CheckTally tally;
+	MaterialTable table;
+	table.setLayout(MATERIAL_BRICK, layoutOf(1024, 11, BC1), 0);
+	table.setLayout(MATERIAL_BUILDING, layoutOf(1024, 11, BC1), 0);
+	table.setLayout(MATERIAL_BUILDING2, layoutOf(1024, 11, BC1), 1);
+	table.setLayout(MATERIAL_ENEMY, layoutOf(32, 6, BC1), 0);
+	table.setLayout(MATERIAL_BULLET, layoutOf(1024, 10, BC1), 0);
+	table.setLayout(MATERIAL_RED, layoutOf(32, 6, RGBA8), 0);
+	table.setLayout(MATERIAL_BLUE, layoutOf(32, 6, BC1), 0);
+	bool ok = true;
+	for(int i=0; i<NUM_MATERIALS; i++)
+		ok = ok && table.getGroup(i) == i && table.getSlice(i) == materialNS::NO_SLICE;
+	expect(&tally, ok, "groups before build");
+
+	table.build();
+	//Material by material: group, slice
+	static const int GROUPS[NUM_MATERIALS][2] = {{0, 0}, {0, 1}, {1, 0}, {2, 0}, {5, -1}, {6, -1}, {3, 0}, {7, -1}, {4, 0}, {2, 1}, {8, -1}};
+	ok = table.getGroupCount() == 9 && table.getArrayCount() == 5;
+	for(int i=0; ok && i<NUM_MATERIALS; i++)
+		ok = table.getGroup(i) == GROUPS[i][0] && table.getSlice(i) == GROUPS[i][1];
+	expect(&tally, ok, "groups and slices");
+	ok = table.getArrayCount() == 5 && table.getArrayMaterials(2).size() == 2 && table.getArrayMaterials(2)[0] == MATERIAL_ENEMY
+		&& table.getArrayMaterials(2)[1] == MATERIAL_BLUE;
+	expect(&tally, ok, "array slices");
+	expect(&tally, table.getGroup(-1) == -1 && table.getSlice(-1) == materialNS::NO_SLICE, "unbound material");
+
+	table.clear();
+	table.build();
+	ok = table.getArrayCount() == 0 && table.getGroupCount() == NUM_MATERIALS;
+	for(int i=0; i<NUM_MATERIALS; i++)
+		ok = ok && table.getGroup(i) == i;
+	expect(&tally, ok, "nothing known");
+	return report("materials:", tally);
+}
+
+bool checkRendering()
+{
+	int failures = 0;
+	failures += !checkRenderQueue();
+	failures += !checkInstanceBatcher();
+	failures += !checkFrustumCuller();
+	failures += !checkOcclusionCuller();
+	failures += !checkStaticBatcher();
+	failures += !checkMaterialTable();
+	if(failures == 0) printf("render checks:  all match\n");
+	else printf("render checks:  %d differ\n", failures);
+	return failures == 0;
+}
@@ -0,0 +1,17 @@
+#ifndef RENDER_CHECKS_H
+#define RENDER_CHECKS_H
+
+//What rugger_headless --batches runs: each of the renderer's CPU-side parts
+//given a small scene made up for it, whose answers are known, and checked
+//against them. Each prints a line and returns whether it all matched.
+bool checkRenderQueue();
+bool checkInstanceBatcher();
+bool checkFrustumCuller();
+bool checkOcclusionCuller();
+bool checkStaticBatcher();
+bool checkMaterialTable();
+
+//Every check above, then a line saying whether they all matched
+bool checkRendering();
+
+#endif
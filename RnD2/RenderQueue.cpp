@@ -0,0 +1,89 @@
+#include "RenderQueue.h"
+#include "Profiler.h"
+#include <string.h>
+
+RenderKey RenderQueue::makeKey(RenderPass pass, RenderTechnique technique, int material, int mesh, float depth)
+{
+	using namespace renderQueueNS;
+	//A non-negative float's bits sort the same as its value. Anything behind the
+	//eye is culled anyway, so it can all count as zero.
+	if(!(depth > 0)) depth = 0;
+	unsigned int bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	if(pass == RENDER_BLENDED) bits = ~bits;
+
+	//-1 goes to 0, so the material field never borrows into the technique
+	if(material < -1 || material >= MAX_MATERIALS) material = MAX_MATERIALS - 1;
+	return ((RenderKey)pass << PASS_SHIFT)
+		| ((RenderKey)technique << TECHNIQUE_SHIFT)
+		| ((RenderKey)(material + 1) << MATERIAL_SHIFT)
+		| ((RenderKey)(mesh & (MAX_MESHES - 1)) << MESH_SHIFT)
+		| ((RenderKey)bits << DEPTH_SHIFT);
+}
+
+//A byte at a time, least significant first, so each pass keeps the last one's
+//order. All eight histograms are counted in one read of the keys, and a byte
+//every key has the same value in (the unused top one, the pass for an all
+//opaque frame) costs nothing.
+void RenderQueue::sort()
+{
+	PROFILE_ZONE("RenderQueue::sort");
+	int n = keys.size();
+	order.resize(n);
+	scratch.resize(n);
+	for(int i=0; i<n; i++)
+		order[i] = i;
+	radixPasses = 0;
+	if(n < 2) return;
+
+	memset(counts, 0, sizeof(counts));
+	for(int i=0; i<n; i++)
+	{
+		RenderKey k = keys[i];
+		for(int b=0; b<8; b++)
+			counts[b][(k >> (b*8)) & 0xff]++;
+	}
+
+	for(int b=0; b<8; b++)
+	{
+		int* count = counts[b];
+		if(count[(keys[0] >> (b*8)) & 0xff] == n) continue;
+
+		int start = 0;
+		for(int v=0; v<256; v++)
+		{
+			int c = count[v];
+			count[v] = start;
+			start += c;
+		}
+		for(int i=0; i<n; i++)
+		{
+			int index = order[i];
+			scratch[count[(keys[index] >> (b*8)) & 0xff]++] = index;
+		}
+		order.swap(scratch);
+		radixPasses++;
+	}
+}
+
+int RenderQueue::countSortedChanges(RenderKey mask)
+{
+	int changes = 0;
+	for(unsigned int i=1; i<order.size(); i++)
+	{
+		if((keys[order[i]] & mask) != (keys[order[i-1]] & mask))
+			changes++;
+	}
+	return changes;
+}
+
+int RenderQueue::countSubmittedChanges(RenderKey mask)
+{
+	int changes = 0;
+	for(unsigned int i=1; i<keys.size(); i++)
+	{
+		if((keys[i] & mask) != (keys[i-1] & mask))
+			changes++;
+	}
+	return changes;
+}
@@ -0,0 +1,67 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <vector>
+using std::vector;
+
+typedef unsigned long long RenderKey;
+
+//Sort key layout, low bit first. Everything above DEPTH is state, so draws that
+//share it sit together once sorted and only a change in it costs anything.
+namespace renderQueueNS {
+	const int DEPTH_SHIFT = 0;
+	const int MESH_SHIFT = 32;
+	const int MATERIAL_SHIFT = 44;
+	const int TECHNIQUE_SHIFT = 52;
+	const int PASS_SHIFT = 54;
+
+	const int MAX_MESHES = 1 << 12;
+	const int MAX_MATERIALS = (1 << 8) - 1;
+
+	//What a change in costs: textures and shaders, but not the mesh, which is
+	//just the next draw call
+	const RenderKey STATE_MASK = ~0ull << MATERIAL_SHIFT;
+	//What has to match to share one instanced draw
+	const RenderKey BATCH_MASK = ~0ull << MESH_SHIFT;
+}
+
+//Opaque draws go first, nearest first, so the depth test throws away what's
+//behind them; blended ones after, furthest first, so they blend in order
+enum RenderPass {RENDER_OPAQUE, RENDER_BLENDED};
+enum RenderTechnique {TECH_LIT, TECH_INSTANCED};
+
+//Keys submitted over a frame, sorted once with an LSD radix sort. Each key
+//carries the index it was submitted at, so the caller sorts its own draws by it.
+class RenderQueue
+{
+public:
+	RenderQueue() {radixPasses = 0;}
+
+	//material -1 is "whatever is bound"; depth is view space, so larger is further
+	static RenderKey makeKey(RenderPass pass, RenderTechnique technique, int material, int mesh, float depth);
+
+	void clear() {keys.clear();}
+	void submit(RenderKey key) {keys.push_back(key);}
+	int getCount() {return keys.size();}
+	//Sorts, stable in submission order for equal keys
+	void sort();
+	//Valid after sort(): which submission is i'th, and its key
+	int getIndex(int i) {return order[i];}
+	RenderKey getSortedKey(int i) {return keys[order[i]];}
+
+	//How often the masked bits change between neighbours, sorted or as submitted
+	int countSortedChanges(RenderKey mask);
+	int countSubmittedChanges(RenderKey mask);
+	//Byte passes the last sort() needed; ones every key agrees on are skipped
+	int getRadixPasses() {return radixPasses;}
+
+private:
+	vector<RenderKey> keys;
+	vector<int> order;
+	vector<int> scratch;
+	//One histogram per byte of the key
+	int counts[8][256];
+	int radixPasses;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "Replay.h"
+#include <cstring>
+
+//Fields are written one at a time, little-endian as x86 lays them out, so the
+//file doesn't depend on struct padding
+static bool writeFrame(FILE* f, const ReplayFrame& r)
+{
+	return fwrite(&r.dt, sizeof(r.dt), 1, f) == 1 &&
+		fwrite(&r.keysDown, sizeof(r.keysDown), 1, f) == 1 &&
+		fwrite(&r.keysPressed, sizeof(r.keysPressed), 1, f) == 1 &&
+		fwrite(&r.mouseX, sizeof(r.mouseX), 1, f) == 1 &&
+		fwrite(&r.mouseY, sizeof(r.mouseY), 1, f) == 1 &&
+		fwrite(&r.enemyCostMs, sizeof(r.enemyCostMs), 1, f) == 1 &&
+		fwrite(&r.stateHash, sizeof(r.stateHash), 1, f) == 1;
+}
+
+static bool readFrame(FILE* f, ReplayFrame& r)
+{
+	return fread(&r.dt, sizeof(r.dt), 1, f) == 1 &&
+		fread(&r.keysDown, sizeof(r.keysDown), 1, f) == 1 &&
+		fread(&r.keysPressed, sizeof(r.keysPressed), 1, f) == 1 &&
+		fread(&r.mouseX, sizeof(r.mouseX), 1, f) == 1 &&
+		fread(&r.mouseY, sizeof(r.mouseY), 1, f) == 1 &&
+		fread(&r.enemyCostMs, sizeof(r.enemyCostMs), 1, f) == 1 &&
+		fread(&r.stateHash, sizeof(r.stateHash), 1, f) == 1;
+}
+
+static int keyIndex(UCHAR vkey)
+{
+	for(int i=0; i<simInputNS::NUM_KEYS; i++)
+		if(simInputNS::KEYS[i] == vkey) return i;
+	return -1;
+}
+
+static short clampShort(int v)
+{
+	if(v > 32767) return 32767;
+	if(v < -32768) return -32768;
+	return (short)v;
+}
+
+ReplayInput::ReplayInput()
+{
+	live = 0;
+	deferred = false;
+	releasedKeys = clearedKeys = 0;
+	memset(&captured, 0, sizeof(captured));
+	current = captured;
+}
+
+void ReplayInput::capture(SimInput* liveInput)
+{
+	live = liveInput;
+	memset(&captured, 0, sizeof(captured));
+	for(int i=0; i<simInputNS::NUM_KEYS; i++)
+	{
+		if(live->isKeyDown(simInputNS::KEYS[i])) captured.keysDown |= 1 << i;
+		if(live->wasKeyPressed(simInputNS::KEYS[i])) captured.keysPressed |= 1 << i;
+	}
+	captured.mouseX = clampShort(live->getMouseRawX());
+	captured.mouseY = clampShort(live->getMouseRawY());
+	current = captured;
+}
+
+void ReplayInput::nextStep()
+{
+	//Starts from what the last step left, so keys it released stay released
+	current.keysPressed = 0;
+	current.mouseX = 0;
+	current.mouseY = 0;
+	captured = current;
+}
+
+void ReplayInput::setFrame(const ReplayFrame& f)
+{
+	live = 0;
+	captured = f;
+	current = f;
+}
+
+bool ReplayInput::isKeyDown(UCHAR vkey) const
+{
+	int i = keyIndex(vkey);
+	return i >= 0 && (current.keysDown & (1 << i)) != 0;
+}
+
+bool ReplayInput::wasKeyPressed(UCHAR vkey) const
+{
+	int i = keyIndex(vkey);
+	return i >= 0 && (current.keysPressed & (1 << i)) != 0;
+}
+
+void ReplayInput::clearKeyPress(UCHAR vkey)
+{
+	int i = keyIndex(vkey);
+	if(i >= 0) current.keysPressed &= ~(1 << i);
+	if(deferred && i >= 0) clearedKeys |= 1 << i;
+	else if(live) live->clearKeyPress(vkey);
+}
+
+void ReplayInput::releaseKey(UCHAR vkey)
+{
+	int i = keyIndex(vkey);
+	if(i >= 0)
+	{
+		current.keysDown &= ~(1 << i);
+		current.keysPressed &= ~(1 << i);
+	}
+	if(deferred && i >= 0) releasedKeys |= 1 << i;
+	else if(live) live->releaseKey(vkey);
+}
+
+void ReplayInput::flush()
+{
+	for(int i=0; live && i<simInputNS::NUM_KEYS; i++)
+	{
+		if(releasedKeys & (1 << i)) live->releaseKey(simInputNS::KEYS[i]);
+		else if(clearedKeys & (1 << i)) live->clearKeyPress(simInputNS::KEYS[i]);
+	}
+	releasedKeys = clearedKeys = 0;
+}
+
+ReplayRecorder::ReplayRecorder()
+{
+	file = 0;
+	frames = 0;
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+	stop();
+}
+
+bool ReplayRecorder::start(const char* filename, unsigned int seed, unsigned int flags)
+{
+	stop();
+	file = fopen(filename, "wb");
+	if(!file) return false;
+	unsigned int version = replayNS::VERSION;
+	fwrite(replayNS::MAGIC, sizeof(replayNS::MAGIC), 1, file);
+	fwrite(&version, sizeof(version), 1, file);
+	fwrite(&seed, sizeof(seed), 1, file);
+	fwrite(&flags, sizeof(flags), 1, file);
+	frames = 0;
+	return true;
+}
+
+void ReplayRecorder::record(const ReplayFrame& f)
+{
+	if(!file) return;
+	if(writeFrame(file, f)) frames++;
+}
+
+void ReplayRecorder::stop()
+{
+	if(file) fclose(file);
+	file = 0;
+}
+
+bool ReplayLog::load(const char* filename)
+{
+	FILE* f = fopen(filename, "rb");
+	if(!f) return false;
+
+	char magic[sizeof(replayNS::MAGIC)];
+	unsigned int version = 0;
+	bool ok = fread(magic, sizeof(magic), 1, f) == 1 &&
+		memcmp(magic, replayNS::MAGIC, sizeof(magic)) == 0 &&
+		fread(&version, sizeof(version), 1, f) == 1 &&
+		version == replayNS::VERSION &&
+		fread(&seed, sizeof(seed), 1, f) == 1 &&
+		fread(&flags, sizeof(flags), 1, f) == 1;
+
+	frames.clear();
+	ReplayFrame r;
+	//A log cut short by a crash just ends at the last whole frame
+	while(ok && readFrame(f, r))
+		frames.push_back(r);
+	fclose(f);
+	return ok;
+}
+
+float ReplayLog::getDuration()
+{
+	float total = 0.0f;
+	for(unsigned int i=0; i<frames.size(); i++)
+		total += frames[i].dt;
+	return total;
+}
@@ -0,0 +1,119 @@
+//=======================================================================================
+// Replay.h
+//
+// Recording and replaying the simulation. Everything World::update depends on
+// from outside is logged per frame: dt, the keys and mouse movement it reads,
+// and the enemy cost the wave director budgets with (a wall clock measurement).
+// With the SimRandom seed in the header, that is enough to run the frames again
+// headless and get the same state hash after each one.
+//
+// Hashes only match on the platform and build that recorded them; D3DX and
+// SimMath round differently. The capacities in game.txt have to match too.
+//=======================================================================================
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "SimInput.h"
+#include <cstdio>
+#include <vector>
+using std::vector;
+
+namespace replayNS {
+	const char MAGIC[4] = {'R', 'R', 'P', 'L'};
+	const int VERSION = 1;
+	const char DEFAULT_FILE[] = "last.rpl";
+
+	//Header flags, so a replay starts and restarts the way the recording did
+	const unsigned int START_PLAYING = 1;		//skipped the menus with World::startPlaying
+	const unsigned int RESTART_ON_GAME_OVER = 2;	//a fresh World after every WIN/LOSE
+}
+
+//Input to one World::update, 20 bytes on disk
+struct ReplayFrame
+{
+	float dt;
+	unsigned short keysDown;		//bit i is simInputNS::KEYS[i]
+	unsigned short keysPressed;
+	short mouseX;
+	short mouseY;
+	float enemyCostMs;
+	unsigned int stateHash;		//World::computeStateHash after the update
+};
+
+//What the simulation reads as its input. Live, capture() takes a snapshot of the
+//window's Input once a frame; in a replay the frames come from the log. A frame
+//in the log is one World::update, so one fixed step.
+class ReplayInput : public SimInput
+{
+public:
+	ReplayInput();
+
+	//Snapshot of live's keys and mouse movement for this frame
+	void capture(SimInput* live);
+	//For the second and later fixed steps of one frame: keys still held down,
+	//but the presses and mouse movement went to the first step
+	void nextStep();
+	void setFrame(const ReplayFrame& f);
+	//The frame as captured, before the simulation released or cleared anything
+	const ReplayFrame& getFrame() {return captured;}
+
+	virtual bool isKeyDown(UCHAR vkey) const;
+	virtual bool wasKeyPressed(UCHAR vkey) const;
+	//Both also pass through to the live input, so the next capture agrees
+	virtual void clearKeyPress(UCHAR vkey);
+	virtual void releaseKey(UCHAR vkey);
+	virtual int getMouseRawX() {int x = current.mouseX; current.mouseX = 0; return x;}
+	virtual int getMouseRawY() {int y = current.mouseY; current.mouseY = 0; return y;}
+
+	//Holds the pass-through back until flush, for a simulation on another
+	//thread from the one that owns the live input
+	void setDeferred(bool d) {deferred = d;}
+	void flush();
+
+private:
+	SimInput* live;
+	bool deferred;
+	unsigned short releasedKeys;	//held back for flush, same bits as keysDown
+	unsigned short clearedKeys;
+	ReplayFrame captured;
+	ReplayFrame current;
+};
+
+//Streams frames to disk as they happen, so a crash keeps what led up to it
+class ReplayRecorder
+{
+public:
+	ReplayRecorder();
+	~ReplayRecorder();
+
+	bool start(const char* filename, unsigned int seed, unsigned int flags = 0);
+	void record(const ReplayFrame& f);
+	void stop();
+	bool isRecording() {return file != 0;}
+	int getFrameCount() {return frames;}
+
+private:
+	FILE* file;
+	int frames;
+};
+
+class ReplayLog
+{
+public:
+	bool load(const char* filename);
+
+	unsigned int getSeed() {return seed;}
+	unsigned int getFlags() {return flags;}
+	int getFrameCount() {return frames.size();}
+	const ReplayFrame& getFrame(int i) {return frames[i];}
+	//Simulated seconds in the whole log
+	float getDuration();
+
+private:
+	unsigned int seed;
+	unsigned int flags;
+	vector<ReplayFrame> frames;
+};
+
+#endif
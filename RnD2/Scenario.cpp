@@ -0,0 +1,196 @@
+#include "Scenario.h"
+#include <math.h>
+
+ScenarioDesc::ScenarioDesc()
+{
+	seed = 1;
+	buildings = 0;
+	walls = 0;
+	barrels = 0;
+	lamps = 0;
+	pickups = 0;
+	enemies = 0;
+}
+
+//Shrinks every count by the same factor, so the mix stays what was asked for
+static void fitCounts(int* counts[], int n, int limit)
+{
+	double total = 0;
+	for(int i=0; i<n; i++)
+	{
+		if(*counts[i] < 0) *counts[i] = 0;
+		total += *counts[i];
+	}
+	if(total <= limit) return;
+	for(int i=0; i<n; i++)
+		*counts[i] = (int)(*counts[i] * (limit / total));
+}
+
+void ScenarioDesc::clamp()
+{
+	int* statics[] = {&buildings, &walls, &barrels, &lamps};
+	int* dynamics[] = {&pickups, &enemies};
+	fitCounts(statics, 4, scenarioNS::MAX_STATIC);
+	fitCounts(dynamics, 2, scenarioNS::MAX_DYNAMIC);
+}
+
+bool ScenarioDesc::isEmpty() const
+{
+	return getStaticCount() == 0 && getDynamicCount() == 0;
+}
+
+Scenario::Scenario()
+{
+	blocks = 0;
+	spacing = scenarioNS::BLOCK_SIZE + scenarioNS::STREET_WIDTH;
+	randomState = 1;
+	playerStart = Vector3(0, 5, 0);
+}
+
+//xorshift32, as SimRandom, but its own so generating a city doesn't move the
+//simulation's sequence
+unsigned int Scenario::nextRandom()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+float Scenario::randomRange(float low, float high)
+{
+	return low + (high - low) * ((nextRandom() >> 8) / 16777216.0f);
+}
+
+Vector3 Scenario::streetPoint()
+{
+	float along = crossing(nextRandom() % (blocks + 1));
+	float across = randomRange(crossing(0), crossing(blocks));
+	if(nextRandom() & 1) return Vector3(along, 0, across);
+	return Vector3(across, 0, along);
+}
+
+Vector3 Scenario::kerbPoint(int bx, int bz, float inset)
+{
+	using namespace scenarioNS;
+	float x0 = crossing(bx) + STREET_WIDTH/2;
+	float z0 = crossing(bz) + STREET_WIDTH/2;
+	float t = randomRange(0, BLOCK_SIZE);
+	switch(nextRandom() % 4)
+	{
+	case 0:		return Vector3(x0 + t, 0, z0 + inset);
+	case 1:		return Vector3(x0 + t, 0, z0 + BLOCK_SIZE - inset);
+	case 2:		return Vector3(x0 + inset, 0, z0 + t);
+	default:	return Vector3(x0 + BLOCK_SIZE - inset, 0, z0 + t);
+	}
+}
+
+void Scenario::generate(const ScenarioDesc& d)
+{
+	using namespace scenarioNS;
+	desc = d;
+	desc.clamp();
+	//xorshift sticks at zero
+	randomState = desc.seed ? desc.seed : 1;
+
+	//An even number of blocks puts a street crossing, and the nav grid's
+	//centre, on the origin
+	blocks = (int)ceil(sqrt((double)desc.getStaticCount() / STATIC_PER_BLOCK));
+	if(blocks < 2) blocks = 2;
+	blocks += blocks % 2;
+	int numBlocks = blocks*blocks;
+	float lot = BLOCK_SIZE / BLOCK_LOTS;
+
+	buildings.resize(desc.buildings);
+	walls.clear();
+	walls.reserve(desc.walls + desc.lamps);
+	barrels.resize(desc.barrels);
+	lamps.clear();
+	lamps.reserve(desc.lamps);
+	pickups.resize(desc.pickups);
+	enemies.resize(desc.enemies);
+
+	//Buildings fill each block's lots a round at a time, so a sparse city is
+	//spread out rather than packed into the first few blocks
+	for(int i=0; i<desc.buildings; i++)
+	{
+		int block = i % numBlocks;
+		int lotIndex = (i / numBlocks) % (BLOCK_LOTS*BLOCK_LOTS);
+		float x0 = crossing(block % blocks) + STREET_WIDTH/2;
+		float z0 = crossing(block / blocks) + STREET_WIDTH/2;
+		ScenarioBox& b = buildings[i];
+		b.position = Vector3(x0 + (lotIndex % BLOCK_LOTS + 0.5f)*lot, 0, z0 + (lotIndex / BLOCK_LOTS + 0.5f)*lot);
+		b.width = (float)(4 + nextRandom() % 9);
+		b.height = (float)(10 + nextRandom() % 51);
+		b.depth = (float)(4 + nextRandom() % 9);
+	}
+
+	//Low walls along the block edges, one lot long with a gap between each
+	for(int i=0; i<desc.walls; i++)
+	{
+		int block = i % numBlocks;
+		int side = (i / numBlocks) % 4;
+		int segment = (i / numBlocks / 4) % BLOCK_LOTS;
+		float x0 = crossing(block % blocks) + STREET_WIDTH/2;
+		float z0 = crossing(block / blocks) + STREET_WIDTH/2;
+		float along = (segment + 0.5f)*lot;
+		float half = lot/2 - 1.0f;
+		ScenarioBox w;
+		w.height = KERB_HEIGHT;
+		if(side < 2)
+		{
+			w.position = Vector3(x0 + along, 0, side == 0 ? z0 : z0 + BLOCK_SIZE);
+			w.width = half;
+			w.depth = 1.0f;
+		}
+		else
+		{
+			w.position = Vector3(side == 2 ? x0 : x0 + BLOCK_SIZE, 0, z0 + along);
+			w.width = 1.0f;
+			w.depth = half;
+		}
+		walls.push_back(w);
+	}
+
+	for(int i=0; i<desc.barrels; i++)
+		barrels[i] = kerbPoint(nextRandom() % blocks, nextRandom() % blocks, -3.0f);
+
+	//Lamps go on the block corners first, then anywhere along the kerb
+	for(int i=0; i<desc.lamps; i++)
+	{
+		Vector3 p;
+		if(i < numBlocks*4)
+		{
+			int block = i % numBlocks;
+			int corner = i / numBlocks;
+			float x = crossing(block % blocks) + STREET_WIDTH/2 - 2.0f;
+			float z = crossing(block / blocks) + STREET_WIDTH/2 - 2.0f;
+			if(corner & 1) x += BLOCK_SIZE + 4.0f;
+			if(corner & 2) z += BLOCK_SIZE + 4.0f;
+			p = Vector3(x, 0, z);
+		}
+		else p = kerbPoint(nextRandom() % blocks, nextRandom() % blocks, -2.0f);
+
+		ScenarioBox post;
+		post.position = p;
+		post.width = 0.5f;
+		post.height = LAMP_HEIGHT;
+		post.depth = 0.5f;
+		walls.push_back(post);
+		lamps.push_back(Vector3(p.x, LAMP_HEIGHT, p.z));
+	}
+
+	//Amounts as the level 1 daytime pickups
+	const int AMOUNTS[] = {15, 15, 5, 1};
+	for(int i=0; i<desc.pickups; i++)
+	{
+		pickups[i].position = streetPoint();
+		pickups[i].kind = (PickupKind)(nextRandom() % 4);
+		pickups[i].amount = AMOUNTS[pickups[i].kind];
+	}
+
+	for(int i=0; i<desc.enemies; i++)
+		enemies[i] = streetPoint();
+
+	playerStart = Vector3(crossing(blocks/2), 5, crossing(blocks/2));
+}
@@ -0,0 +1,100 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "constants.h"
+#include "pickup.h"
+#include <vector>
+using std::vector;
+
+//Generated city layouts for finding out what breaks at scale. Square blocks
+//of buildings with a kerb of walls, separated by streets; the enemies' nav
+//grid is the street crossings.
+namespace scenarioNS {
+	//Static is buildings, walls, barrels and lamps; dynamic is pickups and enemies
+	const int MAX_STATIC = 100000;
+	const int MAX_DYNAMIC = 10000;
+
+	const float BLOCK_SIZE = 120.0f;
+	const float STREET_WIDTH = 30.0f;
+	//Buildings sit on a grid of BLOCK_LOTS by BLOCK_LOTS lots in each block,
+	//and the city is sized so an average block has this many static objects
+	const int BLOCK_LOTS = 4;
+	const int STATIC_PER_BLOCK = 16;
+	const float KERB_HEIGHT = 2.5f;
+	const float LAMP_HEIGHT = 8.0f;
+}
+
+//How much of everything to make. The same desc always gives the same city.
+struct ScenarioDesc
+{
+	unsigned int seed;
+	int buildings;
+	int walls;
+	int barrels;
+	int lamps;
+	int pickups;
+	int enemies;
+
+	ScenarioDesc();
+	//Scales the counts down to fit MAX_STATIC and MAX_DYNAMIC
+	void clamp();
+	bool isEmpty() const;
+	int getStaticCount() const {return buildings + walls + barrels + lamps;}
+	int getDynamicCount() const {return pickups + enemies;}
+};
+
+//Centre and half-extents, as GameObject::init takes them
+struct ScenarioBox
+{
+	Vector3 position;
+	float width;
+	float height;
+	float depth;
+};
+
+struct ScenarioPickup
+{
+	Vector3 position;
+	PickupKind kind;
+	int amount;
+};
+
+class Scenario
+{
+public:
+	Scenario();
+
+	void generate(const ScenarioDesc& desc);
+
+	const ScenarioDesc& getDesc() const {return desc;}
+	//Blocks along each side; the nav grid has one more waypoint than this
+	int getBlocks() const {return blocks;}
+	//Width and depth of the city, street crossing to street crossing
+	float getExtent() const {return blocks*spacing;}
+
+	//Lamp posts are walls; lamps are where their lights go
+	vector<ScenarioBox> buildings;
+	vector<ScenarioBox> walls;
+	vector<Vector3> barrels;
+	vector<Vector3> lamps;
+	vector<ScenarioPickup> pickups;
+	vector<Vector3> enemies;
+	Vector3 playerStart;
+
+private:
+	unsigned int nextRandom();
+	float randomRange(float low, float high);
+	//Street crossing k along either axis
+	float crossing(int k) const {return -getExtent()/2 + k*spacing;}
+	//A random point on the middle of a street
+	Vector3 streetPoint();
+	//A random point along the kerb of block bx, bz
+	Vector3 kerbPoint(int bx, int bz, float inset);
+
+	ScenarioDesc desc;
+	int blocks;
+	float spacing;
+	unsigned int randomState;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "ScriptedInput.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+static bool eventBefore(const ScriptedEvent& a, const ScriptedEvent& b)
+{
+	return a.tick < b.tick;
+}
+
+ScriptedInput::ScriptedInput()
+{
+	clear();
+}
+
+void ScriptedInput::clear()
+{
+	events.clear();
+	next = 0;
+	tick = -1;
+	length = 0;
+	mouseX = mouseY = 0;
+	for(int i=0; i<scriptedInputNS::NUM_KEYS; i++)
+	{
+		keysDown[i] = false;
+		keysPressed[i] = false;
+	}
+}
+
+void ScriptedInput::addKey(int t, UCHAR key, bool down)
+{
+	ScriptedEvent e;
+	e.tick = t;
+	e.mouse = false;
+	e.key = key;
+	e.down = down;
+	e.dx = e.dy = 0;
+	events.push_back(e);
+	length = Max(length, t+1);
+}
+
+void ScriptedInput::addMouse(int t, int dx, int dy)
+{
+	ScriptedEvent e;
+	e.tick = t;
+	e.mouse = true;
+	e.key = 0;
+	e.down = false;
+	e.dx = dx;
+	e.dy = dy;
+	events.push_back(e);
+	length = Max(length, t+1);
+}
+
+//Format, one event per line, # starts a comment:
+//	<tick> down|up <key>
+//	<tick> mouse <dx> <dy>
+//	<tick> end				(loop length, if longer than the last event)
+bool ScriptedInput::loadFromFile(const char* filename)
+{
+	std::ifstream in(filename);
+	if(!in) return false;
+	clear();
+
+	string line;
+	while(std::getline(in, line))
+	{
+		line = line.substr(0, line.find('#'));
+		std::istringstream ss(line);
+		int t;
+		string kind;
+		if(!(ss >> t >> kind)) continue;
+
+		if(kind == "down" || kind == "up")
+		{
+			string name;
+			ss >> name;
+			int k = 0;
+			while(k < simInputNS::NUM_KEYS && name != simInputNS::KEY_NAMES[k]) k++;
+			if(k == simInputNS::NUM_KEYS) return false;
+			addKey(t, simInputNS::KEYS[k], kind == "down");
+		}
+		else if(kind == "mouse")
+		{
+			int dx = 0, dy = 0;
+			ss >> dx >> dy;
+			addMouse(t, dx, dy);
+		}
+		else if(kind == "end") length = Max(length, t);
+		else return false;
+	}
+	std::stable_sort(events.begin(), events.end(), eventBefore);
+	return true;
+}
+
+void ScriptedInput::advance()
+{
+	tick++;
+	if(length > 0 && tick >= length)
+	{
+		tick = 0;
+		next = 0;
+	}
+
+	for(int i=0; i<scriptedInputNS::NUM_KEYS; i++)
+		keysPressed[i] = false;
+
+	while(next < events.size() && events[next].tick <= tick)
+	{
+		ScriptedEvent& e = events[next++];
+		if(e.mouse)
+		{
+			mouseX += e.dx;
+			mouseY += e.dy;
+		}
+		else
+		{
+			if(e.down && !keysDown[e.key]) keysPressed[e.key] = true;
+			keysDown[e.key] = e.down;
+		}
+	}
+}
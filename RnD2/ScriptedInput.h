@@ -0,0 +1,55 @@
+#ifndef SCRIPTED_INPUT_H
+#define SCRIPTED_INPUT_H
+
+#include "SimInput.h"
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace scriptedInputNS {
+	const int NUM_KEYS = 256;
+}
+
+struct ScriptedEvent
+{
+	int tick;
+	bool mouse;
+	UCHAR key;
+	bool down;
+	int dx, dy;
+};
+
+//Plays back keyboard and mouse input from a text script, one tick per
+//advance(). Runs past the end of the script start it over from tick 0.
+class ScriptedInput : public SimInput
+{
+public:
+	ScriptedInput();
+
+	bool loadFromFile(const char* filename);
+	void clear();
+	void addKey(int tick, UCHAR key, bool down);
+	void addMouse(int tick, int dx, int dy);
+	//Applies every event for the next tick
+	void advance();
+	int getTick() {return tick;}
+
+	virtual bool isKeyDown(UCHAR vkey) const {return keysDown[vkey];}
+	virtual bool wasKeyPressed(UCHAR vkey) const {return keysPressed[vkey];}
+	virtual void clearKeyPress(UCHAR vkey) {keysPressed[vkey] = false;}
+	virtual void releaseKey(UCHAR vkey) {keysDown[vkey] = false; keysPressed[vkey] = false;}
+	virtual int getMouseRawX() {int x = mouseX; mouseX = 0; return x;}
+	virtual int getMouseRawY() {int y = mouseY; mouseY = 0; return y;}
+
+private:
+	vector<ScriptedEvent> events;
+	unsigned int next;
+	int tick;
+	int length;
+	bool keysDown[scriptedInputNS::NUM_KEYS];
+	bool keysPressed[scriptedInputNS::NUM_KEYS];
+	int mouseX, mouseY;
+};
+
+#endif
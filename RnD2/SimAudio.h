@@ -0,0 +1,15 @@
+#ifndef SIMAUDIO_H
+#define SIMAUDIO_H
+
+//Sound as the simulation sees it: fire-and-forget cues by name. The base
+//class plays nothing, which is all a headless run needs.
+class SimAudio
+{
+public:
+	virtual ~SimAudio() {}
+
+	virtual void playCue(const char cue[]) {}
+	virtual void stopCue(const char cue[], int time = 1) {}
+};
+
+#endif
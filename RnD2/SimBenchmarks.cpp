@@ -0,0 +1,738 @@
+//=======================================================================================
+// SimBenchmarks.cpp
+//
+// Google Benchmark suite for the simulation hot paths. Built as rugger_bench when
+// CMake finds the benchmark package.
+//
+//   rugger_bench --benchmark_out=bench.json --benchmark_out_format=json
+//
+// or "cmake --build <dir> --target bench_json", which does the same into the build
+// directory. Compare two runs with benchmark's tools/compare.py.
+//=======================================================================================
+
+#include "World.h"
+#include "Wall.h"
+#include "Enemy.h"
+#include "Gun.h"
+#include "Waypoint.h"
+#include "ScriptedInput.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "FrameSnapshot.h"
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "StaticBatcher.h"
+#include "PackedVertex.h"
+#include "ImageDecoder.h"
+#include "MipGenerator.h"
+#include "BlockCompressor.h"
+#include "SimRandom.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace benchNS {
+	const unsigned int SEED = 1234;
+	const float DT = 1.0f/60.0f;
+	//Half the side of the square entities get scattered over
+	const int SPREAD = 500;
+	//Waypoint spacing in the generated nav grids, as on level 1
+	const float GRID_SPACING = 100.0f;
+	//The street the occlusion cull is timed down: blocks of buildings each
+	//side, BLOCK apart, and enemies out to this far either side of it
+	const int STREET_BLOCKS = 50;
+	const float BLOCK = 40.0f;
+	const float STREET_HALF_WIDTH = 15.0f;
+	const float BLOCKS_WIDTH = 400.0f;
+	//The city the job system's scaling is timed in
+	const int SCALING_STATICS = 10000;
+	const int SCALING_DYNAMICS = 4000;
+}
+
+//1 thread and all of them, or just 1 on a single core so no case runs twice
+static std::vector<int64_t> oneAndAllThreads()
+{
+	std::vector<int64_t> threads(1, 1);
+	if(Thread::getCoreCount() > 1) threads.push_back(Thread::getCoreCount());
+	return threads;
+}
+
+static Vector3 randomPosition()
+{
+	return Vector3(RandF(-benchNS::SPREAD, benchNS::SPREAD), 0.0f, RandF(-benchNS::SPREAD, benchNS::SPREAD));
+}
+
+//One mover tested against N walls, as in World::handleWallCollisions
+static void BM_Collided(benchmark::State& state)
+{
+	srand(benchNS::SEED);
+	int count = state.range(0);
+	vector<Wall> walls(count);
+	for(int i=0; i<count; i++)
+		walls[i].init(NULL, 2.0f, randomPosition(), Vector3(0,0,0), 0, 1, 10, 10, 10);
+	Wall mover;
+	mover.init(NULL, 2.0f, Vector3(0,0,0), Vector3(0,0,0), 0, 1, 2, 2, 2);
+
+	int hits = 0;
+	for(auto _ : state)
+	{
+		for(int i=0; i<count; i++)
+			if(mover.collided(&walls[i])) hits++;
+		benchmark::DoNotOptimize(hits);
+	}
+	state.SetItemsProcessed(state.iterations()*count);
+}
+BENCHMARK(BM_Collided)->RangeMultiplier(4)->Range(16, 4096);
+
+//N x N grid of waypoints linked in the cardinal directions, like the game's 5 x 5 one
+static void makeGrid(NavGrid& grid, int n)
+{
+	grid.place(n, (n-1)*benchNS::GRID_SPACING, (n-1)*benchNS::GRID_SPACING);
+	grid.linkAll();
+}
+
+//Corner to corner path across an N x N nav grid, grid reset included
+static void BM_PathfindAStar(benchmark::State& state)
+{
+	int n = state.range(0);
+	NavGrid grid;
+	makeGrid(grid, n);
+
+	size_t length = 0;
+	for(auto _ : state)
+	{
+		list<Waypoint*> path = grid.findPath(grid.at(0, 0), grid.at(n-1, n-1));
+		length = path.size();
+		benchmark::DoNotOptimize(length);
+	}
+	state.counters["path"] = (double)length;
+	state.SetItemsProcessed(state.iterations()*n*n);
+}
+BENCHMARK(BM_PathfindAStar)->DenseRange(5, 30, 5)->Arg(50);
+
+//N lookups against the level 1 waypoint grid, half of them inside the short-circuit radius
+static void BM_FindNearestWaypoint(benchmark::State& state)
+{
+	srand(benchNS::SEED);
+	int count = state.range(0);
+	NavGrid grid;
+	makeGrid(grid, WAYPOINT_SIZE);
+	Enemy enemy;
+	enemy.init(NULL, 2.0f, Vector3(0,0,0));
+	enemy.setNavGrid(&grid);
+	vector<Vector3> queries(count);
+	for(int i=0; i<count; i++)
+		queries[i] = (i%2) ? randomPosition() : randomPosition()*0.1f;
+
+	for(auto _ : state)
+	{
+		for(int i=0; i<count; i++)
+			benchmark::DoNotOptimize(enemy.findNearestWaypoint(queries[i]));
+	}
+	state.SetItemsProcessed(state.iterations()*count);
+}
+BENCHMARK(BM_FindNearestWaypoint)->RangeMultiplier(4)->Range(16, 4096);
+
+//Scale/rotate/translate matrices for N objects
+static void BM_Transform(benchmark::State& state)
+{
+	srand(benchNS::SEED);
+	int count = state.range(0);
+	Wall object;
+	object.init(NULL, 2.0f, Vector3(0,0,0), Vector3(0,0,0), 0);
+	vector<Vector3> rotations(count), positions(count);
+	for(int i=0; i<count; i++)
+	{
+		rotations[i] = Vector3(RandF(0, 2*PI), RandF(0, 2*PI), RandF(0, 2*PI));
+		positions[i] = randomPosition();
+	}
+
+	for(auto _ : state)
+	{
+		for(int i=0; i<count; i++)
+		{
+			Matrix m = object.transform(Vector3(1,2,3), rotations[i], positions[i]);
+			benchmark::DoNotOptimize(m);
+		}
+	}
+	state.SetItemsProcessed(state.iterations()*count);
+}
+BENCHMARK(BM_Transform)->RangeMultiplier(4)->Range(16, 4096);
+
+//Gun::update over N bullets with every other one spent, so half get compacted out.
+//Refilling the list between iterations is not timed.
+static void BM_GunUpdate(benchmark::State& state)
+{
+	int count = state.range(0);
+	vector<Bullet*> bullets;
+	Pistol gun(NULL, &bullets);
+
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		while((int)bullets.size() < count)
+			bullets.push_back(new Bullet(NULL, 2.0f, Vector3(0,0,0), Vector3(0,0,1), 0, 1));
+		for(int i=0; i<count; i++)
+		{
+			if(i%2) bullets[i]->setInActive();
+			else bullets[i]->setActive();
+		}
+		state.ResumeTiming();
+
+		gun.update(benchNS::DT);
+	}
+	for(unsigned int i=0; i<bullets.size(); i++)
+		delete bullets[i];
+	state.SetItemsProcessed(state.iterations()*count);
+}
+BENCHMARK(BM_GunUpdate)->RangeMultiplier(4)->Range(16, 4096);
+
+//Choosing the day's pickups on level 1
+static void BM_PlacePickups(benchmark::State& state)
+{
+	srand(benchNS::SEED);
+	SimAudio audio;
+	ScriptedInput input;
+	World* world = new World;
+	world->init(&input, &audio, WorldMeshes());
+
+	for(auto _ : state)
+		world->reshufflePickups();
+	delete world;
+}
+BENCHMARK(BM_PlacePickups);
+
+//Whole simulation ticks with nobody at the keyboard, from the first night onwards
+static void BM_WorldTick(benchmark::State& state)
+{
+	srand(benchNS::SEED);
+	SimAudio audio;
+	ScriptedInput input;
+	World* world = new World;
+	world->init(&input, &audio, WorldMeshes());
+	world->startPlaying();
+	while(!world->isNight())
+		world->update(benchNS::DT);
+
+	for(auto _ : state)
+	{
+		world->update(benchNS::DT);
+		if(world->getGameState() != PLAYING)
+		{
+			state.PauseTiming();
+			delete world;
+			world = new World;
+			world->init(&input, &audio, WorldMeshes());
+			world->startPlaying();
+			state.ResumeTiming();
+		}
+	}
+	delete world;
+}
+BENCHMARK(BM_WorldTick);
+
+//A generated city of statics static and dynamics dynamic objects
+static void generateCity(int statics, int dynamics, Scenario* scenario)
+{
+	ScenarioDesc desc;
+	desc.seed = benchNS::SEED;
+	desc.buildings = statics*4/10;
+	desc.walls = statics*4/10;
+	desc.barrels = statics/10;
+	desc.lamps = statics - desc.buildings - desc.walls - desc.barrels;
+	desc.pickups = dynamics/5;
+	desc.enemies = dynamics - desc.pickups;
+	scenario->generate(desc);
+}
+
+//Times World::update in the city, starting it again untimed whenever a game ends
+static void tickCity(benchmark::State& state, const Scenario& scenario)
+{
+	SimAudio audio;
+	ScriptedInput input;
+	World* world = 0;
+	for(auto _ : state)
+	{
+		if(world == 0 || world->getGameState() != PLAYING)
+		{
+			state.PauseTiming();
+			delete world;
+			SimRandom::seed(benchNS::SEED);
+			world = new World;
+			world->init(&input, &audio, WorldMeshes());
+			world->loadScenario(scenario);
+			world->startPlaying();
+			state.ResumeTiming();
+		}
+		world->update(benchNS::DT);
+	}
+	delete world;
+}
+
+//Whole simulation ticks in a generated city of N static and M dynamic objects,
+//everyone out at once and nobody at the keyboard
+static void BM_ScenarioTick(benchmark::State& state)
+{
+	int statics = state.range(0);
+	int dynamics = state.range(1);
+	Scenario scenario;
+	generateCity(statics, dynamics, &scenario);
+	tickCity(state, scenario);
+	state.SetItemsProcessed(state.iterations()*(statics + dynamics));
+}
+BENCHMARK(BM_ScenarioTick)->Args({1000, 100})->Args({10000, 1000})->Args({100000, 10000})->Unit(benchmark::kMillisecond);
+
+//Sorting a captured frame of a generated city into instance batches, as the
+//renderer does every frame. Meshes are NULL, so batches split on material
+//only, or with the second argument 1 on bind group, every material but the
+//street's and the road's being a slice of one array, the most a table shares.
+static void BM_InstanceBuild(benchmark::State& state)
+{
+	ScenarioDesc desc;
+	desc.seed = benchNS::SEED;
+	desc.buildings = state.range(0)/2;
+	desc.walls = state.range(0)/2;
+	desc.enemies = state.range(0)/10;
+	Scenario scenario;
+	scenario.generate(desc);
+
+	SimAudio audio;
+	ScriptedInput input;
+	World* world = new World;
+	world->init(&input, &audio, WorldMeshes());
+	world->loadScenario(scenario);
+	world->startPlaying();
+	world->update(benchNS::DT);
+	FrameSnapshot snapshot;
+	snapshot.capture(world, 1.0f);
+	//The scenery too, as if it were still drawn with the rest
+	snapshot.draws.clear();
+	world->draw(&snapshot);
+
+	MaterialTable materials;
+	TextureData layout;
+	layout.width = layout.height = 1024;
+	layout.mipLevels = 11;
+	layout.format = textureDataNS::BC1;
+	for(int i=0; i<NUM_MATERIALS; i++)
+		if(i != MATERIAL_STREET && i != MATERIAL_ROAD) materials.setLayout(i, layout, 0);
+	materials.build();
+
+	InstanceBatcher batcher;
+	batcher.setMaterialTable(state.range(1) ? &materials : 0);
+	for(auto _ : state)
+	{
+		batcher.clear();
+		batcher.setView(snapshot.view);
+		snapshot.replay(&batcher);
+		batcher.build();
+		benchmark::DoNotOptimize(batcher.getInstances().data());
+	}
+	state.counters["draws"] = (double)batcher.getDrawCount();
+	state.counters["batches"] = (double)batcher.getBatchCount();
+	state.counters["state_changes"] = (double)batcher.getStateChanges();
+	state.counters["drawn_state_changes"] = (double)batcher.getDrawnStateChanges();
+	state.SetItemsProcessed(state.iterations()*batcher.getDrawCount());
+	delete world;
+}
+BENCHMARK(BM_InstanceBuild)->ArgsProduct({{100, 1000, 10000, 100000}, {0, 1}});
+
+//The radix sort alone, on keys spread over every field as a busy frame's would be
+static void BM_RenderQueueSort(benchmark::State& state)
+{
+	srand(benchNS::SEED);
+	vector<RenderKey> keys(state.range(0));
+	for(unsigned int i=0; i<keys.size(); i++)
+	{
+		RenderPass pass = rand() % 8 ? RENDER_OPAQUE : RENDER_BLENDED;
+		float depth = 1.0f + 5000.0f*rand()/RAND_MAX;
+		keys[i] = RenderQueue::makeKey(pass, TECH_INSTANCED, rand() % NUM_MATERIALS, rand() % 16, depth);
+	}
+
+	RenderQueue queue;
+	for(auto _ : state)
+	{
+		queue.clear();
+		for(unsigned int i=0; i<keys.size(); i++)
+			queue.submit(keys[i]);
+		queue.sort();
+		benchmark::DoNotOptimize(queue.getIndex(0));
+	}
+	state.counters["radix_passes"] = (double)queue.getRadixPasses();
+	state.counters["state_changes"] = (double)queue.countSortedChanges(renderQueueNS::STATE_MASK);
+	state.SetItemsProcessed(state.iterations()*keys.size());
+}
+BENCHMARK(BM_RenderQueueSort)->RangeMultiplier(10)->Range(100, 100000);
+
+//The frustum cull over a scenario's draw list, four boxes at a time or one.
+//Only the test is timed; building the box list is the same either way.
+//The camera is the player's at the start, looking down a street.
+static void BM_FrustumCull(benchmark::State& state)
+{
+	ScenarioDesc desc;
+	desc.seed = benchNS::SEED;
+	desc.buildings = state.range(0)/2;
+	desc.walls = state.range(0)/2;
+	Scenario scenario;
+	scenario.generate(desc);
+
+	SimAudio audio;
+	ScriptedInput input;
+	World* world = new World;
+	world->init(&input, &audio, WorldMeshes());
+	world->loadScenario(scenario);
+	world->startPlaying();
+	world->update(benchNS::DT);
+	FrameSnapshot snapshot;
+	snapshot.capture(world, 1.0f);
+	snapshot.draws.clear();
+	world->draw(&snapshot);
+
+	FrustumCuller culler;
+	culler.setViewProj(snapshot.view*snapshot.proj);
+	for(unsigned int i=0; i<snapshot.draws.size(); i++)
+		culler.addMesh(snapshot.draws[i].world, 1.0f);
+	bool simd = state.range(1) != 0;
+	for(auto _ : state)
+	{
+		if(simd) culler.cull();
+		else culler.cullScalar();
+		benchmark::DoNotOptimize(culler.getVisible().data());
+	}
+	state.counters["visible"] = (double)culler.getVisibleCount();
+	state.counters["culled"] = (double)culler.getCulledCount();
+	state.SetItemsProcessed(state.iterations()*culler.getCount());
+	delete world;
+}
+BENCHMARK(BM_FrustumCull)->ArgsProduct({{1000, 100000}, {0, 1}});
+
+//A whole occlusion cull, occluders in and draws tested, after the frustum cull
+//of a scenario seen from the street, with the scenery in static pieces as the
+//game has it. Has to stay well under a millisecond.
+static void BM_OcclusionCull(benchmark::State& state)
+{
+	ScenarioDesc desc;
+	desc.seed = benchNS::SEED;
+	desc.buildings = state.range(0)/2;
+	desc.walls = state.range(0)/2;
+	Scenario scenario;
+	scenario.generate(desc);
+
+	SimAudio audio;
+	ScriptedInput input;
+	World* world = new World;
+	world->init(&input, &audio, WorldMeshes());
+	world->loadScenario(scenario);
+	world->startPlaying();
+	world->update(benchNS::DT);
+	FrameSnapshot snapshot;
+	snapshot.capture(world, 1.0f);
+
+	StaticBatcher statics;
+	snapshot.replayStatic(&statics);
+	statics.build();
+	FrustumCuller culler;
+	statics.cull(&culler, snapshot.view*snapshot.proj);
+	vector<int> visiblePieces = culler.getVisible();
+	//The benchmarks' meshes are all stand-ins, so unscaled
+	snapshot.cull(&culler, 0);
+	OcclusionCuller occlusion;
+	occlusion.setSimd(state.range(1) != 0);
+	vector<int> visible;
+	vector<int> pieces;
+	for(auto _ : state)
+	{
+		visible = culler.getVisible();
+		pieces = visiblePieces;
+		snapshot.occlude(&occlusion, 0, &visible, &statics, &pieces);
+		benchmark::DoNotOptimize(visible.data());
+	}
+	state.counters["tested"] = (double)occlusion.getTestedCount();
+	state.counters["occluded"] = (double)occlusion.getOccludedCount();
+	state.counters["occluders"] = (double)occlusion.getOccluderCount();
+	delete world;
+}
+BENCHMARK(BM_OcclusionCull)->ArgsProduct({{1000, 100000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+//What the occlusion cull is for, as on level 2: the eye at street level down a
+//long street with buildings along both sides, and N enemies, one in ten out
+//in the street and the rest in the blocks behind the buildings, where most of
+//them are hidden. A thousand, some 800 tested, has to stay well under a
+//millisecond; ten thousand shows how the testing grows past that.
+static void BM_OcclusionStreet(benchmark::State& state)
+{
+	using namespace benchNS;
+	srand(SEED);
+	FrameSnapshot snapshot;
+	Camera camera;
+	camera.setPerspective();
+	snapshot.proj = camera.getProjectionMatrix();
+	Vector3 eye(0, 5, 0), at(0, 5, 100), up(0, 1, 0);
+	D3DXMatrixLookAtLH(&snapshot.view, &eye, &at, &up);
+
+	//30 across, 80 high and 36 deep, with a 4 wide alley between each
+	StaticBatcher statics;
+	statics.setMaterial(MATERIAL_BUILDING);
+	for(int k=0; k<STREET_BLOCKS; k++)
+	{
+		for(int side=-1; side<=1; side+=2)
+		{
+			Matrix scale, move;
+			Scale(&scale, 15, 40, 18);
+			Translate(&move, side*(STREET_HALF_WIDTH + 15), 0, BLOCK*(k + 0.5f));
+			statics.drawMesh(NULL, scale*move, false);
+		}
+	}
+	statics.build();
+
+	int count = state.range(0);
+	snapshot.setMaterial(MATERIAL_ENEMY);
+	for(int i=0; i<count; i++)
+	{
+		float x = (i % 10 == 0) ? RandF(-STREET_HALF_WIDTH, STREET_HALF_WIDTH)
+			: RandF(STREET_HALF_WIDTH + 35, BLOCKS_WIDTH) * (i % 2 ? 1 : -1);
+		Matrix move;
+		Translate(&move, x, 0, RandF(BLOCK, STREET_BLOCKS*BLOCK));
+		snapshot.drawMesh(NULL, move, false);
+	}
+
+	FrustumCuller culler;
+	statics.cull(&culler, snapshot.view*snapshot.proj);
+	vector<int> visiblePieces = culler.getVisible();
+	snapshot.cull(&culler, 0);
+	OcclusionCuller occlusion;
+	occlusion.setSimd(state.range(1) != 0);
+	vector<int> visible;
+	vector<int> pieces;
+	for(auto _ : state)
+	{
+		visible = culler.getVisible();
+		pieces = visiblePieces;
+		snapshot.occlude(&occlusion, 0, &visible, &statics, &pieces);
+		benchmark::DoNotOptimize(visible.data());
+	}
+	state.counters["tested"] = (double)occlusion.getTestedCount();
+	state.counters["occluded"] = (double)occlusion.getOccludedCount();
+	state.counters["occluders"] = (double)occlusion.getOccluderCount();
+}
+BENCHMARK(BM_OcclusionStreet)->ArgsProduct({{1000, 10000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+//Rebuilding a generated city's scenery on the CPU: sorting it into pieces and
+//moving every box into place, which a level switch pays once
+static void BM_StaticBuild(benchmark::State& state)
+{
+	ScenarioDesc desc;
+	desc.seed = benchNS::SEED;
+	desc.buildings = state.range(0)/2;
+	desc.walls = state.range(0)/2;
+	Scenario scenario;
+	scenario.generate(desc);
+
+	SimAudio audio;
+	ScriptedInput input;
+	World* world = new World;
+	world->init(&input, &audio, WorldMeshes());
+	world->loadScenario(scenario);
+	world->startPlaying();
+	world->update(benchNS::DT);
+	FrameSnapshot snapshot;
+	snapshot.capture(world, 1.0f);
+
+	StaticBatcher statics;
+	vector<PackedVertex> vertices(staticBatchNS::MAX_PIECE_BOXES*staticBatchNS::BOX_VERTICES);
+	for(auto _ : state)
+	{
+		statics.clear();
+		snapshot.replayStatic(&statics);
+		statics.build();
+		for(int i=0; i<statics.getPieceCount(); i++)
+			statics.fillVertices(i, &vertices[0]);
+		benchmark::DoNotOptimize(vertices.data());
+	}
+	state.counters["boxes"] = (double)statics.getBoxCount();
+	state.counters["pieces"] = (double)statics.getPieceCount();
+	state.SetItemsProcessed(state.iterations()*statics.getBoxCount());
+	delete world;
+}
+BENCHMARK(BM_StaticBuild)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+//Packing a vertex, most of which is finding the nearest octahedral normal
+static void BM_PackVertex(benchmark::State& state)
+{
+	const int count = 4096;
+	vector<Vector3> normals(count);
+	for(int i=0; i<count; i++)
+	{
+		Vector3 n(2.0f*rand()/RAND_MAX - 1.0f, 2.0f*rand()/RAND_MAX - 1.0f, 2.0f*rand()/RAND_MAX - 1.0f);
+		D3DXVec3Normalize(&normals[i], &n);
+	}
+	const float white[4] = {1, 1, 1, 1};
+	vector<PackedVertex> out(count);
+	for(auto _ : state)
+	{
+		for(int i=0; i<count; i++)
+			packVertex(normals[i], normals[i], white, 0.5f, 0.25f, &out[i]);
+		benchmark::DoNotOptimize(out.data());
+	}
+	state.SetItemsProcessed(state.iterations()*count);
+	state.SetBytesProcessed(state.iterations()*count*sizeof(PackedVertex));
+}
+BENCHMARK(BM_PackVertex);
+
+//Decoding the game's textures from memory: a big PNG, a progressive and a
+//baseline JPEG, and a DDS, which is mostly a copy
+static const char* DECODE_FILES[] = {"bricks.png", "building2.jpg", "skyscraper.jpg", "defaultspec.dds"};
+
+static void BM_DecodeImage(benchmark::State& state)
+{
+	const char* name = DECODE_FILES[state.range(0)];
+	std::string path = std::string(RUGGER_ASSET_DIR) + "/" + name;
+	vector<unsigned char> file;
+	FILE* f = fopen(path.c_str(), "rb");
+	if(f)
+	{
+		fseek(f, 0, SEEK_END);
+		file.resize(ftell(f));
+		fseek(f, 0, SEEK_SET);
+		if(fread(file.data(), 1, file.size(), f) != file.size()) file.clear();
+		fclose(f);
+	}
+	TextureData data;
+	if(file.empty() || !decodeImage(file.data(), file.size(), &data))
+	{
+		state.SkipWithError("could not decode");
+		return;
+	}
+	for(auto _ : state)
+	{
+		decodeImage(file.data(), file.size(), &data);
+		benchmark::DoNotOptimize(data.texels.data());
+	}
+	state.SetLabel(name);
+	state.SetItemsProcessed(state.iterations()*data.width*data.height);
+	state.SetBytesProcessed(state.iterations()*file.size());
+}
+BENCHMARK(BM_DecodeImage)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+
+//Block-compressing one level of a photo on one thread, at each quality, to
+//BC1, BC3 and BC4. Items are texels, so items/s is the MP/s the packer gets
+//per core.
+static void BM_CompressBlocks(benchmark::State& state)
+{
+	static const textureDataNS::Format FORMATS[] = {textureDataNS::BC1, textureDataNS::BC3, textureDataNS::BC4};
+	static const char* LABELS[] = {"BC1", "BC3", "BC4"};
+	textureDataNS::Format format = FORMATS[state.range(0)];
+	blockCompressNS::Quality quality = (blockCompressNS::Quality)state.range(1);
+	std::string path = std::string(RUGGER_ASSET_DIR) + "/skyscraper.jpg";
+	TextureData image;
+	if(!loadImage(path.c_str(), &image))
+	{
+		state.SkipWithError("could not decode");
+		return;
+	}
+	resizeImage(&image, image.width & ~3, image.height & ~3);
+	TextureData out;
+	for(auto _ : state)
+	{
+		compressTexture(image, format, quality, &out);
+		benchmark::DoNotOptimize(out.texels.data());
+	}
+	state.SetLabel(LABELS[state.range(0)]);
+	state.SetItemsProcessed(state.iterations()*image.width*image.height);
+}
+BENCHMARK(BM_CompressBlocks)->ArgsProduct({{0, 1, 2}, {0, 1, 2}})->Unit(benchmark::kMillisecond);
+
+//A photo's full mip chain with each filter, linear and sRGB, on 1 and N
+//threads, the caller included. Items are top-level texels, so items/s is MP/s.
+static void BM_GenerateMips(benchmark::State& state)
+{
+	static const char* LABELS[] = {"box", "box srgb", "kaiser", "kaiser srgb"};
+	std::string path = std::string(RUGGER_ASSET_DIR) + "/skyscraper.jpg";
+	TextureData image;
+	if(!loadImage(path.c_str(), &image))
+	{
+		state.SkipWithError("could not decode");
+		return;
+	}
+	MipOptions options;
+	options.filter = (mipNS::Filter)state.range(0);
+	options.srgb = state.range(1) != 0;
+	TextureData work;
+	JobSystem::init((int)state.range(2) - 1);
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		work = image;
+		state.ResumeTiming();
+		generateMips(&work, options);
+		benchmark::DoNotOptimize(work.texels.data());
+	}
+	JobSystem::shutdown();
+	state.SetLabel(LABELS[state.range(0)*2 + state.range(1)]);
+	state.SetItemsProcessed(state.iterations()*image.width*image.height);
+}
+BENCHMARK(BM_GenerateMips)->ArgsProduct({{mipNS::BOX, mipNS::KAISER}, {0, 1}, oneAndAllThreads()})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+//A 640x480 menu resampled to the nearest power of two, 512x512, with the
+//Kaiser filter in sRGB, on 1 and N threads
+static void BM_ResizeImage(benchmark::State& state)
+{
+	std::string path = std::string(RUGGER_ASSET_DIR) + "/introMenu.png";
+	TextureData image;
+	if(!loadImage(path.c_str(), &image))
+	{
+		state.SkipWithError("could not decode");
+		return;
+	}
+	MipOptions options;
+	options.filter = mipNS::KAISER;
+	options.srgb = true;
+	int w = nearestPowerOfTwo(image.width), h = nearestPowerOfTwo(image.height);
+	TextureData work;
+	JobSystem::init((int)state.range(0) - 1);
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		work = image;
+		state.ResumeTiming();
+		resizeImage(&work, w, h, options);
+		benchmark::DoNotOptimize(work.texels.data());
+	}
+	JobSystem::shutdown();
+	state.SetItemsProcessed(state.iterations()*image.width*image.height);
+}
+BENCHMARK(BM_ResizeImage)->ArgsProduct({oneAndAllThreads()})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+//Cost of one profiler zone, recording or switched off at runtime
+static void BM_ProfileZone(benchmark::State& state)
+{
+	bool wasEnabled = Profiler::isEnabled();
+	Profiler::setEnabled(state.range(0) != 0);
+	for(auto _ : state)
+	{
+		PROFILE_ZONE("BM_ProfileZone");
+		benchmark::ClobberMemory();
+	}
+	Profiler::setEnabled(wasEnabled);
+	Profiler::clear();
+}
+BENCHMARK(BM_ProfileZone)->Arg(1)->Arg(0);
+
+//The same ticks in one city on 1 to N threads, the caller included, for how
+//World's per-object passes scale on the job system
+static void BM_JobScaling(benchmark::State& state)
+{
+	Scenario scenario;
+	generateCity(benchNS::SCALING_STATICS, benchNS::SCALING_DYNAMICS, &scenario);
+	JobSystem::init(state.range(0) - 1);
+	tickCity(state, scenario);
+	JobSystem::shutdown();
+	state.SetItemsProcessed(state.iterations()*(benchNS::SCALING_STATICS + benchNS::SCALING_DYNAMICS));
+}
+BENCHMARK(BM_JobScaling)->DenseRange(1, Thread::getCoreCount())->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,41 @@
+#ifndef SIMINPUT_H
+#define SIMINPUT_H
+
+#include "constants.h"
+
+//Virtual key codes the simulation reads, with their Windows values
+#ifndef _WIN32
+#define VK_SHIFT	0x10
+#define VK_ESCAPE	0x1B
+#define VK_SPACE	0x20
+#define VK_LEFT		0x25
+#define VK_UP		0x26
+#define VK_RIGHT	0x27
+#define VK_DOWN		0x28
+#endif
+
+//Every key the simulation reads, with the names scripts and logs use for them
+namespace simInputNS {
+	const int NUM_KEYS = 15;
+	const UCHAR KEYS[NUM_KEYS] = {KEY_W, KEY_A, KEY_S, KEY_D, KEY_F, KEY_K, KEY_L, KEY_M, KEY_0, VK_SPACE, VK_SHIFT, VK_LEFT, VK_RIGHT, VK_UP, VK_DOWN};
+	const char* const KEY_NAMES[NUM_KEYS] = {"W", "A", "S", "D", "F", "K", "L", "M", "0", "SPACE", "SHIFT", "LEFT", "RIGHT", "UP", "DOWN"};
+}
+
+//Keyboard and mouse state as the simulation reads it. Input implements it
+//for the window; ScriptedInput plays back a text script.
+class SimInput
+{
+public:
+	virtual ~SimInput() {}
+
+	virtual bool isKeyDown(UCHAR vkey) const = 0;
+	virtual bool wasKeyPressed(UCHAR vkey) const = 0;
+	virtual void clearKeyPress(UCHAR vkey) = 0;
+	//Treat the key as up until it is pressed again
+	virtual void releaseKey(UCHAR vkey) = 0;
+	//Movement since the last call
+	virtual int getMouseRawX() = 0;
+	virtual int getMouseRawY() = 0;
+};
+
+#endif
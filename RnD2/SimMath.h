@@ -0,0 +1,262 @@
+//=======================================================================================
+// SimMath.h
+//
+// The vector/matrix types the simulation uses. On Windows these are the real D3DX
+// ones; everywhere else a small stand-in with the same names and conventions
+// (row vectors, left-handed) so the simulation code compiles unchanged.
+//=======================================================================================
+
+#ifndef SIMMATH_H
+#define SIMMATH_H
+
+#include <cstdlib>
+#include <cfloat>
+#include <cmath>
+
+#ifdef _WIN32
+
+#include <d3dx10.h>
+
+#else
+
+typedef float FLOAT;
+
+#define D3DX_PI    ((FLOAT) 3.141592654f)
+#define D3DXToRadian( degree ) ((degree) * (D3DX_PI / 180.0f))
+#define D3DXToDegree( radian ) ((radian) * (180.0f / D3DX_PI))
+
+struct D3DXVECTOR3
+{
+	FLOAT x, y, z;
+
+	D3DXVECTOR3() {}
+	D3DXVECTOR3(FLOAT _x, FLOAT _y, FLOAT _z) : x(_x), y(_y), z(_z) {}
+
+	operator FLOAT* () {return &x;}
+	operator const FLOAT* () const {return &x;}
+
+	D3DXVECTOR3& operator += (const D3DXVECTOR3& v) {x += v.x; y += v.y; z += v.z; return *this;}
+	D3DXVECTOR3& operator -= (const D3DXVECTOR3& v) {x -= v.x; y -= v.y; z -= v.z; return *this;}
+	D3DXVECTOR3& operator *= (FLOAT f) {x *= f; y *= f; z *= f; return *this;}
+	D3DXVECTOR3& operator /= (FLOAT f) {FLOAT inv = 1.0f / f; x *= inv; y *= inv; z *= inv; return *this;}
+
+	D3DXVECTOR3 operator + () const {return *this;}
+	D3DXVECTOR3 operator - () const {return D3DXVECTOR3(-x, -y, -z);}
+
+	D3DXVECTOR3 operator + (const D3DXVECTOR3& v) const {return D3DXVECTOR3(x + v.x, y + v.y, z + v.z);}
+	D3DXVECTOR3 operator - (const D3DXVECTOR3& v) const {return D3DXVECTOR3(x - v.x, y - v.y, z - v.z);}
+	D3DXVECTOR3 operator * (FLOAT f) const {return D3DXVECTOR3(x * f, y * f, z * f);}
+	D3DXVECTOR3 operator / (FLOAT f) const {FLOAT inv = 1.0f / f; return D3DXVECTOR3(x * inv, y * inv, z * inv);}
+
+	friend D3DXVECTOR3 operator * (FLOAT f, const D3DXVECTOR3& v) {return D3DXVECTOR3(f * v.x, f * v.y, f * v.z);}
+
+	bool operator == (const D3DXVECTOR3& v) const {return x == v.x && y == v.y && z == v.z;}
+	bool operator != (const D3DXVECTOR3& v) const {return x != v.x || y != v.y || z != v.z;}
+};
+
+struct D3DXMATRIX
+{
+	union {
+		struct {
+			FLOAT _11, _12, _13, _14;
+			FLOAT _21, _22, _23, _24;
+			FLOAT _31, _32, _33, _34;
+			FLOAT _41, _42, _43, _44;
+		};
+		FLOAT m[4][4];
+	};
+
+	D3DXMATRIX() {}
+	D3DXMATRIX(FLOAT f11, FLOAT f12, FLOAT f13, FLOAT f14,
+			   FLOAT f21, FLOAT f22, FLOAT f23, FLOAT f24,
+			   FLOAT f31, FLOAT f32, FLOAT f33, FLOAT f34,
+			   FLOAT f41, FLOAT f42, FLOAT f43, FLOAT f44)
+	{
+		_11 = f11; _12 = f12; _13 = f13; _14 = f14;
+		_21 = f21; _22 = f22; _23 = f23; _24 = f24;
+		_31 = f31; _32 = f32; _33 = f33; _34 = f34;
+		_41 = f41; _42 = f42; _43 = f43; _44 = f44;
+	}
+
+	FLOAT& operator () (unsigned int row, unsigned int col) {return m[row][col];}
+	FLOAT operator () (unsigned int row, unsigned int col) const {return m[row][col];}
+
+	operator FLOAT* () {return &_11;}
+	operator const FLOAT* () const {return &_11;}
+
+	D3DXMATRIX operator * (const D3DXMATRIX& b) const
+	{
+		D3DXMATRIX r;
+		for(int i=0; i<4; i++)
+			for(int j=0; j<4; j++)
+				r.m[i][j] = m[i][0]*b.m[0][j] + m[i][1]*b.m[1][j] + m[i][2]*b.m[2][j] + m[i][3]*b.m[3][j];
+		return r;
+	}
+	D3DXMATRIX& operator *= (const D3DXMATRIX& b) {*this = *this * b; return *this;}
+
+	bool operator == (const D3DXMATRIX& b) const
+	{
+		for(int i=0; i<4; i++)
+			for(int j=0; j<4; j++)
+				if(m[i][j] != b.m[i][j]) return false;
+		return true;
+	}
+	bool operator != (const D3DXMATRIX& b) const {return !(*this == b);}
+};
+
+inline FLOAT D3DXVec3Length(const D3DXVECTOR3* v)
+{
+	return sqrtf(v->x*v->x + v->y*v->y + v->z*v->z);
+}
+
+inline FLOAT D3DXVec3LengthSq(const D3DXVECTOR3* v)
+{
+	return v->x*v->x + v->y*v->y + v->z*v->z;
+}
+
+inline FLOAT D3DXVec3Dot(const D3DXVECTOR3* a, const D3DXVECTOR3* b)
+{
+	return a->x*b->x + a->y*b->y + a->z*b->z;
+}
+
+inline D3DXVECTOR3* D3DXVec3Cross(D3DXVECTOR3* out, const D3DXVECTOR3* a, const D3DXVECTOR3* b)
+{
+	D3DXVECTOR3 r(a->y*b->z - a->z*b->y, a->z*b->x - a->x*b->z, a->x*b->y - a->y*b->x);
+	*out = r;
+	return out;
+}
+
+// Like D3DX, a zero-length vector normalizes to zero rather than NaN.
+inline D3DXVECTOR3* D3DXVec3Normalize(D3DXVECTOR3* out, const D3DXVECTOR3* v)
+{
+	FLOAT len = D3DXVec3Length(v);
+	if(len > 0.0f) *out = *v / len;
+	else *out = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	return out;
+}
+
+inline D3DXVECTOR3* D3DXVec3TransformCoord(D3DXVECTOR3* out, const D3DXVECTOR3* v, const D3DXMATRIX* m)
+{
+	FLOAT x = v->x*m->_11 + v->y*m->_21 + v->z*m->_31 + m->_41;
+	FLOAT y = v->x*m->_12 + v->y*m->_22 + v->z*m->_32 + m->_42;
+	FLOAT z = v->x*m->_13 + v->y*m->_23 + v->z*m->_33 + m->_43;
+	FLOAT w = v->x*m->_14 + v->y*m->_24 + v->z*m->_34 + m->_44;
+	*out = D3DXVECTOR3(x/w, y/w, z/w);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixIdentity(D3DXMATRIX* out)
+{
+	*out = D3DXMATRIX(1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixMultiply(D3DXMATRIX* out, const D3DXMATRIX* a, const D3DXMATRIX* b)
+{
+	*out = (*a) * (*b);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixScaling(D3DXMATRIX* out, FLOAT sx, FLOAT sy, FLOAT sz)
+{
+	*out = D3DXMATRIX(sx,0,0,0, 0,sy,0,0, 0,0,sz,0, 0,0,0,1);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixTranslation(D3DXMATRIX* out, FLOAT x, FLOAT y, FLOAT z)
+{
+	*out = D3DXMATRIX(1,0,0,0, 0,1,0,0, 0,0,1,0, x,y,z,1);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixRotationX(D3DXMATRIX* out, FLOAT a)
+{
+	FLOAT c = cosf(a), s = sinf(a);
+	*out = D3DXMATRIX(1,0,0,0, 0,c,s,0, 0,-s,c,0, 0,0,0,1);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixRotationY(D3DXMATRIX* out, FLOAT a)
+{
+	FLOAT c = cosf(a), s = sinf(a);
+	*out = D3DXMATRIX(c,0,-s,0, 0,1,0,0, s,0,c,0, 0,0,0,1);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixRotationZ(D3DXMATRIX* out, FLOAT a)
+{
+	FLOAT c = cosf(a), s = sinf(a);
+	*out = D3DXMATRIX(c,s,0,0, -s,c,0,0, 0,0,1,0, 0,0,0,1);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixLookAtLH(D3DXMATRIX* out, const D3DXVECTOR3* eye, const D3DXVECTOR3* at, const D3DXVECTOR3* up)
+{
+	D3DXVECTOR3 xaxis, yaxis, zaxis;
+	D3DXVECTOR3 look = *at - *eye;
+	D3DXVec3Normalize(&zaxis, &look);
+	D3DXVec3Cross(&xaxis, up, &zaxis);
+	D3DXVec3Normalize(&xaxis, &xaxis);
+	D3DXVec3Cross(&yaxis, &zaxis, &xaxis);
+	*out = D3DXMATRIX(xaxis.x, yaxis.x, zaxis.x, 0,
+					  xaxis.y, yaxis.y, zaxis.y, 0,
+					  xaxis.z, yaxis.z, zaxis.z, 0,
+					  -D3DXVec3Dot(&xaxis, eye), -D3DXVec3Dot(&yaxis, eye), -D3DXVec3Dot(&zaxis, eye), 1);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixPerspectiveFovLH(D3DXMATRIX* out, FLOAT fovy, FLOAT aspect, FLOAT zn, FLOAT zf)
+{
+	FLOAT yScale = 1.0f / tanf(fovy/2.0f);
+	FLOAT xScale = yScale / aspect;
+	*out = D3DXMATRIX(xScale,0,0,0, 0,yScale,0,0, 0,0,zf/(zf-zn),1, 0,0,-zn*zf/(zf-zn),0);
+	return out;
+}
+
+#endif // _WIN32
+
+
+//*****************************************************************************
+// Convenience functions shared by the simulation and the renderer.
+//*****************************************************************************
+
+const float PI       = 3.14159265358979323f;
+const float MATH_EPS = 0.0001f;
+
+// Returns random float in [0, 1).
+inline float RandF()
+{
+	return (float)(rand()) / (float)RAND_MAX;
+}
+
+// Returns random float in [a, b).
+inline float RandF(float a, float b)
+{
+	return a + RandF()*(b-a);
+}
+
+template<typename T>
+inline T Min(const T& a, const T& b)
+{
+	return a < b ? a : b;
+}
+
+template<typename T>
+inline T Max(const T& a, const T& b)
+{
+	return a > b ? a : b;
+}
+
+template<typename T>
+inline T Lerp(const T& a, const T& b, float t)
+{
+	return a + (b-a)*t;
+}
+
+template<typename T>
+inline T Clamp(const T& x, const T& low, const T& high)
+{
+	return x < low ? low : (x > high ? high : x);
+}
+
+#endif // SIMMATH_H
@@ -0,0 +1,18 @@
+#include "SimRandom.h"
+
+unsigned int SimRandom::state = 1;
+
+void SimRandom::seed(unsigned int s)
+{
+	//xorshift sticks at zero
+	state = s ? s : 1;
+}
+
+//xorshift32 (Marsaglia)
+int SimRandom::next()
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (int)(state >> 1);
+}
@@ -0,0 +1,23 @@
+#ifndef SIM_RANDOM_H
+#define SIM_RANDOM_H
+
+namespace simRandomNS {
+	const int MAX = 0x7FFFFFFF;
+}
+
+//The simulation's random numbers. Unlike rand() the sequence is the same on
+//every platform, and nothing outside the simulation draws from it, so a run
+//repeats exactly from its seed (see Replay.h).
+class SimRandom
+{
+public:
+	static void seed(unsigned int s);
+	//0 to simRandomNS::MAX
+	static int next();
+	static unsigned int getState() {return state;}
+
+private:
+	static unsigned int state;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SIMRENDERER_H
+#define SIMRENDERER_H
+
+#include "constants.h"
+
+//Meshes are opaque to the simulation; only the renderer looks inside a Box
+class Box;
+
+//Surface looks the world asks for. The renderer decides what texture each is.
+enum SimMaterial {
+	MATERIAL_BRICK,
+	MATERIAL_BUILDING,
+	MATERIAL_BUILDING2,
+	MATERIAL_ENEMY,
+	MATERIAL_STREET,
+	MATERIAL_ROAD,
+	MATERIAL_BULLET,
+	MATERIAL_BARREL,
+	MATERIAL_RED,
+	MATERIAL_BLUE,
+	MATERIAL_YELLOW,
+	NUM_MATERIALS
+};
+
+//What game objects draw through. The D3D10 game implements it with effect
+//variables; headless runs don't draw at all.
+class SimRenderer
+{
+public:
+	SimRenderer() : interpolation(1.0f) {}
+	virtual ~SimRenderer() {}
+
+	//How far between the last two simulation steps this frame is, 0-1
+	void setInterpolation(float alpha) {interpolation = alpha;}
+	float getInterpolation() {return interpolation;}
+
+	//Used by every drawMesh call until the next setMaterial
+	virtual void setMaterial(int material) = 0;
+	virtual void drawMesh(Box* mesh, const Matrix& world, bool glow) = 0;
+
+protected:
+	float interpolation;
+};
+
+//How big the renderer draws each mesh. A Box is -1 to 1 across and 0 to 2 up
+//times its scale, which is applied in the shader rather than the world
+//matrix, so anything sizing a draw from its matrix asks here too.
+class MeshSizes
+{
+public:
+	virtual ~MeshSizes() {}
+	virtual float getScale(Box* mesh) const = 0;
+};
+
+#endif
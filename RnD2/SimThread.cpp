@@ -0,0 +1,57 @@
+#include "SimThread.h"
+
+SimThread::SimThread()
+{
+	job = 0;
+	arg = 0;
+	quit = 0;
+	busy = false;
+}
+
+SimThread::~SimThread()
+{
+	stop();
+}
+
+bool SimThread::start(Thread::Function j, void* a)
+{
+	if(isRunning()) return false;
+	job = j;
+	arg = a;
+	atomicStore(&quit, 0);
+	return thread.start(loop, this);
+}
+
+void SimThread::stop()
+{
+	if(!isRunning()) return;
+	wait();
+	atomicStore(&quit, 1);
+	go.notify();
+	thread.join();
+}
+
+void SimThread::kick()
+{
+	busy = true;
+	go.notify();
+}
+
+void SimThread::wait()
+{
+	if(!busy) return;
+	done.wait();
+	busy = false;
+}
+
+void SimThread::loop(void* self)
+{
+	SimThread* t = (SimThread*)self;
+	for(;;)
+	{
+		t->go.wait();
+		if(atomicLoad(&t->quit)) break;
+		t->job(t->arg);
+		t->done.notify();
+	}
+}
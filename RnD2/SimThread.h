@@ -0,0 +1,36 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include "Threading.h"
+
+//Runs the simulation a frame at a time on its own thread. Each kick runs the
+//job once; the game kicks the next frame and then draws the last one while it runs.
+class SimThread
+{
+public:
+	SimThread();
+	~SimThread();
+
+	bool start(Thread::Function job, void* arg);
+	//Waits for the running job, then ends the thread
+	void stop();
+	bool isRunning() {return thread.isStarted();}
+
+	//Runs the job once. The last kick has to have been waited for.
+	void kick();
+	//Returns when the kicked job is done, straight away if nothing was kicked
+	void wait();
+
+private:
+	static void loop(void* self);
+
+	Thread thread;
+	Signal go;
+	Signal done;
+	Thread::Function job;
+	void* arg;
+	volatile long quit;
+	bool busy;
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "StaticBatcher.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+
+//Box's faces as its coloured init makes them: normal, then four corners
+static const float FACES[6][5][3] = {
+	{{0, 0, -1}, {-1, 0, -1}, {-1, 2, -1}, {+1, 2, -1}, {+1, 0, -1}},	//front
+	{{-1, 0, 0}, {-1, 0, +1}, {-1, 2, +1}, {-1, 2, -1}, {-1, 0, -1}},	//left
+	{{0, 0, +1}, {+1, 0, +1}, {+1, 2, +1}, {-1, 2, +1}, {-1, 0, +1}},	//back
+	{{+1, 0, 0}, {+1, 0, -1}, {+1, 2, -1}, {+1, 2, +1}, {+1, 0, +1}},	//right
+	{{0, +1, 0}, {-1, 2, -1}, {-1, 2, +1}, {+1, 2, +1}, {+1, 2, -1}},	//top
+	{{0, -1, 0}, {-1, 0, +1}, {-1, 0, -1}, {+1, 0, -1}, {+1, 0, +1}},	//bottom
+};
+//Each corner's texture coordinates as half floats, 0x3c00 being 1
+static const unsigned short FACE_UV_HALF[4][2] = {{0x3c00, 0x3c00}, {0x3c00, 0}, {0, 0}, {0, 0x3c00}};
+
+StaticBatcher::StaticBatcher()
+{
+	material = -1;
+	sizes = 0;
+}
+
+void StaticBatcher::clear()
+{
+	material = -1;
+	meshes.clear();
+	records.clear();
+	order.clear();
+	pieces.clear();
+}
+
+void StaticBatcher::drawMesh(Box* mesh, const Matrix& world, bool)
+{
+	using namespace staticBatchNS;
+	Record r;
+	r.mesh = mesh;
+	r.meshId = std::find(meshes.begin(), meshes.end(), mesh) - meshes.begin();
+	if(r.meshId == (int)meshes.size()) meshes.push_back(mesh);
+	r.material = material;
+	//Pieces draw at a scale of 1, so the mesh's own goes in the matrix
+	r.world = world;
+	float scale = sizes ? sizes->getScale(mesh) : 1.0f;
+	if(scale != 1.0f)
+		for(int i=0; i<3; i++)
+			for(int j=0; j<3; j++)
+				r.world.m[i][j] *= scale;
+	const Matrix& w = r.world;
+	//The levels sit around the origin, so it's the middle of a chunk rather
+	//than a corner of four. The grid never moves, so a chunk nothing changed
+	//in builds the same pieces again.
+	r.chunkX = (int)floor(w._41 / CHUNK_SIZE + 0.5f);
+	r.chunkZ = (int)floor(w._43 / CHUNK_SIZE + 0.5f);
+	//Box is 2 across and 2 high, so the half-extents are the axis lengths
+	float ex = sqrt(w._11*w._11 + w._12*w._12 + w._13*w._13);
+	float ey = sqrt(w._21*w._21 + w._22*w._22 + w._23*w._23);
+	float ez = sqrt(w._31*w._31 + w._32*w._32 + w._33*w._33);
+	int big = (ex >= OCCLUDER_HALF_EXTENT) + (ey >= OCCLUDER_HALF_EXTENT) + (ez >= OCCLUDER_HALF_EXTENT);
+	r.occluder = big >= 2;
+	records.push_back(r);
+}
+
+//Material first so a frame binds each texture pair once, then mesh, then
+//chunk; ties keep the order drawn so the same world always builds the same
+bool StaticBatcher::comesBefore(int a, int b)
+{
+	const Record& ra = records[a];
+	const Record& rb = records[b];
+	if(ra.material != rb.material) return ra.material < rb.material;
+	if(ra.meshId != rb.meshId) return ra.meshId < rb.meshId;
+	if(ra.chunkZ != rb.chunkZ) return ra.chunkZ < rb.chunkZ;
+	if(ra.chunkX != rb.chunkX) return ra.chunkX < rb.chunkX;
+	return a < b;
+}
+
+static void hashBytes(unsigned long long& h, const void* data, int size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	for(int i=0; i<size; i++)
+		h = (h ^ p[i]) * 1099511628211ull;
+}
+
+void StaticBatcher::build()
+{
+	PROFILE_ZONE("StaticBatcher::build");
+	using namespace staticBatchNS;
+	int n = records.size();
+	order.resize(n);
+	for(int i=0; i<n; i++)
+		order[i] = i;
+	Compare compare;
+	compare.batcher = this;
+	std::sort(order.begin(), order.end(), compare);
+
+	pieces.clear();
+	for(int i=0; i<n; i++)
+	{
+		const Record& r = records[order[i]];
+		bool start = pieces.empty() || pieces.back().count == MAX_PIECE_BOXES;
+		if(!start)
+		{
+			const Record& last = records[order[i-1]];
+			start = r.material != last.material || r.mesh != last.mesh || r.chunkX != last.chunkX || r.chunkZ != last.chunkZ;
+		}
+		if(start)
+		{
+			StaticPiece p;
+			p.chunkX = r.chunkX;
+			p.chunkZ = r.chunkZ;
+			p.mesh = r.mesh;
+			p.material = r.material;
+			p.first = i;
+			p.count = 0;
+			p.hash = 14695981039346656037ull;
+			hashBytes(p.hash, &r.material, sizeof(r.material));
+			hashBytes(p.hash, &r.mesh, sizeof(r.mesh));
+			pieces.push_back(p);
+		}
+		StaticPiece& p = pieces.back();
+		p.count++;
+		hashBytes(p.hash, &r.world, sizeof(Matrix));
+	}
+
+	//Bounds from each box's centre and half-extents, as FrustumCuller::addMesh
+	for(unsigned int k=0; k<pieces.size(); k++)
+	{
+		StaticPiece& p = pieces[k];
+		Vector3 lo(1e30f, 1e30f, 1e30f), hi(-1e30f, -1e30f, -1e30f);
+		for(int i=0; i<p.count; i++)
+		{
+			const Matrix& w = records[order[p.first + i]].world;
+			Vector3 c(w._21 + w._41, w._22 + w._42, w._23 + w._43);
+			Vector3 h(fabs(w._11) + fabs(w._21) + fabs(w._31),
+				fabs(w._12) + fabs(w._22) + fabs(w._32),
+				fabs(w._13) + fabs(w._23) + fabs(w._33));
+			lo = Vector3(std::min(lo.x, c.x - h.x), std::min(lo.y, c.y - h.y), std::min(lo.z, c.z - h.z));
+			hi = Vector3(std::max(hi.x, c.x + h.x), std::max(hi.y, c.y + h.y), std::max(hi.z, c.z + h.z));
+		}
+		p.centre = (lo + hi)*0.5f;
+		p.halfExtents = (hi - lo)*0.5f;
+	}
+}
+
+//Corners by the whole matrix; normals by its upper 3x3 and normalized, which
+//is right for a box's normals since each lies along one of its axes
+void StaticBatcher::fillVertices(int piece, PackedVertex* out)
+{
+	const StaticPiece& p = pieces[piece];
+	//A zero normal packs as {0, 0}, so these start out agreeing
+	Vector3 lastNormal[6];
+	short packed[6][2];
+	for(int f=0; f<6; f++)
+	{
+		lastNormal[f] = Vector3(0, 0, 0);
+		packed[f][0] = packed[f][1] = 0;
+	}
+	for(int i=0; i<p.count; i++)
+	{
+		const Matrix& w = records[order[p.first + i]].world;
+		for(int f=0; f<6; f++)
+		{
+			const float* n = FACES[f][0];
+			Vector3 normal(n[0]*w._11 + n[1]*w._21 + n[2]*w._31,
+				n[0]*w._12 + n[1]*w._22 + n[2]*w._32,
+				n[0]*w._13 + n[1]*w._23 + n[2]*w._33);
+			D3DXVec3Normalize(&normal, &normal);
+			//Packed once for the face's four corners, and not again while the
+			//boxes are turned the same way, as scenery mostly is
+			if(normal != lastNormal[f]) {
+				lastNormal[f] = normal;
+				packNormal(normal, packed[f]);
+			}
+			for(int c=0; c<4; c++)
+			{
+				Vector3 corner(FACES[f][c+1][0], FACES[f][c+1][1], FACES[f][c+1][2]);
+				D3DXVec3TransformCoord(&corner, &corner, &w);
+				out->pos[0] = corner.x;
+				out->pos[1] = corner.y;
+				out->pos[2] = corner.z;
+				out->normal[0] = packed[f][0];
+				out->normal[1] = packed[f][1];
+				out->color[0] = out->color[1] = out->color[2] = out->color[3] = 255;
+				out->texc[0] = FACE_UV_HALF[c][0];
+				out->texc[1] = FACE_UV_HALF[c][1];
+				out++;
+			}
+		}
+	}
+}
+
+void StaticBatcher::fillIndices(int boxes, unsigned short* out)
+{
+	static const int QUAD[6] = {0, 1, 2, 3, 2, 0};
+	for(int b=0; b<boxes; b++)
+		for(int f=0; f<6; f++)
+			for(int i=0; i<6; i++)
+				*out++ = (unsigned short)(b*staticBatchNS::BOX_VERTICES + f*4 + QUAD[i]);
+}
+
+void StaticBatcher::cull(FrustumCuller* culler, const Matrix& viewProj)
+{
+	culler->setViewProj(viewProj);
+	culler->clear();
+	for(unsigned int i=0; i<pieces.size(); i++)
+		culler->add(pieces[i].centre, pieces[i].halfExtents);
+	culler->cull();
+}
+
+void StaticBatcher::addOccluders(OcclusionCuller* occlusion, const vector<int>& visible)
+{
+	for(unsigned int v=0; v<visible.size(); v++)
+	{
+		const StaticPiece& p = pieces[visible[v]];
+		for(int i=0; i<p.count; i++)
+		{
+			const Record& r = records[order[p.first + i]];
+			if(r.occluder) occlusion->addOccluder(r.world);
+		}
+	}
+}
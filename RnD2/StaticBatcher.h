@@ -0,0 +1,102 @@
+#ifndef STATIC_BATCHER_H
+#define STATIC_BATCHER_H
+
+#include "SimRenderer.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "PackedVertex.h"
+#include <vector>
+using std::vector;
+
+namespace staticBatchNS {
+	//Scenery is grouped into square chunks this wide, so a chunk off screen
+	//costs nothing
+	const float CHUNK_SIZE = 1024.0f;
+	const int BOX_VERTICES = 24;
+	const int BOX_INDICES = 36;
+	//As many boxes as 16-bit indices reach
+	const int MAX_PIECE_BOXES = 65536 / BOX_VERTICES;
+	//A box with two half-extents at least this big can hide things behind it
+	const float OCCLUDER_HALF_EXTENT = 5.0f;
+}
+
+//The boxes of one chunk that share a mesh and material, drawn with one call
+struct StaticPiece
+{
+	int chunkX, chunkZ;
+	Box* mesh;
+	int material;
+	int first;
+	int count;
+	Vector3 centre;
+	Vector3 halfExtents;
+	//Of the boxes in it, so a rebuild can tell which pieces are unchanged
+	unsigned long long hash;
+};
+
+//Stands in as the renderer for the world's scenery and merges it into pieces
+//to be pre-transformed into one vertex and index buffer each. Vertices are
+//filled straight into whatever buffer the caller has, so the whole city is
+//never held twice. Each box's mesh scale goes into its matrix as it's drawn,
+//so pieces draw at a scale of 1.
+//
+//No D3D in here, so the pieces can be checked without a GPU.
+class StaticBatcher : public SimRenderer
+{
+public:
+	StaticBatcher();
+	virtual ~StaticBatcher() {}
+
+	void clear();
+	//Sorts the boxes by material, mesh and chunk and cuts them into pieces
+	void build();
+	//Meshes are as big as this says; NULL leaves them unscaled
+	void setMeshSizes(const MeshSizes* s) {sizes = s;}
+
+	virtual void setMaterial(int m) {material = m;}
+	//Scenery never glows
+	virtual void drawMesh(Box* mesh, const Matrix& world, bool glow);
+
+	int getBoxCount() {return records.size();}
+	int getPieceCount() {return pieces.size();}
+	const StaticPiece& getPiece(int i) {return pieces[i];}
+	//Box k of a piece
+	const Matrix& getWorld(int piece, int k) {return records[order[pieces[piece].first + k]].world;}
+
+	//BOX_VERTICES for each of the piece's boxes, already moved by their world
+	//matrices; white, since the piece's colour is its mesh's
+	void fillVertices(int piece, PackedVertex* out);
+	//A triangle list for that many boxes; the same for every piece
+	static void fillIndices(int boxes, unsigned short* out);
+
+	//Leaves the pieces that may be on screen in the culler's visible list
+	void cull(FrustumCuller* culler, const Matrix& viewProj);
+	//The big boxes of the given pieces, as occluders only
+	void addOccluders(OcclusionCuller* occlusion, const vector<int>& visible);
+
+private:
+	struct Record
+	{
+		Box* mesh;
+		int meshId;
+		int material;
+		int chunkX, chunkZ;
+		bool occluder;
+		Matrix world;
+	};
+	bool comesBefore(int a, int b);
+	struct Compare
+	{
+		StaticBatcher* batcher;
+		bool operator()(int a, int b) const {return batcher->comesBefore(a, b);}
+	};
+
+	int material;
+	const MeshSizes* sizes;
+	vector<Box*> meshes;
+	vector<Record> records;
+	vector<int> order;
+	vector<StaticPiece> pieces;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "TextureData.h"
+
+using namespace textureDataNS;
+
+int TextureData::unitSize(Format f)
+{
+	switch(f)
+	{
+	case BC1: case BC4: return 8;
+	case BC2: case BC3: return 16;
+	default: return 4;
+	}
+}
+
+int TextureData::fullMipCount(int w, int h)
+{
+	int levels = 1;
+	while(w > 1 || h > 1)
+	{
+		w = w > 1 ? w/2 : 1;
+		h = h > 1 ? h/2 : 1;
+		levels++;
+	}
+	return levels;
+}
+
+void TextureData::allocate(int w, int h, int mips, Format f)
+{
+	width = w;
+	height = h;
+	mipLevels = mips;
+	format = f;
+	texels.resize(getMipOffset(mips));
+}
+
+int TextureData::getMipWidth(int level) const
+{
+	int w = width >> level;
+	return w > 0 ? w : 1;
+}
+
+int TextureData::getMipHeight(int level) const
+{
+	int h = height >> level;
+	return h > 0 ? h : 1;
+}
+
+int TextureData::getRowPitch(int level) const
+{
+	int w = getMipWidth(level);
+	if(isCompressed()) w = (w + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	return w * unitSize(format);
+}
+
+int TextureData::getMipSize(int level) const
+{
+	int rows = getMipHeight(level);
+	if(isCompressed()) rows = (rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	return rows * getRowPitch(level);
+}
+
+int TextureData::getMipOffset(int level) const
+{
+	int offset = 0;
+	for(int i=0; i<level; i++)
+		offset += getMipSize(i);
+	return offset;
+}
@@ -0,0 +1,43 @@
+#ifndef TEXTURE_DATA_H
+#define TEXTURE_DATA_H
+
+#include <vector>
+using std::vector;
+
+namespace textureDataNS {
+	//8-bit RGBA texels, or 4x4 blocks of one of the BC formats
+	enum Format {RGBA8, BC1, BC2, BC3, BC4, NUM_FORMATS};
+	const int BLOCK_SIZE = 4;
+}
+
+//A texture's texels as they go to the GPU: every mip level, largest first,
+//each packed tight against the one before
+struct TextureData
+{
+	int width, height;
+	int mipLevels;
+	textureDataNS::Format format;
+	vector<unsigned char> texels;
+
+	TextureData() : width(0), height(0), mipLevels(0), format(textureDataNS::RGBA8) {}
+
+	//Sizes the texels for this many levels of this format
+	void allocate(int w, int h, int mips, textureDataNS::Format f);
+	bool isCompressed() const {return format != textureDataNS::RGBA8;}
+
+	int getMipWidth(int level) const;
+	int getMipHeight(int level) const;
+	//Bytes from one row of texels, or of blocks, to the next
+	int getRowPitch(int level) const;
+	int getMipSize(int level) const;
+	int getMipOffset(int level) const;
+	unsigned char* getMip(int level) {return &texels[getMipOffset(level)];}
+	const unsigned char* getMip(int level) const {return &texels[getMipOffset(level)];}
+
+	//Levels in a full chain down to 1x1
+	static int fullMipCount(int w, int h);
+	//Bytes in one texel, or in one block for the BC formats
+	static int unitSize(textureDataNS::Format f);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "TextureLoader.h"
+#include "ImageDecoder.h"
+
+using namespace textureLoaderNS;
+
+TextureLoader::TextureLoader()
+{
+	numThreads = 0;
+	pending = 0;
+	quit = 0;
+}
+
+TextureLoader::~TextureLoader()
+{
+	stop();
+	for(size_t i=0; i<done.size(); i++)
+		delete done[i];
+	done.clear();
+}
+
+bool TextureLoader::start(int count)
+{
+	if(numThreads) return false;
+	if(count > MAX_THREADS) count = MAX_THREADS;
+	atomicStore(&quit, 0);
+	for(int i=0; i<count; i++)
+	{
+		if(!threads[i].start(workerLoop, this)) break;
+		numThreads++;
+	}
+	return numThreads == count;
+}
+
+void TextureLoader::stop()
+{
+	if(!numThreads) return;
+	atomicStore(&quit, 1);
+	work.post(numThreads);
+	for(int i=0; i<numThreads; i++)
+		threads[i].join();
+	numThreads = 0;
+	for(size_t i=0; i<queued.size(); i++)
+	{
+		delete queued[i];
+		atomicDecrement(&pending);
+	}
+	queued.clear();
+}
+
+void TextureLoader::request(int id, const std::string& path)
+{
+	Request* r = new Request;
+	r->id = id;
+	r->path = path;
+	r->ok = false;
+	atomicIncrement(&pending);
+	if(!numThreads)
+	{
+		decode(r);
+		return;
+	}
+	{
+		ScopedLock lock(mutex);
+		queued.push_back(r);
+	}
+	work.post();
+}
+
+bool TextureLoader::takeDone(int* id, TextureData* out, bool* ok)
+{
+	Request* r;
+	{
+		ScopedLock lock(mutex);
+		if(done.empty()) return false;
+		r = done.front();
+		done.pop_front();
+	}
+	*id = r->id;
+	*ok = r->ok;
+	out->width = r->data.width;
+	out->height = r->data.height;
+	out->mipLevels = r->data.mipLevels;
+	out->format = r->data.format;
+	out->texels.swap(r->data.texels);
+	delete r;
+	atomicDecrement(&pending);
+	return true;
+}
+
+int TextureLoader::getPending()
+{
+	return (int)atomicLoad(&pending);
+}
+
+void TextureLoader::decode(Request* r)
+{
+	r->ok = loadImage(r->path.c_str(), &r->data);
+	ScopedLock lock(mutex);
+	done.push_back(r);
+}
+
+void TextureLoader::workerLoop(void* self)
+{
+	TextureLoader* l = (TextureLoader*)self;
+	for(;;)
+	{
+		l->work.wait();
+		if(atomicLoad(&l->quit)) break;
+		Request* r;
+		{
+			ScopedLock lock(l->mutex);
+			if(l->queued.empty()) continue;
+			r = l->queued.front();
+			l->queued.pop_front();
+		}
+		l->decode(r);
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include "Threading.h"
+#include "TextureData.h"
+#include <deque>
+#include <string>
+
+namespace textureLoaderNS {
+	const int MAX_THREADS = 8;
+}
+
+//Decodes image files on threads of its own, so a texture can be asked for
+//mid-game and turn up a few frames later. These aren't JobSystem jobs: one
+//big file would hold up whoever waits on the job system behind it.
+//
+//	loader.request(id, "bricks.png");
+//	...
+//	while(loader.takeDone(&id, &data, &ok)) upload(id, data);
+class TextureLoader
+{
+public:
+	TextureLoader();
+	//Stops, dropping anything not yet decoded
+	~TextureLoader();
+
+	//With no threads, request() decodes there and then
+	bool start(int threads);
+	void stop();
+
+	//id is the caller's, handed back with the texels
+	void request(int id, const std::string& path);
+	//Hands over one finished request, or returns false if none is done yet.
+	//ok is false if the file was missing or couldn't be decoded.
+	bool takeDone(int* id, TextureData* out, bool* ok);
+	//Requested and not yet taken
+	int getPending();
+
+private:
+	TextureLoader(const TextureLoader&);
+	TextureLoader& operator=(const TextureLoader&);
+
+	struct Request
+	{
+		int id;
+		std::string path;
+		TextureData data;
+		bool ok;
+	};
+
+	static void workerLoop(void* self);
+	void decode(Request* r);
+
+	Thread threads[textureLoaderNS::MAX_THREADS];
+	int numThreads;
+	Mutex mutex;
+	Semaphore work;
+	std::deque<Request*> queued;
+	std::deque<Request*> done;
+	volatile long pending;
+	volatile long quit;
+};
+
+#endif
@@ -2,6 +2,26 @@
 #include <fstream>
 
 using namespace std;
+using namespace textureMgrNS;
+
+// What each TextureData format is on the GPU
+static const DXGI_FORMAT FORMATS[textureDataNS::NUM_FORMATS] =
+{
+	DXGI_FORMAT_R8G8B8A8_UNORM,
+	DXGI_FORMAT_BC1_UNORM,
+	DXGI_FORMAT_BC2_UNORM,
+	DXGI_FORMAT_BC3_UNORM,
+	DXGI_FORMAT_BC4_UNORM,
+};
+
+// The names are all plain ASCII
+static string toPath(const wstring& filename)
+{
+	string path;
+	for(size_t i = 0; i < filename.size(); ++i)
+		path += (char)filename[i];
+	return path;
+}
 
 TextureMgr& GetTextureMgr()
 {
@@ -11,16 +31,18 @@ TextureMgr& GetTextureMgr()
 }
 
 TextureMgr::TextureMgr()
-: md3dDevice(0), mRandomTexRV(0)
+: md3dDevice(0), mRandomTexRV(0), mPlaceholderRV(0)
 {
 }
 
 TextureMgr::~TextureMgr()
 {
+	mLoader.stop();
 	for(size_t i = 0; i < mTextureRVs.size(); ++i)
 		ReleaseCOM(mTextureRVs[i]);
 
 	ReleaseCOM(mRandomTexRV);
+	ReleaseCOM(mPlaceholderRV);
 }
 
 void TextureMgr::init(ID3D10Device* device)
@@ -28,6 +50,12 @@ void TextureMgr::init(ID3D10Device* device)
 	md3dDevice = device;
 
 	buildRandomTex();
+	buildPlaceholderTex();
+	mLoader.start(LOADER_THREADS);
+
+	// Without a pack everything is decoded, just more slowly
+	if( !mPack.open(assetPackNS::DEFAULT_FILE) )
+		OutputDebugStringW(L"TextureMgr: no asset pack, decoding textures instead\n");
 }
 
 void TextureMgr::dumpInfo()const
@@ -47,19 +75,169 @@ ID3D10ShaderResourceView* TextureMgr::getRandomTex()
 	return mRandomTexRV;
 }
 
+TextureId TextureMgr::intern(const wstring& name, bool* existed)
+{
+	unordered_map<wstring, TextureId>::iterator it = mTextureIds.find(name);
+	*existed = it != mTextureIds.end();
+	if(*existed) return it->second;
+
+	TextureId id = (TextureId)mTextureRVs.size();
+	mTextureIds[name] = id;
+	mTextureNames.push_back(name);
+	mTextureRVs.push_back(0);
+	mRequested.push_back(false);
+	return id;
+}
+
+TextureId TextureMgr::getId(wstring filename)
+{
+	bool existed;
+	return intern(filename, &existed);
+}
+
 ID3D10ShaderResourceView* TextureMgr::createTex(wstring filename)
 {
 	// Has this texture already been created?
-	for(size_t i = 0; i < mTextureRVs.size(); ++i)
-		if( mTextureNames[i] == filename )
-			return mTextureRVs[i];
+	bool existed;
+	TextureId id = intern(filename, &existed);
+	if( mTextureRVs[id] )
+		return mTextureRVs[id];
 
-	// If not, create it.
+	// If not, create it. A background load of it still going is thrown away
+	// when it finishes.
 	ID3D10ShaderResourceView* rv = 0;
 	HR(D3DX10CreateShaderResourceViewFromFile(md3dDevice, filename.c_str(), 0, 0, &rv, 0 ));
 
-	mTextureNames.push_back(filename);
-	mTextureRVs.push_back(rv);
+	mTextureRVs[id] = rv;
+
+	return rv;
+}
+
+TextureId TextureMgr::loadTex(wstring filename)
+{
+	bool existed;
+	TextureId id = intern(filename, &existed);
+	if( mTextureRVs[id] || mRequested[id] )
+		return id;
+
+	// Straight from the mapped pack to the GPU; the pages can go after
+	const PackEntry* entry = findPacked(filename);
+	if( entry )
+	{
+		TextureData layout;
+		const unsigned char* texels = mPack.getTexels(entry, &layout);
+		mTextureRVs[id] = upload(layout, texels);
+		mPack.release(entry);
+		return id;
+	}
+
+	mLoader.request(id, toPath(filename));
+	mRequested[id] = true;
+
+	return id;
+}
+
+const PackEntry* TextureMgr::findPacked(const wstring& filename)
+{
+	return mPack.find(toPath(filename).c_str());
+}
+
+bool TextureMgr::getPackedLayout(TextureId id, TextureData* layout)
+{
+	if( id < 0 || id >= (TextureId)mTextureNames.size() )
+		return false;
+	const PackEntry* entry = findPacked(mTextureNames[id]);
+	if( !entry )
+		return false;
+	mPack.getTexels(entry, layout);
+	return true;
+}
+
+ID3D10ShaderResourceView* TextureMgr::getTex(TextureId id)
+{
+	if( id < 0 || id >= (TextureId)mTextureRVs.size() || !mTextureRVs[id] )
+		return mPlaceholderRV;
+	return mTextureRVs[id];
+}
+
+bool TextureMgr::isReady(TextureId id)
+{
+	return id >= 0 && id < (TextureId)mTextureRVs.size() && mTextureRVs[id] != 0;
+}
+
+void TextureMgr::update(int maxUploads)
+{
+	int id;
+	bool ok;
+	TextureData data;
+	for(int i = 0; i < maxUploads && mLoader.takeDone(&id, &data, &ok); ++i)
+	{
+		if( !ok )
+		{
+			wstring msg = L"TextureMgr: could not load " + mTextureNames[id] + L"\n";
+			OutputDebugStringW(msg.c_str());
+			continue;
+		}
+		if( !mTextureRVs[id] )
+			mTextureRVs[id] = upload(data, &data.texels[0]);
+	}
+}
+
+ID3D10ShaderResourceView* TextureMgr::upload(const TextureData& data, const unsigned char* texels)
+{
+	D3D10_TEXTURE2D_DESC texDesc;
+	texDesc.Width              = data.width;
+	texDesc.Height             = data.height;
+	texDesc.ArraySize          = 1;
+	texDesc.Format             = FORMATS[data.format];
+	texDesc.SampleDesc.Count   = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.CPUAccessFlags     = 0;
+
+	ID3D10Texture2D* tex = 0;
+	bool generateMips = !data.isCompressed() && data.mipLevels == 1;
+	if( generateMips )
+	{
+		// A PNG or JPEG is one level; the GPU makes the rest, which needs
+		// a texture it can render to
+		texDesc.MipLevels = 0;
+		texDesc.Usage     = D3D10_USAGE_DEFAULT;
+		texDesc.BindFlags = D3D10_BIND_SHADER_RESOURCE | D3D10_BIND_RENDER_TARGET;
+		texDesc.MiscFlags = D3D10_RESOURCE_MISC_GENERATE_MIPS;
+		HR(md3dDevice->CreateTexture2D(&texDesc, 0, &tex));
+		md3dDevice->UpdateSubresource(tex, 0, 0, texels, data.getRowPitch(0), 0);
+	}
+	else
+	{
+		// Every level is in the file already
+		vector<D3D10_SUBRESOURCE_DATA> initData(data.mipLevels);
+		for(int i = 0; i < data.mipLevels; ++i)
+		{
+			initData[i].pSysMem          = texels + data.getMipOffset(i);
+			initData[i].SysMemPitch      = data.getRowPitch(i);
+			initData[i].SysMemSlicePitch = data.getMipSize(i);
+		}
+		texDesc.MipLevels = data.mipLevels;
+		texDesc.Usage     = D3D10_USAGE_IMMUTABLE;
+		texDesc.BindFlags = D3D10_BIND_SHADER_RESOURCE;
+		texDesc.MiscFlags = 0;
+		HR(md3dDevice->CreateTexture2D(&texDesc, &initData[0], &tex));
+	}
+	if( !tex )
+		return 0;
+
+	D3D10_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	viewDesc.Format = texDesc.Format;
+	viewDesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2D;
+	viewDesc.Texture2D.MostDetailedMip = 0;
+	viewDesc.Texture2D.MipLevels = (UINT)-1;
+
+	ID3D10ShaderResourceView* rv = 0;
+	HR(md3dDevice->CreateShaderResourceView(tex, &viewDesc, &rv));
+	if( rv && generateMips )
+		md3dDevice->GenerateMips(rv);
+
+	ReleaseCOM(tex);
 
 	return rv;
 }
@@ -69,9 +247,26 @@ ID3D10ShaderResourceView* TextureMgr::createTexArray(wstring arrayName, const St
 	//
 	// Has this texture already been created?
 	//
-	for(size_t i = 0; i < mTextureRVs.size(); ++i)
-		if( mTextureNames[i] == arrayName )
-			return mTextureRVs[i];
+	bool existed;
+	TextureId id = intern(arrayName, &existed);
+	if( mTextureRVs[id] )
+		return mTextureRVs[id];
+
+	// Every slice from the pack if they're all there and alike
+	vector<const PackEntry*> entries;
+	for(size_t i = 0; i < filenames.size(); ++i)
+	{
+		const PackEntry* e = findPacked(filenames[i]);
+		if( !e || (i > 0 && (e->width != entries[0]->width || e->height != entries[0]->height ||
+			e->mipLevels != entries[0]->mipLevels || e->format != entries[0]->format)) )
+			break;
+		entries.push_back(e);
+	}
+	if( !entries.empty() && entries.size() == filenames.size() )
+	{
+		mTextureRVs[id] = uploadArray(entries);
+		return mTextureRVs[id];
+	}
 
 	//
 	// Load the texture elements individually from file.  These textures
@@ -174,18 +369,73 @@ ID3D10ShaderResourceView* TextureMgr::createTexArray(wstring arrayName, const St
 	for(UINT i = 0; i < arraySize; ++i)
 		ReleaseCOM(srcTex[i]); 
 
-	mTextureNames.push_back(arrayName);
-	mTextureRVs.push_back(texArrayRV);
+	mTextureRVs[id] = texArrayRV;
 
 	return texArrayRV;
 }
 
+ID3D10ShaderResourceView* TextureMgr::uploadArray(const vector<const PackEntry*>& entries)
+{
+	// Subresources go mip by mip within a slice, slice after slice
+	TextureData layout;
+	UINT arraySize = (UINT)entries.size();
+	vector<D3D10_SUBRESOURCE_DATA> initData;
+	for(UINT i = 0; i < arraySize; ++i)
+	{
+		const unsigned char* texels = mPack.getTexels(entries[i], &layout);
+		for(int j = 0; j < layout.mipLevels; ++j)
+		{
+			D3D10_SUBRESOURCE_DATA d;
+			d.pSysMem          = texels + layout.getMipOffset(j);
+			d.SysMemPitch      = layout.getRowPitch(j);
+			d.SysMemSlicePitch = layout.getMipSize(j);
+			initData.push_back(d);
+		}
+	}
+
+	D3D10_TEXTURE2D_DESC texArrayDesc;
+	texArrayDesc.Width              = layout.width;
+	texArrayDesc.Height             = layout.height;
+	texArrayDesc.MipLevels          = layout.mipLevels;
+	texArrayDesc.ArraySize          = arraySize;
+	texArrayDesc.Format             = FORMATS[layout.format];
+	texArrayDesc.SampleDesc.Count   = 1;
+	texArrayDesc.SampleDesc.Quality = 0;
+	texArrayDesc.Usage              = D3D10_USAGE_IMMUTABLE;
+	texArrayDesc.BindFlags          = D3D10_BIND_SHADER_RESOURCE;
+	texArrayDesc.CPUAccessFlags     = 0;
+	texArrayDesc.MiscFlags          = 0;
+
+	ID3D10Texture2D* texArray = 0;
+	HR(md3dDevice->CreateTexture2D(&texArrayDesc, &initData[0], &texArray));
+	for(UINT i = 0; i < arraySize; ++i)
+		mPack.release(entries[i]);
+	if( !texArray )
+		return 0;
+
+	D3D10_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	viewDesc.Format = texArrayDesc.Format;
+	viewDesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2DARRAY;
+	viewDesc.Texture2DArray.MostDetailedMip = 0;
+	viewDesc.Texture2DArray.MipLevels = texArrayDesc.MipLevels;
+	viewDesc.Texture2DArray.FirstArraySlice = 0;
+	viewDesc.Texture2DArray.ArraySize = arraySize;
+
+	ID3D10ShaderResourceView* rv = 0;
+	HR(md3dDevice->CreateShaderResourceView(texArray, &viewDesc, &rv));
+
+	ReleaseCOM(texArray);
+
+	return rv;
+}
+
 ID3D10ShaderResourceView* TextureMgr::createCubeTex(std::wstring filename)
 {
 	// Has this texture already been created?
-	for(size_t i = 0; i < mTextureRVs.size(); ++i)
-		if( mTextureNames[i] == filename )
-			return mTextureRVs[i];
+	bool existed;
+	TextureId id = intern(filename, &existed);
+	if( mTextureRVs[id] )
+		return mTextureRVs[id];
 
 	// If not, create it.
 	D3DX10_IMAGE_LOAD_INFO loadInfo;
@@ -209,8 +459,7 @@ ID3D10ShaderResourceView* TextureMgr::createCubeTex(std::wstring filename)
    
 	ReleaseCOM(tex);
 
-	mTextureNames.push_back(filename);
-	mTextureRVs.push_back(rv);
+	mTextureRVs[id] = rv;
 
 	return rv;
 }
@@ -261,4 +510,34 @@ void TextureMgr::buildRandomTex()
     HR(md3dDevice->CreateShaderResourceView(randomTex, &viewDesc, &mRandomTexRV));
 
 	ReleaseCOM(randomTex);
-}
\ No newline at end of file
+}
+
+void TextureMgr::buildPlaceholderTex()
+{
+	// One opaque black texel
+	const unsigned int black = 0xff000000;
+
+	D3D10_SUBRESOURCE_DATA initData;
+	initData.pSysMem = &black;
+	initData.SysMemPitch = sizeof(black);
+	initData.SysMemSlicePitch = sizeof(black);
+
+	D3D10_TEXTURE2D_DESC texDesc;
+	texDesc.Width = 1;
+	texDesc.Height = 1;
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = 1;
+	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Usage = D3D10_USAGE_IMMUTABLE;
+	texDesc.BindFlags = D3D10_BIND_SHADER_RESOURCE;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = 0;
+
+	ID3D10Texture2D* tex = 0;
+	HR(md3dDevice->CreateTexture2D(&texDesc, &initData, &tex));
+	HR(md3dDevice->CreateShaderResourceView(tex, 0, &mPlaceholderRV));
+
+	ReleaseCOM(tex);
+}
@@ -2,8 +2,23 @@
 #define TEXTUREMGR_H
 
 #include "d3dUtil.h"
+#include "TextureLoader.h"
+#include "AssetPack.h"
 #include <vector>
 #include <string>
+#include <unordered_map>
+
+//An interned texture name; the same file always gets the same one
+typedef int TextureId;
+
+namespace textureMgrNS {
+	const TextureId NO_TEXTURE = -1;
+	//Decoding threads, so loads don't hold up the job system's workers for long
+	const int LOADER_THREADS = 2;
+	//Textures made from decoded files per update(), so a burst of them is
+	//spread over a few frames
+	const int UPLOADS_PER_FRAME = 4;
+}
 
 class TextureMgr
 {
@@ -18,6 +33,9 @@ public:
 
 	ID3D10ShaderResourceView* getRandomTex();
 	ID3D10ShaderResourceView* createTex(std::wstring filename);
+	// Slices come straight from the asset pack when every file is in it with
+	// the same size, mips and format; otherwise they're loaded with D3DX,
+	// which needs files of one size.
 	ID3D10ShaderResourceView* createTexArray(
 		std::wstring arrayName, 
 		const std::vector<std::wstring>& filenames);
@@ -25,6 +43,25 @@ public:
 	// .dds files can store cube textures in one file
 	ID3D10ShaderResourceView* createCubeTex(std::wstring filename);
 
+	// Uploads the file from the asset pack if it's in there. If not, starts
+	// decoding it in the background and returns straight away; getTex gives a
+	// 1x1 black texture, which adds nothing to the lit colour, until update()
+	// has made the real one.
+	TextureId loadTex(std::wstring filename);
+	// The file's id without loading it, for a texture that may only be used
+	// as a slice of an array; loadTex it later if it's wanted on its own
+	TextureId getId(std::wstring filename);
+	ID3D10ShaderResourceView* getTex(TextureId id);
+	bool isReady(TextureId id);
+	const std::wstring& getName(TextureId id) {return mTextureNames[id];}
+	// The size, mips and format the texture has in the asset pack; false if
+	// it isn't in it
+	bool getPackedLayout(TextureId id, TextureData* layout);
+	int getPendingCount() {return mLoader.getPending();}
+
+	// Makes textures from files that have finished decoding. Call once a
+	// frame on the render thread; the device isn't to be used from the loader's.
+	void update(int maxUploads = textureMgrNS::UPLOADS_PER_FRAME);
 
 private:
 	TextureMgr();
@@ -33,16 +70,31 @@ private:
 	~TextureMgr();
 
 	void buildRandomTex();
+	void buildPlaceholderTex();
+	// The name's id, and whether it was already there
+	TextureId intern(const std::wstring& name, bool* existed);
+	// layout gives the sizes and texels the data, which may be in the pack
+	ID3D10ShaderResourceView* upload(const TextureData& layout, const unsigned char* texels);
+	// A Texture2DArray with a slice from the pack for each entry
+	ID3D10ShaderResourceView* uploadArray(const std::vector<const PackEntry*>& entries);
+	// The pack's entry for a file, if it has one
+	const PackEntry* findPacked(const std::wstring& filename);
 
 private:
 	ID3D10Device* md3dDevice;
 
 	StringVector mTextureNames;
 	std::vector<ID3D10ShaderResourceView*> mTextureRVs;
+	// Given to the loader, so loadTex doesn't ask twice
+	std::vector<bool> mRequested;
+	std::unordered_map<std::wstring, TextureId> mTextureIds;
 
 	ID3D10ShaderResourceView* mRandomTexRV;
+	ID3D10ShaderResourceView* mPlaceholderRV;
+	TextureLoader mLoader;
+	AssetPack mPack;
 };
 
 TextureMgr& GetTextureMgr();
 
-#endif // TEXTUREMGR_H
\ No newline at end of file
+#endif // TEXTUREMGR_H
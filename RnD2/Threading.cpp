@@ -0,0 +1,166 @@
+#include "Threading.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+Thread::Thread()
+{
+	started = false;
+	function = 0;
+	arg = 0;
+}
+
+Thread::~Thread()
+{
+	join();
+}
+
+bool Thread::start(Function f, void* a)
+{
+	if(started) return false;
+	function = f;
+	arg = a;
+#ifdef _WIN32
+	//_beginthreadex rather than CreateThread so the CRT sets itself up for the thread
+	handle = (HANDLE)_beginthreadex(0, 0, entry, this, 0, 0);
+	started = handle != 0;
+#else
+	started = pthread_create(&handle, 0, entry, this) == 0;
+#endif
+	return started;
+}
+
+void Thread::join()
+{
+	if(!started) return;
+#ifdef _WIN32
+	WaitForSingleObject(handle, INFINITE);
+	CloseHandle(handle);
+#else
+	pthread_join(handle, 0);
+#endif
+	started = false;
+}
+
+#ifdef _WIN32
+unsigned __stdcall Thread::entry(void* self)
+{
+	Thread* t = (Thread*)self;
+	t->function(t->arg);
+	return 0;
+}
+#else
+void* Thread::entry(void* self)
+{
+	Thread* t = (Thread*)self;
+	t->function(t->arg);
+	return 0;
+}
+#endif
+
+void Thread::yield()
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+int Thread::getCoreCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	int n = (int)info.dwNumberOfProcessors;
+#else
+	int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return n > 0 ? n : 1;
+}
+
+#ifdef _WIN32
+Mutex::Mutex() {InitializeCriticalSection(&cs);}
+Mutex::~Mutex() {DeleteCriticalSection(&cs);}
+void Mutex::lock() {EnterCriticalSection(&cs);}
+void Mutex::unlock() {LeaveCriticalSection(&cs);}
+
+Signal::Signal() {event = CreateEvent(0, FALSE, FALSE, 0);}
+Signal::~Signal() {CloseHandle(event);}
+void Signal::notify() {SetEvent(event);}
+void Signal::wait() {WaitForSingleObject(event, INFINITE);}
+
+Semaphore::Semaphore() {semaphore = CreateSemaphore(0, 0, 0x7FFFFFFF, 0);}
+Semaphore::~Semaphore() {CloseHandle(semaphore);}
+void Semaphore::post(int n) {if(n > 0) ReleaseSemaphore(semaphore, n, 0);}
+void Semaphore::wait() {WaitForSingleObject(semaphore, INFINITE);}
+#else
+Mutex::Mutex() {pthread_mutex_init(&mutex, 0);}
+Mutex::~Mutex() {pthread_mutex_destroy(&mutex);}
+void Mutex::lock() {pthread_mutex_lock(&mutex);}
+void Mutex::unlock() {pthread_mutex_unlock(&mutex);}
+
+Signal::Signal()
+{
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&cond, 0);
+	set = false;
+}
+
+Signal::~Signal()
+{
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+void Signal::notify()
+{
+	pthread_mutex_lock(&mutex);
+	set = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void Signal::wait()
+{
+	pthread_mutex_lock(&mutex);
+	while(!set) pthread_cond_wait(&cond, &mutex);
+	set = false;
+	pthread_mutex_unlock(&mutex);
+}
+
+Semaphore::Semaphore()
+{
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&cond, 0);
+	count = 0;
+}
+
+Semaphore::~Semaphore()
+{
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+void Semaphore::post(int n)
+{
+	if(n <= 0) return;
+	pthread_mutex_lock(&mutex);
+	count += n;
+	if(n == 1) pthread_cond_signal(&cond);
+	else pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void Semaphore::wait()
+{
+	pthread_mutex_lock(&mutex);
+	while(count == 0) pthread_cond_wait(&cond, &mutex);
+	count--;
+	pthread_mutex_unlock(&mutex);
+}
+#endif
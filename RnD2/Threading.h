@@ -0,0 +1,159 @@
+//=======================================================================================
+// Threading.h
+//
+// The little threading the game needs, on Win32 or pthreads: atomics on a long,
+// thread-local variables, a thread, a mutex, a wake-up signal and a semaphore.
+// VS2010 has no <thread> or <atomic>.
+//=======================================================================================
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#ifdef _WIN32
+#include <windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#define THREAD_LOCAL __thread
+#endif
+
+//All of these are full barriers except the plain load and store, which only
+//order against the memory around them (acquire and release)
+#ifdef _WIN32
+inline long atomicIncrement(volatile long* v) {return InterlockedIncrement(v);}
+inline long atomicDecrement(volatile long* v) {return InterlockedDecrement(v);}
+inline long atomicAdd(volatile long* v, long n) {return InterlockedExchangeAdd(v, n) + n;}
+inline long atomicExchange(volatile long* v, long x) {return InterlockedExchange(v, x);}
+//Stores x if *v was expected; returns what *v was
+inline long atomicCompareExchange(volatile long* v, long x, long expected) {return InterlockedCompareExchange(v, x, expected);}
+//x86 loads and stores already have acquire/release order; these keep the compiler honest
+inline long atomicLoad(volatile long* v) {long x = *v; _ReadWriteBarrier(); return x;}
+inline void atomicStore(volatile long* v, long x) {_ReadWriteBarrier(); *v = x;}
+//64 bits even where a long is 32, for clock counts
+inline long long atomicAdd64(volatile long long* v, long long n) {return InterlockedExchangeAdd64(v, n) + n;}
+inline long long atomicExchange64(volatile long long* v, long long x) {return InterlockedExchange64(v, x);}
+#else
+inline long atomicIncrement(volatile long* v) {return __atomic_add_fetch(v, 1, __ATOMIC_SEQ_CST);}
+inline long atomicDecrement(volatile long* v) {return __atomic_sub_fetch(v, 1, __ATOMIC_SEQ_CST);}
+inline long atomicAdd(volatile long* v, long n) {return __atomic_add_fetch(v, n, __ATOMIC_SEQ_CST);}
+inline long atomicExchange(volatile long* v, long x) {return __atomic_exchange_n(v, x, __ATOMIC_SEQ_CST);}
+inline long atomicCompareExchange(volatile long* v, long x, long expected)
+{
+	__atomic_compare_exchange_n(v, &expected, x, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return expected;
+}
+inline long atomicLoad(volatile long* v) {return __atomic_load_n(v, __ATOMIC_ACQUIRE);}
+inline void atomicStore(volatile long* v, long x) {__atomic_store_n(v, x, __ATOMIC_RELEASE);}
+inline long long atomicAdd64(volatile long long* v, long long n) {return __atomic_add_fetch(v, n, __ATOMIC_SEQ_CST);}
+inline long long atomicExchange64(volatile long long* v, long long x) {return __atomic_exchange_n(v, x, __ATOMIC_SEQ_CST);}
+#endif
+
+class Thread
+{
+public:
+	typedef void (*Function)(void* arg);
+
+	Thread();
+	//Joins, so a running thread has to be told to finish first
+	~Thread();
+
+	bool start(Function f, void* arg);
+	void join();
+	bool isStarted() {return started;}
+
+	//Gives the rest of this time slice to another thread
+	static void yield();
+	static int getCoreCount();
+
+private:
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+
+#ifdef _WIN32
+	static unsigned __stdcall entry(void* self);
+	HANDLE handle;
+#else
+	static void* entry(void* self);
+	pthread_t handle;
+#endif
+	bool started;
+	Function function;
+	void* arg;
+};
+
+class Mutex
+{
+public:
+	Mutex();
+	~Mutex();
+	void lock();
+	void unlock();
+
+private:
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+
+#ifdef _WIN32
+	CRITICAL_SECTION cs;
+#else
+	pthread_mutex_t mutex;
+#endif
+};
+
+class ScopedLock
+{
+public:
+	ScopedLock(Mutex& m) : mutex(m) {mutex.lock();}
+	~ScopedLock() {mutex.unlock();}
+
+private:
+	ScopedLock& operator=(const ScopedLock&);
+	Mutex& mutex;
+};
+
+//Auto-reset: each wait() returns once per notify(). A notify with nobody
+//waiting is kept for the next wait, but notifies don't add up.
+class Signal
+{
+public:
+	Signal();
+	~Signal();
+	void notify();
+	void wait();
+
+private:
+	Signal(const Signal&);
+	Signal& operator=(const Signal&);
+
+#ifdef _WIN32
+	HANDLE event;
+#else
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool set;
+#endif
+};
+
+//Counts posts; each wait takes one, sleeping until there is one to take
+class Semaphore
+{
+public:
+	Semaphore();
+	~Semaphore();
+	void post(int n = 1);
+	void wait();
+
+private:
+	Semaphore(const Semaphore&);
+	Semaphore& operator=(const Semaphore&);
+
+#ifdef _WIN32
+	HANDLE semaphore;
+#else
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+#endif
+};
+
+#endif
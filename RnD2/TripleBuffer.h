@@ -0,0 +1,46 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include "Threading.h"
+
+//Hands whole objects from one writer thread to one reader thread without
+//locks. The writer fills its slot and publishes it; the reader takes the newest
+//published slot. Neither ever waits, and the writer can publish again while the
+//reader still holds the last one. A slot that was never read is just reused.
+template <class T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : writeSlot(0), readSlot(1), latest(2) {}
+
+	//Writer
+	T& getWriteBuffer() {return slots[writeSlot];}
+	void publish()
+	{
+		writeSlot = atomicExchange(&latest, writeSlot | FRESH) & ~FRESH;
+	}
+
+	//Reader. True if there was something newer than the last acquire; either
+	//way getReadBuffer is the newest the reader has.
+	bool acquire()
+	{
+		if(!(atomicLoad(&latest) & FRESH)) return false;
+		readSlot = atomicExchange(&latest, readSlot) & ~FRESH;
+		return true;
+	}
+	const T& getReadBuffer() {return slots[readSlot];}
+
+private:
+	TripleBuffer(const TripleBuffer&);
+	TripleBuffer& operator=(const TripleBuffer&);
+
+	//Set on latest while it holds a slot the reader hasn't taken
+	static const long FRESH = 4;
+
+	T slots[3];
+	long writeSlot;			//only the writer touches this
+	long readSlot;			//only the reader touches this
+	volatile long latest;	//the one in between, swapped with the other two
+};
+
+#endif
@@ -4,12 +4,21 @@
 #define VERTEX_H
 
 #include "d3dUtil.h"
+#include "PackedVertex.h"
 
 struct Vertex
 {
 	Vertex(D3DXVECTOR3 p, D3DXVECTOR3 n, D3DXCOLOR d, D3DXCOLOR s, D3DXVECTOR2 t):
 		pos(p), normal(n), diffuse(d), spec(s), texc(t) {}
-	Vertex(D3DXVECTOR3 p, D3DXCOLOR c): pos(p), diffuse(c), spec(c) {}
+	Vertex(D3DXVECTOR3 p, D3DXCOLOR c): pos(p), normal(0.0f, 0.0f, 0.0f), diffuse(c), spec(c), texc(0.0f, 0.0f) {}
+	//What goes in the vertex buffer. spec is left behind: every mesh gives it
+	//the diffuse colour, and lighting.fx uses the one colour for both.
+	PackedVertex pack() const
+	{
+		PackedVertex p;
+		packVertex(pos, normal, diffuse, texc.x, texc.y, &p);
+		return p;
+	}
 	D3DXVECTOR3 pos;
 	D3DXVECTOR3 normal;
 	D3DXCOLOR   diffuse;
@@ -0,0 +1,81 @@
+#include "WaveDirector.h"
+
+WaveDirector::WaveDirector()
+{
+	pacing.baseCount = waveNS::BASE_COUNT;
+	pacing.perNight = waveNS::PER_NIGHT;
+	pacing.spawnInterval = waveNS::SPAWN_INTERVAL;
+	budgetMs = waveNS::BUDGET_MS;
+	capacity = waveNS::MIN_ACTIVE;
+	reset();
+}
+
+void WaveDirector::reset()
+{
+	waveRunning = false;
+	queued = 0;
+	sinceLastSpawn = 0.0f;
+	costPerEnemy = 0.0f;
+	targetActive = capacity;
+}
+
+void WaveDirector::startWave(int nightCount)
+{
+	waveRunning = true;
+	queued += pacing.baseCount + pacing.perNight*nightCount;
+	//Let the first one out straight away
+	sinceLastSpawn = pacing.spawnInterval;
+}
+
+void WaveDirector::endWave()
+{
+	waveRunning = false;
+	queued = 0;
+}
+
+void WaveDirector::recordCost(float ms, int activeEnemies)
+{
+	if(activeEnemies <= 0) return;
+	float sample = ms / activeEnemies;
+	if(costPerEnemy <= 0.0f) costPerEnemy = sample;
+	else costPerEnemy += (sample - costPerEnemy) * waveNS::COST_SMOOTHING;
+}
+
+int WaveDirector::update(float dt, int activeEnemies)
+{
+	//Until there's a measurement assume everything fits. No budget means no limit.
+	if(costPerEnemy > 0.0f && budgetMs > 0.0f) targetActive = (int)(budgetMs / costPerEnemy);
+	else targetActive = capacity;
+	if(targetActive > capacity) targetActive = capacity;
+	if(targetActive < waveNS::MIN_ACTIVE) targetActive = waveNS::MIN_ACTIVE;
+
+	if(!waveRunning) return 0;
+	sinceLastSpawn += dt;
+	if(sinceLastSpawn < pacing.spawnInterval) return 0;
+
+	if(activeEnemies > targetActive + waveNS::RETIRE_SLACK)
+	{
+		sinceLastSpawn = 0.0f;
+		return -1;
+	}
+	if(queued > 0 && activeEnemies < targetActive)
+	{
+		sinceLastSpawn = 0.0f;
+		//With no interval, release everything that fits at once
+		if(pacing.spawnInterval <= 0.0f)
+			return (queued < targetActive - activeEnemies) ? queued : targetActive - activeEnemies;
+		return 1;
+	}
+	return 0;
+}
+
+void WaveDirector::spawned(int n)
+{
+	queued -= n;
+	if(queued < 0) queued = 0;
+}
+
+void WaveDirector::retired(int n)
+{
+	queued += n;
+}
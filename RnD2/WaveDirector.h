@@ -0,0 +1,76 @@
+#ifndef WAVE_DIRECTOR_H
+#define WAVE_DIRECTOR_H
+
+namespace waveNS {
+	//Pacing: a night's wave is BASE_COUNT + PER_NIGHT*nightCount enemies, let out
+	//one every SPAWN_INTERVAL seconds
+	const int BASE_COUNT = 4;
+	const int PER_NIGHT = 4;
+	const float SPAWN_INTERVAL = 0.5f;
+
+	//Budget: how many ms of enemy simulation a frame may spend
+	const float BUDGET_MS = 2.0f;
+	//Never throttle below this many enemies, however slow the machine
+	const int MIN_ACTIVE = 4;
+	//Retire extra enemies this much over the target, so noise doesn't cause churn
+	const int RETIRE_SLACK = 2;
+	//Only enemies at least this far from the player get retired
+	const float RETIRE_DISTANCE = 150.0f;
+	//Weight of the newest sample in the rolling per-enemy cost
+	const float COST_SMOOTHING = 0.05f;
+}
+
+//Difficulty pacing, independent of the performance budget
+struct WavePacing
+{
+	int baseCount;
+	int perNight;
+	float spawnInterval;
+};
+
+//Decides how many enemies are out at once. Spawns for a night are queued and
+//released while the measured cost per enemy says they fit in the budget.
+class WaveDirector
+{
+public:
+	WaveDirector();
+
+	void setPacing(const WavePacing& p) {pacing = p;}
+	const WavePacing& getPacing() {return pacing;}
+	//Zero or less lets out everything up to capacity, whatever it costs
+	void setBudget(float ms) {budgetMs = ms;}
+	float getBudget() {return budgetMs;}
+	void setCapacity(int c) {capacity = c;}
+
+	//Queues the spawns for this night's wave
+	void startWave(int nightCount);
+	//Drops whatever is still queued when the night ends
+	void endWave();
+	void reset();
+
+	//Feed in how long the enemy update and collision passes took this frame
+	void recordCost(float ms, int activeEnemies);
+
+	//Positive: this many queued enemies can spawn now.
+	//Negative: retire this many and they go back on the queue.
+	int update(float dt, int activeEnemies);
+	void spawned(int n);
+	void retired(int n);
+
+	int getQueued() {return queued;}
+	int getTargetActive() {return targetActive;}
+	float getCostPerEnemy() {return costPerEnemy;}
+
+private:
+	WavePacing pacing;
+	float budgetMs;
+	int capacity;
+
+	bool waveRunning;
+	int queued;
+	float sinceLastSpawn;
+	float costPerEnemy;
+	int targetActive;
+};
+
+#endif
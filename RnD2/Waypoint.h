@@ -1,7 +1,7 @@
 #ifndef __WAYPOINT_H
 #define __WAYPOINT_H
 
-#include "d3dUtil.h"
+#include "constants.h"
 #include <list>
 using std::list;
 #include <vector>
@@ -28,6 +28,8 @@ public:
 		pos = w.pos;
 		adjacentWaypoints = w.adjacentWaypoints;
 		parent = w.parent;
+		active = w.active;
+		containedIn = w.containedIn;
 	}
 
 	Waypoint& operator=(const Waypoint& w)
@@ -37,6 +39,8 @@ public:
 		pos = w.pos;
 		adjacentWaypoints = w.adjacentWaypoints;
 		parent = w.parent;
+		active = w.active;
+		containedIn = w.containedIn;
 		return *this;
 	}
 
@@ -50,7 +54,7 @@ public:
 	void setActive(bool a){active = a;}
 
 	void addNeighbor(Waypoint* n){adjacentWaypoints.push_back(n);}
-	vector<Waypoint*> getNeighbors(){return adjacentWaypoints;}
+	const vector<Waypoint*>& getNeighbors(){return adjacentWaypoints;}
 
 	float getFCost() const{return fCost;}
 	void setFCost(const float& f){fCost = f;}
@@ -0,0 +1,1160 @@
+#include "World.h"
+#include "Profiler.h"
+#include "PerfStats.h"
+#include "SimRandom.h"
+#include "JobSystem.h"
+
+World::World()
+{
+	input = NULL;
+	audio = NULL;
+	enemyCostMs = 0.0f;
+	enemyCostOverride = -1.0f;
+	gameState = INTROSCREEN;
+	nextState = INTROSCREEN;
+	holdTime = 0.0f;
+	level = 1;
+	scenario = false;
+	staticVersion = 0;
+	staticDirty = true;
+	night = false;
+	timect = 0.0f;
+	dt = 0.0f;
+	playMusic = true;
+	attacked = false;
+	sinceLastAttacked = 0.0f;
+}
+
+World::~World()
+{
+	for(unsigned int i=0; i<pBullets.size(); i++)
+		delete pBullets[i];
+}
+
+void World::init(SimInput* input, SimAudio* audio, const WorldMeshes& meshes, const char* configFile)
+{
+	World::input = input;
+	World::audio = audio;
+	World::meshes = meshes;
+	gameState = INTROSCREEN;
+	holdTime = 0.0f;
+	config.loadFromFile(configFile);
+
+	initBasicVariables();
+	initUniqueObjects();
+	initBarrels();
+	initPickups();
+	initWallPositions();
+	initBuildingPositions();
+	initNavGrid();
+	initEnemies(config.maxEnemies);
+	enemyBrain.loadFromFile(enemyStateNS::DEFAULT_FILE);
+	waveDirector.setCapacity(enemies.getCapacity());
+	waveDirector.reset();
+
+	player.init(meshes.bullet, &pBullets, meshes.player, sqrt(2.0f), Vector3(3,5,0), Vector3(0,0,0), gameNS::PLAYER_SPEED, audio, 1, 1, 1, 5);
+	camera.init(input, player.getPosition(), Vector3(1, 0, 0), player.getPosition() + Vector3(1, 0, 0));
+
+	if(!config.scenario.isEmpty())
+	{
+		Scenario s;
+		s.generate(config.scenario);
+		loadScenario(s);
+	}
+}
+
+void World::startPlaying()
+{
+	audio->stopCue(INTROMUSIC);
+	gameState = PLAYING;
+	camera.transformToWorld(player.getPosition());
+}
+
+void World::initBasicVariables()
+{
+	shotTimer = 0;
+	hasntPlayedYet = true;
+	nightDayTrans = false;
+	walking = false;
+	level = 1;
+	scenario = false;
+	night = false;
+	timect = 0.0f;
+	timeOfDay = "Day";
+	debugMode = false;
+	nightCount = 0;
+	enemyCostMs = 0.0f;
+	stepTime = 0.0f;
+	step1 = true;
+	placedPickups = false;
+	dayCount = 1;
+	attacked = false;
+	sinceLastAttacked = 0.0f;
+	startingLevelPosition = Vector3(0.0f,5.0f, -1250.0f);
+}
+
+//Box, value and sound go together for each kind of pickup
+Pickup World::makePickup(PickupKind kind, int amount, int mapIndex)
+{
+	Pickup p;
+	switch(kind)
+	{
+	case PICKUP_HEALTH:
+		p = Pickup(meshes.health, &player.health, INCREASE, amount, mapIndex, ZIPPER, audio, level);
+		p.setMaterial(MATERIAL_RED);
+		break;
+	case PICKUP_AMMO:
+		p = Pickup(meshes.ammo, &player.ammo, INCREASE, amount, mapIndex, RELOAD, audio, level);
+		p.setMaterial(MATERIAL_BLUE);
+		break;
+	case PICKUP_SPEED:
+		p = Pickup(meshes.speed, &player.speed, INCREASE, amount, mapIndex, WHOOSH, audio, level);
+		p.setMaterial(MATERIAL_YELLOW);
+		break;
+	default:
+		p = Pickup(meshes.gun, &player.currentGun, INCREASE, amount, mapIndex, NEW_GUN, audio, level);
+		break;
+	}
+	return p;
+}
+
+void World::initPickups() {
+	//define the pickups
+	dayPickups.clear();
+	nightPickups.clear();
+	if (level == 1) {
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 0));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 15, 1));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 15, 2));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 15, 3));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 15, 4));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 5));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 6));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 7));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 8));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 9));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 10));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 11));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 12));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 13));
+		dayPickups.push_back(makePickup(PICKUP_SPEED, 5, 14));
+		dayPickups.push_back(makePickup(PICKUP_SPEED, 5, 15));
+		dayPickups.push_back(makePickup(PICKUP_SPEED, 5, 16));
+		dayPickups.push_back(makePickup(PICKUP_SPEED, 5, 17));
+
+		nightPickups.push_back(makePickup(PICKUP_HEALTH, 50, 13));
+		nightPickups.push_back(makePickup(PICKUP_HEALTH, 50, 14));
+		nightPickups.push_back(makePickup(PICKUP_HEALTH, 50, 15));
+		nightPickups.push_back(makePickup(PICKUP_HEALTH, 50, 16));
+		nightPickups.push_back(makePickup(PICKUP_AMMO, 50, 13));
+		nightPickups.push_back(makePickup(PICKUP_AMMO, 50, 14));
+		nightPickups.push_back(makePickup(PICKUP_AMMO, 50, 15));
+		nightPickups.push_back(makePickup(PICKUP_GUN, 1, 16));
+
+	} else if (level == 2) {
+		dayPickups.push_back(makePickup(PICKUP_GUN, 1, 0));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 1));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 2));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 3));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 4));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 5));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 6));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 7));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 8));
+		dayPickups.push_back(makePickup(PICKUP_AMMO, 20, 9));
+		dayPickups.push_back(makePickup(PICKUP_GUN, 1, 10));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 11));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 12));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 13));
+		dayPickups.push_back(makePickup(PICKUP_GUN, 1, 14));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 15));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 16));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 17));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 18));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 19));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 15, 20));
+		dayPickups.push_back(makePickup(PICKUP_SPEED, 10, 21));
+		dayPickups.push_back(makePickup(PICKUP_SPEED, 10, 22));
+		dayPickups.push_back(makePickup(PICKUP_HEALTH, 30, 23));
+		dayPickups.push_back(makePickup(PICKUP_SPEED, 10, 24));
+
+		nightPickups.push_back(makePickup(PICKUP_AMMO, 30, 9));
+		nightPickups.push_back(makePickup(PICKUP_HEALTH, 50, 12));
+		nightPickups.push_back(makePickup(PICKUP_AMMO, 30, 10));
+		nightPickups.push_back(makePickup(PICKUP_HEALTH, 50, 16));
+	}
+
+	for (unsigned int i = 0; i < dayPickups.size(); i++)
+		dayPickups[i].setInActive();
+	for (unsigned int i = 0; i < nightPickups.size(); i++)
+		nightPickups[i].setInActive();
+}
+
+void World::initBuildingPositions() {
+	markStaticChanged();
+	Box* brick = meshes.brick;
+	//clear old buildings if any and make new ones.
+	buildings.clear();
+	if (level == 1) {
+		for (int i = 0; i < 12; i++)
+			buildings.push_back(Building());
+	} else if (level == 2) {
+		for (int i = 0; i < 27; i++)
+			buildings.push_back(Building());
+	}
+
+	if (level == 1) {
+		//					geom,  rad,  position,					sc,	w,		h,	d    //Level 1 Buildings
+		buildings[0].init(brick, 2.0f, Vector3(150, 0, -150),	1,	20,		50,  20);// Front right corner buildings
+		buildings[1].init(brick, 2.0f, Vector3(150, 0, -50),	1,	20,		50,  20);
+		buildings[2].init(brick, 2.0f, Vector3(50, 0, -150),	1,	20,		50,  20);
+
+		buildings[3].init(brick, 2.0f, Vector3(150, 0, 150),	1,	20,		50,  20);// Front left corner buildings
+		buildings[4].init(brick, 2.0f, Vector3(150, 0, 50),	1,	20,		50,  20);
+		buildings[5].init(brick, 2.0f, Vector3(50, 0, 150),	1,	20,		50,  20);
+
+		buildings[6].init(brick, 2.0f, Vector3(-150, 0, -150), 1,	20,		50,  20);// Back right corner buildings
+		buildings[7].init(brick, 2.0f, Vector3(-150, 0, -50),	1,	20,		50,  20);
+		buildings[8].init(brick, 2.0f, Vector3(-50, 0, -150),	1,	20,		50,  20);
+
+		buildings[9].init(brick, 2.0f, Vector3(-150, 0, 150),	1,	20,		50,  20);// Back left corner buildings
+		buildings[10].init(brick, 2.0f, Vector3(-150, 0, 50),	1,	20,		50,  20);
+		buildings[11].init(brick, 2.0f, Vector3(-50, 0, 150),	1,	20,		50,  20);
+	} else if (level == 2) {
+		buildings[0].init(brick, 2.0f, Vector3(700, 0, 1300),1,	190,	50,  190);//Left Side Building 1
+		buildings[1].init(brick, 2.0f, Vector3(370, 0, 1020),1,	50,		50,  95);//Left Side Building 2
+		buildings[2].init(brick, 2.0f, Vector3(300, 0, 1350),1,	95,		50,  95);//Left Side Building 3
+		buildings[3].init(brick, 2.0f, Vector3(700, 0, 925),1,	95,		50,  95);//Left Side Building 4
+
+		buildings[4].init(brick, 2.0f, Vector3(300, 0, 700),	1,	95,		70,  90);//Left Side Building 5
+		buildings[5].init(brick, 2.0f, Vector3(700, 0, 500),	1,	120,	50,  95);//Left Side Building 6
+		buildings[6].init(brick, 2.0f, Vector3(700, 0, 150),	1,	120,	50,  108);//Left Side Building 7
+		buildings[7].init(brick, 2.0f, Vector3(350, 0, 250),	1,	72,		50,  120);//Left Side Building 8
+
+		buildings[8].init(brick, 2.0f, Vector3(750, 0, -200),	1,	90,		80,  95);//Left Side Building 9
+		buildings[9].init(brick, 2.0f, Vector3(350, 0, -300),	1,	75,		50,  95);//Left Side Building 10
+		buildings[10].init(brick, 2.0f, Vector3(750, 0, -550),	1,	120,		50,  95);//Left Side Building 11
+		buildings[11].init(brick, 2.0f, Vector3(325, 0, -650),	1,	100,	50,  95);//Left Side Building 12
+		buildings[12].init(brick, 2.0f, Vector3(800, 0, -1200),1,	120,	50,  250);//Left Side Building 13
+		buildings[13].init(brick, 2.0f, Vector3(350, 0, -1300),1,	72,		50,  72);//Left Side Building 14
+
+		buildings[14].init(brick, 2.0f, Vector3(-700, 0, 1150),1,	95,		50,  320);//Right Side Building 15
+		buildings[15].init(brick, 2.0f, Vector3(-300, 0, 1100),1,	110,	50,  130);//Right Side Building 16
+		buildings[16].init(brick, 2.0f, Vector3(-600, 0, 450),	1,	100,	50,  90);//Right Side Building 17
+		buildings[17].init(brick, 2.0f, Vector3(-300, 0, 550),	1,	50,		30,  150);//Right Side Building 18
+		buildings[18].init(brick, 2.0f, Vector3(-370, 0, 195),1,	95,		50,  95);//Right Side Building 19
+
+		buildings[19].init(brick, 2.0f, Vector3(-615, 0, -10),	1,	150,	50,  110);//Right Side Building 20
+		buildings[20].init(brick, 2.0f, Vector3(-370, 0, -215),1,	95,		50,  95);//Right Side Building 21
+		buildings[21].init(brick, 2.0f, Vector3(-700, 0, -275),1,	95,		50,  95);//Right Side Building 22
+		buildings[22].init(brick, 2.0f, Vector3(-250, 0, -700),1,	50,		90,  50);//Right Side Building 23
+
+		buildings[23].init(brick, 2.0f, Vector3(-650, 0, -800), 1,	110,	50,  200);//Right Side Building 24
+		buildings[24].init(brick, 2.0f, Vector3(-225, 0, -1000),1,	50,		60,  50);//Right Side Building 25
+		buildings[25].init(brick, 2.0f, Vector3(-650, 0, -1300),1,	110,	50,  200);//Right Side Building 26
+		buildings[26].init(brick, 2.0f, Vector3(-200, 0, -1300),1,	50,		30,  50);//Right Side Building 27
+	}
+}
+
+void World::initWallPositions() {
+	markStaticChanged();
+	Box* brick = meshes.brick;
+	walls.clear();
+	//create number of walls per level.
+	if (level == 1)
+		for (int i = 0; i < 16; i++)
+			walls.push_back(Wall());
+	else if (level == 2)
+		for (int i = 0; i < 12; i++)
+			walls.push_back(Wall());
+
+	if (level == 1)  {
+		//				   geom,  rad,  position,								sc,	w,			h,	d
+		walls[0].init(brick, 2.0f, Vector3(125, 0, 250), Vector3(0,0,0),	1, 	1,	125,	10,		10);//	Left/Front wall
+		walls[1].init(brick, 2.0f, Vector3(-125, 0, -250), Vector3(0,0,0), 1,	1,	125,	10,		10);//	Right/back wall
+		walls[2].init(brick, 2.0f, Vector3(250, 0, 125),	 Vector3(0,0,0), 1,	1,	10,		10,		125);//	Front/Left wall
+		walls[3].init(brick, 2.0f, Vector3(-250, 0, -125),	 Vector3(0,0,0), 1,	1,	10,		10,		125);//	Back/Right wall
+
+		walls[4].init(brick, 2.0f, Vector3(-125, 0, 250),	 Vector3(0,0,0), 1,	1,	125,	10,		10);//	Left/Back wall
+		walls[5].init(brick, 2.0f, Vector3(125, 0, -250),	 Vector3(0,0,0), 1,	1,	125,	10,		10);//	Right/Front wall
+		walls[6].init(brick, 2.0f, Vector3(250, 0, -125),	 Vector3(0,0,0), 1,	1,	10,		10,		125);//	Front/Right wall
+		walls[7].init(brick, 2.0f, Vector3(-250, 0, 125),	 Vector3(0,0,0), 1,	1,	10,		10,		125);//	Back/Left wall
+
+		walls[8].init(brick, 2.0f, Vector3(36, 0, 55),		 Vector3(0,0,0), 1,	1,	20,		2.5,	1);//	Left/Front inner wall
+		walls[9].init(brick, 2.0f, Vector3(-36, 0, -55),	 Vector3(0,0,0), 1,	1,	20,		2.5,	1);//	Right/Back inner wall
+		walls[10].init(brick, 2.0f, Vector3(55, 0, 36),	 Vector3(0,0,0), 1,	1,	1,		2.5,	20);//	Front/Left inner wall
+		walls[11].init(brick, 2.0f, Vector3(-55, 0, -36),	 Vector3(0,0,0), 1,	1,	1,		2.5,	20);//	Back/Right inner wall
+
+		walls[12].init(brick, 2.0f, Vector3(-36, 0, 55),	 Vector3(0,0,0), 1,	1,	20,		2.5,	1);//	Left/Back inner wall
+		walls[13].init(brick, 2.0f, Vector3(36, 0, -55),	 Vector3(0,0,0), 1,	1,	20,		2.5,	1);//	Right/Front inner wall
+		walls[14].init(brick, 2.0f, Vector3(55, 0, -36),	 Vector3(0,0,0), 1,	1,	1,		2.5,	20);//	Front/Right inner wall
+		walls[15].init(brick, 2.0f, Vector3(-55, 0, 36),	 Vector3(0,0,0), 1,	1,	1,		2.5,	20);//	Back/Left inner wall
+	} else if (level == 2) {
+		//Level 2
+		walls[0].init(brick, 2.0f, Vector3(0, 0, -1625),	Vector3(0,0,0), 1,	1,	980,	20,	10);// Far Wall
+		walls[1].init(brick, 2.0f, Vector3(0, 0, 1625),	Vector3(0,0,0), 1,	1,	980,	20,	10);// Back Wall
+		walls[2].init(brick, 2.0f, Vector3(-980, 0, 0),	Vector3(0,0,0), 1,	1,	10,		20,	1625);// Back Wall
+		walls[3].init(brick, 2.0f, Vector3(980, 0, 0),		Vector3(0,0,0), 1,	1,	10,		20,	1625);// Back Wall
+
+		//Safe zone - level 2
+		walls[4].init(brick, 2.0f, Vector3(482.5, 0, 50),	Vector3(0, 0, 0), 1, 1, 17.5,	2.5, 1);
+		walls[5].init(brick, 2.0f, Vector3(417.5, 0, 50),	Vector3(0, 0, 0), 1, 1, 17.5,	2.5, 1);
+		walls[6].init(brick, 2.0f, Vector3(500, 0, 32.5),	Vector3(0, 0, 0), 1, 1, 1,		2.5, 17.5);
+		walls[7].init(brick, 2.0f, Vector3(400, 0, 32.5),	Vector3(0, 0, 0), 1, 1, 1,		2.5, 17.5);
+
+		walls[8].init(brick, 2.0f, Vector3(482.5, 0, -50),Vector3(0, 0, 0), 1, 1, 17.5,	2.5, 1);
+		walls[9].init(brick, 2.0f, Vector3(417.5, 0, -50),Vector3(0, 0, 0), 1, 1, 17.5,	2.5, 1);
+		walls[10].init(brick, 2.0f, Vector3(500, 0, -32.5),Vector3(0, 0, 0), 1, 1, 1,		2.5, 17.5);
+		walls[11].init(brick, 2.0f, Vector3(400, 0, -32.5),Vector3(0, 0, 0), 1, 1, 1,		2.5, 17.5);
+	}
+}
+
+void World::initUniqueObjects() {
+	markStaticChanged();
+	floor.init(meshes.floor, 2.0f, Vector3(0,-1000.0f,0), Vector3(0,0,0), 1, 1.0f, 250, 500, 250);
+	floor2.init(meshes.floor, 2.0f, Vector3(0,-1000.0f,0), Vector3(0,0,0), 1, 1.0f, 975, 500, 1625);
+}
+
+//Barrels line both sides of the level 2 road, {x, z}
+static const float BARREL_LAYOUT[][2] = {
+	{-85, 1500}, {85, 1475}, {-85, 1300}, {85, 1275}, {-85, 1100}, {85, 1075},
+	{-85, 800}, {85, 775}, {-85, 500}, {85, 475}, {-85, 300}, {85, 275},
+	{-85, -275}, {85, -300}, {-85, -475}, {85, -500}, {-85, -775}, {85, -800},
+	{-85, -1075}, {85, -1100}, {-85, -1275}, {85, -1300}, {-85, -1475}, {85, -1500},
+};
+
+void World::initBarrels() {
+	markStaticChanged();
+	int count = sizeof(BARREL_LAYOUT)/sizeof(BARREL_LAYOUT[0]);
+	barrels.assign(count, Barrel());
+	for(int i=0; i<count; i++)
+		barrels[i].init(meshes.brick, 2.0f, Vector3(BARREL_LAYOUT[i][0], 0, BARREL_LAYOUT[i][1]), 1.0f, 1, 3, 1);
+}
+
+//Every slot is set up now, so spawning later is just taking one from the pool
+void World::initEnemies(int capacity) {
+	enemies.init(capacity);
+	for(int i=0; i<enemies.getCapacity(); i++) {
+		enemies[i].setNavGrid(&navGrid);
+		enemies[i].init(meshes.enemy, 2.0f, Vector3((float)(SimRandom::next()%50),0.f,(float)(SimRandom::next()%50)), Vector3(0.f,0.f,0.f), 1.f, 1.f, 1, 2, 1);
+		enemies[i].faceObject(&player);
+	}
+}
+
+//One grid for every enemy, the same size in both levels
+void World::initNavGrid() {
+	int n = config.waypointGrid;
+	if (level == 1) {
+		navGrid.place(n, gameNS::GRID_SIZE_1, gameNS::GRID_SIZE_1);
+		navGrid.clearLinks();
+		navGrid.linkAll();
+	} else if (level == 2) {
+		//Level 2 adds its links to level 1's
+		navGrid.place(n, gameNS::GRID_WIDTH_2, gameNS::GRID_DEPTH_2);
+		for(int i=0; i<n; i++)
+		{
+			for(int j=0; j<n; j++)
+			{
+				//The gaps that route enemies around the level 2 buildings are
+				//placed for the default grid; other sizes get the plain grid
+				bool west = true, east = true, south = true, north = true;
+				if(n == WAYPOINT_SIZE)
+				{
+					if(i == 0 && j == 2) east = false;
+					else if(i == 1 && j == 2) west = south = north = false;
+					else if(i == 1 && j == 1) west = north = false;
+					else if(i == 0 && j == 1) east = false;
+					else if(i == 1 && j == 3) south = false;
+				}
+				navGrid.link(i, j, west, east, south, north);
+			}
+		}
+	}
+}
+
+void World::loadScenario(const Scenario& s)
+{
+	Box* brick = meshes.brick;
+	scenario = true;
+	level = 1;
+	markStaticChanged();
+
+	float half = s.getExtent()/2 + scenarioNS::STREET_WIDTH;
+	floor.init(meshes.floor, 2.0f, Vector3(0,-1000.0f,0), Vector3(0,0,0), 1, 1.0f, half, 500, half);
+
+	buildings.assign(s.buildings.size(), Building());
+	for(unsigned int i=0; i<buildings.size(); i++) {
+		const ScenarioBox& b = s.buildings[i];
+		buildings[i].init(brick, 2.0f, b.position, 1, (int)b.width, (int)b.height, (int)b.depth);
+	}
+	walls.assign(s.walls.size(), Wall());
+	for(unsigned int i=0; i<walls.size(); i++) {
+		const ScenarioBox& w = s.walls[i];
+		walls[i].init(brick, 2.0f, w.position, Vector3(0,0,0), 1, 1, w.width, w.height, w.depth);
+	}
+	barrels.assign(s.barrels.size(), Barrel());
+	for(unsigned int i=0; i<barrels.size(); i++)
+		barrels[i].init(brick, 2.0f, s.barrels[i], 1.0f, 1, 3, 1);
+	lampSpots = s.lamps;
+
+	//Pickups alternate between day and night, and are all out at their time of day
+	dayPickups.clear();
+	nightPickups.clear();
+	for(unsigned int i=0; i<s.pickups.size(); i++) {
+		Pickup p = makePickup(s.pickups[i].kind, s.pickups[i].amount, 0);
+		p.setPosition(s.pickups[i].position);
+		p.setInActive();
+		if(i % 2 == 0) dayPickups.push_back(p);
+		else nightPickups.push_back(p);
+	}
+	placedPickups = false;
+
+	//The whole street plan, one waypoint per crossing
+	navGrid.place(s.getBlocks() + 1, s.getExtent(), s.getExtent());
+	navGrid.clearLinks();
+	navGrid.linkAll();
+
+	int capacity = config.maxEnemies;
+	if(capacity < (int)s.enemies.size()) capacity = s.enemies.size();
+	initEnemies(capacity);
+	for(unsigned int i=0; i<s.enemies.size(); i++)
+		startEnemy(enemies.acquire(), s.enemies[i]);
+	aiLod.reset();
+	//Everything the scenario asked for stays out, however long it takes
+	waveDirector.setCapacity(enemies.getCapacity());
+	waveDirector.setBudget(0.0f);
+	waveDirector.reset();
+
+	camera.setPosition(s.playerStart);
+	player.setPosition(s.playerStart);
+}
+
+
+void World::update(float dt)
+{
+	PROFILE_ZONE("World::update");
+	PERF_TIMER(PERF_UPDATE);
+	World::dt = dt;
+	savePrevious();
+
+	//The game stops while the end of play is held, then moves on
+	if(holdTime > 0.0f) {
+		holdTime -= dt;
+		if(holdTime > 0.0f) return;
+		gameState = nextState;
+		input->releaseKey(VK_SPACE);
+	}
+
+	if (gameState == INTROSCREEN){
+		camera.transformToMenu();
+		if(input->isKeyDown(VK_SPACE)){
+			gameState = INSTRUCTIONS;
+			input->releaseKey(VK_SPACE);
+		}
+	}
+	if (gameState == INSTRUCTIONS) {
+		if(input->isKeyDown(VK_SPACE)){
+			startPlaying();
+			input->releaseKey(VK_SPACE);
+		}
+	}
+	if(gameState == PLAYING)
+		updatePlaying(dt);
+	if (gameState == BEATLV1) {
+		if (level == 1 && !scenario)
+			startLevel2();
+		//lock the screen at a certain spot and render the cube with the transition graphic and then...
+		if(input->isKeyDown(VK_SPACE)) {
+			camera.transformToWorld(startingLevelPosition);
+			gameState = PLAYING;
+		}
+	}
+	if(gameState == LOSE || gameState == WIN)
+		camera.transformToMenu();
+}
+
+void World::updatePlaying(float dt)
+{
+	Vector3 oldPos = camera.getPosition();
+	timect += dt;
+	sinceLastAttacked += dt;
+	updateGameState(); //Checks for win/lose/levelTransition conditions
+	updateDebugMode();
+	updateMusic();
+	updateDayNight();
+
+	if(input->isKeyDown(VK_SHIFT)) camera.update(dt, 1.5*static_cast<float>(gameNS::PLAYER_SPEED), &walking);
+	else camera.update(dt, static_cast<float>(gameNS::PLAYER_SPEED), &walking);
+
+	updatePlayer(dt);
+	double enemyStart = clock.getRealTime();
+	updateEnemies(dt);
+	enemyCostMs = (float)((clock.getRealTime() - enemyStart) * 1000.0);
+	updatePickups();
+	updateWalls();
+	updateBuildings();
+	updateUniqueObjects(dt);
+	if(staticDirty) {
+		staticVersion++;
+		staticDirty = false;
+	}
+	placePickups();
+
+	//Handle Collisions
+	handleWallCollisions(oldPos);
+	handleBuildingCollisions(oldPos);
+	double collideStart = clock.getRealTime();
+	handleEnemyCollisions(dt);
+	enemyCostMs += (float)((clock.getRealTime() - collideStart) * 1000.0);
+	updateWaves(dt);
+
+	attacked = false;
+	for(int k=0; k<enemies.getActiveCount(); k++)
+	{
+		if(enemies.getActive(k).getAttacking())
+		{
+			attacked = true;
+			sinceLastAttacked = 0;
+		}
+	}
+
+	if(level == 2 && nightCount >= 2) endPlaying(WIN);
+}
+
+void World::startLevel2()
+{
+	camera.transformToMenu();
+	D3DXVECTOR3 pos = D3DXVECTOR3(10,0,10);
+	camera.setPosition(pos);
+	level = 2;
+	initPickups();
+	initWallPositions();
+	initBuildingPositions();
+
+	enemies.releaseAll();
+	initNavGrid();
+	aiLod.reset();
+	waveDirector.reset();
+}
+
+void World::updateMusic() {
+	if (hasntPlayedYet || nightDayTrans) {
+		hasntPlayedYet = false;
+		nightDayTrans = false;
+		if (playMusic) {
+			audio->stopCue(MUSIC);
+			audio->playCue(MUSIC);
+		}
+	}
+}
+
+void World::updateDebugMode() {
+	if(input->wasKeyPressed(KEY_K)) {
+		debugMode = true;
+		input->clearKeyPress(KEY_K);
+		player.setSpeed(500);
+	}
+	if (input->wasKeyPressed(KEY_L)) {
+		camera.setPosition(D3DXVECTOR3(camera.getPosition().x, 5, camera.getPosition().z));
+		debugMode = false;
+		input->clearKeyPress(KEY_L);
+		player.setSpeed(200);
+	}
+	if (input->wasKeyPressed(KEY_M)) {
+		playMusic = false;
+		audio->stopCue(MUSIC);
+	}
+}
+
+void World::updateUniqueObjects(float dt) {
+	floor.update(dt);
+	floor2.update(dt);
+
+	for(unsigned int i=0; i<barrels.size(); i++)
+		barrels[i].update(dt);
+}
+
+void World::updateWalls() {
+	JobSystem::parallelFor(walls.size(), gameNS::JOB_GRAIN, updateWallRange, this);
+}
+
+void World::updateWallRange(void* data, int begin, int end) {
+	World* w = (World*)data;
+	for(int i=begin; i<end; i++)
+		w->walls[i].update(w->dt);
+}
+
+void World::updateBuildings() {
+	JobSystem::parallelFor(buildings.size(), gameNS::JOB_GRAIN, updateBuildingRange, this);
+}
+
+void World::updateBuildingRange(void* data, int begin, int end) {
+	World* w = (World*)data;
+	for(int i=begin; i<end; i++)
+		w->buildings[i].update(w->dt);
+}
+
+void World::updatePlayer(float dt) {
+	PROFILE_ZONE("updatePlayer");
+	player.setPosition(camera.getPosition());
+	player.setVelocity(camera.getDirection());
+	D3DXVECTOR3 pos = player.getPosition();
+
+	player.update(dt, camera.getLookatDirection(), meshes.bullet, &pBullets); //bullet should follow camera lookat vector
+
+	//Update shooting
+	if(input->isKeyDown(VK_SPACE))
+	{
+		if(player.canShoot())
+			player.fired = true; //this player value being set dictates whether the player shoots the next time player.update() is called
+		else player.fired = false;
+	} else {
+		player.firedLastFrame = false;
+		player.fired = false;
+	}
+
+	//Update walking noises
+	if (walking) {
+		stepTime += 1;
+		if (stepTime*dt > gameNS::FOOTSTEP_GAP) {
+			if (level == 1) {
+				if (pos.x < gameNS::GRASSY_AREA_WIDTH/2.0f && pos.x > -gameNS::GRASSY_AREA_WIDTH/2.0f  && pos.z > -gameNS::GRASSY_AREA_WIDTH/2.0f && pos.z < gameNS::GRASSY_AREA_WIDTH/2.0f) { //in grassy area
+					if (step1) audio->playCue(FOOTSTEP3);
+					else audio->playCue(FOOTSTEP4);
+				} else {
+					if (step1) audio->playCue(FOOTSTEP1);
+					else audio->playCue(FOOTSTEP2);
+				}
+			} else if (level == 2) {
+				if (pos.x < gameNS::ROAD_WIDTH/2.0f && pos.x > -gameNS::ROAD_WIDTH/2.0f && pos.z > -gameNS::ROAD_LENGTH/2.0f && pos.z < gameNS::ROAD_LENGTH/2.0f) {
+					if (step1) audio->playCue(FOOTSTEP1);
+					else audio->playCue(FOOTSTEP2);
+				} else {
+					if (step1) audio->playCue(FOOTSTEP3);
+					else audio->playCue(FOOTSTEP4);
+				}
+			}
+			step1 = !step1;
+			stepTime = 0.0f;
+		}
+	}
+
+	if (debugMode) { //Allow flying with space and shift
+		if(input->isKeyDown(VK_SPACE)) camera.flying(true);
+		else camera.flying(false);
+		if(input->isKeyDown(VK_SHIFT)) camera.falling(true);
+		else camera.falling(false);
+	}
+}
+
+void World::updateEnemies(float dt)
+{
+	PROFILE_ZONE("updateEnemies");
+	PERF_TIMER(PERF_AI);
+	JobSystem::parallelFor(enemies.getActiveCount(), gameNS::JOB_GRAIN, enemySpeedRange, this);
+
+	//Thinking uses SimRandom and hurts the player, so it stays in order on this
+	//thread; only the moving afterwards is split into jobs. Near enemies think every frame, distant ones less often (see AiLodScheduler)
+	enemyBrain.setNight(night);
+	aiLod.update(enemies, &player, dt, &enemyBrain);
+	//Enemies that died thinking give their slots back
+	enemies.sweep();
+}
+
+//Enemies slow down inside the safe zone at night
+void World::enemySpeedRange(void* data, int begin, int end)
+{
+	World* w = (World*)data;
+	Vector3 safeZone = (w->level == 2) ? Vector3(450,0,0) : Vector3(0,0,0);
+	for(int k=begin; k<end; k++)
+	{
+		Enemy& e = w->enemies.getActive(k);
+		if(e.getActiveState())
+		{
+			if(w->night)
+			{
+				Vector3 toSafeZone = e.getPosition() - safeZone;
+				if(D3DXVec3LengthSq(&toSafeZone) < 55*55)
+					e.setSpeed(enemyNS::DAY_SPEED);
+				else e.setSpeed(enemyNS::NIGHT_SPEED);
+			}
+			else e.setSpeed(enemyNS::DAY_SPEED);
+		}
+	}
+}
+
+void World::stopBullet(Bullet* b)
+{
+	b->setInActive();
+	b->setVelocity(D3DXVECTOR3(0,0,0));
+	b->setPosition(D3DXVECTOR3(0,0,0));
+	shotTimer = 0;
+}
+
+void World::handleWallCollisions(Vector3 pos) {
+	PROFILE_ZONE("handleWallCollisions");
+	PERF_TIMER(PERF_COLLISION);
+	for(unsigned int i=0; i<walls.size(); i++)
+	{
+		if(player.collided(&walls[i]))
+			camera.setPosition(pos);
+ 	}
+
+	//A bullet stops at the first wall it touches, whichever that is, so bullets
+	//can be tested in parallel and stopped afterwards
+	bulletHits.assign(pBullets.size(), -1);
+	JobSystem::parallelFor(pBullets.size(), gameNS::JOB_GRAIN, bulletWallRange, this);
+	for(unsigned int j=0; j<pBullets.size(); j++)
+		if(bulletHits[j] >= 0) stopBullet(pBullets[j]);
+}
+
+void World::bulletWallRange(void* data, int begin, int end) {
+	World* w = (World*)data;
+	for(int j=begin; j<end; j++)
+	{
+		for(unsigned int i=0; i<w->walls.size(); i++)
+		{
+			if(w->pBullets[j]->collided(&w->walls[i]))
+			{
+				w->bulletHits[j] = i;
+				break;
+			}
+		}
+	}
+}
+
+void World::handleBuildingCollisions(Vector3 pos) {
+	PROFILE_ZONE("handleBuildingCollisions");
+	PERF_TIMER(PERF_COLLISION);
+	for(unsigned int i=0; i<buildings.size(); i++)
+	{
+		if (buildings[i].getActiveState() == false) continue;
+		if(player.collided(&buildings[i])){
+			camera.setPosition(pos);
+			camera.setLookAt(camera.getOldLookat());
+		}
+	}
+
+	bulletHits.assign(pBullets.size(), -1);
+	JobSystem::parallelFor(pBullets.size(), gameNS::JOB_GRAIN, bulletBuildingRange, this);
+	for(unsigned int j=0; j<pBullets.size(); j++)
+		if(bulletHits[j] >= 0) stopBullet(pBullets[j]);
+}
+
+void World::bulletBuildingRange(void* data, int begin, int end) {
+	World* w = (World*)data;
+	for(int j=begin; j<end; j++)
+	{
+		for(unsigned int i=0; i<w->buildings.size(); i++)
+		{
+			if (w->buildings[i].getActiveState() == false) continue;
+			if(w->pBullets[j]->collided(&w->buildings[i]))
+			{
+				w->bulletHits[j] = i;
+				break;
+			}
+		}
+	}
+}
+
+void World::handleEnemyCollisions(float dt)
+{
+	PROFILE_ZONE("handleEnemyCollisions");
+	PERF_TIMER(PERF_COLLISION);
+	//Each bullet hits the first enemy it touches. The hits are applied in bullet
+	//order, so the damage comes out the same however the jobs ran.
+	bulletHits.assign(pBullets.size(), -1);
+	JobSystem::parallelFor(pBullets.size(), gameNS::JOB_GRAIN, bulletEnemyRange, this);
+	for(unsigned int j=0; j<pBullets.size(); j++)
+	{
+		if(bulletHits[j] < 0) continue;
+		stopBullet(pBullets[j]);
+		enemies[bulletHits[j]].damage(50);
+	}
+
+	JobSystem::parallelFor(enemies.getActiveCount(), gameNS::JOB_GRAIN, enemySceneryRange, this);
+}
+
+void World::bulletEnemyRange(void* data, int begin, int end)
+{
+	World* w = (World*)data;
+	for(int j=begin; j<end; j++)
+	{
+		for(int k=0; k<w->enemies.getActiveCount(); k++)
+		{
+			if(w->pBullets[j]->collided(&w->enemies.getActive(k)))
+			{
+				w->bulletHits[j] = w->enemies.getActiveSlot(k);
+				break;
+			}
+		}
+	}
+}
+
+//Only enemies near the player are kept out of the scenery
+void World::enemySceneryRange(void* data, int begin, int end)
+{
+	World* w = (World*)data;
+	for(int k=begin; k<end; k++)
+	{
+		Enemy& e = w->enemies.getActive(k);
+		Vector3 toPlayer = e.getPosition() - w->player.getPosition();
+		if(D3DXVec3LengthSq(&toPlayer) >= 100*100) continue;
+		for(unsigned int j=0; j<w->walls.size(); j++)
+		{
+			if(e.collided(&w->walls[j]))
+				e.setPosition(e.getOldPos());
+		}
+		for(unsigned int j=0; j<w->buildings.size(); j++)
+		{
+			if(e.collided(&w->buildings[j]))
+				e.setPosition(e.getOldPos());
+		}
+	}
+}
+
+void World::placePickups() {
+	PROFILE_ZONE("placePickups");
+	PERF_TIMER(PERF_PICKUPS);
+	if (placedPickups) return;
+
+	//A scenario puts out every pickup for the time of day
+	if (scenario) {
+		for (unsigned int i = 0; i < dayPickups.size(); i++)
+			if (night) dayPickups[i].setInActive(); else dayPickups[i].setActive();
+		for (unsigned int i = 0; i < nightPickups.size(); i++)
+			if (night) nightPickups[i].setActive(); else nightPickups[i].setInActive();
+		placedPickups = true;
+		return;
+	}
+
+	int maxNightPickups = 0;
+	int maxDayPickups = 0;
+	if(level == 1){
+		maxNightPickups = 8;
+		maxDayPickups = 18;
+	}
+	else if(level == 2){
+		maxNightPickups = 4;
+		maxDayPickups = 25;
+	}
+	vector<int> choices;
+	bool day = !night;
+	vector<Pickup>& pickups = day ? dayPickups : nightPickups;
+	int maxPickups = day ? maxDayPickups : maxNightPickups;
+	if (pickups.size() > 0) { //otherwise divide by zero when I mod by size
+		vector<int> tempUsedIndices;
+		for (int i = 0; i < maxPickups; i++) {
+			bool add = true;
+			int choice = SimRandom::next()%pickups.size();
+			for (unsigned int j = 0; j < tempUsedIndices.size(); j++) { //check that chosen pickup mapIndex isn't in the usedMapIndices
+				if (tempUsedIndices[j] == pickups[choice].getMapIndex())
+					add = false; //there is already a pickup in the spot of the chosen pickup
+			}
+			if (add) {
+				choices.push_back(choice); //add that to displayed pickups
+				tempUsedIndices.push_back(pickups[choice].getMapIndex()); //record that mapIndex as used
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < nightPickups.size(); i++)
+		nightPickups[i].setInActive();
+	for (unsigned int i = 0; i < dayPickups.size(); i++)
+		dayPickups[i].setInActive();
+
+	for (unsigned int i = 0; i < choices.size(); i++)
+		pickups[choices[i]].setActive();
+
+	placedPickups = true;
+}
+
+void World::updatePickups() {
+	PROFILE_ZONE("updatePickups");
+	PERF_TIMER(PERF_PICKUPS);
+	//Picking up changes the player, so that part goes in order on this thread
+	int count = dayPickups.size() + nightPickups.size();
+	pickupHits.assign(count, 0);
+	JobSystem::parallelFor(count, gameNS::JOB_GRAIN, touchPickupRange, this);
+	for (int i = 0; i < count; i++) {
+		if (pickupHits[i])
+			pickupAt(i).activate();
+	}
+	JobSystem::parallelFor(count, gameNS::JOB_GRAIN, updatePickupRange, this);
+}
+
+void World::touchPickupRange(void* data, int begin, int end) {
+	World* w = (World*)data;
+	for (int i = begin; i < end; i++)
+		w->pickupHits[i] = w->player.collided(&w->pickupAt(i));
+}
+
+void World::updatePickupRange(void* data, int begin, int end) {
+	World* w = (World*)data;
+	for (int i = begin; i < end; i++)
+		w->pickupAt(i).update(w->dt);
+}
+
+void World::updateDayNight() {
+	if(timect >= gameNS::DAYLEN)
+	{
+		timect = 0;
+		night = !night;
+		if(night)
+		{
+			if(timeOfDay == "Evening")
+			{
+				placedPickups = false;
+				//Enemies come out over time in updateWaves, as the frame budget allows
+				waveDirector.startWave(nightCount);
+			}
+			timeOfDay = "Night";
+		}
+		else
+		{
+			if (timeOfDay == "Dawn")
+			{
+				nightCount++;
+				placedPickups = false;
+				waveDirector.endWave();
+				nightDayTrans = true;
+			}
+			timeOfDay = "Day";
+			dayCount++;
+		}
+	}
+	if(timect >= gameNS::DAYLEN - gameNS::TRANSITIONTIME)
+	{
+		if(night) timeOfDay = "Dawn";
+		else timeOfDay = "Evening";
+	}
+}
+
+float World::getDaylight()
+{
+	float t = (timect - (gameNS::DAYLEN - gameNS::TRANSITIONTIME)) / gameNS::TRANSITIONTIME;
+	t = Clamp(t, 0.0f, 1.0f);
+	return night ? t : 1.0f - t;
+}
+
+static void hashBytes(unsigned int& h, const void* data, int size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	for(int i=0; i<size; i++)
+	{
+		h ^= p[i];
+		h *= 16777619u;
+	}
+}
+
+template<typename T>
+static void hashValue(unsigned int& h, T v)
+{
+	hashBytes(h, &v, sizeof(v));
+}
+
+unsigned int World::computeStateHash()
+{
+	unsigned int h = 2166136261u;
+	hashValue(h, (int)gameState);
+	hashValue(h, holdTime);
+	hashValue(h, level);
+	hashValue(h, night);
+	hashValue(h, timect);
+	hashValue(h, nightCount);
+	hashValue(h, SimRandom::getState());
+
+	hashValue(h, camera.getPosition());
+	hashValue(h, camera.getLookatDirection());
+	hashValue(h, player.getPosition());
+	hashValue(h, player.getHealth());
+	hashValue(h, player.getAmmo());
+	hashValue(h, player.getScore());
+
+	for(int k=0; k<enemies.getActiveCount(); k++)
+	{
+		Enemy& e = enemies.getActive(k);
+		hashValue(h, enemies.getActiveSlot(k));
+		hashValue(h, e.getPosition());
+		hashValue(h, e.getHealth());
+		hashValue(h, e.getState());
+	}
+	for(unsigned int i=0; i<pBullets.size(); i++)
+	{
+		hashValue(h, pBullets[i]->getActiveState());
+		hashValue(h, pBullets[i]->getPosition());
+	}
+	for(unsigned int i=0; i<dayPickups.size(); i++)
+		hashValue(h, dayPickups[i].getActiveState());
+	for(unsigned int i=0; i<nightPickups.size(); i++)
+		hashValue(h, nightPickups[i].getActiveState());
+	return h;
+}
+
+int World::getLiveBulletCount()
+{
+	int count = 0;
+	for(unsigned int i=0; i<pBullets.size(); i++)
+		if(pBullets[i]->getActiveState()) count++;
+	return count;
+}
+
+void World::updateWaves(float dt)
+{
+	PROFILE_ZONE("updateWaves");
+	int active = getActiveEnemyCount();
+
+	if(enemyCostOverride >= 0.0f) enemyCostMs = enemyCostOverride;
+	waveDirector.recordCost(enemyCostMs, active);
+	int n = waveDirector.update(dt, active);
+	int spawned = 0;
+	for(; spawned<n; spawned++)
+		if(!spawnEnemy()) break;
+	waveDirector.spawned(spawned);
+	if(n < 0)
+	{
+		retireEnemy();
+	}
+}
+
+bool World::spawnEnemy()
+{
+	int i = enemies.acquire();
+	if(i < 0) return false;
+	startEnemy(i, navGrid.get(SimRandom::next()%navGrid.getCount())->getPosition());
+	return true;
+}
+
+void World::startEnemy(int slot, const Vector3& pos)
+{
+	Enemy& e = enemies[slot];
+	e.setHealth(100);
+	enemyBrain.resetEnemy(&e);
+	e.setPosition(pos);
+	e.savePrevious();
+	aiLod.restart(slot);
+}
+
+//Puts the enemy furthest from the player back on the wave queue, as long as
+//it's far enough away that the player won't see it vanish
+void World::retireEnemy()
+{
+	int furthest = -1;
+	float furthestDist = waveNS::RETIRE_DISTANCE*waveNS::RETIRE_DISTANCE;
+	for(int k=0; k<enemies.getActiveCount(); k++)
+	{
+		Vector3 d = enemies.getActive(k).getPosition() - player.getPosition();
+		float distSq = D3DXVec3LengthSq(&d);
+		if(distSq > furthestDist)
+		{
+			furthestDist = distSq;
+			furthest = enemies.getActiveSlot(k);
+		}
+	}
+	if(furthest < 0) return;
+	enemies.release(furthest);
+	waveDirector.retired(1);
+}
+
+void World::updateGameState() {
+	//Handle possible transitions from the PLAYING state
+	if (player.getHealth() <= 0) {
+		endPlaying(LOSE);
+		input->releaseKey(KEY_SPACE);
+	}
+	if (dayCount > gameNS::NUM_NIGHTS_TO_ADVANCE && level == 1 && !scenario) {
+		endPlaying(BEATLV1);
+		input->releaseKey(KEY_SPACE);
+		input->releaseKey(KEY_0);
+		nightCount = 0;
+	}
+	if (dayCount == gameNS::NUM_NIGHTS_TO_ADVANCE && level == 2) {
+		endPlaying(WIN);
+		input->releaseKey(KEY_SPACE);
+	}
+	if (input->isKeyDown(KEY_0)) {
+		nightCount = gameNS::NUM_NIGHTS_TO_ADVANCE;
+		input->releaseKey(KEY_SPACE);
+		input->releaseKey(KEY_0);
+	}
+}
+
+void World::endPlaying(GameState next)
+{
+	nextState = next;
+	holdTime = gameNS::END_OF_PLAY_HOLD;
+}
+
+//Where everything that moves was before this step, for drawing in between steps
+void World::savePrevious()
+{
+	camera.savePrevious();
+	for(int k=0; k<enemies.getActiveCount(); k++)
+		enemies.getActive(k).savePrevious();
+	for(unsigned int i=0; i<pBullets.size(); i++)
+		pBullets[i]->savePrevious();
+}
+
+
+void World::draw(SimRenderer* renderer)
+{
+	drawStatic(renderer);
+	drawDynamic(renderer);
+}
+
+void World::drawStatic(SimRenderer* renderer)
+{
+	PROFILE_ZONE("World::drawStatic");
+	if (level == 2 || scenario) {
+		renderer->setMaterial(MATERIAL_BARREL);
+		for(unsigned int i = 0; i < barrels.size(); i++)
+			barrels[i].draw(renderer);
+	}
+
+	if (level == 1) {
+		renderer->setMaterial(MATERIAL_STREET);
+		floor.draw(renderer);
+	} else if (level == 2) {
+		renderer->setMaterial(MATERIAL_ROAD);
+		floor2.draw(renderer);
+	}
+
+	{
+		PROFILE_ZONE("drawBuildings");
+		renderer->setMaterial(level == 1 ? MATERIAL_BUILDING : MATERIAL_BUILDING2);
+		for(unsigned int i=0; i<buildings.size(); i++)
+			buildings[i].draw(renderer);
+	}
+
+	{
+		PROFILE_ZONE("drawWalls");
+		renderer->setMaterial(MATERIAL_BRICK);
+		for(unsigned int i=0; i<walls.size(); i++)
+			walls[i].draw(renderer);
+	}
+}
+
+void World::drawDynamic(SimRenderer* renderer)
+{
+	PROFILE_ZONE("World::drawDynamic");
+	renderer->setMaterial(MATERIAL_ENEMY);
+	for(int k=0; k<enemies.getActiveCount(); k++)
+		enemies.getActive(k).draw(renderer);
+
+	//The gun pickup has no material of its own and wears the buildings'
+	renderer->setMaterial(level == 1 ? MATERIAL_BUILDING : MATERIAL_BUILDING2);
+	drawPickups(renderer);
+
+	renderer->setMaterial(MATERIAL_BULLET);
+	player.draw(renderer);
+}
+
+void World::drawPickups(SimRenderer* renderer) {
+	PROFILE_ZONE("drawPickups");
+	for (unsigned int i = 0; i < dayPickups.size(); i++)
+		if (dayPickups[i].getActiveState())
+			dayPickups[i].draw(renderer);
+	for (unsigned int i = 0; i < nightPickups.size(); i++)
+		if (nightPickups[i].getActiveState())
+			nightPickups[i].draw(renderer);
+}
@@ -0,0 +1,252 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "constants.h"
+#include "SimInput.h"
+#include "SimAudio.h"
+#include "SimRenderer.h"
+#include "GameTimer.h"
+#include "Wall.h"
+#include "Building.h"
+#include "Barrel.h"
+#include "Player.h"
+#include "Bullet.h"
+#include "pickup.h"
+#include "Enemy.h"
+#include "AiLodScheduler.h"
+#include "EnemyStateMachine.h"
+#include "WaveDirector.h"
+#include "Camera.h"
+#include "GameConfig.h"
+#include "ObjectPool.h"
+#include "NavGrid.h"
+#include "Scenario.h"
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+//Simulation constants. The game adds its render-only ones (colors, lights) to gameNS.
+namespace gameNS {
+	const float DAYLEN = 40;
+	const float TRANSITIONTIME = 10;
+
+	const int NUM_WALLS = 28;
+	const int NUM_BUILDINGS = 39;
+	const int PERIMETER = 4;
+	const int NUM_BULLETS = 100;
+
+	const float FOOTSTEP_GAP = 0.45f;
+	const int GRASSY_AREA_WIDTH = 110;
+	const int NUM_NIGHTS_TO_ADVANCE = 2;
+	const int PLAYER_SPEED = 30;
+	const int ROAD_LENGTH = 4000;
+	const int ROAD_WIDTH = 170;
+	//Seconds the last moment of play stays up before the win/lose/next level screen
+	const float END_OF_PLAY_HOLD = 2.0f;
+	//Objects per job in the parallel update and collision passes
+	const int JOB_GRAIN = 32;
+	//Ground the nav grid covers in each level, whatever its size
+	const float GRID_SIZE_1 = 400.0f;
+	const float GRID_WIDTH_2 = 1800.0f;
+	const float GRID_DEPTH_2 = 3200.0f;
+}
+
+//Meshes the world hands to its objects. A headless run leaves them all NULL;
+//nothing but the renderer ever looks inside one.
+struct WorldMeshes
+{
+	Box* brick;
+	Box* floor;
+	Box* enemy;
+	Box* player;
+	Box* bullet;
+	Box* health;
+	Box* ammo;
+	Box* speed;
+	Box* gun;
+
+	WorldMeshes() : brick(NULL), floor(NULL), enemy(NULL), player(NULL), bullet(NULL),
+		health(NULL), ammo(NULL), speed(NULL), gun(NULL) {}
+};
+
+//Everything that plays the game: player, enemies, level geometry, pickups, the
+//day/night cycle and the game state. No D3D in here, so it also runs headless.
+class World
+{
+public:
+	World();
+	~World();
+
+	//Reads the capacities from the config file, then sizes and fills the pools.
+	//A config with a scenario in it loads that in place of level 1.
+	void init(SimInput* input, SimAudio* audio, const WorldMeshes& meshes, const char* configFile = configNS::DEFAULT_FILE);
+	void update(float dt);
+	//Everything: the scenery that never moves, then the rest
+	void draw(SimRenderer* renderer);
+	//Walls, buildings, barrels and the floor. They only change with the level,
+	//and when they do the version goes up, once their matrices are current.
+	void drawStatic(SimRenderer* renderer);
+	void drawDynamic(SimRenderer* renderer);
+	int getStaticVersion() {return staticVersion;}
+
+	//Skips the intro screens straight into level 1
+	void startPlaying();
+	//Swaps the level for a generated city: its scenery, pickups, nav grid and
+	//enemies, which all start out at once. Play then carries on from day 1 and
+	//never moves on to level 2.
+	void loadScenario(const Scenario& s);
+	bool isScenario() {return scenario;}
+
+	//1 in full day, 0 at night, ramping between over TRANSITIONTIME
+	float getDaylight();
+	//Picks a fresh set of pickups for the current time of day
+	void reshufflePickups() {placedPickups = false; placePickups();}
+
+	GameState getGameState() {return gameState;}
+	int getLevel() {return level;}
+	bool isNight() {return night;}
+	string getTimeOfDay() {return timeOfDay;}
+	int getDayCount() {return dayCount;}
+	int getNightCount() {return nightCount;}
+	bool getDebugMode() {return debugMode;}
+	bool getAttacked() {return attacked;}
+	float getSinceLastAttacked() {return sinceLastAttacked;}
+	float getEnemyCostMs() {return enemyCostMs;}
+	//Use this cost instead of timing the enemies, so a replay budgets its waves
+	//exactly as the recording did. Negative goes back to measuring.
+	void setEnemyCostOverride(float ms) {enemyCostOverride = ms;}
+	//FNV-1a over everything that plays: player, enemies, bullets, pickups,
+	//clock, game state and the random sequence
+	unsigned int computeStateHash();
+	Player& getPlayer() {return player;}
+	Camera& getCamera() {return camera;}
+	const GameConfig& getConfig() {return config;}
+	//Slot i of the enemy pool, active or not
+	Enemy& getEnemy(int i) {return enemies[i];}
+	int getEnemyCapacity() {return enemies.getCapacity();}
+	int getActiveEnemyCount() {return enemies.getActiveCount();}
+	int getBarrelCount() {return barrels.size();}
+	Barrel& getBarrel(int i) {return barrels[i];}
+	int getBuildingCount() {return buildings.size();}
+	int getWallCount() {return walls.size();}
+	int getPickupCount() {return dayPickups.size() + nightPickups.size();}
+	//Where a scenario's lamps are; empty on the built levels
+	const vector<Vector3>& getLampSpots() {return lampSpots;}
+	NavGrid& getNavGrid() {return navGrid;}
+	int getLiveBulletCount();
+	AiLodScheduler& getAiLod() {return aiLod;}
+	WaveDirector& getWaveDirector() {return waveDirector;}
+
+private:
+	void initBasicVariables();
+	void initPickups();
+	void initWallPositions();
+	void initBuildingPositions();
+	void initUniqueObjects();
+	void initBarrels();
+	void initEnemies(int capacity);
+	void initNavGrid();
+	Pickup makePickup(PickupKind kind, int amount, int mapIndex);
+
+	void updatePlaying(float dt);
+	void updateMusic();
+	void updateDebugMode();
+	void updateUniqueObjects(float dt);
+	//Shared out over the job system; the range jobs step by the dt update() kept
+	void updateWalls();
+	void updateBuildings();
+	void updatePlayer(float dt);
+	void updateEnemies(float dt);
+	void updatePickups();
+	void placePickups();
+	void updateDayNight();
+	void updateWaves(float dt);
+	bool spawnEnemy();
+	void startEnemy(int slot, const Vector3& pos);
+	void retireEnemy();
+	void updateGameState();
+	//Leaves PLAYING for next once END_OF_PLAY_HOLD has passed
+	void endPlaying(GameState next);
+	void startLevel2();
+	void savePrevious();
+
+	void handleWallCollisions(Vector3 pos);
+	void handleBuildingCollisions(Vector3 pos);
+	void handleEnemyCollisions(float dt);
+	void stopBullet(Bullet* b);
+
+	//Parallel pass bodies for JobSystem::parallelFor; data is the World. Each only
+	//writes its own items, or its own slot in bulletHits/pickupHits.
+	static void updateWallRange(void* data, int begin, int end);
+	static void updateBuildingRange(void* data, int begin, int end);
+	static void updatePickupRange(void* data, int begin, int end);
+	static void touchPickupRange(void* data, int begin, int end);
+	static void enemySpeedRange(void* data, int begin, int end);
+	static void bulletWallRange(void* data, int begin, int end);
+	static void bulletBuildingRange(void* data, int begin, int end);
+	static void bulletEnemyRange(void* data, int begin, int end);
+	static void enemySceneryRange(void* data, int begin, int end);
+	Pickup& pickupAt(int i) {return i < (int)dayPickups.size() ? dayPickups[i] : nightPickups[i - dayPickups.size()];}
+
+	void drawPickups(SimRenderer* renderer);
+	void markStaticChanged() {staticDirty = true;}
+
+	SimInput* input;
+	SimAudio* audio;
+	WorldMeshes meshes;
+	GameConfig config;
+	GameTimer clock;
+
+	Player player;
+	vector<Bullet*> pBullets;
+	ObjectPool<Enemy> enemies;
+	NavGrid navGrid;
+	AiLodScheduler aiLod;
+	EnemyStateMachine enemyBrain;
+	WaveDirector waveDirector;
+	float enemyCostMs;
+	float enemyCostOverride;
+
+	vector<Barrel> barrels;
+	Wall floor;
+	Wall floor2;
+	vector<Building> buildings;
+	vector<Wall> walls;
+	vector<Pickup> dayPickups;
+	vector<Pickup> nightPickups;
+	//What each bullet hit in the last collision pass, -1 for nothing
+	vector<int> bulletHits;
+	//Which pickups (day then night) the player is touching
+	vector<char> pickupHits;
+	vector<Vector3> lampSpots;
+
+	Camera camera;
+	GameState gameState;
+	GameState nextState;
+	float holdTime;
+	int level;
+	bool scenario;
+	int staticVersion;
+	bool staticDirty;
+	bool night;
+	float timect;
+	string timeOfDay;
+	int dayCount;
+	int nightCount;
+	bool placedPickups;
+	bool nightDayTrans;
+	bool hasntPlayedYet;
+	bool playMusic;
+	bool debugMode;
+	bool walking;
+	float stepTime;
+	bool step1;
+	Vector3 startingLevelPosition;
+	bool attacked;
+	float sinceLastAttacked;
+	int shotTimer;
+	float dt;
+};
+
+#endif
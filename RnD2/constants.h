@@ -1,7 +1,15 @@
 #ifndef Constants_H
 #define Constants_H
+#ifdef _WIN32
 #include <windows.h>
+#else
+typedef unsigned int	UINT;
+typedef unsigned long	DWORD;
+typedef unsigned char	UCHAR;
+typedef unsigned char	BYTE;
+#endif
 #include <string>
+#include "SimMath.h"
 
 // window
 const char CLASS_NAME[] = "RUGBOI";
@@ -29,7 +37,7 @@ const UINT GAME_HEIGHT = 720;               // height of game in pixels
 //const double PI = 3.14159265;
 const double GRAVITY = 2.67428e-11f;
 
-//Global constant to define the size of the waypoint grid
+//Default size of the waypoint grid; waypoint_grid in game.txt overrides it
 const int WAYPOINT_SIZE = 5;
 
 static float heuristicConstant = 5.0f;
@@ -42,6 +50,7 @@ const UCHAR KEY_L	= 'L';
 const UCHAR KEY_K	= 'K';
 const UCHAR KEY_M	= 'M';
 const UCHAR KEY_F	= 'F';
+const UCHAR KEY_P	= 'P';
 const UCHAR KEY_SPACE = ' ';
 const UCHAR KEY_0	= '0';
 
@@ -27,7 +27,7 @@
 #endif
 
 
-#include <d3dx10.h>
+#include "SimMath.h"
 #include <dxerr.h>
 #include <cassert>
 #include <vector>
@@ -87,18 +87,6 @@ D3DX10INLINE UINT ARGB2ABGR(UINT argb)
 	return (A << 24) | (B << 16) | (G << 8) | (R << 0);
 }
 
-// Returns random float in [0, 1).
-D3DX10INLINE float RandF()
-{
-	return (float)(rand()) / (float)RAND_MAX;
-}
-
-// Returns random float in [a, b).
-D3DX10INLINE float RandF(float a, float b)
-{
-	return a + RandF()*(b-a);
-}
-
 // Returns random vector on the unit sphere.
 D3DX10INLINE D3DXVECTOR3 RandUnitVec3()
 {
@@ -107,38 +95,13 @@ D3DX10INLINE D3DXVECTOR3 RandUnitVec3()
 	return v;
 }
  
-template<typename T>
-D3DX10INLINE T Min(const T& a, const T& b)
-{
-	return a < b ? a : b;
-}
-
-template<typename T>
-D3DX10INLINE T Max(const T& a, const T& b)
-{
-	return a > b ? a : b;
-}
- 
-template<typename T>
-D3DX10INLINE T Lerp(const T& a, const T& b, float t)
-{
-	return a + (b-a)*t;
-}
-
-template<typename T>
-D3DX10INLINE T Clamp(const T& x, const T& low, const T& high)
-{
-	return x < low ? low : (x > high ? high : x); 
-}
-
-
 //*****************************************************************************
 // Constants
 //*****************************************************************************
 
+#ifndef INFINITY
 const float INFINITY = FLT_MAX;
-const float PI       = 3.14159265358979323f;
-const float MATH_EPS = 0.0001f;
+#endif
 
 const D3DXCOLOR WHITE(1.0f, 1.0f, 1.0f, 1.0f);
 const D3DXCOLOR BLACK(0.0f, 0.0f, 0.0f, 1.0f);
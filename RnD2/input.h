@@ -14,6 +14,7 @@ class Input;
 #include <WindowsX.h>
 #include <string>
 #include <XInput.h>
+#include "SimInput.h"
 
 
 // for high-definition mouse
@@ -66,7 +67,7 @@ struct ControllerState
     bool                connected;
 };
 
-class Input
+class Input : public SimInput
 {
 private:
     bool keysDown[inputNS::KEYS_ARRAY_LEN];     // true if specified key is down
@@ -108,6 +109,9 @@ public:
     // Save key up state
     void keyUp(WPARAM);
 
+    // Same as a key up message, for the simulation
+    void releaseKey(UCHAR vkey) {keyUp(vkey);}
+
     // Save the char just entered in textIn string
     void keyIn(WPARAM);
 
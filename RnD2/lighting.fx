@@ -14,6 +14,7 @@ cbuffer cbPerFrame
 	int gLightNum;
 	int gGlow;
 	float3 gCubeColor;
+	float4x4 gViewProj;
 };
 
 cbuffer cbPerObject
@@ -21,10 +22,18 @@ cbuffer cbPerObject
 	float4x4 gWorld;
 	float4x4 gWVP;
 	float4x4 gTexMtx;
+	// A Box's colour and size. Every Box shares one white unit cube, so these
+	// make it the Box; anything with colours of its own leaves them at 1.
+	float4 gBoxColor = {1.0f, 1.0f, 1.0f, 1.0f};
+	float gBoxScale = 1.0f;
+	// The material's slice of gMaterialMaps, or -1 to use gDiffuseMap
+	float gMaterialSlice = -1.0f;
 };
 
 Texture2D gDiffuseMap;
 Texture2D gSpecMap;
+// Every material's diffuse map that's the same size; see D3DRenderer
+Texture2DArray gMaterialMaps;
 
 SamplerState gTriLinearSam
 {
@@ -33,15 +42,28 @@ SamplerState gTriLinearSam
 	AddressV = CLAMP;
 };
 
+// A PackedVertex: the normal is octahedron-packed, and the one colour is
+// both diffuse and specular
 struct VS_IN
 {
 	float3 posL    : POSITION;
-	float3 normalL : NORMAL;
+	float2 normalL : NORMAL;
 	float4 diffuse : DIFFUSE;
-	float4 spec    : SPECULAR;
 	float2  texC   : TEXCOORD;
 };
 
+// One per instance in InstancedTech, after the vertex
+struct VS_INSTANCED_IN
+{
+	float3 posL    : POSITION;
+	float2 normalL : NORMAL;
+	float4 diffuse : DIFFUSE;
+	float2  texC   : TEXCOORD;
+	row_major float4x4 world : WORLD;
+	float4 glow    : GLOW;
+	float slice    : SLICE;
+};
+
 struct VS_OUT
 {
 	float4 posH    : SV_POSITION;
@@ -50,23 +72,55 @@ struct VS_OUT
     float4 diffuse : DIFFUSE;
     float4 spec    : SPECULAR;
 	float2  texC   : TEXCOORD;
+	// Flat colour in xyz, drawn instead of lighting when w is 1
+	float4 glow    : GLOW;
+	nointerpolation float slice : SLICE;
 };
 
+// As unpackNormal in PackedVertex.cpp
+float3 OctDecode(float2 e)
+{
+	float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
 VS_OUT VS(VS_IN vIn)
 {
 	VS_OUT vOut;
 	
 	// Transform to world space space.
-	vOut.posW    = mul(float4(vIn.posL, 1.0f), gWorld);
-	vOut.normalW = mul(float4(vIn.normalL, 0.0f), gWorld);
+	float3 posL  = vIn.posL * gBoxScale;
+	vOut.posW    = mul(float4(posL, 1.0f), gWorld);
+	vOut.normalW = mul(float4(OctDecode(vIn.normalL), 0.0f), gWorld);
 		
 	// Transform to homogeneous clip space.
-	vOut.posH    = mul(float4(vIn.posL, 1.0f), gWVP);
+	vOut.posH    = mul(float4(posL, 1.0f), gWVP);
 	
 	// Output vertex attributes for interpolation across triangle.
-	vOut.diffuse = vIn.diffuse;
-	vOut.spec    = vIn.spec;
+	vOut.diffuse = vIn.diffuse * gBoxColor;
+	vOut.spec    = vOut.diffuse;
+	vOut.texC    = mul(float4(vIn.texC, 0.0f, 1.0f), gTexMtx);
+	vOut.glow    = float4(gCubeColor, gGlow == 2 ? 1.0f : 0.0f);
+	vOut.slice   = gMaterialSlice;
+
+	return vOut;
+}
+
+VS_OUT VSInstanced(VS_INSTANCED_IN vIn)
+{
+	VS_OUT vOut;
+
+	vOut.posW    = mul(float4(vIn.posL * gBoxScale, 1.0f), vIn.world);
+	vOut.normalW = mul(float4(OctDecode(vIn.normalL), 0.0f), vIn.world);
+	vOut.posH    = mul(float4(vOut.posW, 1.0f), gViewProj);
+
+	vOut.diffuse = vIn.diffuse * gBoxColor;
+	vOut.spec    = vOut.diffuse;
 	vOut.texC    = mul(float4(vIn.texC, 0.0f, 1.0f), gTexMtx);
+	vOut.glow    = vIn.glow;
+	vOut.slice   = vIn.slice;
 
 	return vOut;
 }
@@ -77,8 +131,12 @@ float4 PS(VS_OUT pIn) : SV_Target
 	// Interpolating normal can make it not be of unit length so normalize it.
     pIn.normalW = normalize(pIn.normalW);
    
-	pIn.diffuse += gDiffuseMap.Sample( gTriLinearSam, pIn.texC );
-	pIn.spec    += gSpecMap.Sample( gTriLinearSam, pIn.texC );
+	if (pIn.slice >= 0.0f)
+		pIn.diffuse += gMaterialMaps.Sample( gTriLinearSam, float3(pIn.texC, pIn.slice) );
+	else
+		pIn.diffuse += gDiffuseMap.Sample( gTriLinearSam, pIn.texC );
+	// The pack keeps specular maps as BC4, red only
+	pIn.spec    += gSpecMap.Sample( gTriLinearSam, pIn.texC ).rrra;
    
 	//pIn.spec.a *= 256.0f;
 
@@ -87,8 +145,8 @@ float4 PS(VS_OUT pIn) : SV_Target
     
     float3 litColor = {0.05f, 0.05f, 0.05f};
 
-	if (gGlow == 2) 
-		return float4(gCubeColor.x, gCubeColor.y, gCubeColor.z, pIn.diffuse.a);
+	if (pIn.glow.w > 0.5f) 
+		return float4(pIn.glow.x, pIn.glow.y, pIn.glow.z, pIn.diffuse.a);
 		//return float4(gCubeColor.x, 0, 0, pIn.diffuse.a);
 	
 	//directed light for scene (sun)
@@ -116,5 +174,16 @@ technique10 LightTech
     }
 }
 
+// World matrices come per instance; see D3DRenderer::flushInstances
+technique10 InstancedTech
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_4_0, VSInstanced() ) );
+        SetGeometryShader( NULL );
+        SetPixelShader( CompileShader( ps_4_0, PS() ) );
+    }
+}
+
 
 
@@ -1,6 +1,6 @@
 #include "pickup.h"
 
-Pickup::Pickup(Box *b, int* value, int MOD, int amount, int mapIndex, const char* sound, Audio* a, unsigned int level) {
+Pickup::Pickup(Box *b, int* value, int MOD, int amount, int mapIndex, const char* sound, SimAudio* a, unsigned int level) {
 	radius = 1;
 	radius *= 1.01f; //fudge factor
 	active = true;
@@ -106,27 +106,11 @@ Pickup::Pickup(Box *b, int* value, int MOD, int amount, int mapIndex, const char
 	mod = MOD;
 	Pickup::amount = amount;
 	Pickup::SOUND = const_cast<char*>(sound);
-	mfxGlow = box->getGlowVar();
-	mfxCubeColorVar = box->getCubeColorVar();
-	mfxCubeColorVar->SetRawValue(&box->getColor(), 0, sizeof(D3DXVECTOR3));
 }
 
-void Pickup::draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP) {
-	if (glow)
-		mfxGlow->SetInt(2);
-	else mfxGlow->SetInt(0);
-
-	Matrix mWVP = GameObject::world * (*mVP);
-	mfxWVPVar->SetMatrix((float*)&mWVP);
-	mfxWorldVar->SetMatrix((float*)GameObject::world);
-	D3D10_TECHNIQUE_DESC techDesc;
-	mTech->GetDesc( &techDesc );
-	for(UINT p = 0; p < techDesc.Passes; ++p)
-	{
-		mTech->GetPassByIndex( p )->Apply(0);
-		box->draw();
-	}
-	if (glow) mfxGlow->SetInt(0);
+void Pickup::draw(SimRenderer* renderer) {
+	if(material >= 0) renderer->setMaterial(material);
+	renderer->drawMesh(box, world, glow);
 }
 
 void Pickup::activate() {
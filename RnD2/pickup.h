@@ -1,24 +1,26 @@
 #ifndef PICKUP_H
 #define PICKUP_H
 #include "GameObject.h"
-#include "Audio.h"
+#include "SimAudio.h"
 #include "constants.h"
 #include<vector>
 #include "Gun.h"
 #include "Player.h"
 using std::vector;
 
+enum PickupKind {PICKUP_HEALTH, PICKUP_AMMO, PICKUP_SPEED, PICKUP_GUN};
+
 class Pickup : public GameObject
 {
 public:
 	Pickup(){}
-	Pickup(Box *b, int* value, int MOD, int amount, int mapIndex, const char* sound, Audio* a, unsigned int level);
+	Pickup(Box *b, int* value, int MOD, int amount, int mapIndex, const char* sound, SimAudio* a, unsigned int level);
 	~Pickup();
 
 	//Width and height in integral number of boxes(bricks)
 	virtual void update(float dt);
 	void activate();
-	void draw(ID3D10EffectMatrixVariable* mfxWVPVar, ID3D10EffectMatrixVariable* mfxWorldVar, ID3D10EffectTechnique* mTech, Matrix* mVP);
+	void draw(SimRenderer* renderer);
 	//void setPosition (Vector3 pos) {position = pos;}
 	//Vector3 getPosition() {return position;}
 	//void setRadius(float r) {radius = r; radiusSquared = (scale*r)*(scale*r);}
@@ -44,19 +46,17 @@ public:
 	}
 
 	int getMapIndex() {return mapIndex;}
-	D3DXVECTOR3 getColor(){return box->getColor();}
 
 private:
 	float radius;
 	float radiusSquared;
 	int* value;
-	Audio* audio;
+	SimAudio* audio;
 	int mod;
 	int amount;
 	char* SOUND;
 	int mapIndex;
 	vector<Vector3> mapLocations;
-	ID3D10EffectScalarVariable* mfxGlow;
 };
 
 #endif
\ No newline at end of file